@@ -0,0 +1,231 @@
+#include "BookCacheKey.h"
+
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+#include <Serialization.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+constexpr uint8_t KEY_MAP_VERSION = 1;
+constexpr char KEY_MAP_FILE[] = "/cache_keys.bin";
+constexpr char KEY_MAP_TMP_FILE[] = "/cache_keys.bin.tmp";
+constexpr char KEY_MAP_OLD_FILE[] = "/cache_keys.bin.old";
+
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+struct Mapping {
+  uint64_t pathHash;
+  uint32_t size;
+  uint32_t mtime;
+  uint64_t key;
+};
+
+uint64_t fnv1a(const uint8_t* data, const size_t length, uint64_t hash = FNV_OFFSET_BASIS) {
+  for (size_t i = 0; i < length; i++) {
+    hash ^= data[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+uint64_t pathHash(const std::string& path) {
+  return fnv1a(reinterpret_cast<const uint8_t*>(path.data()), path.size());
+}
+
+std::string toHex(const uint64_t value) {
+  static constexpr char DIGITS[] = "0123456789abcdef";
+  std::string hex(16, '0');
+  for (int i = 15, shift = 0; i >= 0; i--, shift += 4) {
+    hex[i] = DIGITS[(value >> shift) & 0xF];
+  }
+  return hex;
+}
+
+bool renameFile(const std::string& from, const std::string& to) {
+  FsFile file;
+  if (!SdMan.openFileForRead("BCK", from, file)) {
+    return false;
+  }
+  const bool renamed = file.rename(to.c_str());
+  file.close();
+  return renamed;
+}
+
+// Most recently fingerprinted first
+void readMappings(const std::string& cacheDir, std::vector<Mapping>& out) {
+  out.clear();
+  const std::string mapPath = cacheDir + KEY_MAP_FILE;
+  const std::string oldPath = cacheDir + KEY_MAP_OLD_FILE;
+  // A map set aside by a save that never finished is still good
+  if (!SdMan.exists(mapPath.c_str()) && (!SdMan.exists(oldPath.c_str()) || !renameFile(oldPath, mapPath))) {
+    return;
+  }
+  FsFile file;
+  if (!SdMan.openFileForRead("BCK", mapPath, file)) {
+    return;
+  }
+
+  uint8_t version = 0;
+  uint8_t count = 0;
+  serialization::readPod(file, version);
+  serialization::readPod(file, count);
+  if (version != KEY_MAP_VERSION || count > BookCacheKey::MAX_MAPPED) {
+    Serial.printf("[%lu] [BCK] Ignoring key map version %u with %u entries\n", millis(), version, count);
+    file.close();
+    return;
+  }
+
+  out.resize(count);
+  for (auto& mapping : out) {
+    serialization::readPod(file, mapping.pathHash);
+    serialization::readPod(file, mapping.size);
+    serialization::readPod(file, mapping.mtime);
+    serialization::readPod(file, mapping.key);
+  }
+  file.close();
+}
+
+bool writeMappings(const std::string& cacheDir, const std::vector<Mapping>& mappings) {
+  const std::string mapPath = cacheDir + KEY_MAP_FILE;
+  const std::string tmpPath = cacheDir + KEY_MAP_TMP_FILE;
+  SdMan.mkdir(cacheDir.c_str());
+
+  FsFile file;
+  if (!SdMan.openFileForWrite("BCK", tmpPath, file)) {
+    return false;
+  }
+  serialization::writePod(file, KEY_MAP_VERSION);
+  serialization::writePod(file, static_cast<uint8_t>(mappings.size()));
+  for (const auto& mapping : mappings) {
+    serialization::writePod(file, mapping.pathHash);
+    serialization::writePod(file, mapping.size);
+    serialization::writePod(file, mapping.mtime);
+    serialization::writePod(file, mapping.key);
+  }
+  file.close();
+
+  // Commit by rename. Rename can't replace a file, so the old map is set aside until the new one is in place, and
+  // readMappings() picks it up again if power is lost in between
+  const std::string oldPath = cacheDir + KEY_MAP_OLD_FILE;
+  if (SdMan.exists(oldPath.c_str())) {
+    SdMan.remove(oldPath.c_str());
+  }
+  if (SdMan.exists(mapPath.c_str()) && !renameFile(mapPath, oldPath)) {
+    SdMan.remove(tmpPath.c_str());
+    return false;
+  }
+  if (!renameFile(tmpPath, mapPath)) {
+    renameFile(oldPath, mapPath);
+    return false;
+  }
+  SdMan.remove(oldPath.c_str());
+  return true;
+}
+}  // namespace
+
+uint64_t BookCacheKey::fingerprint(FsFile& file, const uint32_t size) {
+  uint64_t hash = fnv1a(reinterpret_cast<const uint8_t*>(&size), sizeof(size));
+  uint8_t buffer[SAMPLE_SIZE];
+
+  // Small files are read whole, larger ones at the start, the end and evenly spaced offsets in between
+  const bool whole = size <= SAMPLE_SIZE * SAMPLE_COUNT;
+  const uint32_t samples = whole ? (size + SAMPLE_SIZE - 1) / SAMPLE_SIZE : SAMPLE_COUNT;
+  for (uint32_t i = 0; i < samples; i++) {
+    const uint32_t offset =
+        whole ? i * SAMPLE_SIZE : static_cast<uint32_t>(uint64_t{size - SAMPLE_SIZE} * i / (SAMPLE_COUNT - 1));
+    const uint32_t length = std::min(SAMPLE_SIZE, size - offset);
+    if (!file.seekSet(offset)) {
+      break;
+    }
+    const int bytesRead = file.read(buffer, length);
+    if (bytesRead <= 0) {
+      break;
+    }
+    hash = fnv1a(buffer, static_cast<size_t>(bytesRead), hash);
+  }
+  return hash;
+}
+
+std::string BookCacheKey::get(const std::string& cacheDir, const std::string& path) {
+  FsFile file;
+  if (!SdMan.openFileForRead("BCK", path, file)) {
+    return toHex(pathHash(path));
+  }
+  const auto size = static_cast<uint32_t>(file.fileSize());
+  uint16_t date = 0, time = 0;
+  file.getModifyDateTime(&date, &time);
+  const uint32_t mtime = (static_cast<uint32_t>(date) << 16) | time;
+  const uint64_t hash = pathHash(path);
+
+  std::vector<Mapping> mappings;
+  readMappings(cacheDir, mappings);
+  for (const auto& mapping : mappings) {
+    if (mapping.pathHash == hash && mapping.size == size && mapping.mtime == mtime) {
+      file.close();
+      return toHex(mapping.key);
+    }
+  }
+
+  const unsigned long start = millis();
+  const uint64_t key = fingerprint(file, size);
+  file.close();
+  Serial.printf("[%lu] [BCK] Fingerprinted %s in %lu ms\n", millis(), path.c_str(), millis() - start);
+
+  // Replace whatever was remembered for this path, the book changed or was never seen
+  for (auto it = mappings.begin(); it != mappings.end(); ++it) {
+    if (it->pathHash == hash) {
+      mappings.erase(it);
+      break;
+    }
+  }
+  if (mappings.size() >= MAX_MAPPED) {
+    mappings.resize(MAX_MAPPED - 1);
+  }
+  mappings.insert(mappings.begin(), {hash, size, mtime, key});
+  if (!writeMappings(cacheDir, mappings)) {
+    Serial.printf("[%lu] [BCK] Could not save the key map\n", millis());
+  }
+  return toHex(key);
+}
+
+void BookCacheKey::relocate(const std::string& cacheDir, const std::string& from, const std::string& to) {
+  const uint64_t fromHash = pathHash(from);
+  const uint64_t toHash = pathHash(to);
+
+  std::vector<Mapping> mappings;
+  readMappings(cacheDir, mappings);
+  bool found = false;
+  for (auto it = mappings.begin(); it != mappings.end();) {
+    if (it->pathHash == toHash) {
+      it = mappings.erase(it);
+      continue;
+    }
+    if (it->pathHash == fromHash) {
+      it->pathHash = toHash;
+      found = true;
+    }
+    ++it;
+  }
+  // Unknown books are fingerprinted at their new path, which gives the same key anyway
+  if (found && !writeMappings(cacheDir, mappings)) {
+    Serial.printf("[%lu] [BCK] Could not save the key map\n", millis());
+  }
+}
+
+void BookCacheKey::forget(const std::string& cacheDir, const std::string& path) {
+  const uint64_t hash = pathHash(path);
+  std::vector<Mapping> mappings;
+  readMappings(cacheDir, mappings);
+  const auto it = std::find_if(mappings.begin(), mappings.end(),
+                               [hash](const Mapping& mapping) { return mapping.pathHash == hash; });
+  if (it == mappings.end()) {
+    return;
+  }
+  mappings.erase(it);
+  if (!writeMappings(cacheDir, mappings)) {
+    Serial.printf("[%lu] [BCK] Could not save the key map\n", millis());
+  }
+}
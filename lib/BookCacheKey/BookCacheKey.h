@@ -0,0 +1,32 @@
+#pragma once
+#include <SdFat.h>
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Cache keys for books derived from their content rather than their path, so moving or renaming a book keeps its
+ * cached metadata, sections and thumbnails.
+ *
+ * The key is a 64-bit fingerprint of the file size and SAMPLE_COUNT chunks of SAMPLE_SIZE bytes spread over the file
+ * (start, end and evenly in between), so it reads the same few KB no matter how large the book is. The last
+ * MAX_MAPPED fingerprints are remembered by path, size and modify time in <cacheDir>/cache_keys.bin, so opening a
+ * known book only has to stat it.
+ */
+class BookCacheKey {
+ public:
+  static constexpr uint32_t SAMPLE_SIZE = 1024;
+  static constexpr uint32_t SAMPLE_COUNT = 4;
+  static constexpr uint32_t MAX_MAPPED = 64;
+
+  // Key for the book at path as 16 hex digits, falling back to a hash of the path if the book can't be read
+  static std::string get(const std::string& cacheDir, const std::string& path);
+  // Carry the remembered key of a book over to its new path after a move or rename
+  static void relocate(const std::string& cacheDir, const std::string& from, const std::string& to);
+  // Drop the remembered key of path, for a file replaced on the device: nothing sets FAT timestamps, so a new book of
+  // the same size would otherwise get the old one's key
+  static void forget(const std::string& cacheDir, const std::string& path);
+
+ private:
+  static uint64_t fingerprint(FsFile& file, uint32_t size);
+};
@@ -0,0 +1,488 @@
+#include "DirectoryListing.h"
+
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+#include <Serialization.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace {
+constexpr uint8_t LISTING_FILE_VERSION = 2;
+// stamp.mtime, stamp.entryCount, stamp.nameHash, count, dirCount, pageTableOffset, letterIndex
+constexpr uint32_t TRAILER_SIZE = (6 + DirectoryListing::LETTER_BUCKETS) * sizeof(uint32_t);
+// Read buffer per run while merging
+constexpr size_t RUN_BUFFER_SIZE = 256;
+constexpr uint16_t MAX_NAME_LENGTH = 1024;
+
+const std::string EMPTY_NAME;
+
+uint8_t fold(const char c) {
+  const auto b = static_cast<uint8_t>(c);
+  return (b >= 'A' && b <= 'Z') ? static_cast<uint8_t>(b - 'A' + 'a') : b;
+}
+
+bool isDirectory(const std::string& name) { return !name.empty() && name.back() == '/'; }
+
+// First 8 case-folded bytes, big-endian, so comparing them agrees with comparing the folded names
+uint64_t foldedPrefix(const std::string& name) {
+  uint64_t prefix = 0;
+  for (size_t i = 0; i < 8; i++) {
+    prefix = (prefix << 8) | (i < name.size() ? fold(name[i]) : 0);
+  }
+  return prefix;
+}
+
+bool foldedLess(const std::string& a, const std::string& b) {
+  const size_t length = std::min(a.size(), b.size());
+  for (size_t i = 0; i < length; i++) {
+    const uint8_t x = fold(a[i]);
+    const uint8_t y = fold(b[i]);
+    if (x != y) {
+      return x < y;
+    }
+  }
+  return a.size() < b.size();
+}
+
+// A name with its folded prefix computed once, most comparisons while sorting stop there
+struct SortName {
+  uint64_t prefix;
+  bool directory;
+  std::string name;
+
+  explicit SortName(std::string n) : prefix(foldedPrefix(n)), directory(isDirectory(n)), name(std::move(n)) {}
+
+  bool operator<(const SortName& other) const {
+    if (directory != other.directory) {
+      return directory;
+    }
+    if (prefix != other.prefix) {
+      return prefix < other.prefix;
+    }
+    return foldedLess(name, other.name);
+  }
+};
+
+uint32_t letterBucket(const std::string& name) {
+  const uint8_t c = name.empty() ? 0 : fold(name[0]);
+  if (c < 'a') {
+    return 0;
+  }
+  if (c <= 'z') {
+    return 1 + c - 'a';
+  }
+  return DirectoryListing::LETTER_BUCKETS - 1;
+}
+
+void writeName(FsFile& out, const std::string& name) {
+  const auto length = static_cast<uint16_t>(name.size());
+  serialization::writePod(out, length);
+  out.write(reinterpret_cast<const uint8_t*>(name.data()), length);
+}
+
+// Sequential reader over one sorted run of the runs file, buffered so interleaved runs don't re-read sectors
+class RunCursor {
+ public:
+  RunCursor(const uint32_t offset, const uint32_t end, const uint32_t names)
+      : offset(offset), end(end), remaining(names) {}
+
+  bool next(FsFile& runs) {
+    if (remaining == 0) {
+      return false;
+    }
+    uint16_t length;
+    if (!read(runs, reinterpret_cast<uint8_t*>(&length), sizeof(length)) || length > MAX_NAME_LENGTH) {
+      return false;
+    }
+    std::string name(length, '\0');
+    if (!read(runs, reinterpret_cast<uint8_t*>(&name[0]), length)) {
+      return false;
+    }
+    current.reset(new SortName(std::move(name)));
+    remaining--;
+    return true;
+  }
+
+  const SortName& name() const { return *current; }
+
+ private:
+  uint32_t offset;  // Next unbuffered byte in the runs file
+  uint32_t end;
+  uint32_t remaining;
+  uint8_t buffer[RUN_BUFFER_SIZE] = {};
+  size_t bufferLength = 0;
+  size_t bufferPosition = 0;
+  std::unique_ptr<SortName> current;
+
+  bool read(FsFile& runs, uint8_t* dst, size_t length) {
+    while (length > 0) {
+      if (bufferPosition == bufferLength) {
+        const size_t toRead = std::min<size_t>(RUN_BUFFER_SIZE, end - offset);
+        if (toRead == 0 || !runs.seek(offset) || runs.read(buffer, toRead) != static_cast<int>(toRead)) {
+          return false;
+        }
+        offset += toRead;
+        bufferLength = toRead;
+        bufferPosition = 0;
+      }
+      const size_t chunk = std::min(length, bufferLength - bufferPosition);
+      memcpy(dst, buffer + bufferPosition, chunk);
+      bufferPosition += chunk;
+      dst += chunk;
+      length -= chunk;
+    }
+    return true;
+  }
+};
+}  // namespace
+
+void DirectoryListing::Stamp::addEntry(const char* name) {
+  entryCount++;
+  // The terminator goes in too, so "ab" + "c" and "a" + "bc" differ
+  do {
+    nameHash = (nameHash ^ static_cast<uint8_t>(*name)) * 16777619u;
+  } while (*name++ != '\0');
+}
+
+bool DirectoryListing::less(const std::string& a, const std::string& b) { return SortName(a) < SortName(b); }
+
+std::string DirectoryListing::pathFor(const std::string& cacheDir, const std::string& dirPath) {
+  std::string normalised = dirPath;
+  while (normalised.size() > 1 && normalised.back() == '/') {
+    normalised.pop_back();
+  }
+  return cacheDir + "/dirs/" + std::to_string(std::hash<std::string>{}(normalised)) + ".lst";
+}
+
+void DirectoryListing::invalidate(const std::string& cacheDir, const std::string& dirPath) {
+  const std::string path = pathFor(cacheDir, dirPath);
+  if (SdMan.exists(path.c_str())) {
+    SdMan.remove(path.c_str());
+  }
+}
+
+void DirectoryListing::close() {
+  if (file) {
+    file.close();
+  }
+  count = 0;
+  dirCount = 0;
+  pageOffsets.clear();
+  window.clear();
+  windowFirstPage = 0;
+}
+
+bool DirectoryListing::open(const std::string& dirPath, const Stamp& stamp) {
+  close();
+  cachePath = pathFor(cacheDir, dirPath);
+  if (!SdMan.exists(cachePath.c_str()) || !SdMan.openFileForRead("DIR", cachePath, file)) {
+    return false;
+  }
+
+  uint8_t version;
+  serialization::readPod(file, version);
+  const auto fileSize = static_cast<uint32_t>(file.size());
+  if (version != LISTING_FILE_VERSION || fileSize < sizeof(version) + TRAILER_SIZE) {
+    Serial.printf("[%lu] [DIR] Unknown listing version %u\n", millis(), version);
+    close();
+    return false;
+  }
+
+  Stamp cachedStamp;
+  uint32_t pageTableOffset;
+  file.seek(fileSize - TRAILER_SIZE);
+  serialization::readPod(file, cachedStamp.mtime);
+  serialization::readPod(file, cachedStamp.entryCount);
+  serialization::readPod(file, cachedStamp.nameHash);
+  serialization::readPod(file, count);
+  serialization::readPod(file, dirCount);
+  serialization::readPod(file, pageTableOffset);
+  for (auto& start : letterIndex) {
+    serialization::readPod(file, start);
+  }
+
+  const uint32_t pageCount = (count + PAGE_ENTRIES - 1) / PAGE_ENTRIES;
+  if (!(cachedStamp == stamp) || dirCount > count ||
+      pageTableOffset + pageCount * sizeof(uint32_t) + TRAILER_SIZE != fileSize) {
+    close();
+    return false;
+  }
+
+  pageOffsets.resize(pageCount);
+  file.seek(pageTableOffset);
+  for (auto& offset : pageOffsets) {
+    serialization::readPod(file, offset);
+  }
+  return true;
+}
+
+bool DirectoryListing::build(const std::string& dirPath, const Stamp& stamp, const EntrySource& nextEntry) {
+  close();
+  const auto start = millis();
+  cachePath = pathFor(cacheDir, dirPath);
+  const std::string runsPath = cachePath + ".runs";
+  const std::string tmpPath = cachePath + ".tmp";
+  SdMan.mkdir(cacheDir.c_str());
+  SdMan.mkdir((cacheDir + "/dirs").c_str());
+
+  // Pass 1: sorted runs of at most RUN_ENTRIES names
+  struct Run {
+    uint32_t offset;
+    uint32_t end;
+    uint32_t names;
+  };
+  std::vector<Run> runs;
+  FsFile runsFile;
+  if (!SdMan.openFileForWrite("DIR", runsPath, runsFile)) {
+    return false;
+  }
+  std::vector<SortName> buffer;
+  buffer.reserve(RUN_ENTRIES);
+  uint32_t runsSize = 0;
+  const auto flushRun = [&] {
+    if (buffer.empty()) {
+      return;
+    }
+    std::sort(buffer.begin(), buffer.end());
+    const uint32_t runStart = runsSize;
+    for (const auto& entry : buffer) {
+      writeName(runsFile, entry.name);
+      runsSize += sizeof(uint16_t) + entry.name.size();
+    }
+    runs.push_back({runStart, runsSize, static_cast<uint32_t>(buffer.size())});
+    buffer.clear();
+  };
+  std::string name;
+  while (nextEntry(name)) {
+    if (name.empty() || name.size() > MAX_NAME_LENGTH) {
+      continue;
+    }
+    buffer.emplace_back(std::move(name));
+    name.clear();
+    if (buffer.size() == RUN_ENTRIES) {
+      flushRun();
+    }
+  }
+  flushRun();
+  runsFile.close();
+  std::vector<SortName>().swap(buffer);
+
+  // Pass 2: merge the runs into the listing, noting page offsets and where each letter starts
+  FsFile out;
+  if (!SdMan.openFileForRead("DIR", runsPath, runsFile)) {
+    SdMan.remove(runsPath.c_str());
+    return false;
+  }
+  if (!SdMan.openFileForWrite("DIR", tmpPath, out)) {
+    runsFile.close();
+    SdMan.remove(runsPath.c_str());
+    return false;
+  }
+
+  std::vector<std::unique_ptr<RunCursor>> cursors;
+  cursors.reserve(runs.size());
+  bool ok = true;
+  for (const auto& run : runs) {
+    cursors.emplace_back(new RunCursor(run.offset, run.end, run.names));
+    ok = ok && cursors.back()->next(runsFile);
+  }
+
+  serialization::writePod(out, LISTING_FILE_VERSION);
+  uint32_t written = sizeof(LISTING_FILE_VERSION);
+  uint32_t nextBucket = 0;
+  while (ok && !cursors.empty()) {
+    size_t smallest = 0;
+    for (size_t i = 1; i < cursors.size(); i++) {
+      if (cursors[i]->name() < cursors[smallest]->name()) {
+        smallest = i;
+      }
+    }
+    const SortName& entry = cursors[smallest]->name();
+    if (count % PAGE_ENTRIES == 0) {
+      pageOffsets.push_back(written);
+    }
+    if (entry.directory) {
+      dirCount++;
+    } else {
+      const uint32_t bucket = letterBucket(entry.name);
+      while (nextBucket <= bucket) {
+        letterIndex[nextBucket++] = count;
+      }
+    }
+    writeName(out, entry.name);
+    written += sizeof(uint16_t) + entry.name.size();
+    count++;
+
+    if (!cursors[smallest]->next(runsFile)) {
+      cursors.erase(cursors.begin() + static_cast<std::ptrdiff_t>(smallest));
+    }
+  }
+  while (nextBucket < LETTER_BUCKETS) {
+    letterIndex[nextBucket++] = count;
+  }
+  runsFile.close();
+  SdMan.remove(runsPath.c_str());
+
+  uint32_t expected = 0;
+  for (const auto& run : runs) {
+    expected += run.names;
+  }
+  if (!ok || count != expected) {
+    Serial.printf("[%lu] [DIR] Failed to merge listing of %s\n", millis(), dirPath.c_str());
+    out.close();
+    SdMan.remove(tmpPath.c_str());
+    close();
+    return false;
+  }
+
+  const uint32_t pageTableOffset = written;
+  for (const uint32_t offset : pageOffsets) {
+    serialization::writePod(out, offset);
+  }
+  serialization::writePod(out, stamp.mtime);
+  serialization::writePod(out, stamp.entryCount);
+  serialization::writePod(out, stamp.nameHash);
+  serialization::writePod(out, count);
+  serialization::writePod(out, dirCount);
+  serialization::writePod(out, pageTableOffset);
+  for (const uint32_t letterStart : letterIndex) {
+    serialization::writePod(out, letterStart);
+  }
+  out.close();
+
+  // Commit by rename so a half written listing is never picked up
+  if (SdMan.exists(cachePath.c_str())) {
+    SdMan.remove(cachePath.c_str());
+  }
+  FsFile built;
+  if (!SdMan.openFileForRead("DIR", tmpPath, built)) {
+    close();
+    return false;
+  }
+  const bool renamed = built.rename(cachePath.c_str());
+  built.close();
+  if (!renamed) {
+    Serial.printf("[%lu] [DIR] Could not move listing into place\n", millis());
+    close();
+    return false;
+  }
+
+  Serial.printf("[%lu] [DIR] Listed %s: %u entries in %u runs in %lu ms\n", millis(), dirPath.c_str(), count,
+                static_cast<uint32_t>(runs.size()), millis() - start);
+  return open(dirPath, stamp);
+}
+
+bool DirectoryListing::readName(std::string& name) {
+  uint16_t length;
+  if (file.read(reinterpret_cast<uint8_t*>(&length), sizeof(length)) != sizeof(length) || length > MAX_NAME_LENGTH) {
+    return false;
+  }
+  name.resize(length);
+  return file.read(reinterpret_cast<uint8_t*>(&name[0]), length) == length;
+}
+
+bool DirectoryListing::loadWindow(const uint32_t page) {
+  // The page before stays loaded too, so scrolling back across a page boundary doesn't reload
+  const uint32_t firstPage = page > 0 ? page - 1 : 0;
+  const uint32_t firstIndex = firstPage * PAGE_ENTRIES;
+  const uint32_t names = std::min(WINDOW_PAGES * PAGE_ENTRIES, count - firstIndex);
+
+  window.clear();
+  if (!file || !file.seek(pageOffsets[firstPage])) {
+    return false;
+  }
+  window.resize(names);
+  for (auto& name : window) {
+    if (!readName(name)) {
+      window.clear();
+      return false;
+    }
+  }
+  windowFirstPage = firstPage;
+  return true;
+}
+
+const std::string& DirectoryListing::at(const uint32_t index) {
+  if (index >= count) {
+    return EMPTY_NAME;
+  }
+  const uint32_t windowStart = windowFirstPage * PAGE_ENTRIES;
+  if (index < windowStart || index >= windowStart + window.size()) {
+    if (!loadWindow(index / PAGE_ENTRIES)) {
+      return EMPTY_NAME;
+    }
+  }
+  return window[index - windowFirstPage * PAGE_ENTRIES];
+}
+
+int32_t DirectoryListing::find(const std::string& name) {
+  if (count == 0) {
+    return -1;
+  }
+  // Binary search the first name of each page, then scan the one page that can hold it
+  const SortName target(name);
+  uint32_t low = 0;
+  uint32_t high = static_cast<uint32_t>(pageOffsets.size());
+  std::string first;
+  while (high - low > 1) {
+    const uint32_t mid = low + (high - low) / 2;
+    if (!file.seek(pageOffsets[mid]) || !readName(first)) {
+      return -1;
+    }
+    if (target < SortName(first)) {
+      high = mid;
+    } else {
+      low = mid;
+    }
+  }
+  const uint32_t pageEnd = std::min(count, (low + 1) * PAGE_ENTRIES);
+  for (uint32_t i = low * PAGE_ENTRIES; i < pageEnd; i++) {
+    if (at(i) == name) {
+      return static_cast<int32_t>(i);
+    }
+  }
+  return -1;
+}
+
+uint32_t DirectoryListing::nextLetter(const uint32_t index) {
+  if (count == 0) {
+    return 0;
+  }
+  if (index < dirCount) {
+    return dirCount < count ? dirCount : 0;
+  }
+  const uint32_t bucket = letterBucket(at(index));
+  const uint32_t next = bucket + 1 < LETTER_BUCKETS ? letterIndex[bucket + 1] : count;
+  return next < count ? next : 0;
+}
+
+uint32_t DirectoryListing::previousLetter(const uint32_t index) {
+  if (count == 0) {
+    return 0;
+  }
+  uint32_t limit = count;
+  if (index < dirCount) {
+    if (index > 0) {
+      return 0;
+    }
+  } else {
+    const uint32_t bucketStart = letterIndex[letterBucket(at(index))];
+    if (index > bucketStart) {
+      return bucketStart;
+    }
+    // Before the first letter come the directories, if any
+    if (bucketStart == dirCount && dirCount > 0) {
+      return 0;
+    }
+    limit = bucketStart > dirCount ? bucketStart : count;
+  }
+  // letterIndex never decreases, so the last start below the limit is the previous letter
+  for (uint32_t bucket = LETTER_BUCKETS; bucket-- > 0;) {
+    if (letterIndex[bucket] < limit) {
+      return letterIndex[bucket];
+    }
+  }
+  return 0;
+}
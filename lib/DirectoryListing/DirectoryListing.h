@@ -0,0 +1,83 @@
+#pragma once
+#include <SdFat.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Sorted listing of one directory, cached on the SD card so huge folders don't have to be read, held in RAM and
+ * sorted every time they are shown.
+ *
+ * Directories come first, then files, each in case-insensitive byte order. Names of directories end with '/'.
+ * The cache is built with an external merge sort (sorted runs of RUN_ENTRIES names, merged into the cache file),
+ * and only a window of WINDOW_PAGES pages of PAGE_ENTRIES names around the last access is kept in RAM.
+ * A cache is only used while the directory's stamp (modify time, raw entry count and a hash of the raw names) is
+ * unchanged. Nothing sets FAT timestamps on the device, so the names are what catches one book swapped for another.
+ */
+class DirectoryListing {
+ public:
+  static constexpr uint32_t PAGE_ENTRIES = 32;
+  static constexpr uint32_t WINDOW_PAGES = 3;
+  static constexpr uint32_t RUN_ENTRIES = 256;
+  // Jump-to-letter buckets for files: anything before 'a', 'a' to 'z', anything after 'z'
+  static constexpr uint32_t LETTER_BUCKETS = 28;
+
+  struct Stamp {
+    uint32_t mtime = 0;               // FAT modify date in the high half, time in the low half
+    uint32_t entryCount = 0;          // Every entry the directory returns, including hidden ones
+    uint32_t nameHash = 2166136261u;  // FNV-1a over the names of those entries, in directory order
+
+    // Account for the next entry the directory returns
+    void addEntry(const char* name);
+    bool operator==(const Stamp& other) const {
+      return mtime == other.mtime && entryCount == other.entryCount && nameHash == other.nameHash;
+    }
+  };
+  // Produces the next name to list (with a trailing '/' for directories), false once the directory is exhausted
+  using EntrySource = std::function<bool(std::string& name)>;
+
+  explicit DirectoryListing(std::string cacheDir) : cacheDir(std::move(cacheDir)) {}
+  ~DirectoryListing() { close(); }
+
+  DirectoryListing(const DirectoryListing& other) = delete;
+  DirectoryListing& operator=(const DirectoryListing& other) = delete;
+
+  // Listing order: directories first, then case-insensitive byte order
+  static bool less(const std::string& a, const std::string& b);
+  // Forget the cached listing of a directory, for changes the stamp can't see such as a rename
+  static void invalidate(const std::string& cacheDir, const std::string& dirPath);
+
+  // Open the cached listing of dirPath if it was built for the same stamp
+  bool open(const std::string& dirPath, const Stamp& stamp);
+  // Build and open the listing of dirPath from every name the source produces
+  bool build(const std::string& dirPath, const Stamp& stamp, const EntrySource& nextEntry);
+  void close();
+
+  uint32_t size() const { return count; }
+  uint32_t getDirectoryCount() const { return dirCount; }
+  // The name at index, or an empty string if it can't be read
+  const std::string& at(uint32_t index);
+  // Index of name, or -1
+  int32_t find(const std::string& name);
+  // First file of the next or previous starting letter, wrapping like the list itself
+  uint32_t nextLetter(uint32_t index);
+  uint32_t previousLetter(uint32_t index);
+
+ private:
+  std::string cacheDir;
+  std::string cachePath;
+  FsFile file;
+  uint32_t count = 0;
+  uint32_t dirCount = 0;
+  std::vector<uint32_t> pageOffsets;
+  uint32_t letterIndex[LETTER_BUCKETS] = {};
+  // Names of the pages [windowFirstPage, windowFirstPage + window.size() / PAGE_ENTRIES)
+  std::vector<std::string> window;
+  uint32_t windowFirstPage = 0;
+
+  static std::string pathFor(const std::string& cacheDir, const std::string& dirPath);
+  bool loadWindow(uint32_t page);
+  bool readName(std::string& name);
+};
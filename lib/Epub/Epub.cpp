@@ -3,14 +3,60 @@
 #include <FsHelpers.h>
 #include <HardwareSerial.h>
 #include <JpegToBmpConverter.h>
+#include <PngToBmpConverter.h>
 #include <SDCardManager.h>
+#include <Serialization.h>
 #include <ZipFile.h>
 
+#include <algorithm>
+#include <cctype>
+
 #include "Epub/parsers/ContainerParser.h"
 #include "Epub/parsers/ContentOpfParser.h"
 #include "Epub/parsers/TocNavParser.h"
 #include "Epub/parsers/TocNcxParser.h"
 
+namespace {
+constexpr uint8_t INDEX_JOURNAL_VERSION = 1;
+
+// Size of the EPUB file, recorded in the indexing journal so a replaced file doesn't resume a stale build
+uint32_t epubFileSize(const std::string& path) {
+  FsFile file;
+  if (!SdMan.openFileForRead("EBP", path, file)) {
+    return 0;
+  }
+  const auto size = static_cast<uint32_t>(file.size());
+  file.close();
+  return size;
+}
+
+// Cover and inline images are decoded by file extension
+enum class ImageFormat { Unsupported, Jpeg, Png };
+
+ImageFormat getImageFormat(const std::string& href) {
+  std::string lower = href;
+  std::transform(lower.begin(), lower.end(), lower.begin(), [](const unsigned char c) { return std::tolower(c); });
+  const auto endsWith = [&lower](const std::string& suffix) {
+    return lower.size() >= suffix.size() && lower.compare(lower.size() - suffix.size(), suffix.size(), suffix) == 0;
+  };
+  if (endsWith(".jpg") || endsWith(".jpeg")) {
+    return ImageFormat::Jpeg;
+  }
+  if (endsWith(".png")) {
+    return ImageFormat::Png;
+  }
+  return ImageFormat::Unsupported;
+}
+
+bool imageFileToBmpStreams(const ImageFormat format, FsFile& image, const BmpOutputStage::Target* targets,
+                           const int targetCount) {
+  if (format == ImageFormat::Png) {
+    return PngToBmpConverter::pngFileToBmpStreams(image, targets, targetCount);
+  }
+  return JpegToBmpConverter::jpegFileToBmpStreams(image, targets, targetCount);
+}
+}  // namespace
+
 bool Epub::findContentOpfFile(std::string* contentOpfFile) const {
   const auto containerPath = "META-INF/container.xml";
   size_t containerSize;
@@ -235,30 +281,13 @@ void Epub::parseCssFiles() const {
     for (const auto& cssPath : cssFiles) {
       Serial.printf("[%lu] [EBP] Parsing CSS file: %s\n", millis(), cssPath.c_str());
 
-      // Extract CSS file to temp location
-      const auto tmpCssPath = getCachePath() + "/.tmp.css";
-      FsFile tempCssFile;
-      if (!SdMan.openFileForWrite("EBP", tmpCssPath, tempCssFile)) {
-        Serial.printf("[%lu] [EBP] Could not create temp CSS file\n", millis());
-        continue;
-      }
-      if (!readItemContentsToStream(cssPath, tempCssFile, 1024)) {
+      // Tokenize straight out of the inflater, rules are only added once the whole file was read
+      CssParser::StreamLoader loader(*cssParser);
+      if (!readItemContentsToStream(cssPath, loader, 1024)) {
         Serial.printf("[%lu] [EBP] Could not read CSS file: %s\n", millis(), cssPath.c_str());
-        tempCssFile.close();
-        SdMan.remove(tmpCssPath.c_str());
-        continue;
-      }
-      tempCssFile.close();
-
-      // Parse the CSS file
-      if (!SdMan.openFileForRead("EBP", tmpCssPath, tempCssFile)) {
-        Serial.printf("[%lu] [EBP] Could not open temp CSS file for reading\n", millis());
-        SdMan.remove(tmpCssPath.c_str());
         continue;
       }
-      cssParser->loadFromStream(tempCssFile);
-      tempCssFile.close();
-      SdMan.remove(tmpCssPath.c_str());
+      loader.finish();
     }
 
     // Save to cache for next time
@@ -284,6 +313,11 @@ bool Epub::load(const bool buildIfMissing, const bool skipLoadingCss) {
 
   // Try to load existing cache first
   if (bookMetadataCache->load()) {
+    // Leftovers from a build that was interrupted right after book.bin was committed
+    if (SdMan.exists(getIndexJournalPath().c_str())) {
+      SdMan.remove(getIndexJournalPath().c_str());
+      bookMetadataCache->cleanupTmpFiles();
+    }
     if (!skipLoadingCss && !loadCssRulesFromCache()) {
       Serial.printf("[%lu] [EBP] Warning: CSS rules cache not found, attempting to parse CSS files\n", millis());
       // to get CSS file list
@@ -308,60 +342,83 @@ bool Epub::load(const bool buildIfMissing, const bool skipLoadingCss) {
 
   const uint32_t indexingStart = millis();
 
-  // Begin building cache - stream entries to disk immediately
-  if (!bookMetadataCache->beginWrite()) {
-    Serial.printf("[%lu] [EBP] Could not begin writing cache\n", millis());
-    return false;
+  BookMetadataCache::BookMetadata bookMetadata;
+  uint16_t resumeSpineCount = 0;
+  uint16_t resumeTocCount = 0;
+  const IndexPhase resumePhase = loadIndexJournal(bookMetadata, resumeSpineCount, resumeTocCount);
+
+  if (resumePhase == IndexPhase::None) {
+    // Anything left behind by an interrupted build without a checkpoint has to be redone
+    bookMetadataCache->cleanupTmpFiles();
+    // Begin building cache - stream entries to disk immediately
+    if (!bookMetadataCache->beginWrite()) {
+      Serial.printf("[%lu] [EBP] Could not begin writing cache\n", millis());
+      return false;
+    }
+  } else {
+    Serial.printf("[%lu] [EBP] Resuming interrupted indexing after phase %u\n", millis(),
+                  static_cast<uint8_t>(resumePhase));
+    if (!bookMetadataCache->resumeWrite(resumeSpineCount, resumeTocCount)) {
+      Serial.printf("[%lu] [EBP] Could not resume writing cache\n", millis());
+      return false;
+    }
   }
 
   // OPF Pass
-  const uint32_t opfStart = millis();
-  BookMetadataCache::BookMetadata bookMetadata;
-  if (!bookMetadataCache->beginContentOpfPass()) {
-    Serial.printf("[%lu] [EBP] Could not begin writing content.opf pass\n", millis());
-    return false;
-  }
-  if (!parseContentOpf(bookMetadata)) {
-    Serial.printf("[%lu] [EBP] Could not parse content.opf\n", millis());
-    return false;
-  }
-  if (!bookMetadataCache->endContentOpfPass()) {
-    Serial.printf("[%lu] [EBP] Could not end writing content.opf pass\n", millis());
-    return false;
+  if (resumePhase < IndexPhase::ContentOpfDone) {
+    const uint32_t opfStart = millis();
+    if (!bookMetadataCache->beginContentOpfPass()) {
+      Serial.printf("[%lu] [EBP] Could not begin writing content.opf pass\n", millis());
+      return false;
+    }
+    if (!parseContentOpf(bookMetadata)) {
+      Serial.printf("[%lu] [EBP] Could not parse content.opf\n", millis());
+      return false;
+    }
+    if (!bookMetadataCache->endContentOpfPass()) {
+      Serial.printf("[%lu] [EBP] Could not end writing content.opf pass\n", millis());
+      return false;
+    }
+    Serial.printf("[%lu] [EBP] OPF pass completed in %lu ms\n", millis(), millis() - opfStart);
+    saveIndexJournal(IndexPhase::ContentOpfDone, bookMetadata);
   }
-  Serial.printf("[%lu] [EBP] OPF pass completed in %lu ms\n", millis(), millis() - opfStart);
 
   // TOC Pass - try EPUB 3 nav first, fall back to NCX
-  const uint32_t tocStart = millis();
-  if (!bookMetadataCache->beginTocPass()) {
-    Serial.printf("[%lu] [EBP] Could not begin writing toc pass\n", millis());
-    return false;
-  }
+  if (resumePhase < IndexPhase::TocDone) {
+    const uint32_t tocStart = millis();
+    if (!bookMetadataCache->beginTocPass()) {
+      Serial.printf("[%lu] [EBP] Could not begin writing toc pass\n", millis());
+      // The checkpoint is useless without its temp files, start over next time
+      SdMan.remove(getIndexJournalPath().c_str());
+      return false;
+    }
 
-  bool tocParsed = false;
+    bool tocParsed = false;
 
-  // Try EPUB 3 nav document first (preferred)
-  if (!tocNavItem.empty()) {
-    Serial.printf("[%lu] [EBP] Attempting to parse EPUB 3 nav document\n", millis());
-    tocParsed = parseTocNavFile();
-  }
+    // Try EPUB 3 nav document first (preferred)
+    if (!tocNavItem.empty()) {
+      Serial.printf("[%lu] [EBP] Attempting to parse EPUB 3 nav document\n", millis());
+      tocParsed = parseTocNavFile();
+    }
 
-  // Fall back to NCX if nav parsing failed or wasn't available
-  if (!tocParsed && !tocNcxItem.empty()) {
-    Serial.printf("[%lu] [EBP] Falling back to NCX TOC\n", millis());
-    tocParsed = parseTocNcxFile();
-  }
+    // Fall back to NCX if nav parsing failed or wasn't available
+    if (!tocParsed && !tocNcxItem.empty()) {
+      Serial.printf("[%lu] [EBP] Falling back to NCX TOC\n", millis());
+      tocParsed = parseTocNcxFile();
+    }
 
-  if (!tocParsed) {
-    Serial.printf("[%lu] [EBP] Warning: Could not parse any TOC format\n", millis());
-    // Continue anyway - book will work without TOC
-  }
+    if (!tocParsed) {
+      Serial.printf("[%lu] [EBP] Warning: Could not parse any TOC format\n", millis());
+      // Continue anyway - book will work without TOC
+    }
 
-  if (!bookMetadataCache->endTocPass()) {
-    Serial.printf("[%lu] [EBP] Could not end writing toc pass\n", millis());
-    return false;
+    if (!bookMetadataCache->endTocPass()) {
+      Serial.printf("[%lu] [EBP] Could not end writing toc pass\n", millis());
+      return false;
+    }
+    Serial.printf("[%lu] [EBP] TOC pass completed in %lu ms\n", millis(), millis() - tocStart);
+    saveIndexJournal(IndexPhase::TocDone, bookMetadata);
   }
-  Serial.printf("[%lu] [EBP] TOC pass completed in %lu ms\n", millis(), millis() - tocStart);
 
   // Close the cache files
   if (!bookMetadataCache->endWrite()) {
@@ -373,6 +430,7 @@ bool Epub::load(const bool buildIfMissing, const bool skipLoadingCss) {
   const uint32_t buildStart = millis();
   if (!bookMetadataCache->buildBookBin(filepath, bookMetadata)) {
     Serial.printf("[%lu] [EBP] Could not update mappings and sizes\n", millis());
+    SdMan.remove(getIndexJournalPath().c_str());
     return false;
   }
   Serial.printf("[%lu] [EBP] buildBookBin completed in %lu ms\n", millis(), millis() - buildStart);
@@ -381,6 +439,7 @@ bool Epub::load(const bool buildIfMissing, const bool skipLoadingCss) {
   if (!bookMetadataCache->cleanupTmpFiles()) {
     Serial.printf("[%lu] [EBP] Could not cleanup tmp files - ignoring\n", millis());
   }
+  SdMan.remove(getIndexJournalPath().c_str());
 
   // Reload the cache from disk so it's in the correct state
   bookMetadataCache.reset(new BookMetadataCache(cachePath));
@@ -413,6 +472,89 @@ bool Epub::clearCache() const {
   return true;
 }
 
+std::string Epub::getIndexJournalPath() const { return cachePath + "/index.journal"; }
+
+bool Epub::saveIndexJournal(const IndexPhase phase, const BookMetadataCache::BookMetadata& bookMetadata) const {
+  // Written aside and renamed over the previous checkpoint, so a crash mid-write leaves the old one intact or none
+  const std::string journalPath = getIndexJournalPath();
+  const std::string tmpPath = journalPath + ".tmp";
+  FsFile file;
+  if (!SdMan.openFileForWrite("EBP", tmpPath, file)) {
+    Serial.printf("[%lu] [EBP] Could not write indexing checkpoint\n", millis());
+    return false;
+  }
+  serialization::writePod(file, INDEX_JOURNAL_VERSION);
+  serialization::writePod(file, static_cast<uint8_t>(phase));
+  serialization::writePod(file, epubFileSize(filepath));
+  serialization::writePod(file, static_cast<uint16_t>(bookMetadataCache->getSpineCount()));
+  serialization::writePod(file, static_cast<uint16_t>(bookMetadataCache->getTocCount()));
+  serialization::writeString(file, bookMetadata.title);
+  serialization::writeString(file, bookMetadata.author);
+  serialization::writeString(file, bookMetadata.language);
+  serialization::writeString(file, bookMetadata.coverItemHref);
+  serialization::writeString(file, bookMetadata.textReferenceHref);
+  // Everything else the later passes need from content.opf
+  serialization::writeString(file, contentBasePath);
+  serialization::writeString(file, tocNcxItem);
+  serialization::writeString(file, tocNavItem);
+  serialization::writePod(file, static_cast<uint16_t>(cssFiles.size()));
+  for (const auto& cssFile : cssFiles) {
+    serialization::writeString(file, cssFile);
+  }
+  file.close();
+
+  if (SdMan.exists(journalPath.c_str())) {
+    SdMan.remove(journalPath.c_str());
+  }
+  if (!SdMan.openFileForRead("EBP", tmpPath, file)) {
+    return false;
+  }
+  const bool renamed = file.rename(journalPath.c_str());
+  file.close();
+  return renamed;
+}
+
+Epub::IndexPhase Epub::loadIndexJournal(BookMetadataCache::BookMetadata& bookMetadata, uint16_t& spineCount,
+                                        uint16_t& tocCount) {
+  const std::string journalPath = getIndexJournalPath();
+  FsFile file;
+  if (!SdMan.exists(journalPath.c_str()) || !SdMan.openFileForRead("EBP", journalPath, file)) {
+    return IndexPhase::None;
+  }
+
+  uint8_t version = 0;
+  uint8_t phase = 0;
+  uint32_t epubSize = 0;
+  serialization::readPod(file, version);
+  serialization::readPod(file, phase);
+  serialization::readPod(file, epubSize);
+  if (version != INDEX_JOURNAL_VERSION || phase == 0 || phase > static_cast<uint8_t>(IndexPhase::TocDone) ||
+      epubSize != epubFileSize(filepath)) {
+    Serial.printf("[%lu] [EBP] Discarding stale indexing checkpoint\n", millis());
+    file.close();
+    SdMan.remove(journalPath.c_str());
+    return IndexPhase::None;
+  }
+  serialization::readPod(file, spineCount);
+  serialization::readPod(file, tocCount);
+  serialization::readString(file, bookMetadata.title);
+  serialization::readString(file, bookMetadata.author);
+  serialization::readString(file, bookMetadata.language);
+  serialization::readString(file, bookMetadata.coverItemHref);
+  serialization::readString(file, bookMetadata.textReferenceHref);
+  serialization::readString(file, contentBasePath);
+  serialization::readString(file, tocNcxItem);
+  serialization::readString(file, tocNavItem);
+  uint16_t cssFileCount = 0;
+  serialization::readPod(file, cssFileCount);
+  cssFiles.resize(cssFileCount);
+  for (auto& cssFile : cssFiles) {
+    serialization::readString(file, cssFile);
+  }
+  file.close();
+  return static_cast<IndexPhase>(phase);
+}
+
 void Epub::setupCacheDir() const {
   if (SdMan.exists(cachePath.c_str())) {
     return;
@@ -474,40 +616,43 @@ bool Epub::generateCoverBmp(bool cropped) const {
     return false;
   }
 
-  if (coverImageHref.substr(coverImageHref.length() - 4) == ".jpg" ||
-      coverImageHref.substr(coverImageHref.length() - 5) == ".jpeg") {
-    Serial.printf("[%lu] [EBP] Generating BMP from JPG cover image (%s mode)\n", millis(), cropped ? "cropped" : "fit");
-    const auto coverJpgTempPath = getCachePath() + "/.cover.jpg";
+  const auto format = getImageFormat(coverImageHref);
+  if (format != ImageFormat::Unsupported) {
+    Serial.printf("[%lu] [EBP] Generating BMP from %s cover image (%s mode)\n", millis(),
+                  format == ImageFormat::Png ? "PNG" : "JPG", cropped ? "cropped" : "fit");
+    const auto coverTempPath = getCachePath() + "/.cover.img";
 
-    FsFile coverJpg;
-    if (!SdMan.openFileForWrite("EBP", coverJpgTempPath, coverJpg)) {
+    FsFile coverImage;
+    if (!SdMan.openFileForWrite("EBP", coverTempPath, coverImage)) {
       return false;
     }
-    readItemContentsToStream(coverImageHref, coverJpg, 1024);
-    coverJpg.close();
+    readItemContentsToStream(coverImageHref, coverImage, 1024);
+    coverImage.close();
 
-    if (!SdMan.openFileForRead("EBP", coverJpgTempPath, coverJpg)) {
+    if (!SdMan.openFileForRead("EBP", coverTempPath, coverImage)) {
       return false;
     }
 
     FsFile coverBmp;
     if (!SdMan.openFileForWrite("EBP", getCoverBmpPath(cropped), coverBmp)) {
-      coverJpg.close();
+      coverImage.close();
       return false;
     }
-    const bool success = JpegToBmpConverter::jpegFileToBmpStream(coverJpg, coverBmp, cropped);
-    coverJpg.close();
+    const BmpOutputStage::Target target = {&coverBmp, BmpOutputStage::TARGET_MAX_WIDTH,
+                                           BmpOutputStage::TARGET_MAX_HEIGHT, false, cropped};
+    const bool success = imageFileToBmpStreams(format, coverImage, &target, 1);
+    coverImage.close();
     coverBmp.close();
-    SdMan.remove(coverJpgTempPath.c_str());
+    SdMan.remove(coverTempPath.c_str());
 
     if (!success) {
-      Serial.printf("[%lu] [EBP] Failed to generate BMP from JPG cover image\n", millis());
+      Serial.printf("[%lu] [EBP] Failed to generate BMP from cover image\n", millis());
       SdMan.remove(getCoverBmpPath(cropped).c_str());
     }
-    Serial.printf("[%lu] [EBP] Generated BMP from JPG cover image, success: %s\n", millis(), success ? "yes" : "no");
+    Serial.printf("[%lu] [EBP] Generated BMP from cover image, success: %s\n", millis(), success ? "yes" : "no");
     return success;
   } else {
-    Serial.printf("[%lu] [EBP] Cover image is not a JPG, skipping\n", millis());
+    Serial.printf("[%lu] [EBP] Cover image is not a JPG or PNG, skipping\n", millis());
   }
 
   return false;
@@ -516,9 +661,25 @@ bool Epub::generateCoverBmp(bool cropped) const {
 std::string Epub::getThumbBmpPath() const { return cachePath + "/thumb_[HEIGHT].bmp"; }
 std::string Epub::getThumbBmpPath(int height) const { return cachePath + "/thumb_" + std::to_string(height) + ".bmp"; }
 
-bool Epub::generateThumbBmp(int height) const {
+bool Epub::generateThumbBmp(const int height) const { return generateThumbBmps({height}); }
+
+bool Epub::generateThumbBmps(const std::vector<int>& heights) const {
+  if (heights.empty()) {
+    return false;
+  }
+
+  // Only decode for the sizes that are still missing
+  std::vector<int> missingHeights;
+  for (const int height : heights) {
+    if (!SdMan.exists(getThumbBmpPath(height).c_str()) &&
+        std::find(missingHeights.begin(), missingHeights.end(), height) == missingHeights.end() &&
+        missingHeights.size() < BmpOutputStage::MAX_TARGETS) {
+      missingHeights.push_back(height);
+    }
+  }
+
   // Already generated, return true
-  if (SdMan.exists(getThumbBmpPath(height).c_str())) {
+  if (missingHeights.empty()) {
     return true;
   }
 
@@ -528,57 +689,125 @@ bool Epub::generateThumbBmp(int height) const {
   }
 
   const auto coverImageHref = bookMetadataCache->coreMetadata.coverItemHref;
+  const auto format = getImageFormat(coverImageHref);
   if (coverImageHref.empty()) {
     Serial.printf("[%lu] [EBP] No known cover image for thumbnail\n", millis());
-  } else if (coverImageHref.substr(coverImageHref.length() - 4) == ".jpg" ||
-             coverImageHref.substr(coverImageHref.length() - 5) == ".jpeg") {
-    Serial.printf("[%lu] [EBP] Generating thumb BMP from JPG cover image\n", millis());
-    const auto coverJpgTempPath = getCachePath() + "/.cover.jpg";
+  } else if (format != ImageFormat::Unsupported) {
+    Serial.printf("[%lu] [EBP] Generating %d thumb BMP(s) from %s cover image\n", millis(),
+                  static_cast<int>(missingHeights.size()), format == ImageFormat::Png ? "PNG" : "JPG");
+    const auto coverTempPath = getCachePath() + "/.cover.img";
 
-    FsFile coverJpg;
-    if (!SdMan.openFileForWrite("EBP", coverJpgTempPath, coverJpg)) {
+    FsFile coverImage;
+    if (!SdMan.openFileForWrite("EBP", coverTempPath, coverImage)) {
       return false;
     }
-    readItemContentsToStream(coverImageHref, coverJpg, 1024);
-    coverJpg.close();
+    readItemContentsToStream(coverImageHref, coverImage, 1024);
+    coverImage.close();
 
-    if (!SdMan.openFileForRead("EBP", coverJpgTempPath, coverJpg)) {
+    if (!SdMan.openFileForRead("EBP", coverTempPath, coverImage)) {
       return false;
     }
 
-    FsFile thumbBmp;
-    if (!SdMan.openFileForWrite("EBP", getThumbBmpPath(height), thumbBmp)) {
-      coverJpg.close();
-      return false;
+    FsFile thumbBmps[BmpOutputStage::MAX_TARGETS];
+    BmpOutputStage::Target targets[BmpOutputStage::MAX_TARGETS];
+    const int count = static_cast<int>(missingHeights.size());
+    bool opened = true;
+    for (int i = 0; i < count && opened; i++) {
+      opened = SdMan.openFileForWrite("EBP", getThumbBmpPath(missingHeights[i]), thumbBmps[i]);
+      // Use smaller target size for Continue Reading card (half of screen: 240x400)
+      // Generate 1-bit BMP for fast home screen rendering (no gray passes needed)
+      targets[i] = {&thumbBmps[i], static_cast<int>(missingHeights[i] * 0.6), missingHeights[i], true, true};
     }
-    // Use smaller target size for Continue Reading card (half of screen: 240x400)
-    // Generate 1-bit BMP for fast home screen rendering (no gray passes needed)
-    int THUMB_TARGET_WIDTH = height * 0.6;
-    int THUMB_TARGET_HEIGHT = height;
-    const bool success = JpegToBmpConverter::jpegFileTo1BitBmpStreamWithSize(coverJpg, thumbBmp, THUMB_TARGET_WIDTH,
-                                                                             THUMB_TARGET_HEIGHT);
-    coverJpg.close();
-    thumbBmp.close();
-    SdMan.remove(coverJpgTempPath.c_str());
+
+    const bool success = opened && imageFileToBmpStreams(format, coverImage, targets, count);
+    coverImage.close();
+    for (int i = 0; i < count; i++) {
+      thumbBmps[i].close();
+    }
+    SdMan.remove(coverTempPath.c_str());
 
     if (!success) {
-      Serial.printf("[%lu] [EBP] Failed to generate thumb BMP from JPG cover image\n", millis());
-      SdMan.remove(getThumbBmpPath(height).c_str());
+      Serial.printf("[%lu] [EBP] Failed to generate thumb BMP from cover image\n", millis());
+      for (const int height : missingHeights) {
+        SdMan.remove(getThumbBmpPath(height).c_str());
+      }
     }
-    Serial.printf("[%lu] [EBP] Generated thumb BMP from JPG cover image, success: %s\n", millis(),
+    Serial.printf("[%lu] [EBP] Generated thumb BMP from cover image, success: %s\n", millis(),
                   success ? "yes" : "no");
-    return success;
+    return success && SdMan.exists(getThumbBmpPath(heights.front()).c_str());
   } else {
-    Serial.printf("[%lu] [EBP] Cover image is not a JPG, skipping thumbnail\n", millis());
+    Serial.printf("[%lu] [EBP] Cover image is not a JPG or PNG, skipping thumbnail\n", millis());
   }
 
-  // Write an empty bmp file to avoid generation attempts in the future
-  FsFile thumbBmp;
-  SdMan.openFileForWrite("EBP", getThumbBmpPath(height), thumbBmp);
-  thumbBmp.close();
+  // Write empty bmp files to avoid generation attempts in the future
+  for (const int height : missingHeights) {
+    FsFile thumbBmp;
+    SdMan.openFileForWrite("EBP", getThumbBmpPath(height), thumbBmp);
+    thumbBmp.close();
+  }
   return false;
 }
 
+std::string Epub::getImageBmpPath(const std::string& itemHref, const int maxWidth, const int maxHeight) const {
+  // Images are decoded to fit the viewport, so the same href can be cached at several sizes
+  return cachePath + "/images/" + std::to_string(std::hash<std::string>{}(itemHref)) + "_" +
+         std::to_string(maxWidth) + "x" + std::to_string(maxHeight) + ".bmp";
+}
+
+bool Epub::generateImageBmp(const std::string& itemHref, const int maxWidth, const int maxHeight) const {
+  const auto imageBmpPath = getImageBmpPath(itemHref, maxWidth, maxHeight);
+  // Already decoded for this viewport, return true
+  if (SdMan.exists(imageBmpPath.c_str())) {
+    return true;
+  }
+
+  const auto format = getImageFormat(itemHref);
+  if (format == ImageFormat::Unsupported) {
+    Serial.printf("[%lu] [EBP] Inline image is not a JPG or PNG, skipping: %s\n", millis(), itemHref.c_str());
+    return false;
+  }
+
+  {
+    const auto imagesDir = cachePath + "/images";
+    SdMan.mkdir(imagesDir.c_str());
+  }
+
+  const auto imageTempPath = getCachePath() + "/.image.img";
+  FsFile image;
+  if (!SdMan.openFileForWrite("EBP", imageTempPath, image)) {
+    return false;
+  }
+  const bool extracted = readItemContentsToStream(itemHref, image, 1024);
+  image.close();
+  if (!extracted) {
+    Serial.printf("[%lu] [EBP] Could not extract inline image %s\n", millis(), itemHref.c_str());
+    SdMan.remove(imageTempPath.c_str());
+    return false;
+  }
+
+  if (!SdMan.openFileForRead("EBP", imageTempPath, image)) {
+    return false;
+  }
+
+  FsFile imageBmp;
+  if (!SdMan.openFileForWrite("EBP", imageBmpPath, imageBmp)) {
+    image.close();
+    return false;
+  }
+  // Fit (never crop) inside the viewport, dithered down to 2-bit
+  const BmpOutputStage::Target target = {&imageBmp, maxWidth, maxHeight, false, false};
+  const bool success = imageFileToBmpStreams(format, image, &target, 1);
+  image.close();
+  imageBmp.close();
+  SdMan.remove(imageTempPath.c_str());
+
+  if (!success) {
+    Serial.printf("[%lu] [EBP] Failed to decode inline image %s\n", millis(), itemHref.c_str());
+    SdMan.remove(imageBmpPath.c_str());
+  }
+  return success;
+}
+
 uint8_t* Epub::readItemContentsToBytes(const std::string& itemHref, size_t* size, const bool trailingNullByte) const {
   if (itemHref.empty()) {
     Serial.printf("[%lu] [EBP] Failed to read item, empty href\n", millis());
@@ -618,7 +847,19 @@ int Epub::getSpineItemsCount() const {
   return bookMetadataCache->getSpineCount();
 }
 
-size_t Epub::getCumulativeSpineItemSize(const int spineIndex) const { return getSpineItem(spineIndex).cumulativeSize; }
+size_t Epub::getCumulativeSpineItemSize(const int spineIndex) const {
+  if (!bookMetadataCache || !bookMetadataCache->isLoaded()) {
+    Serial.printf("[%lu] [EBP] getCumulativeSpineItemSize called but cache not loaded\n", millis());
+    return 0;
+  }
+
+  if (spineIndex < 0 || spineIndex >= bookMetadataCache->getSpineCount()) {
+    Serial.printf("[%lu] [EBP] getCumulativeSpineItemSize index:%d is out of range\n", millis(), spineIndex);
+    return bookMetadataCache->getSpineCumulativeSize(0);
+  }
+
+  return bookMetadataCache->getSpineCumulativeSize(spineIndex);
+}
 
 BookMetadataCache::SpineEntry Epub::getSpineItem(const int spineIndex) const {
   if (!bookMetadataCache || !bookMetadataCache->isLoaded()) {
@@ -668,7 +909,7 @@ int Epub::getSpineIndexForTocIndex(const int tocIndex) const {
     return 0;
   }
 
-  const int spineIndex = bookMetadataCache->getTocEntry(tocIndex).spineIndex;
+  const int spineIndex = bookMetadataCache->getTocSpineIndex(tocIndex);
   if (spineIndex < 0) {
     Serial.printf("[%lu] [EBP] Section not found for TOC index %d\n", millis(), tocIndex);
     return 0;
@@ -677,7 +918,19 @@ int Epub::getSpineIndexForTocIndex(const int tocIndex) const {
   return spineIndex;
 }
 
-int Epub::getTocIndexForSpineIndex(const int spineIndex) const { return getSpineItem(spineIndex).tocIndex; }
+int Epub::getTocIndexForSpineIndex(const int spineIndex) const {
+  if (!bookMetadataCache || !bookMetadataCache->isLoaded()) {
+    Serial.printf("[%lu] [EBP] getTocIndexForSpineIndex called but cache not loaded\n", millis());
+    return -1;
+  }
+
+  if (spineIndex < 0 || spineIndex >= bookMetadataCache->getSpineCount()) {
+    Serial.printf("[%lu] [EBP] getTocIndexForSpineIndex index:%d is out of range\n", millis(), spineIndex);
+    return bookMetadataCache->getSpineTocIndex(0);
+  }
+
+  return bookMetadataCache->getSpineTocIndex(spineIndex);
+}
 
 size_t Epub::getBookSize() const {
   if (!bookMetadataCache || !bookMetadataCache->isLoaded() || bookMetadataCache->getSpineCount() == 0) {
@@ -702,13 +955,12 @@ int Epub::getSpineIndexForTextReference() const {
     return 0;
   }
 
-  // loop through spine items to get the correct index matching the text href
-  for (size_t i = 0; i < getSpineItemsCount(); i++) {
-    if (getSpineItem(i).href == bookMetadataCache->coreMetadata.textReferenceHref) {
-      Serial.printf("[%lu] [ERS] Text reference %s found at index %d\n", millis(),
-                    bookMetadataCache->coreMetadata.textReferenceHref.c_str(), i);
-      return i;
-    }
+  // Binary search the href index stored in book.bin instead of reading every spine item
+  const int spineIndex = bookMetadataCache->getSpineIndexForHref(bookMetadataCache->coreMetadata.textReferenceHref);
+  if (spineIndex >= 0) {
+    Serial.printf("[%lu] [ERS] Text reference %s found at index %d\n", millis(),
+                  bookMetadataCache->coreMetadata.textReferenceHref.c_str(), spineIndex);
+    return spineIndex;
   }
   // This should not happen, as we checked for empty textReferenceHref earlier
   Serial.printf("[%lu] [EBP] Section not found for text reference\n", millis());
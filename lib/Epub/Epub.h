@@ -1,5 +1,6 @@
 #pragma once
 
+#include <BookCacheKey.h>
 #include <Print.h>
 
 #include <memory>
@@ -38,10 +39,17 @@ class Epub {
   std::string getCssRulesCache() const;
   bool loadCssRulesFromCache() const;
 
+  // Completed indexing passes are journaled so an interrupted build of book.bin resumes instead of starting over
+  enum class IndexPhase : uint8_t { None = 0, ContentOpfDone = 1, TocDone = 2 };
+  std::string getIndexJournalPath() const;
+  bool saveIndexJournal(IndexPhase phase, const BookMetadataCache::BookMetadata& bookMetadata) const;
+  IndexPhase loadIndexJournal(BookMetadataCache::BookMetadata& bookMetadata, uint16_t& spineCount,
+                              uint16_t& tocCount);
+
  public:
   explicit Epub(std::string filepath, const std::string& cacheDir) : filepath(std::move(filepath)) {
-    // create a cache key based on the filepath
-    cachePath = cacheDir + "/epub_" + std::to_string(std::hash<std::string>{}(this->filepath));
+    // create a cache key based on the content, so moving or renaming the book keeps its cache
+    cachePath = cacheDir + "/epub_" + BookCacheKey::get(cacheDir, this->filepath);
   }
   ~Epub() = default;
   std::string& getBasePath() { return contentBasePath; }
@@ -58,6 +66,10 @@ class Epub {
   std::string getThumbBmpPath() const;
   std::string getThumbBmpPath(int height) const;
   bool generateThumbBmp(int height) const;
+  // Generate several thumbnail heights from a single cover decode. Returns the result for the first height.
+  bool generateThumbBmps(const std::vector<int>& heights) const;
+  std::string getImageBmpPath(const std::string& itemHref, int maxWidth, int maxHeight) const;
+  bool generateImageBmp(const std::string& itemHref, int maxWidth, int maxHeight) const;
   uint8_t* readItemContentsToBytes(const std::string& itemHref, size_t* size = nullptr,
                                    bool trailingNullByte = false) const;
   bool readItemContentsToStream(const std::string& itemHref, Print& out, size_t chunkSize) const;
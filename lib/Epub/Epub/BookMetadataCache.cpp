@@ -9,10 +9,14 @@
 #include "FsHelpers.h"
 
 namespace {
-constexpr uint8_t BOOK_CACHE_VERSION = 5;
+constexpr uint8_t BOOK_CACHE_VERSION = 6;
 constexpr char bookBinFile[] = "/book.bin";
+constexpr char tmpBookBinFile[] = "/book.bin.tmp";
 constexpr char tmpSpineBinFile[] = "/spine.bin.tmp";
 constexpr char tmpTocBinFile[] = "/toc.bin.tmp";
+constexpr char tmpSizesFile[] = "/sizes.bin.tmp";
+// Item sizes looked up between two flushes of the size checkpoint
+constexpr int SIZE_CHECKPOINT_INTERVAL = 32;
 }  // namespace
 
 /* ============= WRITING / BUILDING FUNCTIONS ================ */
@@ -25,6 +29,14 @@ bool BookMetadataCache::beginWrite() {
   return true;
 }
 
+bool BookMetadataCache::resumeWrite(const uint16_t spineCount, const uint16_t tocCount) {
+  buildMode = true;
+  this->spineCount = spineCount;
+  this->tocCount = tocCount;
+  Serial.printf("[%lu] [BMC] Resuming write mode with %d spine, %d TOC entries\n", millis(), spineCount, tocCount);
+  return true;
+}
+
 bool BookMetadataCache::beginContentOpfPass() {
   Serial.printf("[%lu] [BMC] Beginning content opf pass\n", millis());
 
@@ -60,10 +72,7 @@ bool BookMetadataCache::beginTocPass() {
       idx.spineIndex = static_cast<int16_t>(i);
       spineHrefIndex.push_back(idx);
     }
-    std::sort(spineHrefIndex.begin(), spineHrefIndex.end(),
-              [](const SpineHrefIndexEntry& a, const SpineHrefIndexEntry& b) {
-                return a.hrefHash < b.hrefHash || (a.hrefHash == b.hrefHash && a.hrefLen < b.hrefLen);
-              });
+    std::sort(spineHrefIndex.begin(), spineHrefIndex.end(), hrefIndexLess);
     spineFile.seek(0);
     useSpineHrefIndex = true;
     Serial.printf("[%lu] [BMC] Using fast index for %d spine items\n", millis(), spineCount);
@@ -96,34 +105,144 @@ bool BookMetadataCache::endWrite() {
   return true;
 }
 
-bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMetadata& metadata) {
-  // Open all three files, writing to meta, reading from spine and toc
-  if (!SdMan.openFileForWrite("BMC", cachePath + bookBinFile, bookFile)) {
+bool BookMetadataCache::fillSpineSizes(const std::string& epubPath, std::vector<uint32_t>& sizes) {
+  sizes.assign(spineCount, 0);
+  const std::string progressPath = cachePath + tmpSizesFile;
+
+  // Sizes looked up before an interruption, a partly written trailing entry is simply looked up again
+  FsFile progress;
+  int resumed = 0;
+  if (SdMan.exists(progressPath.c_str()) && SdMan.openFileForRead("BMC", progressPath, progress)) {
+    resumed = std::min(static_cast<int>(progress.size() / sizeof(uint32_t)), static_cast<int>(spineCount));
+    for (int i = 0; i < resumed; i++) {
+      serialization::readPod(progress, sizes[i]);
+    }
+    progress.close();
+    Serial.printf("[%lu] [BMC] Resuming size lookup at spine item %d/%d\n", millis(), resumed, spineCount);
+  }
+  if (resumed == spineCount) {
+    return true;
+  }
+
+  ZipFile zip(epubPath);
+  // Pre-open zip file to speed up size calculations
+  if (!zip.open()) {
+    Serial.printf("[%lu] [BMC] Could not open EPUB zip for size calculations\n", millis());
+    return false;
+  }
+  // Rewrite the checkpoint with what is already known, then extend it as lookups complete
+  if (!SdMan.openFileForWrite("BMC", progressPath, progress)) {
+    zip.close();
     return false;
   }
+  for (int i = 0; i < resumed; i++) {
+    serialization::writePod(progress, sizes[i]);
+  }
+  progress.flush();
+
+  // NOTE: We intentionally skip calling loadAllFileStatSlims() here.
+  // For large EPUBs (2000+ chapters), pre-loading all ZIP central directory entries
+  // into memory causes OOM crashes on ESP32-C3's limited ~380KB RAM.
+  // Instead, for large books we use a one-pass batch lookup that scans the ZIP
+  // central directory once and matches against spine targets using hash comparison.
+  // This is O(n*log(m)) instead of O(n*m) while avoiding memory exhaustion.
+  // See: https://github.com/crosspoint-reader/crosspoint-reader/issues/134
+  if (spineCount - resumed >= LARGE_SPINE_THRESHOLD) {
+    Serial.printf("[%lu] [BMC] Using batch size lookup for %d spine items\n", millis(), spineCount - resumed);
+
+    std::vector<ZipFile::SizeTarget> targets;
+    targets.reserve(spineCount - resumed);
+
+    spineFile.seek(0);
+    for (int i = 0; i < spineCount; i++) {
+      auto entry = readSpineEntry(spineFile);
+      if (i < resumed) {
+        continue;
+      }
+      std::string path = FsHelpers::normalisePath(entry.href);
+
+      ZipFile::SizeTarget t;
+      t.hash = ZipFile::fnvHash64(path.c_str(), path.size());
+      t.len = static_cast<uint16_t>(path.size());
+      t.index = static_cast<uint16_t>(i);
+      targets.push_back(t);
+    }
+
+    std::sort(targets.begin(), targets.end(), [](const ZipFile::SizeTarget& a, const ZipFile::SizeTarget& b) {
+      return a.hash < b.hash || (a.hash == b.hash && a.len < b.len);
+    });
+
+    int matched = zip.fillUncompressedSizes(targets, sizes);
+    Serial.printf("[%lu] [BMC] Batch lookup matched %d/%d spine items\n", millis(), matched, spineCount - resumed);
+  }
 
+  // Items the batch lookup didn't cover (or all of them for smaller books) are looked up one at a time
+  spineFile.seek(0);
+  for (int i = 0; i < spineCount; i++) {
+    auto spineEntry = readSpineEntry(spineFile);
+    if (i < resumed) {
+      continue;
+    }
+    if (sizes[i] == 0) {
+      size_t itemSize = 0;
+      const std::string path = FsHelpers::normalisePath(spineEntry.href);
+      if (!zip.getInflatedFileSize(path.c_str(), &itemSize)) {
+        Serial.printf("[%lu] [BMC] Warning: Could not get size for spine item: %s\n", millis(), path.c_str());
+      }
+      sizes[i] = static_cast<uint32_t>(itemSize);
+    }
+    serialization::writePod(progress, sizes[i]);
+    if ((i + 1) % SIZE_CHECKPOINT_INTERVAL == 0) {
+      progress.flush();
+    }
+  }
+
+  progress.close();
+  // Close opened zip file
+  zip.close();
+  return true;
+}
+
+bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMetadata& metadata) {
+  // Look up every item size first (the slow part, checkpointed), then write book.bin in one go
   if (!SdMan.openFileForRead("BMC", cachePath + tmpSpineBinFile, spineFile)) {
-    bookFile.close();
     return false;
   }
 
   if (!SdMan.openFileForRead("BMC", cachePath + tmpTocBinFile, tocFile)) {
-    bookFile.close();
     spineFile.close();
     return false;
   }
 
-  constexpr uint32_t headerASize =
-      sizeof(BOOK_CACHE_VERSION) + /* LUT Offset */ sizeof(uint32_t) + sizeof(spineCount) + sizeof(tocCount);
+  std::vector<uint32_t> spineSizes;
+  if (!fillSpineSizes(epubPath, spineSizes)) {
+    spineFile.close();
+    tocFile.close();
+    return false;
+  }
+
+  // Written under a temporary name, an interrupted build must never leave a truncated book.bin behind
+  if (!SdMan.openFileForWrite("BMC", cachePath + tmpBookBinFile, bookFile)) {
+    spineFile.close();
+    tocFile.close();
+    return false;
+  }
+
+  constexpr uint32_t headerASize = sizeof(BOOK_CACHE_VERSION) + /* LUT Offset */ sizeof(uint32_t) +
+                                   /* href index offset */ sizeof(uint32_t) + sizeof(spineCount) + sizeof(tocCount);
   const uint32_t metadataSize = metadata.title.size() + metadata.author.size() + metadata.language.size() +
                                 metadata.coverItemHref.size() + metadata.textReferenceHref.size() +
                                 sizeof(uint32_t) * 5;
   const uint32_t lutSize = sizeof(uint32_t) * spineCount + sizeof(uint32_t) * tocCount;
   const uint32_t lutOffset = headerASize + metadataSize;
+  // Spine and TOC entries are copied with the same encoding as the temp files, so their sizes are known up front
+  const uint32_t hrefIndexOffset =
+      lutOffset + lutSize + static_cast<uint32_t>(spineFile.size()) + static_cast<uint32_t>(tocFile.size());
 
   // Header A
   serialization::writePod(bookFile, BOOK_CACHE_VERSION);
   serialization::writePod(bookFile, lutOffset);
+  serialization::writePod(bookFile, hrefIndexOffset);
   serialization::writePod(bookFile, spineCount);
   serialization::writePod(bookFile, tocCount);
   // Metadata
@@ -164,63 +283,16 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
     }
   }
 
-  ZipFile zip(epubPath);
-  // Pre-open zip file to speed up size calculations
-  if (!zip.open()) {
-    Serial.printf("[%lu] [BMC] Could not open EPUB zip for size calculations\n", millis());
-    bookFile.close();
-    spineFile.close();
-    tocFile.close();
-    return false;
-  }
-  // NOTE: We intentionally skip calling loadAllFileStatSlims() here.
-  // For large EPUBs (2000+ chapters), pre-loading all ZIP central directory entries
-  // into memory causes OOM crashes on ESP32-C3's limited ~380KB RAM.
-  // Instead, for large books we use a one-pass batch lookup that scans the ZIP
-  // central directory once and matches against spine targets using hash comparison.
-  // This is O(n*log(m)) instead of O(n*m) while avoiding memory exhaustion.
-  // See: https://github.com/crosspoint-reader/crosspoint-reader/issues/134
-
-  std::vector<uint32_t> spineSizes;
-  bool useBatchSizes = false;
-
-  if (spineCount >= LARGE_SPINE_THRESHOLD) {
-    Serial.printf("[%lu] [BMC] Using batch size lookup for %d spine items\n", millis(), spineCount);
-
-    std::vector<ZipFile::SizeTarget> targets;
-    targets.reserve(spineCount);
-
-    spineFile.seek(0);
-    for (int i = 0; i < spineCount; i++) {
-      auto entry = readSpineEntry(spineFile);
-      std::string path = FsHelpers::normalisePath(entry.href);
-
-      ZipFile::SizeTarget t;
-      t.hash = ZipFile::fnvHash64(path.c_str(), path.size());
-      t.len = static_cast<uint16_t>(path.size());
-      t.index = static_cast<uint16_t>(i);
-      targets.push_back(t);
-    }
-
-    std::sort(targets.begin(), targets.end(), [](const ZipFile::SizeTarget& a, const ZipFile::SizeTarget& b) {
-      return a.hash < b.hash || (a.hash == b.hash && a.len < b.len);
-    });
-
-    spineSizes.resize(spineCount, 0);
-    int matched = zip.fillUncompressedSizes(targets, spineSizes);
-    Serial.printf("[%lu] [BMC] Batch lookup matched %d/%d spine items\n", millis(), matched, spineCount);
-
-    targets.clear();
-    targets.shrink_to_fit();
-
-    useBatchSizes = true;
-  }
+  std::vector<SpineHrefIndexEntry> hrefIndex;
+  hrefIndex.reserve(spineCount);
 
   uint32_t cumSize = 0;
   spineFile.seek(0);
   int lastSpineTocIndex = -1;
   for (int i = 0; i < spineCount; i++) {
     auto spineEntry = readSpineEntry(spineFile);
+    hrefIndex.push_back(
+        {fnvHash64(spineEntry.href), static_cast<uint16_t>(spineEntry.href.size()), static_cast<int16_t>(i)});
 
     spineEntry.tocIndex = spineToTocIndex[i];
 
@@ -234,30 +306,12 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
     }
     lastSpineTocIndex = spineEntry.tocIndex;
 
-    size_t itemSize = 0;
-    if (useBatchSizes) {
-      itemSize = spineSizes[i];
-      if (itemSize == 0) {
-        const std::string path = FsHelpers::normalisePath(spineEntry.href);
-        if (!zip.getInflatedFileSize(path.c_str(), &itemSize)) {
-          Serial.printf("[%lu] [BMC] Warning: Could not get size for spine item: %s\n", millis(), path.c_str());
-        }
-      }
-    } else {
-      const std::string path = FsHelpers::normalisePath(spineEntry.href);
-      if (!zip.getInflatedFileSize(path.c_str(), &itemSize)) {
-        Serial.printf("[%lu] [BMC] Warning: Could not get size for spine item: %s\n", millis(), path.c_str());
-      }
-    }
-
-    cumSize += itemSize;
+    cumSize += spineSizes[i];
     spineEntry.cumulativeSize = cumSize;
 
     // Write out spine data to book.bin
     writeSpineEntry(bookFile, spineEntry);
   }
-  // Close opened zip file
-  zip.close();
 
   // Loop through toc entries from toc file writing to book.bin
   tocFile.seek(0);
@@ -266,10 +320,34 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
     writeTocEntry(bookFile, tocEntry);
   }
 
+  // Sorted href index, the last section of book.bin
+  std::sort(hrefIndex.begin(), hrefIndex.end(), hrefIndexLess);
+  for (const auto& entry : hrefIndex) {
+    serialization::writePod(bookFile, entry.hrefHash);
+    serialization::writePod(bookFile, entry.hrefLen);
+    serialization::writePod(bookFile, entry.spineIndex);
+  }
+
   bookFile.close();
   spineFile.close();
   tocFile.close();
 
+  // Commit by rename, book.bin is either absent or complete
+  const std::string finalPath = cachePath + bookBinFile;
+  if (SdMan.exists(finalPath.c_str())) {
+    SdMan.remove(finalPath.c_str());
+  }
+  FsFile built;
+  if (!SdMan.openFileForRead("BMC", cachePath + tmpBookBinFile, built)) {
+    return false;
+  }
+  const bool renamed = built.rename(finalPath.c_str());
+  built.close();
+  if (!renamed) {
+    Serial.printf("[%lu] [BMC] Could not move book.bin into place\n", millis());
+    return false;
+  }
+
   Serial.printf("[%lu] [BMC] Successfully built book.bin\n", millis());
   return true;
 }
@@ -281,6 +359,12 @@ bool BookMetadataCache::cleanupTmpFiles() const {
   if (SdMan.exists((cachePath + tmpTocBinFile).c_str())) {
     SdMan.remove((cachePath + tmpTocBinFile).c_str());
   }
+  if (SdMan.exists((cachePath + tmpSizesFile).c_str())) {
+    SdMan.remove((cachePath + tmpSizesFile).c_str());
+  }
+  if (SdMan.exists((cachePath + tmpBookBinFile).c_str())) {
+    SdMan.remove((cachePath + tmpBookBinFile).c_str());
+  }
   return true;
 }
 
@@ -328,11 +412,8 @@ void BookMetadataCache::createTocEntry(const std::string& title, const std::stri
     uint64_t targetHash = fnvHash64(href);
     uint16_t targetLen = static_cast<uint16_t>(href.size());
 
-    auto it =
-        std::lower_bound(spineHrefIndex.begin(), spineHrefIndex.end(), SpineHrefIndexEntry{targetHash, targetLen, 0},
-                         [](const SpineHrefIndexEntry& a, const SpineHrefIndexEntry& b) {
-                           return a.hrefHash < b.hrefHash || (a.hrefHash == b.hrefHash && a.hrefLen < b.hrefLen);
-                         });
+    auto it = std::lower_bound(spineHrefIndex.begin(), spineHrefIndex.end(),
+                               SpineHrefIndexEntry{targetHash, targetLen, 0}, hrefIndexLess);
 
     while (it != spineHrefIndex.end() && it->hrefHash == targetHash && it->hrefLen == targetLen) {
       spineIndex = it->spineIndex;
@@ -377,6 +458,7 @@ bool BookMetadataCache::load() {
   }
 
   serialization::readPod(bookFile, lutOffset);
+  serialization::readPod(bookFile, hrefIndexOffset);
   serialization::readPod(bookFile, spineCount);
   serialization::readPod(bookFile, tocCount);
 
@@ -386,6 +468,14 @@ bool BookMetadataCache::load() {
   serialization::readString(bookFile, coreMetadata.coverItemHref);
   serialization::readString(bookFile, coreMetadata.textReferenceHref);
 
+  spineCumulativeSizes.clear();
+  spineTocIndexes.clear();
+  tocSpineIndexes.clear();
+  tablesAttempted = false;
+  tablesReady = false;
+  spineEntryCache.clear();
+  tocEntryCache.clear();
+
   loaded = true;
   Serial.printf("[%lu] [BMC] Loaded cache data: %d spine, %d TOC entries\n", millis(), spineCount, tocCount);
   return true;
@@ -402,12 +492,16 @@ BookMetadataCache::SpineEntry BookMetadataCache::getSpineEntry(const int index)
     return {};
   }
 
+  if (const SpineEntry* cached = spineEntryCache.find(index)) {
+    return *cached;
+  }
+
   // Seek to spine LUT item, read from LUT and get out data
   bookFile.seek(lutOffset + sizeof(uint32_t) * index);
   uint32_t spineEntryPos;
   serialization::readPod(bookFile, spineEntryPos);
   bookFile.seek(spineEntryPos);
-  return readSpineEntry(bookFile);
+  return spineEntryCache.insert(index, readSpineEntry(bookFile));
 }
 
 BookMetadataCache::TocEntry BookMetadataCache::getTocEntry(const int index) {
@@ -421,12 +515,112 @@ BookMetadataCache::TocEntry BookMetadataCache::getTocEntry(const int index) {
     return {};
   }
 
+  if (const TocEntry* cached = tocEntryCache.find(index)) {
+    return *cached;
+  }
+
   // Seek to TOC LUT item, read from LUT and get out data
   bookFile.seek(lutOffset + sizeof(uint32_t) * spineCount + sizeof(uint32_t) * index);
   uint32_t tocEntryPos;
   serialization::readPod(bookFile, tocEntryPos);
   bookFile.seek(tocEntryPos);
-  return readTocEntry(bookFile);
+  return tocEntryCache.insert(index, readTocEntry(bookFile));
+}
+
+bool BookMetadataCache::ensureTables() {
+  if (tablesAttempted) {
+    return tablesReady;
+  }
+  tablesAttempted = true;
+
+  if (static_cast<uint32_t>(spineCount) + tocCount > MAX_TABLE_ENTRIES) {
+    Serial.printf("[%lu] [BMC] %d spine + %d TOC entries, reading lookups from book.bin\n", millis(), spineCount,
+                  tocCount);
+    return false;
+  }
+
+  // Entries are stored back to back after the LUT, spine first, so one seek covers both tables
+  if (spineCount > 0 || tocCount > 0) {
+    bookFile.seek(lutOffset);
+    uint32_t firstEntryPos;
+    serialization::readPod(bookFile, firstEntryPos);
+    bookFile.seek(firstEntryPos);
+  }
+
+  spineCumulativeSizes.reserve(spineCount);
+  spineTocIndexes.reserve(spineCount);
+  for (int i = 0; i < spineCount; i++) {
+    const auto entry = readSpineEntry(bookFile);
+    spineCumulativeSizes.push_back(static_cast<uint32_t>(entry.cumulativeSize));
+    spineTocIndexes.push_back(entry.tocIndex);
+  }
+  tocSpineIndexes.reserve(tocCount);
+  for (int i = 0; i < tocCount; i++) {
+    tocSpineIndexes.push_back(readTocEntry(bookFile).spineIndex);
+  }
+
+  tablesReady = true;
+  Serial.printf("[%lu] [BMC] Cached %d spine and %d TOC lookups in memory\n", millis(), spineCount, tocCount);
+  return true;
+}
+
+size_t BookMetadataCache::getSpineCumulativeSize(const int index) {
+  if (loaded && index >= 0 && index < static_cast<int>(spineCount) && ensureTables()) {
+    return spineCumulativeSizes[index];
+  }
+  return getSpineEntry(index).cumulativeSize;
+}
+
+int16_t BookMetadataCache::getSpineTocIndex(const int index) {
+  if (loaded && index >= 0 && index < static_cast<int>(spineCount) && ensureTables()) {
+    return spineTocIndexes[index];
+  }
+  return getSpineEntry(index).tocIndex;
+}
+
+int BookMetadataCache::getSpineIndexForHref(const std::string& href) {
+  if (!loaded || spineCount == 0) {
+    return -1;
+  }
+
+  const SpineHrefIndexEntry target{fnvHash64(href), static_cast<uint16_t>(href.size()), 0};
+  auto readIndexEntry = [this](const int position) {
+    SpineHrefIndexEntry entry{};
+    bookFile.seek(hrefIndexOffset + HREF_INDEX_ENTRY_SIZE * position);
+    serialization::readPod(bookFile, entry.hrefHash);
+    serialization::readPod(bookFile, entry.hrefLen);
+    serialization::readPod(bookFile, entry.spineIndex);
+    return entry;
+  };
+
+  // Lower bound over the on-disk index, then confirm candidates against the real href in case of a hash collision
+  int low = 0;
+  int high = spineCount;
+  while (low < high) {
+    const int mid = (low + high) / 2;
+    if (hrefIndexLess(readIndexEntry(mid), target)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  for (int position = low; position < spineCount; position++) {
+    const auto entry = readIndexEntry(position);
+    if (entry.hrefHash != target.hrefHash || entry.hrefLen != target.hrefLen) {
+      break;
+    }
+    if (entry.spineIndex >= 0 && entry.spineIndex < spineCount && getSpineEntry(entry.spineIndex).href == href) {
+      return entry.spineIndex;
+    }
+  }
+  return -1;
+}
+
+int16_t BookMetadataCache::getTocSpineIndex(const int index) {
+  if (loaded && index >= 0 && index < static_cast<int>(tocCount) && ensureTables()) {
+    return tocSpineIndexes[index];
+  }
+  return getTocEntry(index).spineIndex;
 }
 
 BookMetadataCache::SpineEntry BookMetadataCache::readSpineEntry(FsFile& file) const {
@@ -45,6 +45,7 @@ class BookMetadataCache {
  private:
   std::string cachePath;
   size_t lutOffset;
+  uint32_t hrefIndexOffset = 0;
   uint16_t spineCount;
   uint16_t tocCount;
   bool loaded;
@@ -55,16 +56,73 @@ class BookMetadataCache {
   FsFile spineFile;
   FsFile tocFile;
 
-  // Index for fast href→spineIndex lookup (used only for large EPUBs)
+  // Index for fast href→spineIndex lookup. Built in RAM for the TOC pass of large EPUBs, and stored sorted at the end
+  // of book.bin for every book so runtime lookups binary search it on the SD card.
   struct SpineHrefIndexEntry {
     uint64_t hrefHash;  // FNV-1a 64-bit hash
     uint16_t hrefLen;   // length for collision reduction
     int16_t spineIndex;
   };
+  static constexpr uint32_t HREF_INDEX_ENTRY_SIZE = sizeof(uint64_t) + sizeof(uint16_t) + sizeof(int16_t);
+  static bool hrefIndexLess(const SpineHrefIndexEntry& a, const SpineHrefIndexEntry& b) {
+    return a.hrefHash < b.hrefHash || (a.hrefHash == b.hrefHash && a.hrefLen < b.hrefLen);
+  }
   std::vector<SpineHrefIndexEntry> spineHrefIndex;
   bool useSpineHrefIndex = false;
 
   static constexpr uint16_t LARGE_SPINE_THRESHOLD = 400;
+  // Books with more spine + TOC entries than this answer fixed-size lookups from book.bin instead of RAM
+  static constexpr uint32_t MAX_TABLE_ENTRIES = 2048;
+  static constexpr size_t SPINE_ENTRY_CACHE_SIZE = 4;
+  static constexpr size_t TOC_ENTRY_CACHE_SIZE = 16;
+
+  // Fixed-size fields of every entry, read in one sequential pass over book.bin on first use so progress and
+  // chapter lookups never seek on the SD card. Empty when the book is too large or the pass failed.
+  std::vector<uint32_t> spineCumulativeSizes;
+  std::vector<int16_t> spineTocIndexes;
+  std::vector<int16_t> tocSpineIndexes;
+  bool tablesAttempted = false;
+  bool tablesReady = false;
+
+  // Small LRU of recently read entries, the strings (href, title) only ever come from book.bin
+  template <typename Entry, size_t N>
+  struct EntryCache {
+    struct Slot {
+      int index = -1;
+      uint32_t lastUse = 0;
+      Entry entry;
+    };
+    Slot slots[N];
+    uint32_t useCounter = 0;
+
+    const Entry* find(const int index) {
+      for (auto& slot : slots) {
+        if (slot.index == index) {
+          slot.lastUse = ++useCounter;
+          return &slot.entry;
+        }
+      }
+      return nullptr;
+    }
+
+    const Entry& insert(const int index, Entry entry) {
+      Slot* victim = &slots[0];
+      for (auto& slot : slots) {
+        if (slot.lastUse < victim->lastUse) victim = &slot;
+      }
+      victim->index = index;
+      victim->lastUse = ++useCounter;
+      victim->entry = std::move(entry);
+      return victim->entry;
+    }
+
+    void clear() {
+      for (auto& slot : slots) slot = Slot();
+      useCounter = 0;
+    }
+  };
+  EntryCache<SpineEntry, SPINE_ENTRY_CACHE_SIZE> spineEntryCache;
+  EntryCache<TocEntry, TOC_ENTRY_CACHE_SIZE> tocEntryCache;
 
   // FNV-1a 64-bit hash function
   static uint64_t fnvHash64(const std::string& s) {
@@ -80,6 +138,8 @@ class BookMetadataCache {
   uint32_t writeTocEntry(FsFile& file, const TocEntry& entry) const;
   SpineEntry readSpineEntry(FsFile& file) const;
   TocEntry readTocEntry(FsFile& file) const;
+  bool ensureTables();
+  bool fillSpineSizes(const std::string& epubPath, std::vector<uint32_t>& sizes);
 
  public:
   BookMetadata coreMetadata;
@@ -90,6 +150,8 @@ class BookMetadataCache {
 
   // Building phase (stream to disk immediately)
   bool beginWrite();
+  // Continue a build interrupted after a completed pass, with the entry counts that pass produced
+  bool resumeWrite(uint16_t spineCount, uint16_t tocCount);
   bool beginContentOpfPass();
   void createSpineEntry(const std::string& href);
   bool endContentOpfPass();
@@ -99,13 +161,20 @@ class BookMetadataCache {
   bool endWrite();
   bool cleanupTmpFiles() const;
 
-  // Post-processing to update mappings and sizes
+  // Post-processing to update mappings and sizes. Item sizes are checkpointed as they are looked up, so an
+  // interrupted build resumes where it stopped. book.bin only appears, by rename, once it is complete.
   bool buildBookBin(const std::string& epubPath, const BookMetadata& metadata);
 
   // Reading phase (read mode)
   bool load();
   SpineEntry getSpineEntry(int index);
   TocEntry getTocEntry(int index);
+  // Fixed-size fields without the strings, served from RAM for all but huge books
+  size_t getSpineCumulativeSize(int index);
+  int16_t getSpineTocIndex(int index);
+  int16_t getTocSpineIndex(int index);
+  // Spine index of an href exactly as it appears in the spine, or -1
+  int getSpineIndexForHref(const std::string& href);
   int getSpineCount() const { return spineCount; }
   int getTocCount() const { return tocCount; }
   bool isLoaded() const { return loaded; }
@@ -0,0 +1,179 @@
+#include "DomPosition.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+void appendName(std::string& position, const std::string& name) {
+  const size_t length = name.size() < 255 ? name.size() : 255;
+  position.push_back(static_cast<char>(length));
+  position.append(name, 0, length);
+}
+
+void appendU16(std::string& position, const uint16_t value) {
+  position.push_back(static_cast<char>(value & 0xFF));
+  position.push_back(static_cast<char>(value >> 8));
+}
+
+// Reads one encoded field at cursor, false once the position is exhausted or malformed
+class Reader {
+  const std::string& position;
+  size_t cursor = 0;
+
+ public:
+  explicit Reader(const std::string& position) : position(position) {}
+
+  bool atEnd() const { return cursor >= position.size(); }
+
+  bool readU8(uint8_t& out) {
+    if (cursor + 1 > position.size()) {
+      return false;
+    }
+    out = static_cast<uint8_t>(position[cursor++]);
+    return true;
+  }
+
+  bool readU16(uint16_t& out) {
+    if (cursor + 2 > position.size()) {
+      return false;
+    }
+    out = static_cast<uint16_t>(static_cast<uint8_t>(position[cursor]) |
+                                (static_cast<uint8_t>(position[cursor + 1]) << 8));
+    cursor += 2;
+    return true;
+  }
+
+  // Points name at the bytes in place, names are only compared
+  bool readName(const char*& name, uint8_t& length) {
+    if (!readU8(length) || cursor + length > position.size()) {
+      return false;
+    }
+    name = position.data() + cursor;
+    cursor += length;
+    return true;
+  }
+};
+
+bool sameName(const char* name, const uint8_t length, const std::string& other) {
+  return other.size() == length && memcmp(name, other.data(), length) == 0;
+}
+}  // namespace
+
+void DomPosition::appendLevel(std::string& position, const std::string& name, const uint16_t index,
+                              const uint8_t siblingNames) {
+  appendName(position, name);
+  appendU16(position, index);
+  position.push_back(static_cast<char>(siblingNames));
+}
+
+void DomPosition::appendSibling(std::string& position, const std::string& name, const uint16_t count) {
+  appendName(position, name);
+  appendU16(position, count);
+}
+
+std::string DomPosition::toXPath(const std::string& position) {
+  std::string xpath;
+  Reader reader(position);
+  while (!reader.atEnd()) {
+    const char* name;
+    uint8_t length;
+    uint16_t index;
+    uint8_t siblingNames;
+    if (!reader.readName(name, length) || !reader.readU16(index) || !reader.readU8(siblingNames)) {
+      break;
+    }
+    xpath += '/';
+    xpath.append(name, length);
+    xpath += '[' + std::to_string(index) + ']';
+
+    for (uint8_t i = 0; i < siblingNames; i++) {
+      uint16_t count;
+      if (!reader.readName(name, length) || !reader.readU16(count)) {
+        return xpath;
+      }
+    }
+  }
+  return xpath;
+}
+
+bool DomPosition::parseXPath(const std::string& xpointer, std::vector<Step>& out) {
+  out.clear();
+  const size_t fragment = xpointer.find("DocFragment[");
+  if (fragment == std::string::npos) {
+    return false;
+  }
+  const size_t body = xpointer.find("]/body", fragment);
+  if (body == std::string::npos) {
+    return false;
+  }
+
+  size_t start = body + strlen("]/body");
+  while (start < xpointer.size() && xpointer[start] == '/') {
+    size_t end = xpointer.find('/', start + 1);
+    if (end == std::string::npos) {
+      end = xpointer.size();
+    }
+    std::string step = xpointer.substr(start + 1, end - start - 1);
+    start = end;
+
+    // Text node and character offset are finer than a block, the elements above them are enough
+    if (step.empty() || step.compare(0, 4, "text") == 0) {
+      break;
+    }
+    uint16_t index = 1;  // KOReader leaves the index out for an element without same-name siblings
+    const size_t bracket = step.find('[');
+    if (bracket != std::string::npos) {
+      index = static_cast<uint16_t>(strtoul(step.c_str() + bracket + 1, nullptr, 10));
+      step.resize(bracket);
+    } else if (const size_t dot = step.find('.'); dot != std::string::npos) {
+      step.resize(dot);
+    }
+    if (step.empty() || index == 0) {
+      break;
+    }
+    out.emplace_back(std::move(step), index);
+  }
+  return !out.empty();
+}
+
+int DomPosition::compare(const std::string& position, const std::vector<Step>& path) {
+  Reader reader(position);
+  for (const auto& [targetName, targetIndex] : path) {
+    if (reader.atEnd()) {
+      // The block is an ancestor of the element and starts first
+      return -1;
+    }
+
+    const char* name;
+    uint8_t length;
+    uint16_t index;
+    uint8_t siblingNames;
+    if (!reader.readName(name, length) || !reader.readU16(index) || !reader.readU8(siblingNames)) {
+      return 0;
+    }
+    const bool onPath = sameName(name, length, targetName);
+
+    // Siblings before the block with the element's name, read through either way to reach the next level
+    uint16_t seen = 0;
+    for (uint8_t i = 0; i < siblingNames; i++) {
+      uint16_t count;
+      if (!reader.readName(name, length) || !reader.readU16(count)) {
+        return 0;
+      }
+      if (sameName(name, length, targetName)) {
+        seen = count;
+      }
+    }
+
+    if (onPath) {
+      if (index != targetIndex) {
+        return index < targetIndex ? -1 : 1;
+      }
+      continue;
+    }
+    // Different names: the element came first exactly when the block's parent had already seen it
+    return targetIndex <= seen ? 1 : -1;
+  }
+  // The element is the block or one of its ancestors
+  return reader.atEnd() ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Where a block starts in its chapter's DOM, recorded by ChapterHtmlSlimParser for the first block of every page and
+ * matched against KOReader's XPointers (/body/DocFragment[n]/body/div[2]/p[5]/text().17) when syncing.
+ *
+ * A position holds one level per element below <body>, outermost first: the element's name and 1-based index among
+ * its same-name siblings, as in an XPointer, plus how many siblings of each other name came before it. The sibling
+ * counts order the position against any element path, even when the two part ways at elements of different names,
+ * so a chapter's page positions can be binary searched without reparsing the chapter.
+ *
+ * Encoding per level: [u8 name length][name][u16 index][u8 sibling name count] then per sibling name
+ * [u8 name length][name][u16 count].
+ */
+class DomPosition {
+ public:
+  // Element name and 1-based index among same-name siblings
+  using Step = std::pair<std::string, uint16_t>;
+
+  static void appendLevel(std::string& position, const std::string& name, uint16_t index, uint8_t siblingNames);
+  static void appendSibling(std::string& position, const std::string& name, uint16_t count);
+
+  // Element path below <body>, e.g. "/div[2]/p[5]", empty for the body itself
+  static std::string toXPath(const std::string& position);
+  // Element steps after the DocFragment's body of a KOReader XPointer, false if it has none
+  static bool parseXPath(const std::string& xpointer, std::vector<Step>& out);
+  // Negative, zero or positive as the block at position starts before, at or after the element at path
+  static int compare(const std::string& position, const std::vector<Step>& path);
+};
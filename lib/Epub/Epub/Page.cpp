@@ -1,6 +1,8 @@
 #include "Page.h"
 
+#include <GfxRenderer.h>
 #include <HardwareSerial.h>
+#include <SDCardManager.h>
 #include <Serialization.h>
 
 void PageLine::render(GfxRenderer& renderer, const int fontId, const int xOffset, const int yOffset) {
@@ -25,19 +27,66 @@ std::unique_ptr<PageLine> PageLine::deserialize(FsFile& file) {
   return std::unique_ptr<PageLine>(new PageLine(std::move(tb), xPos, yPos));
 }
 
+void PageImage::render(GfxRenderer& renderer, const int fontId, const int xOffset, const int yOffset) {
+  FsFile file;
+  if (!SdMan.openFileForRead("PGE", bmpPath, file)) {
+    Serial.printf("[%lu] [PGE] Could not open cached image %s\n", millis(), bmpPath.c_str());
+    return;
+  }
+
+  Bitmap bitmap(file);
+  if (bitmap.parseHeaders() == BmpReaderError::Ok) {
+    renderer.drawBitmap(bitmap, xPos + xOffset, yPos + yOffset, width, height);
+  } else {
+    Serial.printf("[%lu] [PGE] Cached image %s is not a valid BMP\n", millis(), bmpPath.c_str());
+  }
+  file.close();
+}
+
+bool PageImage::serialize(FsFile& file) {
+  serialization::writePod(file, xPos);
+  serialization::writePod(file, yPos);
+  serialization::writePod(file, width);
+  serialization::writePod(file, height);
+  serialization::writeString(file, bmpPath);
+  return true;
+}
+
+std::unique_ptr<PageImage> PageImage::deserialize(FsFile& file) {
+  int16_t xPos;
+  int16_t yPos;
+  uint16_t width;
+  uint16_t height;
+  std::string bmpPath;
+  serialization::readPod(file, xPos);
+  serialization::readPod(file, yPos);
+  serialization::readPod(file, width);
+  serialization::readPod(file, height);
+  serialization::readString(file, bmpPath);
+  return std::unique_ptr<PageImage>(new PageImage(std::move(bmpPath), width, height, xPos, yPos));
+}
+
 void Page::render(GfxRenderer& renderer, const int fontId, const int xOffset, const int yOffset) const {
   for (auto& element : elements) {
     element->render(renderer, fontId, xOffset, yOffset);
   }
 }
 
+bool Page::hasImages() const {
+  for (const auto& element : elements) {
+    if (element->getTag() == TAG_PageImage) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool Page::serialize(FsFile& file) const {
   const uint16_t count = elements.size();
   serialization::writePod(file, count);
 
   for (const auto& el : elements) {
-    // Only PageLine exists currently
-    serialization::writePod(file, static_cast<uint8_t>(TAG_PageLine));
+    serialization::writePod(file, static_cast<uint8_t>(el->getTag()));
     if (!el->serialize(file)) {
       return false;
     }
@@ -59,6 +108,9 @@ std::unique_ptr<Page> Page::deserialize(FsFile& file) {
     if (tag == TAG_PageLine) {
       auto pl = PageLine::deserialize(file);
       page->elements.push_back(std::move(pl));
+    } else if (tag == TAG_PageImage) {
+      auto pi = PageImage::deserialize(file);
+      page->elements.push_back(std::move(pi));
     } else {
       Serial.printf("[%lu] [PGE] Deserialization failed: Unknown tag %u\n", millis(), tag);
       return nullptr;
@@ -1,6 +1,7 @@
 #pragma once
 #include <SdFat.h>
 
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -8,6 +9,7 @@
 
 enum PageElementTag : uint8_t {
   TAG_PageLine = 1,
+  TAG_PageImage = 2,
 };
 
 // represents something that has been added to a page
@@ -19,6 +21,7 @@ class PageElement {
   virtual ~PageElement() = default;
   virtual void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) = 0;
   virtual bool serialize(FsFile& file) = 0;
+  virtual PageElementTag getTag() const = 0;
 };
 
 // a line from a block element
@@ -30,14 +33,38 @@ class PageLine final : public PageElement {
       : PageElement(xPos, yPos), block(std::move(block)) {}
   void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) override;
   bool serialize(FsFile& file) override;
+  PageElementTag getTag() const override { return TAG_PageLine; }
   static std::unique_ptr<PageLine> deserialize(FsFile& file);
 };
 
+// an image decoded once at section build time and cached as a 2-bit BMP in the book cache
+class PageImage final : public PageElement {
+  std::string bmpPath;
+  uint16_t width;
+  uint16_t height;
+
+ public:
+  PageImage(std::string bmpPath, const uint16_t width, const uint16_t height, const int16_t xPos, const int16_t yPos)
+      : PageElement(xPos, yPos), bmpPath(std::move(bmpPath)), width(width), height(height) {}
+  void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) override;
+  bool serialize(FsFile& file) override;
+  PageElementTag getTag() const override { return TAG_PageImage; }
+  static std::unique_ptr<PageImage> deserialize(FsFile& file);
+};
+
 class Page {
  public:
   // the list of block index and line numbers on this page
   std::vector<std::shared_ptr<PageElement>> elements;
+  // DomPosition of the first block on the page, kept in the section's position table rather than with the page
+  std::string position;
+  // Text offset (see HtmlTextScanner) of the first line on the page, stored alongside its position
+  uint32_t textOffset = 0;
+  // Ids of the elements whose content starts on the page, collected into the section's anchor table
+  std::vector<std::string> anchors;
   void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) const;
+  // true if any element needs the grayscale passes regardless of text anti-aliasing
+  bool hasImages() const;
   bool serialize(FsFile& file) const;
   static std::unique_ptr<Page> deserialize(FsFile& file);
 };
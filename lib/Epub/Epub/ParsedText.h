@@ -10,10 +10,19 @@
 
 #include "blocks/BlockStyle.h"
 #include "blocks/TextBlock.h"
+#include "hyphenation/Hyphenator.h"
 
 class GfxRenderer;
 
 class ParsedText {
+ public:
+  // Working memory for splitting words during layout, owned by the caller and kept off the task's stack
+  struct LayoutScratch {
+    Hyphenator::Scratch hyphenation;
+    Hyphenator::BreakList breaks;
+  };
+
+ private:
   std::list<std::string> words;
   std::list<EpdFontFamily::Style> wordStyles;
   std::list<bool> wordContinues;  // true = word attaches to previous (no space before it)
@@ -23,12 +32,13 @@ class ParsedText {
 
   void applyParagraphIndent();
   std::vector<size_t> computeLineBreaks(const GfxRenderer& renderer, int fontId, int pageWidth, int spaceWidth,
-                                        std::vector<uint16_t>& wordWidths, std::vector<bool>& continuesVec);
+                                        std::vector<uint16_t>& wordWidths, std::vector<bool>& continuesVec,
+                                        LayoutScratch& scratch);
   std::vector<size_t> computeHyphenatedLineBreaks(const GfxRenderer& renderer, int fontId, int pageWidth,
                                                   int spaceWidth, std::vector<uint16_t>& wordWidths,
-                                                  std::vector<bool>& continuesVec);
+                                                  std::vector<bool>& continuesVec, LayoutScratch& scratch);
   bool hyphenateWordAtIndex(size_t wordIndex, int availableWidth, const GfxRenderer& renderer, int fontId,
-                            std::vector<uint16_t>& wordWidths, bool allowFallbackBreaks,
+                            std::vector<uint16_t>& wordWidths, bool allowFallbackBreaks, LayoutScratch& scratch,
                             std::vector<bool>* continuesVec = nullptr);
   void extractLine(size_t breakIndex, int pageWidth, int spaceWidth, const std::vector<uint16_t>& wordWidths,
                    const std::vector<bool>& continuesVec, const std::vector<size_t>& lineBreakIndices,
@@ -46,7 +56,7 @@ class ParsedText {
   BlockStyle& getBlockStyle() { return blockStyle; }
   size_t size() const { return words.size(); }
   bool isEmpty() const { return words.empty(); }
-  void layoutAndExtractLines(const GfxRenderer& renderer, int fontId, uint16_t viewportWidth,
+  void layoutAndExtractLines(const GfxRenderer& renderer, int fontId, uint16_t viewportWidth, LayoutScratch& scratch,
                              const std::function<void(std::shared_ptr<TextBlock>)>& processLine,
                              bool includeLastLine = true);
 };
\ No newline at end of file
@@ -1,20 +1,51 @@
 #include "Section.h"
 
+#include <Bitmap.h>
+#include <FsHelpers.h>
 #include <SDCardManager.h>
 #include <Serialization.h>
 
+#include <algorithm>
+
 #include "Page.h"
+#include "hyphenation/HyphenationCache.h"
 #include "hyphenation/Hyphenator.h"
+#include "hyphenation/SdHyphenation.h"
 #include "parsers/ChapterHtmlSlimParser.h"
 
 namespace {
-constexpr uint8_t SECTION_FILE_VERSION = 12;
+constexpr uint8_t SECTION_FILE_VERSION = 18;
 constexpr uint32_t HEADER_SIZE = sizeof(uint8_t) + sizeof(int) + sizeof(float) + sizeof(bool) + sizeof(uint8_t) +
                                  sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint16_t) + sizeof(bool) + sizeof(bool) +
-                                 sizeof(uint32_t);
+                                 sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint32_t);
+// Page count, page LUT offset, position LUT offset and anchor table offset close the header
+constexpr uint32_t PAGE_COUNT_OFFSET = HEADER_SIZE - sizeof(uint16_t) - 3 * sizeof(uint32_t);
+constexpr uint32_t LUT_OFFSET_OFFSET = HEADER_SIZE - 3 * sizeof(uint32_t);
+// Anchors beyond this are dropped rather than growing the table held in RAM while the section is built
+constexpr size_t MAX_ANCHORS = 4096;
+// Anchor table entry: id hash, page, file offset of the id
+constexpr uint32_t ANCHOR_ENTRY_SIZE = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint32_t);
+
+struct AnchorEntry {
+  uint32_t hash;
+  uint16_t page;
+  uint32_t idOffset;
+};
+
+uint32_t anchorHash(const std::string& id) {
+  uint32_t hash = 2166136261u;
+  for (const char c : id) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+  }
+  return hash;
+}
 }  // namespace
 
-uint32_t Section::onPageComplete(std::unique_ptr<Page> page) {
+std::string Section::sectionPath(const std::shared_ptr<Epub>& epub, const int spineIndex) {
+  return epub->getCachePath() + "/sections/" + std::to_string(spineIndex) + ".bin";
+}
+
+uint32_t Section::onPageComplete(std::unique_ptr<Page> page, uint32_t& positionOffset) {
   if (!file) {
     Serial.printf("[%lu] [SCT] File not open for writing page %d\n", millis(), pageCount);
     return 0;
@@ -25,6 +56,10 @@ uint32_t Section::onPageComplete(std::unique_ptr<Page> page) {
     Serial.printf("[%lu] [SCT] Failed to serialize page %d\n", millis(), pageCount);
     return 0;
   }
+  // The page's text offset and position follow it and are found through the position LUT
+  positionOffset = file.position();
+  serialization::writePod(file, page->textOffset);
+  serialization::writeString(file, page->position);
   Serial.printf("[%lu] [SCT] Page %d processed\n", millis(), pageCount);
 
   pageCount++;
@@ -42,7 +77,7 @@ void Section::writeSectionFileHeader(const int fontId, const float lineCompressi
   static_assert(HEADER_SIZE == sizeof(SECTION_FILE_VERSION) + sizeof(fontId) + sizeof(lineCompression) +
                                    sizeof(extraParagraphSpacing) + sizeof(paragraphAlignment) + sizeof(viewportWidth) +
                                    sizeof(viewportHeight) + sizeof(pageCount) + sizeof(hyphenationEnabled) +
-                                   sizeof(embeddedStyle) + sizeof(uint32_t),
+                                   sizeof(embeddedStyle) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint32_t),
                 "Header size mismatch");
   serialization::writePod(file, SECTION_FILE_VERSION);
   serialization::writePod(file, fontId);
@@ -55,6 +90,8 @@ void Section::writeSectionFileHeader(const int fontId, const float lineCompressi
   serialization::writePod(file, embeddedStyle);
   serialization::writePod(file, pageCount);  // Placeholder for page count (will be initially 0 when written)
   serialization::writePod(file, static_cast<uint32_t>(0));  // Placeholder for LUT offset
+  serialization::writePod(file, static_cast<uint32_t>(0));  // Placeholder for position LUT offset
+  serialization::writePod(file, static_cast<uint32_t>(0));  // Placeholder for anchor table offset
 }
 
 bool Section::loadSectionFile(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
@@ -75,26 +112,11 @@ bool Section::loadSectionFile(const int fontId, const float lineCompression, con
       return false;
     }
 
-    int fileFontId;
-    uint16_t fileViewportWidth, fileViewportHeight;
-    float fileLineCompression;
-    bool fileExtraParagraphSpacing;
-    uint8_t fileParagraphAlignment;
-    bool fileHyphenationEnabled;
-    bool fileEmbeddedStyle;
-    serialization::readPod(file, fileFontId);
-    serialization::readPod(file, fileLineCompression);
-    serialization::readPod(file, fileExtraParagraphSpacing);
-    serialization::readPod(file, fileParagraphAlignment);
-    serialization::readPod(file, fileViewportWidth);
-    serialization::readPod(file, fileViewportHeight);
-    serialization::readPod(file, fileHyphenationEnabled);
-    serialization::readPod(file, fileEmbeddedStyle);
-
-    if (fontId != fileFontId || lineCompression != fileLineCompression ||
-        extraParagraphSpacing != fileExtraParagraphSpacing || paragraphAlignment != fileParagraphAlignment ||
-        viewportWidth != fileViewportWidth || viewportHeight != fileViewportHeight ||
-        hyphenationEnabled != fileHyphenationEnabled || embeddedStyle != fileEmbeddedStyle) {
+    Params fileParams;
+    readParams(file, fileParams);
+    params = {fontId,         lineCompression,    extraParagraphSpacing, paragraphAlignment, viewportWidth,
+              viewportHeight, hyphenationEnabled, embeddedStyle};
+    if (fileParams != params) {
       file.close();
       Serial.printf("[%lu] [SCT] Deserialization failed: Parameters do not match\n", millis());
       clearCache();
@@ -176,17 +198,67 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
   if (!SdMan.openFileForWrite("SCT", filePath, file)) {
     return false;
   }
+  params = {fontId,         lineCompression,    extraParagraphSpacing, paragraphAlignment, viewportWidth,
+            viewportHeight, hyphenationEnabled, embeddedStyle};
   writeSectionFileHeader(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
                          viewportHeight, hyphenationEnabled, embeddedStyle);
   std::vector<uint32_t> lut = {};
+  std::vector<uint32_t> positionLut = {};
+  std::vector<AnchorEntry> anchors = {};
+
+  // Image srcs are relative to the chapter document
+  const std::string chapterBasePath = localPath.substr(0, localPath.find_last_of('/') + 1);
+  const auto imageFn = [this, &chapterBasePath, viewportWidth, viewportHeight](
+                           const std::string& src, std::string* bmpPath, int* width, int* height) {
+    const std::string imageHref = FsHelpers::normalisePath(chapterBasePath + src);
+    if (!epub->generateImageBmp(imageHref, viewportWidth, viewportHeight)) {
+      return false;
+    }
+
+    *bmpPath = epub->getImageBmpPath(imageHref, viewportWidth, viewportHeight);
+    FsFile bmpFile;
+    if (!SdMan.openFileForRead("SCT", *bmpPath, bmpFile)) {
+      return false;
+    }
+    Bitmap bitmap(bmpFile);
+    const bool valid = bitmap.parseHeaders() == BmpReaderError::Ok;
+    *width = bitmap.getWidth();
+    *height = bitmap.getHeight();
+    bmpFile.close();
+    return valid;
+  };
 
   ChapterHtmlSlimParser visitor(
       tmpHtmlPath, renderer, fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
       viewportHeight, hyphenationEnabled,
-      [this, &lut](std::unique_ptr<Page> page) { lut.emplace_back(this->onPageComplete(std::move(page))); },
-      embeddedStyle, popupFn, embeddedStyle ? epub->getCssParser() : nullptr);
+      [this, &lut, &positionLut, &anchors](std::unique_ptr<Page> page) {
+        const uint16_t pageIndex = pageCount;
+        const std::vector<std::string> ids = std::move(page->anchors);
+        uint32_t positionOffset = 0;
+        lut.emplace_back(this->onPageComplete(std::move(page), positionOffset));
+        positionLut.emplace_back(positionOffset);
+        // The ids follow their page, so a lookup can confirm the id its hash found
+        for (const auto& id : ids) {
+          if (anchors.size() == MAX_ANCHORS) {
+            Serial.printf("[%lu] [SCT] Anchor table full, dropping %s\n", millis(), id.c_str());
+            continue;
+          }
+          anchors.push_back({anchorHash(id), pageIndex, static_cast<uint32_t>(file.position())});
+          serialization::writeString(file, id);
+        }
+      },
+      embeddedStyle, popupFn, embeddedStyle ? epub->getCssParser() : nullptr, imageFn);
+  if (hyphenationEnabled) {
+    SdHyphenation::prepareLanguage(epub->getLanguage());
+  }
   Hyphenator::setPreferredLanguage(epub->getLanguage());
+  HyphenationCache::resetStats();
   success = visitor.parseAndBuildPages();
+  if (hyphenationEnabled) {
+    const auto& hyphenationStats = HyphenationCache::stats();
+    Serial.printf("[%lu] [SCT] Hyphenation cache: %u hits, %u misses, %u uncached\n", millis(),
+                  hyphenationStats.hits, hyphenationStats.misses, hyphenationStats.uncached);
+  }
 
   SdMan.remove(tmpHtmlPath.c_str());
   if (!success) {
@@ -214,10 +286,28 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
     return false;
   }
 
-  // Go back and write LUT offset
-  file.seek(HEADER_SIZE - sizeof(uint32_t) - sizeof(pageCount));
+  const uint32_t positionLutOffset = file.position();
+  for (const uint32_t& pos : positionLut) {
+    serialization::writePod(file, pos);
+  }
+
+  const uint32_t anchorTableOffset = file.position();
+  std::sort(anchors.begin(), anchors.end(), [](const AnchorEntry& a, const AnchorEntry& b) {
+    return a.hash < b.hash || (a.hash == b.hash && a.page < b.page);
+  });
+  serialization::writePod(file, static_cast<uint32_t>(anchors.size()));
+  for (const auto& anchor : anchors) {
+    serialization::writePod(file, anchor.hash);
+    serialization::writePod(file, anchor.page);
+    serialization::writePod(file, anchor.idOffset);
+  }
+
+  // Go back and write LUT offsets
+  file.seek(PAGE_COUNT_OFFSET);
   serialization::writePod(file, pageCount);
   serialization::writePod(file, lutOffset);
+  serialization::writePod(file, positionLutOffset);
+  serialization::writePod(file, anchorTableOffset);
   file.close();
   return true;
 }
@@ -227,7 +317,7 @@ std::unique_ptr<Page> Section::loadPageFromSectionFile() {
     return nullptr;
   }
 
-  file.seek(HEADER_SIZE - sizeof(uint32_t));
+  file.seek(LUT_OFFSET_OFFSET);
   uint32_t lutOffset;
   serialization::readPod(file, lutOffset);
   file.seek(lutOffset + sizeof(uint32_t) * currentPage);
@@ -239,3 +329,184 @@ std::unique_ptr<Page> Section::loadPageFromSectionFile() {
   file.close();
   return page;
 }
+
+void Section::readParams(FsFile& file, Params& out) {
+  serialization::readPod(file, out.fontId);
+  serialization::readPod(file, out.lineCompression);
+  serialization::readPod(file, out.extraParagraphSpacing);
+  serialization::readPod(file, out.paragraphAlignment);
+  serialization::readPod(file, out.viewportWidth);
+  serialization::readPod(file, out.viewportHeight);
+  serialization::readPod(file, out.hyphenationEnabled);
+  serialization::readPod(file, out.embeddedStyle);
+}
+
+bool Section::openTables(const std::string& path, const Params& params, FsFile& file, Tables& tables) {
+  if (!SdMan.exists(path.c_str()) || !SdMan.openFileForRead("SCT", path, file)) {
+    return false;
+  }
+  uint8_t version;
+  serialization::readPod(file, version);
+  if (version != SECTION_FILE_VERSION) {
+    file.close();
+    return false;
+  }
+  // Built for other settings, the reader rebuilds it when the chapter is opened
+  Params fileParams;
+  readParams(file, fileParams);
+  if (fileParams != params) {
+    file.close();
+    return false;
+  }
+  file.seek(PAGE_COUNT_OFFSET);
+  serialization::readPod(file, tables.pageCount);
+  serialization::readPod(file, tables.lutOffset);
+  serialization::readPod(file, tables.positionLutOffset);
+  serialization::readPod(file, tables.anchorTableOffset);
+  return true;
+}
+
+bool Section::readPosition(FsFile& file, const uint32_t positionLutOffset, const uint16_t page, std::string& out) {
+  uint32_t positionOffset = 0;
+  file.seek(positionLutOffset + sizeof(uint32_t) * page);
+  serialization::readPod(file, positionOffset);
+  if (positionOffset == 0 || !file.seek(positionOffset + sizeof(uint32_t))) {
+    return false;
+  }
+  serialization::readString(file, out);
+  return true;
+}
+
+bool Section::readTextOffset(FsFile& file, const uint32_t positionLutOffset, const uint16_t page, uint32_t& out) {
+  uint32_t positionOffset = 0;
+  file.seek(positionLutOffset + sizeof(uint32_t) * page);
+  serialization::readPod(file, positionOffset);
+  if (positionOffset == 0 || !file.seek(positionOffset)) {
+    return false;
+  }
+  serialization::readPod(file, out);
+  return true;
+}
+
+std::string Section::getPageXPath(const std::shared_ptr<Epub>& epub, const int spineIndex, const Params& params,
+                                  const int page) {
+  FsFile file;
+  Tables tables;
+  if (!openTables(sectionPath(epub, spineIndex), params, file, tables)) {
+    return "";
+  }
+  std::string position;
+  const bool found =
+      page >= 0 && page < tables.pageCount && readPosition(file, tables.positionLutOffset, page, position);
+  file.close();
+  return found ? DomPosition::toXPath(position) : "";
+}
+
+int Section::findPage(const std::shared_ptr<Epub>& epub, const int spineIndex, const Params& params,
+                      const std::vector<DomPosition::Step>& path) {
+  FsFile file;
+  Tables tables;
+  if (!openTables(sectionPath(epub, spineIndex), params, file, tables)) {
+    return -1;
+  }
+
+  // Pages start in document order, the element is on the last page starting at or before it
+  int low = 0;
+  int high = static_cast<int>(tables.pageCount) - 1;
+  int page = 0;
+  std::string position;
+  while (low <= high) {
+    const int mid = low + (high - low) / 2;
+    if (!readPosition(file, tables.positionLutOffset, mid, position)) {
+      file.close();
+      return -1;
+    }
+    if (DomPosition::compare(position, path) <= 0) {
+      page = mid;
+      low = mid + 1;
+    } else {
+      high = mid - 1;
+    }
+  }
+  file.close();
+  return page;
+}
+
+int Section::findTextPage(const std::shared_ptr<Epub>& epub, const int spineIndex, const Params& params,
+                          const uint32_t textOffset) {
+  FsFile file;
+  Tables tables;
+  if (!openTables(sectionPath(epub, spineIndex), params, file, tables)) {
+    return -1;
+  }
+
+  // Last page starting at or before the offset
+  int low = 0;
+  int high = static_cast<int>(tables.pageCount) - 1;
+  int page = 0;
+  while (low <= high) {
+    const int mid = low + (high - low) / 2;
+    uint32_t pageOffset;
+    if (!readTextOffset(file, tables.positionLutOffset, mid, pageOffset)) {
+      file.close();
+      return -1;
+    }
+    if (pageOffset <= textOffset) {
+      page = mid;
+      low = mid + 1;
+    } else {
+      high = mid - 1;
+    }
+  }
+  file.close();
+  return tables.pageCount > 0 ? page : -1;
+}
+
+int Section::findAnchorPage(const std::string& anchor) const {
+  FsFile anchorFile;
+  Tables tables;
+  if (anchor.empty() || !openTables(filePath, params, anchorFile, tables)) {
+    return -1;
+  }
+
+  uint32_t count = 0;
+  anchorFile.seek(tables.anchorTableOffset);
+  serialization::readPod(anchorFile, count);
+  const uint32_t hash = anchorHash(anchor);
+
+  // First entry with the id's hash, the table is sorted by hash and then page
+  uint32_t low = 0;
+  uint32_t high = count;
+  while (low < high) {
+    const uint32_t mid = low + (high - low) / 2;
+    uint32_t midHash;
+    anchorFile.seek(tables.anchorTableOffset + sizeof(uint32_t) + ANCHOR_ENTRY_SIZE * mid);
+    serialization::readPod(anchorFile, midHash);
+    if (midHash < hash) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  // Ids sharing the hash follow each other, the first that really is the anchor wins
+  int page = -1;
+  std::string id;
+  for (uint32_t i = low; i < count && page < 0; i++) {
+    AnchorEntry entry;
+    anchorFile.seek(tables.anchorTableOffset + sizeof(uint32_t) + ANCHOR_ENTRY_SIZE * i);
+    serialization::readPod(anchorFile, entry.hash);
+    serialization::readPod(anchorFile, entry.page);
+    serialization::readPod(anchorFile, entry.idOffset);
+    if (entry.hash != hash) {
+      break;
+    }
+    anchorFile.seek(entry.idOffset);
+    serialization::readString(anchorFile, id);
+    if (id == anchor) {
+      page = entry.page;
+    }
+  }
+  anchorFile.close();
+  return page;
+}
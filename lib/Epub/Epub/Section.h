@@ -1,23 +1,62 @@
 #pragma once
 #include <functional>
 #include <memory>
+#include <vector>
 
+#include "DomPosition.h"
 #include "Epub.h"
 
 class Page;
 class GfxRenderer;
 
 class Section {
+ public:
+  // Layout settings a section file is built with, its pages only hold while they stay the same
+  struct Params {
+    int fontId = 0;
+    float lineCompression = 0;
+    bool extraParagraphSpacing = false;
+    uint8_t paragraphAlignment = 0;
+    uint16_t viewportWidth = 0;
+    uint16_t viewportHeight = 0;
+    bool hyphenationEnabled = false;
+    bool embeddedStyle = false;
+
+    bool operator==(const Params& other) const {
+      return fontId == other.fontId && lineCompression == other.lineCompression &&
+             extraParagraphSpacing == other.extraParagraphSpacing && paragraphAlignment == other.paragraphAlignment &&
+             viewportWidth == other.viewportWidth && viewportHeight == other.viewportHeight &&
+             hyphenationEnabled == other.hyphenationEnabled && embeddedStyle == other.embeddedStyle;
+    }
+    bool operator!=(const Params& other) const { return !(*this == other); }
+  };
+
+ private:
   std::shared_ptr<Epub> epub;
   const int spineIndex;
   GfxRenderer& renderer;
   std::string filePath;
   FsFile file;
+  // Of the section file last loaded or built
+  Params params;
 
   void writeSectionFileHeader(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                               uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled,
                               bool embeddedStyle);
-  uint32_t onPageComplete(std::unique_ptr<Page> page);
+  uint32_t onPageComplete(std::unique_ptr<Page> page, uint32_t& positionOffset);
+  static std::string sectionPath(const std::shared_ptr<Epub>& epub, int spineIndex);
+  // Lookup tables of a built section file
+  struct Tables {
+    uint16_t pageCount = 0;
+    uint32_t lutOffset = 0;
+    uint32_t positionLutOffset = 0;
+    uint32_t anchorTableOffset = 0;
+  };
+  static void readParams(FsFile& file, Params& out);
+  // Open a section file for its tables, false unless it was built with the given params
+  static bool openTables(const std::string& path, const Params& params, FsFile& file, Tables& tables);
+  static bool readPosition(FsFile& file, uint32_t positionLutOffset, uint16_t page, std::string& out);
+  static bool readTextOffset(FsFile& file, uint32_t positionLutOffset, uint16_t page, uint32_t& out);
 
  public:
   uint16_t pageCount = 0;
@@ -27,7 +66,7 @@ class Section {
       : epub(epub),
         spineIndex(spineIndex),
         renderer(renderer),
-        filePath(epub->getCachePath() + "/sections/" + std::to_string(spineIndex) + ".bin") {}
+        filePath(sectionPath(epub, spineIndex)) {}
   ~Section() = default;
   bool loadSectionFile(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                        uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle);
@@ -36,4 +75,19 @@ class Section {
                          uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle,
                          const std::function<void()>& popupFn = nullptr);
   std::unique_ptr<Page> loadPageFromSectionFile();
+  // Page where the element with this id starts, -1 if the chapter has no such id
+  int findAnchorPage(const std::string& anchor) const;
+
+  const Params& getParams() const { return params; }
+
+  // The lookups below only answer from a section built with the given params, its pages are different otherwise
+
+  // Element path below <body> of the first block on a page of a built section, empty if unknown
+  static std::string getPageXPath(const std::shared_ptr<Epub>& epub, int spineIndex, const Params& params, int page);
+  // Page of a built section holding the element at path (see DomPosition::parseXPath), -1 if unknown
+  static int findPage(const std::shared_ptr<Epub>& epub, int spineIndex, const Params& params,
+                      const std::vector<DomPosition::Step>& path);
+  // Page of a built section holding a text offset reported by HtmlTextScanner, -1 if the section isn't built
+  static int findTextPage(const std::shared_ptr<Epub>& epub, int spineIndex, const Params& params,
+                          uint32_t textOffset);
 };
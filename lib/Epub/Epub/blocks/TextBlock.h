@@ -28,6 +28,12 @@ class TextBlock final : public Block {
   void setBlockStyle(const BlockStyle& blockStyle) { this->blockStyle = blockStyle; }
   const BlockStyle& getBlockStyle() const { return blockStyle; }
   bool isEmpty() override { return words.empty(); }
+  // Bytes of the words on the line, which follow the chapter's text apart from hyphens added at breaks
+  size_t textSize() const {
+    size_t size = 0;
+    for (const auto& word : words) size += word.size();
+    return size;
+  }
   void layout(GfxRenderer& renderer) override {};
   // given a renderer works out where to break the words into lines
   void render(const GfxRenderer& renderer, int fontId, int x, int y) const;
@@ -4,139 +4,80 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstring>
+#include <new>
 
 namespace {
 
 // Buffer size for reading CSS files
 constexpr size_t READ_BUFFER_SIZE = 512;
 
-// Maximum CSS file size we'll process (prevent memory issues)
-constexpr size_t MAX_CSS_SIZE = 64 * 1024;
+// Interned names are stored with a one byte length in the cache file
+constexpr size_t MAX_NAME_LENGTH = 255;
 
 // Check if character is CSS whitespace
 bool isCssWhitespace(const char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f'; }
 
-// Read entire file into string (with size limit)
-std::string readFileContent(FsFile& file) {
-  std::string content;
-  content.reserve(std::min(static_cast<size_t>(file.size()), MAX_CSS_SIZE));
+// Tag names in simple selectors: letters, digits, '-' and '_'
+bool isTagNameChar(const char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_'; }
 
-  char buffer[READ_BUFFER_SIZE];
-  while (file.available() && content.size() < MAX_CSS_SIZE) {
-    const int bytesRead = file.read(buffer, sizeof(buffer));
-    if (bytesRead <= 0) break;
-    content.append(buffer, bytesRead);
-  }
-  return content;
-}
-
-// Remove CSS comments (/* ... */) from content
-std::string stripComments(const std::string& css) {
-  std::string result;
-  result.reserve(css.size());
-
-  size_t pos = 0;
-  while (pos < css.size()) {
-    // Look for start of comment
-    if (pos + 1 < css.size() && css[pos] == '/' && css[pos + 1] == '*') {
-      // Find end of comment
-      const size_t endPos = css.find("*/", pos + 2);
-      if (endPos == std::string::npos) {
-        // Unterminated comment - skip rest of file
-        break;
-      }
-      pos = endPos + 2;
-    } else {
-      result.push_back(css[pos]);
-      ++pos;
-    }
-  }
-  return result;
+// Anything that would make a class part more than a single class name (another class, id, pseudo-class,
+// attribute, combinator...)
+bool isClassNameChar(const char c) {
+  return c != '\0' && !isCssWhitespace(c) && std::strchr(".#:[>+~*()", c) == nullptr;
 }
 
-// Skip @-rules (like @media, @import, @font-face)
-// Returns position after the @-rule
-size_t skipAtRule(const std::string& css, const size_t start) {
-  // Find the end - either semicolon (simple @-rule) or matching brace
-  size_t pos = start + 1;  // Skip the '@'
-
-  // Skip identifier
-  while (pos < css.size() && (std::isalnum(css[pos]) || css[pos] == '-')) {
-    ++pos;
-  }
-
-  // Look for { or ;
-  int braceDepth = 0;
-  while (pos < css.size()) {
-    const char c = css[pos];
-    if (c == '{') {
-      ++braceDepth;
-    } else if (c == '}') {
-      --braceDepth;
-      if (braceDepth == 0) {
-        return pos + 1;
-      }
-    } else if (c == ';' && braceDepth == 0) {
-      return pos + 1;
-    }
-    ++pos;
+// One "tag", ".class" or "tag.class" part of a selector
+struct SelectorPart {
+  std::string tag;
+  std::string className;
+  bool childAfter = false;  // followed by '>' rather than whitespace
+};
+
+bool parseSelectorPart(const std::string& text, SelectorPart& part) {
+  const size_t dotPos = text.find('.');
+  const size_t tagEnd = dotPos == std::string::npos ? text.size() : dotPos;
+  if (!std::all_of(text.begin(), text.begin() + tagEnd, isTagNameChar)) return false;
+  if (dotPos != std::string::npos &&
+      (dotPos + 1 == text.size() || !std::all_of(text.begin() + dotPos + 1, text.end(), isClassNameChar))) {
+    return false;
   }
-  return css.size();
+  if (tagEnd == 0 && dotPos == std::string::npos) return false;
+  if (tagEnd > MAX_NAME_LENGTH || text.size() - tagEnd > MAX_NAME_LENGTH) return false;
+  part.tag = text.substr(0, tagEnd);
+  part.className = dotPos == std::string::npos ? std::string() : text.substr(dotPos + 1);
+  return true;
 }
 
-// Extract next rule from CSS content
-// Returns true if a rule was found, with selector and body filled
-bool extractNextRule(const std::string& css, size_t& pos, std::string& selector, std::string& body) {
-  selector.clear();
-  body.clear();
-
-  // Skip whitespace and @-rules until we find a regular rule
-  while (pos < css.size()) {
-    // Skip whitespace
-    while (pos < css.size() && isCssWhitespace(css[pos])) {
+// Split a normalized selector into its parts, outermost first. Anything other than parts joined by whitespace or
+// '>' fails, sibling combinators end up inside a part and are rejected there. A trailing '>' is kept on the last part.
+bool splitSelector(const std::string& selector, std::vector<SelectorPart>& parts) {
+  parts.clear();
+  size_t pos = 0;
+  while (pos < selector.size()) {
+    if (selector[pos] == ' ') {
       ++pos;
+    } else if (selector[pos] == '>') {
+      if (parts.empty() || parts.back().childAfter) return false;
+      parts.back().childAfter = true;
+      ++pos;
+    } else {
+      const size_t start = pos;
+      while (pos < selector.size() && selector[pos] != ' ' && selector[pos] != '>') ++pos;
+      parts.emplace_back();
+      if (!parseSelectorPart(selector.substr(start, pos - start), parts.back())) return false;
     }
-
-    if (pos >= css.size()) return false;
-
-    // Handle @-rules iteratively (avoids recursion/stack overflow)
-    if (css[pos] == '@') {
-      pos = skipAtRule(css, pos);
-      continue;  // Try again after skipping the @-rule
-    }
-
-    break;  // Found start of a regular rule
-  }
-
-  if (pos >= css.size()) return false;
-
-  // Find opening brace
-  const size_t bracePos = css.find('{', pos);
-  if (bracePos == std::string::npos) return false;
-
-  // Extract selector (everything before the brace)
-  selector = css.substr(pos, bracePos - pos);
-
-  // Find matching closing brace
-  int depth = 1;
-  const size_t bodyStart = bracePos + 1;
-  size_t bodyEnd = bodyStart;
-
-  while (bodyEnd < css.size() && depth > 0) {
-    if (css[bodyEnd] == '{')
-      ++depth;
-    else if (css[bodyEnd] == '}')
-      --depth;
-    ++bodyEnd;
   }
+  return !parts.empty();
+}
 
-  // Extract body (between braces)
-  if (bodyEnd > bodyStart) {
-    body = css.substr(bodyStart, bodyEnd - bodyStart - 1);
+void appendSelectorPart(std::string& out, const std::string& tag, const std::string& className, const bool child) {
+  out += tag;
+  if (!className.empty()) {
+    out += '.';
+    out += className;
   }
-
-  pos = bodyEnd;
-  return true;
+  out += child ? " > " : " ";
 }
 
 }  // anonymous namespace
@@ -419,7 +360,8 @@ CssStyle CssParser::parseDeclarations(const std::string& declBlock) {
 
 // Rule processing
 
-void CssParser::processRuleBlock(const std::string& selectorGroup, const std::string& declarations) {
+void CssParser::processRuleBlock(const std::string& selectorGroup, const std::string& declarations,
+                                 std::vector<ParsedRule>& out) {
   const CssStyle style = parseDeclarations(declarations);
 
   // Only store if any properties were set
@@ -428,19 +370,300 @@ void CssParser::processRuleBlock(const std::string& selectorGroup, const std::st
   // Handle comma-separated selectors
   const auto selectors = splitOnChar(selectorGroup, ',');
 
+  std::vector<SelectorPart> parts;
   for (const auto& sel : selectors) {
     // Normalize the selector
-    std::string key = normalized(sel);
+    const std::string key = normalized(sel);
     if (key.empty()) continue;
 
-    // Store or merge with existing
-    auto it = rulesBySelector_.find(key);
-    if (it != rulesBySelector_.end()) {
-      it->second.applyOver(style);
+    // Only parts that can ever match are kept, anything else drops the whole selector here
+    if (!splitSelector(key, parts) || parts.back().childAfter || parts.size() > MAX_CONTEXT_STEPS + 1) continue;
+
+    std::string context;
+    for (size_t i = 0; i + 1 < parts.size(); ++i) {
+      appendSelectorPart(context, parts[i].tag, parts[i].className, parts[i].childAfter);
+    }
+    out.push_back({std::move(parts.back().tag), std::move(parts.back().className), std::move(context), style});
+  }
+}
+
+// Selector index
+
+void CssParser::clear() {
+  namePool_.clear();
+  nameOffsets_.clear();
+  rules_.clear();
+  contextRules_.clear();
+  contextSteps_.clear();
+  contextSubjects_.clear();
+  memo_.reset();
+}
+
+int CssParser::compareSelectors(const PendingRule& a, const PendingRule& b, const ContextStep* steps) {
+  if (a.tagId != b.tagId) return a.tagId < b.tagId ? -1 : 1;
+  if (a.classId != b.classId) return a.classId < b.classId ? -1 : 1;
+  for (size_t i = 0; i < a.stepCount && i < b.stepCount; ++i) {
+    const ContextStep& stepA = steps[a.firstStep + i];
+    const ContextStep& stepB = steps[b.firstStep + i];
+    if (stepA.tagId != stepB.tagId) return stepA.tagId < stepB.tagId ? -1 : 1;
+    if (stepA.classId != stepB.classId) return stepA.classId < stepB.classId ? -1 : 1;
+    if (stepA.child != stepB.child) return stepA.child ? 1 : -1;
+  }
+  return a.stepCount != b.stepCount ? (a.stepCount < b.stepCount ? -1 : 1) : 0;
+}
+
+void CssParser::mergeRepeated(std::vector<PendingRule>& rules, std::vector<ContextStep>& steps) {
+  // Orders are unique, so repeats end up next to each other in source order without a stable sort's buffer
+  std::sort(rules.begin(), rules.end(), [&steps](const PendingRule& a, const PendingRule& b) {
+    const int cmp = compareSelectors(a, b, steps.data());
+    return cmp != 0 ? cmp < 0 : a.order < b.order;
+  });
+
+  // A merged rule takes the position of its last occurrence
+  size_t merged = 0;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    if (merged > 0 && compareSelectors(rules[merged - 1], rules[i], steps.data()) == 0) {
+      rules[merged - 1].style.applyOver(rules[i].style);
+      rules[merged - 1].order = rules[i].order;
+    } else {
+      if (merged != i) rules[merged] = rules[i];
+      ++merged;
+    }
+  }
+  rules.resize(merged);
+
+  std::vector<ContextStep> kept;
+  kept.reserve(steps.size());
+  for (auto& rule : rules) {
+    const uint32_t firstStep = static_cast<uint32_t>(kept.size());
+    kept.insert(kept.end(), steps.begin() + rule.firstStep, steps.begin() + rule.firstStep + rule.stepCount);
+    rule.firstStep = firstStep;
+  }
+  kept.shrink_to_fit();
+  steps.swap(kept);
+}
+
+void CssParser::mergeIndex(const std::string& namePool, const std::vector<uint32_t>& nameOffsets,
+                           std::vector<PendingRule>& added, std::vector<ContextStep>& addedSteps) {
+  // Names of the index and of the added rules, sorted and without repeats
+  std::vector<const char*> names;
+  names.reserve(nameOffsets_.size() + nameOffsets.size());
+  for (const uint32_t offset : nameOffsets_) names.push_back(namePool_.c_str() + offset);
+  for (const uint32_t offset : nameOffsets) names.push_back(namePool.c_str() + offset);
+  auto nameLess = [](const char* a, const char* b) { return strcmp(a, b) < 0; };
+  std::sort(names.begin(), names.end(), nameLess);
+  names.erase(std::unique(names.begin(), names.end(), [](const char* a, const char* b) { return strcmp(a, b) == 0; }),
+              names.end());
+  if (names.size() >= NO_NAME) {
+    Serial.printf("[%lu] [CSS] Too many selector names (%zu), dropping the rest\n", millis(), names.size());
+    names.resize(NO_NAME - 1);
+  }
+
+  // New IDs of the index's names and of the added ones, NO_NAME for names dropped above
+  auto idOf = [&names, &nameLess](const char* name) -> uint16_t {
+    const auto it = std::lower_bound(names.begin(), names.end(), name, nameLess);
+    return it != names.end() && strcmp(*it, name) == 0 ? static_cast<uint16_t>(it - names.begin()) : NO_NAME;
+  };
+  std::vector<uint16_t> indexIds(nameOffsets_.size());
+  for (size_t i = 0; i < indexIds.size(); ++i) indexIds[i] = idOf(nameOf(static_cast<uint16_t>(i)));
+  std::vector<uint16_t> addedIds(nameOffsets.size());
+  for (size_t i = 0; i < addedIds.size(); ++i) addedIds[i] = idOf(namePool.c_str() + nameOffsets[i]);
+
+  // A name that got dropped would otherwise turn "tag.class" into a broader selector
+  auto remap = [](const std::vector<uint16_t>& ids, const uint16_t id, uint16_t& out) {
+    out = id == NO_NAME ? NO_NAME : ids[id];
+    return (out == NO_NAME) == (id == NO_NAME);
+  };
+
+  // The added rules are remapped where they are, and the index's rules join them so nothing is held twice. Rules
+  // already in the index come from earlier stylesheets, so they go first and later rules override them.
+  auto remapRule = [&remap](const std::vector<uint16_t>& ids, PendingRule& rule, ContextStep* steps) {
+    bool valid = remap(ids, rule.tagId, rule.tagId) && remap(ids, rule.classId, rule.classId);
+    for (size_t i = 0; i < rule.stepCount && valid; ++i) {
+      ContextStep& step = steps[rule.firstStep + i];
+      valid = remap(ids, step.tagId, step.tagId) && remap(ids, step.classId, step.classId);
+    }
+    return valid;
+  };
+  const uint32_t addedBase = static_cast<uint32_t>(rules_.size() + contextRules_.size());
+  size_t kept = 0;
+  for (auto& rule : added) {
+    if (!remapRule(addedIds, rule, addedSteps.data())) continue;
+    rule.order += addedBase;
+    added[kept++] = rule;
+  }
+  added.resize(kept);
+
+  added.reserve(added.size() + addedBase);
+  uint32_t order = 0;
+  for (const auto& rule : rules_) {
+    PendingRule pending{rule.tagId, rule.classId, 0, 0, order++, rule.style};
+    if (remapRule(indexIds, pending, nullptr)) added.push_back(pending);
+  }
+  const uint32_t contextBase = order;
+  for (const auto& rule : contextRules_) {
+    PendingRule pending{rule.tagId, rule.classId, static_cast<uint32_t>(addedSteps.size()), rule.stepCount,
+                        contextBase + rule.order, rule.style};
+    addedSteps.insert(addedSteps.end(), contextSteps_.begin() + rule.firstStep,
+                      contextSteps_.begin() + rule.firstStep + rule.stepCount);
+    if (remapRule(indexIds, pending, addedSteps.data())) added.push_back(pending);
+  }
+  rules_ = std::vector<Rule>();
+  contextRules_ = std::vector<ContextRule>();
+  contextSteps_ = std::vector<ContextStep>();
+  mergeRepeated(added, addedSteps);
+
+  std::string pool;
+  std::vector<uint32_t> offsets;
+  offsets.reserve(names.size());
+  for (const char* name : names) {
+    offsets.push_back(static_cast<uint32_t>(pool.size()));
+    pool.append(name);
+    pool.push_back('\0');
+  }
+
+  // Context rules are ranked by source order, renumbered so the rank fits in 16 bits
+  std::vector<uint32_t> contextOrder;
+  for (uint32_t i = 0; i < added.size(); ++i) {
+    if (added[i].stepCount > 0) contextOrder.push_back(i);
+  }
+  std::sort(contextOrder.begin(), contextOrder.end(),
+            [&added](const uint32_t a, const uint32_t b) { return added[a].order < added[b].order; });
+  for (size_t rank = 0; rank < contextOrder.size(); ++rank) {
+    added[contextOrder[rank]].order = static_cast<uint32_t>(rank);
+  }
+
+  std::vector<Rule> rules;
+  std::vector<ContextRule> contextRules;
+  rules.reserve(added.size() - contextOrder.size());
+  contextRules.reserve(contextOrder.size());
+  contextSteps_.reserve(addedSteps.size());
+  for (const auto& rule : added) {
+    if (rule.stepCount == 0) {
+      rules.push_back({rule.tagId, rule.classId, rule.style});
+      continue;
+    }
+    if (contextSteps_.size() + rule.stepCount > UINT16_MAX || rule.order > UINT16_MAX) {
+      continue;
+    }
+    ContextRule contextRule{};
+    contextRule.tagId = rule.tagId;
+    contextRule.classId = rule.classId;
+    contextRule.firstStep = static_cast<uint16_t>(contextSteps_.size());
+    contextRule.stepCount = rule.stepCount;
+    contextRule.order = static_cast<uint16_t>(rule.order);
+    contextRule.style = rule.style;
+    contextSteps_.insert(contextSteps_.end(), addedSteps.begin() + rule.firstStep,
+                         addedSteps.begin() + rule.firstStep + rule.stepCount);
+    finishContextRule(contextRule);
+    contextRules.push_back(contextRule);
+  }
+
+  namePool_.swap(pool);
+  nameOffsets_.swap(offsets);
+  // Sorting by selector has already put the simple rules in (tag, class) order
+  rules_.swap(rules);
+  std::sort(contextRules.begin(), contextRules.end(), [](const ContextRule& a, const ContextRule& b) {
+    if (a.tagId != b.tagId) return a.tagId < b.tagId;
+    return a.classId != b.classId ? a.classId < b.classId : a.order < b.order;
+  });
+  contextRules_.swap(contextRules);
+  indexContextSubjects();
+  memo_.reset();
+}
+
+void CssParser::finishContextRule(ContextRule& rule) const {
+  auto specificityOf = [](const uint16_t tagId, const uint16_t classId) {
+    return (tagId != NO_NAME ? 1 : 0) + (classId != NO_NAME ? 256 : 0);
+  };
+  int specificity = specificityOf(rule.tagId, rule.classId);
+  rule.filterSlotCount = 0;
+  auto addSlot = [&rule](const uint8_t slot) {
+    if (rule.filterSlotCount < MAX_FILTER_SLOTS &&
+        std::find(rule.filterSlots, rule.filterSlots + rule.filterSlotCount, slot) ==
+            rule.filterSlots + rule.filterSlotCount) {
+      rule.filterSlots[rule.filterSlotCount++] = slot;
+    }
+  };
+  // Outermost steps first, they tend to be the rarer elements (div.chapter rather than p)
+  for (size_t i = rule.stepCount; i-- > 0;) {
+    const ContextStep& step = contextSteps_[rule.firstStep + i];
+    specificity += specificityOf(step.tagId, step.classId);
+    if (step.classId != NO_NAME) addSlot(AncestorStack::filterSlot(step.classId, true));
+    if (step.tagId != NO_NAME) addSlot(AncestorStack::filterSlot(step.tagId, false));
+  }
+  rule.specificity = static_cast<uint16_t>(specificity);
+}
+
+void CssParser::indexContextSubjects() {
+  contextSubjects_.assign(nameOffsets_.size(), false);
+  for (const auto& rule : contextRules_) {
+    if (rule.tagId != NO_NAME) contextSubjects_[rule.tagId] = true;
+    if (rule.classId != NO_NAME) contextSubjects_[rule.classId] = true;
+  }
+}
+
+uint16_t CssParser::findName(const char* name, const size_t length) const {
+  // Names are stored lowercase, the probe is lowered on the fly so lookups never allocate
+  size_t low = 0;
+  size_t high = nameOffsets_.size();
+  while (low < high) {
+    const size_t mid = (low + high) / 2;
+    const char* candidate = namePool_.c_str() + nameOffsets_[mid];
+    int cmp = 0;
+    size_t i = 0;
+    for (; i < length; ++i) {
+      auto probe = static_cast<unsigned char>(name[i]);
+      if (probe >= 'A' && probe <= 'Z') probe += 'a' - 'A';
+      const auto stored = static_cast<unsigned char>(candidate[i]);
+      if (probe != stored) {
+        cmp = probe < stored ? -1 : 1;  // also covers the candidate ending first, '\0' sorts before everything
+        break;
+      }
+    }
+    if (cmp == 0 && candidate[i] != '\0') {
+      cmp = -1;  // probe is a prefix of the candidate
+    }
+    if (cmp == 0) {
+      return static_cast<uint16_t>(mid);
+    }
+    if (cmp < 0) {
+      high = mid;
     } else {
-      rulesBySelector_[key] = style;
+      low = mid + 1;
     }
   }
+  return NO_NAME;
+}
+
+const CssStyle* CssParser::findRule(const uint16_t tagId, const uint16_t classId) const {
+  const auto it = std::lower_bound(rules_.begin(), rules_.end(), std::make_pair(tagId, classId),
+                                   [](const Rule& rule, const std::pair<uint16_t, uint16_t>& key) {
+                                     return rule.tagId != key.first ? rule.tagId < key.first
+                                                                    : rule.classId < key.second;
+                                   });
+  return it != rules_.end() && it->tagId == tagId && it->classId == classId ? &it->style : nullptr;
+}
+
+template <typename Fn>
+void CssParser::forEachContextRule(const uint16_t tagId, const uint16_t classId, Fn&& fn) const {
+  auto it = std::lower_bound(contextRules_.begin(), contextRules_.end(), std::make_pair(tagId, classId),
+                             [](const ContextRule& rule, const std::pair<uint16_t, uint16_t>& key) {
+                               return rule.tagId != key.first ? rule.tagId < key.first : rule.classId < key.second;
+                             });
+  for (; it != contextRules_.end() && it->tagId == tagId && it->classId == classId; ++it) {
+    fn(*it);
+  }
+}
+
+bool CssParser::hasContextRules(const ElementKey& element) const {
+  // Conservative, "div.x p" and ".y" mark p and y without any rule ending in p.y
+  if (contextRules_.empty()) return false;
+  if (element.tagId != NO_NAME && contextSubjects_[element.tagId]) return true;
+  for (size_t i = 0; i < element.classCount; ++i) {
+    if (contextSubjects_[element.classIds[i]]) return true;
+  }
+  return false;
 }
 
 // Main parsing entry point
@@ -451,66 +674,407 @@ bool CssParser::loadFromStream(FsFile& source) {
     return false;
   }
 
-  // Read file content
-  const std::string content = readFileContent(source);
-  if (content.empty()) {
-    return true;  // Empty file is valid
+  StreamLoader loader(*this);
+  uint8_t buffer[READ_BUFFER_SIZE];
+  while (source.available()) {
+    const int bytesRead = source.read(buffer, sizeof(buffer));
+    if (bytesRead <= 0) break;
+    loader.write(buffer, static_cast<size_t>(bytesRead));
   }
+  loader.finish();
+  return true;
+}
 
-  // Remove comments
-  const std::string cleaned = stripComments(content);
+// Incremental tokenizer
 
-  // Parse rules
-  size_t pos = 0;
-  std::string selector, body;
+size_t CssParser::StreamLoader::write(const uint8_t c) { return write(&c, 1); }
+
+size_t CssParser::StreamLoader::write(const uint8_t* buffer, const size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    const char c = static_cast<char>(buffer[i]);
+
+    // Strip comments before tokenizing, a comment can straddle two chunks
+    if (inComment) {
+      if (pendingStar && c == '/') {
+        inComment = false;
+        pendingStar = false;
+      } else {
+        pendingStar = c == '*';
+      }
+      continue;
+    }
+    if (pendingSlash) {
+      pendingSlash = false;
+      if (c == '*') {
+        inComment = true;
+        continue;
+      }
+      consume('/');
+    }
+    if (c == '/') {
+      pendingSlash = true;
+      continue;
+    }
+    consume(c);
+  }
+  return size;
+}
 
-  while (extractNextRule(cleaned, pos, selector, body)) {
-    processRuleBlock(selector, body);
+void CssParser::StreamLoader::consume(const char c) {
+  switch (state) {
+    case BETWEEN_RULES:
+      if (isCssWhitespace(c)) {
+        return;
+      }
+      if (c == '@') {
+        // @media, @font-face, @import... are skipped along with their blocks
+        state = IN_AT_RULE;
+        braceDepth = 0;
+        return;
+      }
+      state = IN_SELECTOR;
+      [[fallthrough]];
+    case IN_SELECTOR:
+      if (c == '{') {
+        state = IN_BODY;
+        braceDepth = 1;
+      } else if (selector.size() < MAX_RULE_SIZE) {
+        selector.push_back(c);
+      } else {
+        oversized = true;
+      }
+      return;
+    case IN_BODY:
+      if (c == '{') {
+        ++braceDepth;
+      } else if (c == '}' && --braceDepth == 0) {
+        endRule();
+        return;
+      }
+      if (body.size() < MAX_RULE_SIZE) {
+        body.push_back(c);
+      } else {
+        oversized = true;
+      }
+      return;
+    case IN_AT_RULE:
+      if (c == '{') {
+        ++braceDepth;
+      } else if (c == '}') {
+        if (--braceDepth == 0) {
+          state = BETWEEN_RULES;
+        }
+      } else if (c == ';' && braceDepth == 0) {
+        state = BETWEEN_RULES;
+      }
+      return;
   }
+}
 
-  Serial.printf("[%lu] [CSS] Parsed %zu rules\n", millis(), rulesBySelector_.size());
+void CssParser::StreamLoader::endRule() {
+  if (oversized) {
+    ++droppedRules;
+  } else {
+    processRuleBlock(selector, body, blockRules);
+    for (const auto& parsed : blockRules) addRule(parsed);
+    blockRules.clear();
+  }
+  selector.clear();
+  body.clear();
+  oversized = false;
+  state = BETWEEN_RULES;
+}
+
+bool CssParser::StreamLoader::intern(const std::string& name, uint16_t& id) {
+  if (name.empty()) {
+    id = NO_NAME;
+    return true;
+  }
+  const auto it = std::lower_bound(sortedNames.begin(), sortedNames.end(), name,
+                                   [this](const uint16_t nameId, const std::string& probe) {
+                                     return strcmp(namePool.c_str() + nameOffsets[nameId], probe.c_str()) < 0;
+                                   });
+  if (it != sortedNames.end() && name == namePool.c_str() + nameOffsets[*it]) {
+    id = *it;
+    return true;
+  }
+  if (nameOffsets.size() >= NO_NAME - 1) {
+    return false;
+  }
+  id = static_cast<uint16_t>(nameOffsets.size());
+  nameOffsets.push_back(static_cast<uint32_t>(namePool.size()));
+  namePool.append(name);
+  namePool.push_back('\0');
+  sortedNames.insert(it, id);
   return true;
 }
 
+void CssParser::StreamLoader::addRule(const ParsedRule& parsed) {
+  std::vector<SelectorPart> parts;
+  if (!parsed.context.empty() && !splitSelector(parsed.context, parts)) {
+    return;
+  }
+
+  PendingRule rule{};
+  rule.firstStep = static_cast<uint32_t>(steps.size());
+  rule.stepCount = static_cast<uint8_t>(parts.size());
+  rule.order = nextOrder;
+  rule.style = parsed.style;
+  bool valid = intern(parsed.tag, rule.tagId) && intern(parsed.className, rule.classId);
+  // Steps are stored nearest ancestor first, the order they are matched in
+  for (size_t i = parts.size(); i-- > 0 && valid;) {
+    ContextStep step{};
+    step.child = parts[i].childAfter;
+    valid = intern(parts[i].tag, step.tagId) && intern(parts[i].className, step.classId);
+    steps.push_back(step);
+  }
+  if (!valid) {
+    steps.resize(rule.firstStep);
+    ++droppedRules;
+    return;
+  }
+  ++nextOrder;
+
+  // A selector read before is merged into its rule straight away
+  const auto merged = rules.begin() + static_cast<std::ptrdiff_t>(mergedCount);
+  const auto it = std::lower_bound(rules.begin(), merged, rule, [this](const PendingRule& a, const PendingRule& b) {
+    return compareSelectors(a, b, steps.data()) < 0;
+  });
+  if (it != merged && compareSelectors(*it, rule, steps.data()) == 0) {
+    it->style.applyOver(rule.style);
+    it->order = rule.order;
+    steps.resize(rule.firstStep);
+    return;
+  }
+
+  rules.push_back(rule);
+  if (rules.size() - mergedCount >= MERGE_BATCH) {
+    mergeBatch();
+  }
+}
+
+void CssParser::StreamLoader::mergeBatch() {
+  mergeRepeated(rules, steps);
+  mergedCount = rules.size();
+}
+
+void CssParser::StreamLoader::finish() {
+  if (pendingSlash) {
+    pendingSlash = false;
+    consume('/');
+  }
+  // A body cut off by the end of the file still counts, a selector without a body doesn't
+  if (state == IN_BODY) {
+    endRule();
+  }
+  selector.clear();
+  selector.shrink_to_fit();
+  body.clear();
+  body.shrink_to_fit();
+  state = BETWEEN_RULES;
+
+  if (droppedRules > 0) {
+    Serial.printf("[%lu] [CSS] Dropped %u rules longer than %u bytes or with too many names\n", millis(),
+                  droppedRules, static_cast<uint32_t>(MAX_RULE_SIZE));
+    droppedRules = 0;
+  }
+  parser.mergeIndex(namePool, nameOffsets, rules, steps);
+  Serial.printf("[%lu] [CSS] Parsed %zu rules\n", millis(), parser.ruleCount());
+
+  namePool = std::string();
+  nameOffsets = std::vector<uint32_t>();
+  sortedNames = std::vector<uint16_t>();
+  rules = std::vector<PendingRule>();
+  steps = std::vector<ContextStep>();
+  mergedCount = 0;
+  nextOrder = 0;
+}
+
 // Style resolution
 
-CssStyle CssParser::resolveStyle(const std::string& tagName, const std::string& classAttr) const {
+bool CssParser::ElementKey::operator==(const ElementKey& other) const {
+  return tagId == other.tagId && classCount == other.classCount &&
+         std::equal(classIds, classIds + classCount, other.classIds);
+}
+
+CssParser::ElementKey CssParser::elementKey(const char* tagName, const char* classAttr) const {
+  ElementKey key;
+  if (nameOffsets_.empty()) {
+    return key;
+  }
+  key.tagId = findName(tagName, strlen(tagName));
+  const char* pos = classAttr;
+  while (*pos != '\0' && key.classCount < MAX_ELEMENT_CLASSES) {
+    while (isCssWhitespace(*pos)) ++pos;
+    const char* start = pos;
+    while (*pos != '\0' && !isCssWhitespace(*pos)) ++pos;
+    if (pos > start) {
+      // Classes no selector mentions can't change the result
+      const uint16_t id = findName(start, static_cast<size_t>(pos - start));
+      if (id != NO_NAME) key.classIds[key.classCount++] = id;
+    }
+  }
+  return key;
+}
+
+CssStyle CssParser::resolveStyle(const char* tagName, const char* classAttr) const {
+  return resolveStyle(elementKey(tagName, classAttr), nullptr);
+}
+
+CssStyle CssParser::resolveSimple(const ElementKey& element) const {
   CssStyle result;
-  const std::string tag = normalized(tagName);
+  auto apply = [this, &result](const uint16_t ruleTag, const uint16_t ruleClass) {
+    if (const CssStyle* style = findRule(ruleTag, ruleClass)) {
+      result.applyOver(*style);
+    }
+  };
 
   // 1. Apply element-level style (lowest priority)
-  const auto tagIt = rulesBySelector_.find(tag);
-  if (tagIt != rulesBySelector_.end()) {
-    result.applyOver(tagIt->second);
+  if (element.tagId != NO_NAME) {
+    apply(element.tagId, NO_NAME);
+  }
+  // 2. Apply class styles (medium priority), then 3. element.class styles (higher priority)
+  for (size_t i = 0; i < element.classCount; ++i) apply(NO_NAME, element.classIds[i]);
+  if (element.tagId != NO_NAME) {
+    for (size_t i = 0; i < element.classCount; ++i) apply(element.tagId, element.classIds[i]);
   }
+  return result;
+}
 
-  // 2. Apply class styles (medium priority)
-  if (!classAttr.empty()) {
-    const auto classes = splitWhitespace(classAttr);
+bool CssParser::matchSteps(const ContextStep* steps, const size_t count, const AncestorStack& ancestors,
+                           const int position) const {
+  if (count == 0) return true;
+  const ContextStep& step = steps[0];
+  auto matches = [&step](const ElementKey& element) {
+    return (step.tagId == NO_NAME || element.tagId == step.tagId) &&
+           (step.classId == NO_NAME ||
+            std::find(element.classIds, element.classIds + element.classCount, step.classId) !=
+                element.classIds + element.classCount);
+  };
+  // "a > b" only looks at the parent, "a b" tries every ancestor and backtracks if the rest fails from there
+  for (int i = position; i >= 0; --i) {
+    if (matches(ancestors.at(i)) && matchSteps(steps + 1, count - 1, ancestors, i - 1)) return true;
+    if (step.child) break;
+  }
+  return false;
+}
 
-    for (const auto& cls : classes) {
-      std::string classKey = "." + normalized(cls);
+bool CssParser::matchesContext(const ContextRule& rule, const AncestorStack& ancestors) const {
+  if (ancestors.size() < rule.stepCount) return false;
+  for (uint8_t i = 0; i < rule.filterSlotCount; ++i) {
+    if (!ancestors.mayContain(rule.filterSlots[i])) return false;
+  }
+  return matchSteps(&contextSteps_[rule.firstStep], rule.stepCount, ancestors,
+                    static_cast<int>(ancestors.size()) - 1);
+}
 
-      auto classIt = rulesBySelector_.find(classKey);
-      if (classIt != rulesBySelector_.end()) {
-        result.applyOver(classIt->second);
-      }
-    }
+CssStyle CssParser::resolveStyle(const ElementKey& element, const AncestorStack* ancestors) const {
+  if (rules_.empty() && contextRules_.empty()) {
+    return CssStyle();
+  }
+
+  // Styles from simple selectors only depend on the element, so they are memoized along with whether any context
+  // rule could still change them
+  uint32_t hash = element.tagId * 2654435761u;
+  for (size_t i = 0; i < element.classCount; ++i) {
+    hash = (hash ^ element.classIds[i]) * 2654435761u;
+  }
+  if (!memo_) {
+    memo_.reset(new (std::nothrow) MemoEntry[MEMO_SIZE]);
+  }
+  if (!memo_) {
+    return resolveWithContext(element, resolveSimple(element), ancestors);
+  }
+  MemoEntry& entry = memo_[(hash >> 16) % MEMO_SIZE];
+  if (!entry.used || !(entry.key == element)) {
+    entry.used = true;
+    entry.key = element;
+    entry.style = resolveSimple(element);
+    entry.hasContextRules = hasContextRules(element);
+  }
+  if (!entry.hasContextRules) {
+    return entry.style;
+  }
+  return resolveWithContext(element, entry.style, ancestors);
+}
 
-    // 3. Apply element.class styles (higher priority)
-    for (const auto& cls : classes) {
-      std::string combinedKey = tag + "." + normalized(cls);
+CssStyle CssParser::resolveWithContext(const ElementKey& element, const CssStyle& simpleStyle,
+                                       const AncestorStack* ancestors) const {
+  if (ancestors == nullptr || ancestors->size() == 0 || !hasContextRules(element)) {
+    return simpleStyle;
+  }
 
-      auto combinedIt = rulesBySelector_.find(combinedKey);
-      if (combinedIt != rulesBySelector_.end()) {
-        result.applyOver(combinedIt->second);
-      }
-    }
+  // Context rules ending in this element that match the ancestors, applied by specificity and then source order
+  constexpr size_t MAX_MATCHED = 16;
+  const ContextRule* matched[MAX_MATCHED];
+  size_t matchedCount = 0;
+  auto collect = [&](const ContextRule& rule) {
+    if (matchedCount < MAX_MATCHED && matchesContext(rule, *ancestors)) matched[matchedCount++] = &rule;
+  };
+  const bool tagIsSubject = element.tagId != NO_NAME && contextSubjects_[element.tagId];
+  if (tagIsSubject) forEachContextRule(element.tagId, NO_NAME, collect);
+  for (size_t i = 0; i < element.classCount; ++i) {
+    if (!contextSubjects_[element.classIds[i]]) continue;
+    forEachContextRule(NO_NAME, element.classIds[i], collect);
+    if (tagIsSubject) forEachContextRule(element.tagId, element.classIds[i], collect);
   }
+  if (matchedCount == 0) {
+    return simpleStyle;
+  }
+  std::sort(matched, matched + matchedCount, [](const ContextRule* a, const ContextRule* b) {
+    return a->specificity != b->specificity ? a->specificity < b->specificity : a->order < b->order;
+  });
 
+  // Simple selectors have specificity 1 (tag), 256 (class) or 257 (tag.class). No context rule falls on 1 or 256,
+  // one that ties with tag.class is applied after it.
+  CssStyle result;
+  size_t next = 0;
+  if (element.tagId != NO_NAME) {
+    if (const CssStyle* style = findRule(element.tagId, NO_NAME)) result.applyOver(*style);
+  }
+  for (; next < matchedCount && matched[next]->specificity < 256; ++next) {
+    result.applyOver(matched[next]->style);
+  }
+  ElementKey withoutTag = element;
+  withoutTag.tagId = NO_NAME;
+  result.applyOver(resolveSimple(withoutTag));
+  if (element.tagId != NO_NAME) {
+    for (size_t i = 0; i < element.classCount; ++i) {
+      if (const CssStyle* style = findRule(element.tagId, element.classIds[i])) result.applyOver(*style);
+    }
+  }
+  for (; next < matchedCount; ++next) {
+    result.applyOver(matched[next]->style);
+  }
   return result;
 }
 
+// Ancestor stack
+
+uint8_t CssParser::AncestorStack::filterSlot(const uint16_t id, const bool isClass) {
+  // Fibonacci hashing, tags and classes with the same ID land in different slots
+  return static_cast<uint8_t>(((static_cast<uint32_t>(id) * 2 + (isClass ? 1 : 0)) * 2654435761u) >> 24);
+}
+
+void CssParser::AncestorStack::push(const ElementKey& element) {
+  entries.push_back(element);
+  if (element.tagId != NO_NAME) ++counts[filterSlot(element.tagId, false)];
+  for (size_t i = 0; i < element.classCount; ++i) ++counts[filterSlot(element.classIds[i], true)];
+}
+
+void CssParser::AncestorStack::pop() {
+  if (entries.empty()) return;
+  const ElementKey& element = entries.back();
+  if (element.tagId != NO_NAME) --counts[filterSlot(element.tagId, false)];
+  for (size_t i = 0; i < element.classCount; ++i) --counts[filterSlot(element.classIds[i], true)];
+  entries.pop_back();
+}
+
+void CssParser::AncestorStack::clear() {
+  entries.clear();
+  std::fill(std::begin(counts), std::end(counts), 0);
+}
+
 // Inline style parsing (static - doesn't need rule database)
 
 CssStyle CssParser::parseInlineStyle(const std::string& styleValue) { return parseDeclarations(styleValue); }
@@ -518,7 +1082,101 @@ CssStyle CssParser::parseInlineStyle(const std::string& styleValue) { return par
 // Cache serialization
 
 // Cache format version - increment when format changes
-constexpr uint8_t CSS_CACHE_VERSION = 1;
+constexpr uint8_t CSS_CACHE_VERSION = 3;
+
+namespace {
+
+void writeStyle(FsFile& file, const CssStyle& style) {
+  file.write(static_cast<uint8_t>(style.textAlign));
+  file.write(static_cast<uint8_t>(style.fontStyle));
+  file.write(static_cast<uint8_t>(style.fontWeight));
+  file.write(static_cast<uint8_t>(style.textDecoration));
+
+  // Write CssLength fields (value + unit)
+  auto writeLength = [&file](const CssLength& len) {
+    file.write(reinterpret_cast<const uint8_t*>(&len.value), sizeof(len.value));
+    file.write(static_cast<uint8_t>(len.unit));
+  };
+
+  writeLength(style.textIndent);
+  writeLength(style.marginTop);
+  writeLength(style.marginBottom);
+  writeLength(style.marginLeft);
+  writeLength(style.marginRight);
+  writeLength(style.paddingTop);
+  writeLength(style.paddingBottom);
+  writeLength(style.paddingLeft);
+  writeLength(style.paddingRight);
+
+  // Write defined flags as uint16_t
+  uint16_t definedBits = 0;
+  if (style.defined.textAlign) definedBits |= 1 << 0;
+  if (style.defined.fontStyle) definedBits |= 1 << 1;
+  if (style.defined.fontWeight) definedBits |= 1 << 2;
+  if (style.defined.textDecoration) definedBits |= 1 << 3;
+  if (style.defined.textIndent) definedBits |= 1 << 4;
+  if (style.defined.marginTop) definedBits |= 1 << 5;
+  if (style.defined.marginBottom) definedBits |= 1 << 6;
+  if (style.defined.marginLeft) definedBits |= 1 << 7;
+  if (style.defined.marginRight) definedBits |= 1 << 8;
+  if (style.defined.paddingTop) definedBits |= 1 << 9;
+  if (style.defined.paddingBottom) definedBits |= 1 << 10;
+  if (style.defined.paddingLeft) definedBits |= 1 << 11;
+  if (style.defined.paddingRight) definedBits |= 1 << 12;
+  file.write(reinterpret_cast<const uint8_t*>(&definedBits), sizeof(definedBits));
+}
+
+bool readStyle(FsFile& file, CssStyle& style) {
+  uint8_t enumVals[4];
+  if (file.read(enumVals, sizeof(enumVals)) != sizeof(enumVals)) {
+    return false;
+  }
+  style.textAlign = static_cast<CssTextAlign>(enumVals[0]);
+  style.fontStyle = static_cast<CssFontStyle>(enumVals[1]);
+  style.fontWeight = static_cast<CssFontWeight>(enumVals[2]);
+  style.textDecoration = static_cast<CssTextDecoration>(enumVals[3]);
+
+  // Read CssLength fields
+  auto readLength = [&file](CssLength& len) -> bool {
+    if (file.read(&len.value, sizeof(len.value)) != sizeof(len.value)) {
+      return false;
+    }
+    uint8_t unitVal;
+    if (file.read(&unitVal, 1) != 1) {
+      return false;
+    }
+    len.unit = static_cast<CssUnit>(unitVal);
+    return true;
+  };
+
+  if (!readLength(style.textIndent) || !readLength(style.marginTop) || !readLength(style.marginBottom) ||
+      !readLength(style.marginLeft) || !readLength(style.marginRight) || !readLength(style.paddingTop) ||
+      !readLength(style.paddingBottom) || !readLength(style.paddingLeft) || !readLength(style.paddingRight)) {
+    return false;
+  }
+
+  // Read defined flags
+  uint16_t definedBits = 0;
+  if (file.read(&definedBits, sizeof(definedBits)) != sizeof(definedBits)) {
+    return false;
+  }
+  style.defined.textAlign = (definedBits & 1 << 0) != 0;
+  style.defined.fontStyle = (definedBits & 1 << 1) != 0;
+  style.defined.fontWeight = (definedBits & 1 << 2) != 0;
+  style.defined.textDecoration = (definedBits & 1 << 3) != 0;
+  style.defined.textIndent = (definedBits & 1 << 4) != 0;
+  style.defined.marginTop = (definedBits & 1 << 5) != 0;
+  style.defined.marginBottom = (definedBits & 1 << 6) != 0;
+  style.defined.marginLeft = (definedBits & 1 << 7) != 0;
+  style.defined.marginRight = (definedBits & 1 << 8) != 0;
+  style.defined.paddingTop = (definedBits & 1 << 9) != 0;
+  style.defined.paddingBottom = (definedBits & 1 << 10) != 0;
+  style.defined.paddingLeft = (definedBits & 1 << 11) != 0;
+  style.defined.paddingRight = (definedBits & 1 << 12) != 0;
+  return true;
+}
+
+}  // anonymous namespace
 
 bool CssParser::saveToCache(FsFile& file) const {
   if (!file) {
@@ -528,59 +1186,45 @@ bool CssParser::saveToCache(FsFile& file) const {
   // Write version
   file.write(CSS_CACHE_VERSION);
 
-  // Write rule count
-  const auto ruleCount = static_cast<uint16_t>(rulesBySelector_.size());
+  // Write the name table in ID order (length-prefixed)
+  const auto nameCount = static_cast<uint16_t>(nameOffsets_.size());
+  file.write(reinterpret_cast<const uint8_t*>(&nameCount), sizeof(nameCount));
+  for (const uint32_t offset : nameOffsets_) {
+    const char* name = namePool_.c_str() + offset;
+    const auto nameLen = static_cast<uint8_t>(strlen(name));
+    file.write(nameLen);
+    file.write(reinterpret_cast<const uint8_t*>(name), nameLen);
+  }
+
+  // Write each rule: selector name IDs + CssStyle fields, already in lookup order
+  const auto ruleCount = static_cast<uint16_t>(rules_.size());
   file.write(reinterpret_cast<const uint8_t*>(&ruleCount), sizeof(ruleCount));
+  for (const auto& rule : rules_) {
+    file.write(reinterpret_cast<const uint8_t*>(&rule.tagId), sizeof(rule.tagId));
+    file.write(reinterpret_cast<const uint8_t*>(&rule.classId), sizeof(rule.classId));
+    writeStyle(file, rule.style);
+  }
+
+  // Context selectors: the shared step array, then the rules pointing into it
+  const auto stepCount = static_cast<uint16_t>(contextSteps_.size());
+  file.write(reinterpret_cast<const uint8_t*>(&stepCount), sizeof(stepCount));
+  for (const auto& step : contextSteps_) {
+    file.write(reinterpret_cast<const uint8_t*>(&step.tagId), sizeof(step.tagId));
+    file.write(reinterpret_cast<const uint8_t*>(&step.classId), sizeof(step.classId));
+    file.write(static_cast<uint8_t>(step.child ? 1 : 0));
+  }
+  const auto contextRuleCount = static_cast<uint16_t>(contextRules_.size());
+  file.write(reinterpret_cast<const uint8_t*>(&contextRuleCount), sizeof(contextRuleCount));
+  for (const auto& rule : contextRules_) {
+    file.write(reinterpret_cast<const uint8_t*>(&rule.tagId), sizeof(rule.tagId));
+    file.write(reinterpret_cast<const uint8_t*>(&rule.classId), sizeof(rule.classId));
+    file.write(reinterpret_cast<const uint8_t*>(&rule.firstStep), sizeof(rule.firstStep));
+    file.write(rule.stepCount);
+    file.write(reinterpret_cast<const uint8_t*>(&rule.order), sizeof(rule.order));
+    writeStyle(file, rule.style);
+  }
 
-  // Write each rule: selector string + CssStyle fields
-  for (const auto& pair : rulesBySelector_) {
-    // Write selector string (length-prefixed)
-    const auto selectorLen = static_cast<uint16_t>(pair.first.size());
-    file.write(reinterpret_cast<const uint8_t*>(&selectorLen), sizeof(selectorLen));
-    file.write(reinterpret_cast<const uint8_t*>(pair.first.data()), selectorLen);
-
-    // Write CssStyle fields (all are POD types)
-    const CssStyle& style = pair.second;
-    file.write(static_cast<uint8_t>(style.textAlign));
-    file.write(static_cast<uint8_t>(style.fontStyle));
-    file.write(static_cast<uint8_t>(style.fontWeight));
-    file.write(static_cast<uint8_t>(style.textDecoration));
-
-    // Write CssLength fields (value + unit)
-    auto writeLength = [&file](const CssLength& len) {
-      file.write(reinterpret_cast<const uint8_t*>(&len.value), sizeof(len.value));
-      file.write(static_cast<uint8_t>(len.unit));
-    };
-
-    writeLength(style.textIndent);
-    writeLength(style.marginTop);
-    writeLength(style.marginBottom);
-    writeLength(style.marginLeft);
-    writeLength(style.marginRight);
-    writeLength(style.paddingTop);
-    writeLength(style.paddingBottom);
-    writeLength(style.paddingLeft);
-    writeLength(style.paddingRight);
-
-    // Write defined flags as uint16_t
-    uint16_t definedBits = 0;
-    if (style.defined.textAlign) definedBits |= 1 << 0;
-    if (style.defined.fontStyle) definedBits |= 1 << 1;
-    if (style.defined.fontWeight) definedBits |= 1 << 2;
-    if (style.defined.textDecoration) definedBits |= 1 << 3;
-    if (style.defined.textIndent) definedBits |= 1 << 4;
-    if (style.defined.marginTop) definedBits |= 1 << 5;
-    if (style.defined.marginBottom) definedBits |= 1 << 6;
-    if (style.defined.marginLeft) definedBits |= 1 << 7;
-    if (style.defined.marginRight) definedBits |= 1 << 8;
-    if (style.defined.paddingTop) definedBits |= 1 << 9;
-    if (style.defined.paddingBottom) definedBits |= 1 << 10;
-    if (style.defined.paddingLeft) definedBits |= 1 << 11;
-    if (style.defined.paddingRight) definedBits |= 1 << 12;
-    file.write(reinterpret_cast<const uint8_t*>(&definedBits), sizeof(definedBits));
-  }
-
-  Serial.printf("[%lu] [CSS] Saved %u rules to cache\n", millis(), ruleCount);
+  Serial.printf("[%lu] [CSS] Saved %u rules to cache\n", millis(), ruleCount + contextRuleCount);
   return true;
 }
 
@@ -599,99 +1243,111 @@ bool CssParser::loadFromCache(FsFile& file) {
     return false;
   }
 
-  // Read rule count
-  uint16_t ruleCount = 0;
-  if (file.read(&ruleCount, sizeof(ruleCount)) != sizeof(ruleCount)) {
+  // Read the name table, which must already be sorted for lookups to work
+  uint16_t nameCount = 0;
+  if (file.read(&nameCount, sizeof(nameCount)) != sizeof(nameCount) || nameCount == NO_NAME) {
     return false;
   }
-
-  // Read each rule
-  for (uint16_t i = 0; i < ruleCount; ++i) {
-    // Read selector string
-    uint16_t selectorLen = 0;
-    if (file.read(&selectorLen, sizeof(selectorLen)) != sizeof(selectorLen)) {
-      rulesBySelector_.clear();
+  nameOffsets_.reserve(nameCount);
+  for (uint16_t i = 0; i < nameCount; ++i) {
+    uint8_t nameLen = 0;
+    if (file.read(&nameLen, 1) != 1 || nameLen == 0) {
+      clear();
       return false;
     }
-
-    std::string selector;
-    selector.resize(selectorLen);
-    if (file.read(&selector[0], selectorLen) != selectorLen) {
-      rulesBySelector_.clear();
+    const auto offset = static_cast<uint32_t>(namePool_.size());
+    namePool_.resize(offset + nameLen + 1);
+    if (file.read(&namePool_[offset], nameLen) != nameLen) {
+      clear();
       return false;
     }
-
-    // Read CssStyle fields
-    CssStyle style;
-    uint8_t enumVal;
-
-    if (file.read(&enumVal, 1) != 1) {
-      rulesBySelector_.clear();
+    if (!nameOffsets_.empty() && strcmp(namePool_.c_str() + nameOffsets_.back(), namePool_.c_str() + offset) >= 0) {
+      clear();
       return false;
     }
-    style.textAlign = static_cast<CssTextAlign>(enumVal);
+    nameOffsets_.push_back(offset);
+  }
 
-    if (file.read(&enumVal, 1) != 1) {
-      rulesBySelector_.clear();
+  // Read each rule
+  uint16_t ruleCount = 0;
+  if (file.read(&ruleCount, sizeof(ruleCount)) != sizeof(ruleCount)) {
+    clear();
+    return false;
+  }
+  rules_.reserve(ruleCount);
+  for (uint16_t i = 0; i < ruleCount; ++i) {
+    Rule rule{};
+    if (file.read(&rule.tagId, sizeof(rule.tagId)) != sizeof(rule.tagId) ||
+        file.read(&rule.classId, sizeof(rule.classId)) != sizeof(rule.classId) || !readStyle(file, rule.style)) {
+      clear();
       return false;
     }
-    style.fontStyle = static_cast<CssFontStyle>(enumVal);
-
-    if (file.read(&enumVal, 1) != 1) {
-      rulesBySelector_.clear();
+    const bool validIds = (rule.tagId < nameCount || rule.tagId == NO_NAME) &&
+                          (rule.classId < nameCount || rule.classId == NO_NAME) &&
+                          !(rule.tagId == NO_NAME && rule.classId == NO_NAME);
+    const bool inOrder = rules_.empty() || rules_.back().tagId < rule.tagId ||
+                         (rules_.back().tagId == rule.tagId && rules_.back().classId < rule.classId);
+    if (!validIds || !inOrder) {
+      clear();
       return false;
     }
-    style.fontWeight = static_cast<CssFontWeight>(enumVal);
+    rules_.push_back(rule);
+  }
 
-    if (file.read(&enumVal, 1) != 1) {
-      rulesBySelector_.clear();
+  auto validId = [nameCount](const uint16_t id) { return id < nameCount || id == NO_NAME; };
+  uint16_t stepCount = 0;
+  if (file.read(&stepCount, sizeof(stepCount)) != sizeof(stepCount)) {
+    clear();
+    return false;
+  }
+  contextSteps_.reserve(stepCount);
+  for (uint16_t i = 0; i < stepCount; ++i) {
+    ContextStep step{};
+    uint8_t child = 0;
+    if (file.read(&step.tagId, sizeof(step.tagId)) != sizeof(step.tagId) ||
+        file.read(&step.classId, sizeof(step.classId)) != sizeof(step.classId) || file.read(&child, 1) != 1 ||
+        !validId(step.tagId) || !validId(step.classId) || (step.tagId == NO_NAME && step.classId == NO_NAME)) {
+      clear();
       return false;
     }
-    style.textDecoration = static_cast<CssTextDecoration>(enumVal);
+    step.child = child != 0;
+    contextSteps_.push_back(step);
+  }
 
-    // Read CssLength fields
-    auto readLength = [&file](CssLength& len) -> bool {
-      if (file.read(&len.value, sizeof(len.value)) != sizeof(len.value)) {
-        return false;
-      }
-      uint8_t unitVal;
-      if (file.read(&unitVal, 1) != 1) {
-        return false;
-      }
-      len.unit = static_cast<CssUnit>(unitVal);
-      return true;
-    };
-
-    if (!readLength(style.textIndent) || !readLength(style.marginTop) || !readLength(style.marginBottom) ||
-        !readLength(style.marginLeft) || !readLength(style.marginRight) || !readLength(style.paddingTop) ||
-        !readLength(style.paddingBottom) || !readLength(style.paddingLeft) || !readLength(style.paddingRight)) {
-      rulesBySelector_.clear();
+  uint16_t contextRuleCount = 0;
+  if (file.read(&contextRuleCount, sizeof(contextRuleCount)) != sizeof(contextRuleCount)) {
+    clear();
+    return false;
+  }
+  contextRules_.reserve(contextRuleCount);
+  for (uint16_t i = 0; i < contextRuleCount; ++i) {
+    ContextRule rule{};
+    if (file.read(&rule.tagId, sizeof(rule.tagId)) != sizeof(rule.tagId) ||
+        file.read(&rule.classId, sizeof(rule.classId)) != sizeof(rule.classId) ||
+        file.read(&rule.firstStep, sizeof(rule.firstStep)) != sizeof(rule.firstStep) ||
+        file.read(&rule.stepCount, 1) != 1 || file.read(&rule.order, sizeof(rule.order)) != sizeof(rule.order) ||
+        !readStyle(file, rule.style)) {
+      clear();
       return false;
     }
-
-    // Read defined flags
-    uint16_t definedBits = 0;
-    if (file.read(&definedBits, sizeof(definedBits)) != sizeof(definedBits)) {
-      rulesBySelector_.clear();
+    const bool valid = validId(rule.tagId) && validId(rule.classId) &&
+                       !(rule.tagId == NO_NAME && rule.classId == NO_NAME) && rule.stepCount > 0 &&
+                       rule.stepCount <= MAX_CONTEXT_STEPS && rule.firstStep + rule.stepCount <= stepCount;
+    const ContextRule* previous = contextRules_.empty() ? nullptr : &contextRules_.back();
+    const bool inOrder = previous == nullptr || previous->tagId < rule.tagId ||
+                         (previous->tagId == rule.tagId && (previous->classId < rule.classId ||
+                                                            (previous->classId == rule.classId &&
+                                                             previous->order < rule.order)));
+    if (!valid || !inOrder) {
+      clear();
       return false;
     }
-    style.defined.textAlign = (definedBits & 1 << 0) != 0;
-    style.defined.fontStyle = (definedBits & 1 << 1) != 0;
-    style.defined.fontWeight = (definedBits & 1 << 2) != 0;
-    style.defined.textDecoration = (definedBits & 1 << 3) != 0;
-    style.defined.textIndent = (definedBits & 1 << 4) != 0;
-    style.defined.marginTop = (definedBits & 1 << 5) != 0;
-    style.defined.marginBottom = (definedBits & 1 << 6) != 0;
-    style.defined.marginLeft = (definedBits & 1 << 7) != 0;
-    style.defined.marginRight = (definedBits & 1 << 8) != 0;
-    style.defined.paddingTop = (definedBits & 1 << 9) != 0;
-    style.defined.paddingBottom = (definedBits & 1 << 10) != 0;
-    style.defined.paddingLeft = (definedBits & 1 << 11) != 0;
-    style.defined.paddingRight = (definedBits & 1 << 12) != 0;
-
-    rulesBySelector_[selector] = style;
+    // Specificity and filter slots are derived from the steps rather than stored
+    finishContextRule(rule);
+    contextRules_.push_back(rule);
   }
+  indexContextSubjects();
 
-  Serial.printf("[%lu] [CSS] Loaded %u rules from cache\n", millis(), ruleCount);
+  Serial.printf("[%lu] [CSS] Loaded %u rules from cache\n", millis(), ruleCount + contextRuleCount);
   return true;
 }
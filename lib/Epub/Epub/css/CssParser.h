@@ -1,9 +1,10 @@
 #pragma once
 
+#include <Print.h>
 #include <SdFat.h>
 
+#include <memory>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "CssStyle.h"
@@ -15,14 +16,35 @@
  * Uses a two-phase approach: first tokenizes the CSS content, then builds
  * a rule database that can be queried during HTML parsing.
  *
+ * Tag and class names used by selectors are interned into sorted integer IDs,
+ * and rules are kept in a flat array sorted by (tag ID, class ID). Resolving an
+ * element is a few binary searches without any allocation, and the result for
+ * each (tag, class list) combination is memoized since books reuse a handful of
+ * them for thousands of elements. The rule cache file stores this index as is.
+ *
+ * Stylesheets are tokenized incrementally (see StreamLoader), so they can be fed
+ * straight from the ZIP inflater. Only the rule being read is kept as text, and
+ * repeated selectors are merged as they are read, so memory follows the number of
+ * distinct selectors rather than the file size.
+ *
+ * Selectors with ancestors ("blockquote p", "div.poem > p") are kept in a
+ * separate array indexed by their rightmost part and matched right to left
+ * against an AncestorStack of the open elements. The stack keeps a counting
+ * Bloom filter of the tags and classes it holds, so a rule naming an ancestor
+ * that isn't open is rejected without walking the stack.
+ *
  * Supported selectors:
  *   - Element selectors: p, div, h1, etc.
  *   - Class selectors: .classname
  *   - Combined: element.classname
+ *   - Descendant and child combinators between the above: div p, div.note > p
  *   - Grouped: selector1, selector2 { }
  *
+ * Matching rules are applied in order of specificity, then source order.
+ *
  * Not supported (silently ignored):
- *   - Descendant/child selectors
+ *   - Sibling combinators (+, ~), universal and id selectors
+ *   - Several classes on one element selector (p.a.b)
  *   - Pseudo-classes and pseudo-elements
  *   - Media queries (content is skipped)
  *   - @import, @font-face, etc.
@@ -36,6 +58,25 @@ class CssParser {
   CssParser(const CssParser&) = delete;
   CssParser& operator=(const CssParser&) = delete;
 
+  class StreamLoader;
+  class AncestorStack;
+
+  // ID of a name no selector uses, also the missing half of a selector ("p" has no class, ".note" has no tag)
+  static constexpr uint16_t NO_NAME = 0xFFFF;
+  // Classes of one element taken into account when matching, further ones are ignored
+  static constexpr size_t MAX_ELEMENT_CLASSES = 6;
+
+  /**
+   * An element reduced to the interned IDs of its tag and of the classes that appear in some selector.
+   */
+  struct ElementKey {
+    uint16_t tagId = NO_NAME;
+    uint8_t classCount = 0;
+    uint16_t classIds[MAX_ELEMENT_CLASSES] = {};
+
+    bool operator==(const ElementKey& other) const;
+  };
+
   /**
    * Load and parse CSS from a file stream.
    * Can be called multiple times to accumulate rules from multiple stylesheets.
@@ -52,7 +93,18 @@ class CssParser {
    * @param classAttr The class attribute value (may contain multiple space-separated classes)
    * @return Combined style with all applicable rules merged
    */
-  [[nodiscard]] CssStyle resolveStyle(const std::string& tagName, const std::string& classAttr) const;
+  [[nodiscard]] CssStyle resolveStyle(const char* tagName, const char* classAttr) const;
+
+  /**
+   * Intern an element's tag and class attribute, for resolveStyle and AncestorStack::push.
+   */
+  [[nodiscard]] ElementKey elementKey(const char* tagName, const char* classAttr) const;
+
+  /**
+   * Resolve the style of an element inside the given open ancestors (which must not include the element itself).
+   * Without ancestors only selectors without combinators can match.
+   */
+  [[nodiscard]] CssStyle resolveStyle(const ElementKey& element, const AncestorStack* ancestors) const;
 
   /**
    * Parse an inline style attribute string.
@@ -64,17 +116,17 @@ class CssParser {
   /**
    * Check if any rules have been loaded
    */
-  [[nodiscard]] bool empty() const { return rulesBySelector_.empty(); }
+  [[nodiscard]] bool empty() const { return rules_.empty() && contextRules_.empty(); }
 
   /**
    * Get count of loaded rule sets
    */
-  [[nodiscard]] size_t ruleCount() const { return rulesBySelector_.size(); }
+  [[nodiscard]] size_t ruleCount() const { return rules_.size() + contextRules_.size(); }
 
   /**
    * Clear all loaded rules
    */
-  void clear() { rulesBySelector_.clear(); }
+  void clear();
 
   /**
    * Save parsed CSS rules to a cache file.
@@ -92,11 +144,97 @@ class CssParser {
   bool loadFromCache(FsFile& file);
 
  private:
-  // Storage: maps normalized selector -> style properties
-  std::unordered_map<std::string, CssStyle> rulesBySelector_;
+  static constexpr size_t MEMO_SIZE = 32;
+  // Ancestor parts of one selector ("body div.x > p" has two)
+  static constexpr size_t MAX_CONTEXT_STEPS = 8;
+  // Ancestor features checked against the Bloom filter before walking the stack
+  static constexpr size_t MAX_FILTER_SLOTS = 4;
+
+  // A "tag", ".class" or "tag.class" selector with its merged declarations
+  struct Rule {
+    uint16_t tagId;
+    uint16_t classId;
+    CssStyle style;
+  };
+
+  // One ancestor part of a context selector
+  struct ContextStep {
+    uint16_t tagId;
+    uint16_t classId;
+    bool child;  // must be the parent of the part to its right rather than any ancestor
+  };
+
+  // Selector with ancestors. tagId/classId are its rightmost part, the steps follow it outwards.
+  struct ContextRule {
+    uint16_t tagId;
+    uint16_t classId;
+    uint16_t firstStep;  // index into contextSteps_
+    uint8_t stepCount;
+    uint8_t filterSlotCount;
+    uint8_t filterSlots[MAX_FILTER_SLOTS];
+    uint16_t specificity;  // 256 per class plus 1 per tag
+    uint16_t order;        // source order, breaks specificity ties
+    CssStyle style;
+  };
+
+  // Rule as it comes out of the stylesheet, before names are interned
+  struct ParsedRule {
+    std::string tag;
+    std::string className;
+    std::string context;  // ancestor parts with their combinators, "div > blockquote " for "div > blockquote p"
+    CssStyle style;
+  };
+
+  // Rule on its way into the index, with names interned into some name table and steps in some step array
+  struct PendingRule {
+    uint16_t tagId;
+    uint16_t classId;
+    uint32_t firstStep;
+    uint8_t stepCount;  // 0 for a selector without ancestors
+    uint32_t order;     // source order, the last occurrence of a repeated selector
+    CssStyle style;
+  };
+
+  struct MemoEntry {
+    bool used = false;
+    bool hasContextRules = false;  // some context rule ends in this element, the memoized style may not be final
+    ElementKey key;
+    CssStyle style;
+  };
+
+  // Interned selector names, lowercase and sorted. The ID of a name is its index in nameOffsets_.
+  std::string namePool_;                     // NUL-terminated names back to back
+  std::vector<uint32_t> nameOffsets_;        // Start of each name in namePool_
+  std::vector<Rule> rules_;                  // Sorted by (tagId, classId), one entry per selector
+  std::vector<ContextRule> contextRules_;    // Sorted by (tagId, classId, order)
+  std::vector<ContextStep> contextSteps_;    // Steps of every context rule, nearest ancestor first
+  std::vector<bool> contextSubjects_;        // Per name ID, whether some context rule ends in that tag or class
+  mutable std::unique_ptr<MemoEntry[]> memo_;
+
+  uint16_t findName(const char* name, size_t length) const;
+  const char* nameOf(uint16_t id) const { return namePool_.c_str() + nameOffsets_[id]; }
+  const CssStyle* findRule(uint16_t tagId, uint16_t classId) const;
+  bool hasContextRules(const ElementKey& element) const;
+  template <typename Fn>
+  void forEachContextRule(uint16_t tagId, uint16_t classId, Fn&& fn) const;
+  bool matchesContext(const ContextRule& rule, const AncestorStack& ancestors) const;
+  bool matchSteps(const ContextStep* steps, size_t count, const AncestorStack& ancestors, int position) const;
+  CssStyle resolveSimple(const ElementKey& element) const;
+  CssStyle resolveWithContext(const ElementKey& element, const CssStyle& simpleStyle,
+                              const AncestorStack* ancestors) const;
+  void finishContextRule(ContextRule& rule) const;
+  void indexContextSubjects();
+  // Merge rules read from a stylesheet into the index, taking over their vectors
+  void mergeIndex(const std::string& namePool, const std::vector<uint32_t>& nameOffsets,
+                  std::vector<PendingRule>& added, std::vector<ContextStep>& addedSteps);
+  // Orders selectors by their interned parts, equal only for the same selector
+  static int compareSelectors(const PendingRule& a, const PendingRule& b, const ContextStep* steps);
+  // Sort rules by selector and merge repeated ones in source order, dropping the steps no rule uses any more
+  static void mergeRepeated(std::vector<PendingRule>& rules, std::vector<ContextStep>& steps);
 
   // Internal parsing helpers
-  void processRuleBlock(const std::string& selectorGroup, const std::string& declarations);
+  static void processRuleBlock(const std::string& selectorGroup, const std::string& declarations,
+                               std::vector<ParsedRule>& out);
   static CssStyle parseDeclarations(const std::string& declBlock);
 
   // Individual property value parsers
@@ -112,3 +250,85 @@ class CssParser {
   static std::vector<std::string> splitOnChar(const std::string& s, char delimiter);
   static std::vector<std::string> splitWhitespace(const std::string& s);
 };
+
+/**
+ * Incremental stylesheet tokenizer. Write the stylesheet in chunks of any size (it is a Print, so
+ * Epub::readItemContentsToStream can inflate straight into it), then call finish() to add the rules
+ * to the parser. Comments are stripped and @-rules skipped on the fly. Only the rule currently being
+ * read is buffered as text, rules longer than MAX_RULE_SIZE are dropped.
+ *
+ * Finished rules are interned as they complete. A selector that was already read is merged into its
+ * earlier rule right away, new ones are merged into the sorted rules every MERGE_BATCH, so memory grows
+ * with the distinct selectors (what the index keeps anyway) rather than with the size of the sheet.
+ */
+class CssParser::StreamLoader final : public Print {
+ public:
+  static constexpr size_t MAX_RULE_SIZE = 4096;
+  static constexpr size_t MERGE_BATCH = 64;
+
+  explicit StreamLoader(CssParser& parser) : parser(parser) {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+
+  /**
+   * Flush the last rule and merge everything read into the parser's index.
+   * Nothing is added to the parser if finish() is never called.
+   */
+  void finish();
+
+ private:
+  enum State : uint8_t { BETWEEN_RULES, IN_SELECTOR, IN_BODY, IN_AT_RULE };
+
+  CssParser& parser;
+  // Names in order of first use, a name's ID is its index in nameOffsets
+  std::string namePool;
+  std::vector<uint32_t> nameOffsets;
+  std::vector<uint16_t> sortedNames;  // name IDs in name order, for lookups
+  // Rules read so far, the first mergedCount sorted by selector and without repeats
+  std::vector<PendingRule> rules;
+  std::vector<ContextStep> steps;
+  size_t mergedCount = 0;
+  uint32_t nextOrder = 0;
+  std::vector<ParsedRule> blockRules;  // scratch for the rules of one block
+  std::string selector;
+  std::string body;
+  State state = BETWEEN_RULES;
+  int braceDepth = 0;
+  bool oversized = false;  // current rule outgrew MAX_RULE_SIZE, skip to its end
+  bool pendingSlash = false;
+  bool inComment = false;
+  bool pendingStar = false;
+  uint32_t droppedRules = 0;
+
+  void consume(char c);
+  void endRule();
+  void addRule(const ParsedRule& parsed);
+  bool intern(const std::string& name, uint16_t& id);
+  void mergeBatch();
+};
+
+/**
+ * The open elements above the one being styled, pushed and popped by the HTML parser as elements start and end.
+ * A counting Bloom filter over the ancestors' tag and class IDs lets context selectors that name an element which
+ * isn't open be rejected in constant time.
+ */
+class CssParser::AncestorStack {
+ public:
+  static constexpr size_t FILTER_SIZE = 256;
+
+  void push(const ElementKey& element);
+  void pop();
+  void clear();
+
+  size_t size() const { return entries.size(); }
+  const ElementKey& at(const size_t index) const { return entries[index]; }
+  // False means no open ancestor has the tag or class that maps to this filter slot
+  bool mayContain(const uint8_t slot) const { return counts[slot] != 0; }
+
+  static uint8_t filterSlot(uint16_t id, bool isClass);
+
+ private:
+  std::vector<ElementKey> entries;
+  uint16_t counts[FILTER_SIZE] = {};
+};
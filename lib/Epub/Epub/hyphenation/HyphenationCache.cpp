@@ -0,0 +1,128 @@
+#include "HyphenationCache.h"
+
+#include <cstring>
+#include <memory>
+#include <new>
+
+HyphenationCache::Stats HyphenationCache::stats_;
+
+namespace {
+
+static_assert((HyphenationCache::kSlots & (HyphenationCache::kSlots - 1)) == 0, "Slot count must be a power of two");
+static_assert(HyphenationCache::kChunkBytes * HyphenationCache::kMaxChunks / 2 < UINT16_MAX,
+              "Slots hold arena positions in 16 bits");
+
+// Entries stop being added past this share of the slots, so probe sequences stay short
+constexpr size_t kMaxEntries = HyphenationCache::kSlots * 3 / 4;
+constexpr uint8_t kFallbackFlag = 0x80;
+constexpr uint8_t kHyphenFlag = 0x80;
+
+// Entry layout: [word length | kFallbackFlag][word bytes][break count][break offsets | kHyphenFlag]
+// Entries start on even arena positions and slots hold the position halved plus one, 0 marks an empty slot.
+std::unique_ptr<uint16_t[]> slots;
+std::unique_ptr<uint8_t[]> chunks[HyphenationCache::kMaxChunks];
+size_t chunkCount = 0;
+size_t chunkUsed = 0;
+size_t entryCount = 0;
+const void* cachedLanguage = nullptr;
+
+// FNV-1a over the word bytes and the fallback flag
+uint32_t hashKey(const std::string& word, const bool includeFallback) {
+  uint32_t hash = 2166136261u;
+  for (const char c : word) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+  }
+  return (hash ^ (includeFallback ? 1u : 0u)) * 16777619u;
+}
+
+const uint8_t* entryAt(const uint16_t slot) {
+  const size_t position = (slot - 1u) * 2;
+  return chunks[position / HyphenationCache::kChunkBytes].get() + position % HyphenationCache::kChunkBytes;
+}
+
+// Room for an entry of the given size in the arena, nullptr once every chunk is used
+uint8_t* reserve(const size_t size, size_t& position) {
+  if (chunkCount == 0 || chunkUsed + size > HyphenationCache::kChunkBytes) {
+    if (chunkCount == HyphenationCache::kMaxChunks) {
+      return nullptr;
+    }
+    chunks[chunkCount].reset(new (std::nothrow) uint8_t[HyphenationCache::kChunkBytes]);
+    if (!chunks[chunkCount]) {
+      return nullptr;
+    }
+    ++chunkCount;
+    chunkUsed = 0;
+  }
+  position = (chunkCount - 1) * HyphenationCache::kChunkBytes + chunkUsed;
+  chunkUsed += (size + 1) & ~static_cast<size_t>(1);
+  return chunks[chunkCount - 1].get() + position % HyphenationCache::kChunkBytes;
+}
+
+}  // namespace
+
+void HyphenationCache::breakOffsets(const std::string& word, const bool includeFallback, Hyphenator::Scratch& scratch,
+                                    Hyphenator::BreakList& out) {
+  const void* language = Hyphenator::preferredHyphenator();
+  if (language != cachedLanguage) {
+    clear();
+    cachedLanguage = language;
+  }
+  if (word.empty() || word.size() > kMaxWordBytes) {
+    ++stats_.uncached;
+    Hyphenator::breakOffsets(word, includeFallback, scratch, out);
+    return;
+  }
+  if (!slots) {
+    slots.reset(new (std::nothrow) uint16_t[kSlots]());
+    if (!slots) {
+      ++stats_.uncached;
+      Hyphenator::breakOffsets(word, includeFallback, scratch, out);
+      return;
+    }
+  }
+
+  const auto header = static_cast<uint8_t>(word.size() | (includeFallback ? kFallbackFlag : 0));
+  size_t index = hashKey(word, includeFallback) & (kSlots - 1);
+  for (; slots[index] != 0; index = (index + 1) & (kSlots - 1)) {
+    const uint8_t* entry = entryAt(slots[index]);
+    if (entry[0] == header && memcmp(entry + 1, word.data(), word.size()) == 0) {
+      ++stats_.hits;
+      const uint8_t* breaks = entry + 1 + word.size();
+      out.clear();
+      for (uint8_t i = 0; i < breaks[0]; ++i) {
+        out.push(breaks[1 + i] & ~kHyphenFlag, (breaks[1 + i] & kHyphenFlag) != 0);
+      }
+      return;
+    }
+  }
+
+  Hyphenator::breakOffsets(word, includeFallback, scratch, out);
+  size_t position = 0;
+  uint8_t* entry = entryCount < kMaxEntries ? reserve(2 + word.size() + out.size(), position) : nullptr;
+  if (!entry) {
+    ++stats_.uncached;
+    return;
+  }
+  ++stats_.misses;
+  entry[0] = header;
+  memcpy(entry + 1, word.data(), word.size());
+  uint8_t* breaks = entry + 1 + word.size();
+  // Break offsets lie inside the word, so they fit below the flag bit
+  breaks[0] = static_cast<uint8_t>(out.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    breaks[1 + i] = static_cast<uint8_t>(out[i].byteOffset | (out[i].requiresInsertedHyphen ? kHyphenFlag : 0));
+  }
+  slots[index] = static_cast<uint16_t>(position / 2 + 1);
+  ++entryCount;
+}
+
+void HyphenationCache::clear() {
+  slots.reset();
+  for (auto& chunk : chunks) {
+    chunk.reset();
+  }
+  chunkCount = 0;
+  chunkUsed = 0;
+  entryCount = 0;
+  cachedLanguage = nullptr;
+}
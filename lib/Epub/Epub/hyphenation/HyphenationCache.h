@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Hyphenator.h"
+
+// Memo in front of Hyphenator::breakOffsets. The same vocabulary recurs constantly within a book and again whenever a
+// chapter is re-paginated (font size, margins...), so results are kept per (word bytes, fallback flag) for the current
+// language, which clears the memo when it changes. Each word is stored with its break offsets in arena chunks
+// allocated as the memo fills, and found through an open addressing table of kSlots. A hit compares the stored word
+// bytes, so different words never share a result.
+//
+// The arena holds the few thousand distinct words a book hyphenates. Once it is full, words that aren't in it yet are
+// computed every time rather than evicting the ones that are, which came first and so tend to be the most frequent.
+//
+// The memo is one per program and not locked, it's meant for the task laying out chapters. Callers bring their own
+// Hyphenator::Scratch for the words it misses.
+class HyphenationCache {
+ public:
+  static constexpr size_t kSlots = 8192;
+  static constexpr size_t kChunkBytes = 8 * 1024;
+  static constexpr size_t kMaxChunks = 8;
+  // Offsets are stored as single bytes with the inserted hyphen flag in the top bit
+  static constexpr size_t kMaxWordBytes = 127;
+
+  struct Stats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    // Lookups that bypassed the cache (word too long, cache full or no memory)
+    uint32_t uncached = 0;
+  };
+
+  // Same contract as Hyphenator::breakOffsets for the current preferred language, filling out in place. Misses are
+  // computed in scratch.
+  static void breakOffsets(const std::string& word, bool includeFallback, Hyphenator::Scratch& scratch,
+                           Hyphenator::BreakList& out);
+
+  static const Stats& stats() { return stats_; }
+  static void resetStats() { stats_ = Stats{}; }
+  // Drop every entry and free the memory.
+  static void clear();
+
+ private:
+  static Stats stats_;
+};
@@ -2,9 +2,39 @@
 
 #include <Utf8.h>
 
+#include <algorithm>
+#include <iterator>
+
 namespace {
 
-// Convert Latin uppercase letters (ASCII plus Latin-1 supplement) to lowercase
+// Uppercase letters of Latin Extended-A and B, generated from the Unicode case mappings: every stride-th codepoint
+// from first to last lowercases to itself plus delta. Sorted by first.
+struct LatinCaseRun {
+  uint16_t first;
+  uint16_t last;
+  int16_t delta;
+  uint8_t stride;
+};
+
+constexpr LatinCaseRun LATIN_EXTENDED_CASE_RUNS[] = {
+    {0x0100, 0x012E, 1, 2}, {0x0130, 0x0130, -199, 1}, {0x0132, 0x0136, 1, 2}, {0x0139, 0x0147, 1, 2},
+    {0x014A, 0x0176, 1, 2}, {0x0178, 0x0178, -121, 1}, {0x0179, 0x017D, 1, 2}, {0x0181, 0x0181, 210, 1},
+    {0x0182, 0x0184, 1, 2}, {0x0186, 0x0186, 206, 1}, {0x0187, 0x0187, 1, 1}, {0x0189, 0x018A, 205, 1},
+    {0x018B, 0x018B, 1, 1}, {0x018E, 0x018E, 79, 1}, {0x018F, 0x018F, 202, 1}, {0x0190, 0x0190, 203, 1},
+    {0x0191, 0x0191, 1, 1}, {0x0193, 0x0193, 205, 1}, {0x0194, 0x0194, 207, 1}, {0x0196, 0x0196, 211, 1},
+    {0x0197, 0x0197, 209, 1}, {0x0198, 0x0198, 1, 1}, {0x019C, 0x019C, 211, 1}, {0x019D, 0x019D, 213, 1},
+    {0x019F, 0x019F, 214, 1}, {0x01A0, 0x01A4, 1, 2}, {0x01A6, 0x01A6, 218, 1}, {0x01A7, 0x01A7, 1, 1},
+    {0x01A9, 0x01A9, 218, 1}, {0x01AC, 0x01AC, 1, 1}, {0x01AE, 0x01AE, 218, 1}, {0x01AF, 0x01AF, 1, 1},
+    {0x01B1, 0x01B2, 217, 1}, {0x01B3, 0x01B5, 1, 2}, {0x01B7, 0x01B7, 219, 1}, {0x01B8, 0x01B8, 1, 1},
+    {0x01BC, 0x01BC, 1, 1}, {0x01C4, 0x01C4, 2, 1}, {0x01C5, 0x01C5, 1, 1}, {0x01C7, 0x01C7, 2, 1},
+    {0x01C8, 0x01C8, 1, 1}, {0x01CA, 0x01CA, 2, 1}, {0x01CB, 0x01DB, 1, 2}, {0x01DE, 0x01EE, 1, 2},
+    {0x01F1, 0x01F1, 2, 1}, {0x01F2, 0x01F4, 1, 2}, {0x01F6, 0x01F6, -97, 1}, {0x01F7, 0x01F7, -56, 1},
+    {0x01F8, 0x021E, 1, 2}, {0x0220, 0x0220, -130, 1}, {0x0222, 0x0232, 1, 2}, {0x023A, 0x023A, 10795, 1},
+    {0x023B, 0x023B, 1, 1}, {0x023D, 0x023D, -163, 1}, {0x023E, 0x023E, 10792, 1}, {0x0241, 0x0241, 1, 1},
+    {0x0243, 0x0243, -195, 1}, {0x0244, 0x0244, 69, 1}, {0x0245, 0x0245, 71, 1}, {0x0246, 0x024E, 1, 2},
+};
+
+// Convert Latin uppercase letters (ASCII, Latin-1 supplement and Latin Extended-A/B) to lowercase
 uint32_t toLowerLatinImpl(const uint32_t cp) {
   if (cp >= 'A' && cp <= 'Z') {
     return cp - 'A' + 'a';
@@ -12,17 +42,20 @@ uint32_t toLowerLatinImpl(const uint32_t cp) {
   if ((cp >= 0x00C0 && cp <= 0x00D6) || (cp >= 0x00D8 && cp <= 0x00DE)) {
     return cp + 0x20;
   }
+  if (cp == 0x1E9E) {  // ẞ
+    return 0x00DF;     // ß
+  }
+  if (cp < LATIN_EXTENDED_CASE_RUNS[0].first || cp > 0x024F) {
+    return cp;
+  }
 
-  switch (cp) {
-    case 0x0152:      // Œ
-      return 0x0153;  // œ
-    case 0x0178:      // Ÿ
-      return 0x00FF;  // ÿ
-    case 0x1E9E:      // ẞ
-      return 0x00DF;  // ß
-    default:
-      return cp;
+  const auto* end = std::end(LATIN_EXTENDED_CASE_RUNS);
+  const auto* run = std::lower_bound(std::begin(LATIN_EXTENDED_CASE_RUNS), end, cp,
+                                     [](const LatinCaseRun& r, const uint32_t value) { return r.last < value; });
+  if (run == end || cp < run->first || (cp - run->first) % run->stride != 0) {
+    return cp;
   }
+  return static_cast<uint32_t>(static_cast<int32_t>(cp) + run->delta);
 }
 
 // Convert Cyrillic uppercase letters to lowercase
@@ -54,15 +87,8 @@ bool isLatinLetter(const uint32_t cp) {
     return true;
   }
 
-  switch (cp) {
-    case 0x0152:  // Œ
-    case 0x0153:  // œ
-    case 0x0178:  // Ÿ
-    case 0x1E9E:  // ẞ
-      return true;
-    default:
-      return false;
-  }
+  // Latin Extended-A and B hold letters only
+  return (cp >= 0x0100 && cp <= 0x024F) || cp == 0x1E9E;  // ẞ
 }
 
 bool isCyrillicLetter(const uint32_t cp) { return (cp >= 0x0400 && cp <= 0x052F); }
@@ -135,14 +161,16 @@ bool isExplicitHyphen(const uint32_t cp) {
 
 bool isSoftHyphen(const uint32_t cp) { return cp == 0x00AD; }
 
-void trimSurroundingPunctuationAndFootnote(std::vector<CodepointInfo>& cps) {
-  if (cps.empty()) {
+void trimSurroundingPunctuationAndFootnote(const CodepointInfo** first, size_t* count) {
+  const CodepointInfo* cps = *first;
+  size_t size = *count;
+  if (size == 0) {
     return;
   }
 
   // Remove trailing footnote references like [12], even if punctuation trails after the closing bracket.
-  if (cps.size() >= 3) {
-    int end = static_cast<int>(cps.size()) - 1;
+  if (size >= 3) {
+    int end = static_cast<int>(size) - 1;
     while (end >= 0 && isPunctuation(cps[end].value)) {
       --end;
     }
@@ -152,17 +180,46 @@ void trimSurroundingPunctuationAndFootnote(std::vector<CodepointInfo>& cps) {
         --pos;
       }
       if (pos >= 0 && cps[pos].value == '[' && end - pos > 1) {
-        cps.erase(cps.begin() + pos, cps.end());
+        size = static_cast<size_t>(pos);
       }
     }
   }
 
-  while (!cps.empty() && isPunctuation(cps.front().value)) {
-    cps.erase(cps.begin());
+  while (size > 0 && isPunctuation(cps->value)) {
+    ++cps;
+    --size;
+  }
+  while (size > 0 && isPunctuation(cps[size - 1].value)) {
+    --size;
   }
-  while (!cps.empty() && isPunctuation(cps.back().value)) {
-    cps.pop_back();
+
+  *first = cps;
+  *count = size;
+}
+
+void trimSurroundingPunctuationAndFootnote(std::vector<CodepointInfo>& cps) {
+  const CodepointInfo* first = cps.data();
+  size_t count = cps.size();
+  trimSurroundingPunctuationAndFootnote(&first, &count);
+
+  const auto offset = static_cast<size_t>(first - cps.data());
+  cps.resize(offset + count);
+  cps.erase(cps.begin(), cps.begin() + offset);
+}
+
+size_t collectCodepoints(const std::string& word, CodepointInfo* out, const size_t capacity) {
+  const unsigned char* base = reinterpret_cast<const unsigned char*>(word.c_str());
+  const unsigned char* ptr = base;
+  size_t count = 0;
+  while (*ptr != 0) {
+    if (count == capacity) {
+      return capacity + 1;
+    }
+    const unsigned char* current = ptr;
+    const uint32_t cp = utf8NextCodepoint(&ptr);
+    out[count++] = {cp, static_cast<size_t>(current - base)};
   }
+  return count;
 }
 
 std::vector<CodepointInfo> collectCodepoints(const std::string& word) {
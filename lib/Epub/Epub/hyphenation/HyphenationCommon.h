@@ -23,3 +23,9 @@ bool isExplicitHyphen(uint32_t cp);
 bool isSoftHyphen(uint32_t cp);
 void trimSurroundingPunctuationAndFootnote(std::vector<CodepointInfo>& cps);
 std::vector<CodepointInfo> collectCodepoints(const std::string& word);
+
+// Allocation-free variants for the layout hot path.
+// Narrows [*first, *first + *count) to the trimmed word without moving any elements.
+void trimSurroundingPunctuationAndFootnote(const CodepointInfo** first, size_t* count);
+// Decodes word into out. Returns the codepoint count, or capacity + 1 if the word doesn't fit.
+size_t collectCodepoints(const std::string& word, CodepointInfo* out, size_t capacity);
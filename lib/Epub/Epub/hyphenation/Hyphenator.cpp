@@ -13,14 +13,7 @@ namespace {
 const LanguageHyphenator* hyphenatorForLanguage(const std::string& langTag) {
   if (langTag.empty()) return nullptr;
 
-  // Extract primary subtag and normalize to lowercase (e.g., "en-US" -> "en").
-  std::string primary;
-  primary.reserve(langTag.size());
-  for (char c : langTag) {
-    if (c == '-' || c == '_') break;
-    if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
-    primary.push_back(c);
-  }
+  const std::string primary = primaryLanguageSubtag(langTag);
   if (primary.empty()) return nullptr;
 
   return getLanguageHyphenatorForPrimaryTag(primary);
@@ -31,6 +24,10 @@ size_t byteOffsetForIndex(const std::vector<CodepointInfo>& cps, const size_t in
   return (index < cps.size()) ? cps[index].byteOffset : (cps.empty() ? 0 : cps.back().byteOffset);
 }
 
+size_t byteOffsetForIndex(const CodepointInfo* cps, const size_t count, const size_t index) {
+  return (index < count) ? cps[index].byteOffset : (count == 0 ? 0 : cps[count - 1].byteOffset);
+}
+
 // Builds a vector of break information from explicit hyphen markers in the given codepoints.
 std::vector<Hyphenator::BreakInfo> buildExplicitBreakInfos(const std::vector<CodepointInfo>& cps) {
   std::vector<Hyphenator::BreakInfo> breaks;
@@ -48,6 +45,17 @@ std::vector<Hyphenator::BreakInfo> buildExplicitBreakInfos(const std::vector<Cod
   return breaks;
 }
 
+// Same as buildExplicitBreakInfos, appending to a BreakList.
+void appendExplicitBreaks(const CodepointInfo* cps, const size_t count, Hyphenator::BreakList& out) {
+  for (size_t i = 1; i + 1 < count; ++i) {
+    const uint32_t cp = cps[i].value;
+    if (!isExplicitHyphen(cp) || !isAlphabetic(cps[i - 1].value) || !isAlphabetic(cps[i + 1].value)) {
+      continue;
+    }
+    out.push(cps[i + 1].byteOffset, isSoftHyphen(cp));
+  }
+}
+
 }  // namespace
 
 std::vector<Hyphenator::BreakInfo> Hyphenator::breakOffsets(const std::string& word, const bool includeFallback) {
@@ -94,4 +102,45 @@ std::vector<Hyphenator::BreakInfo> Hyphenator::breakOffsets(const std::string& w
   return breaks;
 }
 
+void Hyphenator::breakOffsets(const std::string& word, const bool includeFallback, Scratch& scratch, BreakList& out) {
+  out.clear();
+  if (word.empty() || word.size() > UINT8_MAX) {
+    return;
+  }
+
+  const size_t collected = collectCodepoints(word, scratch.codepoints, BreakList::kCapacity);
+  if (collected > BreakList::kCapacity) {
+    return;
+  }
+  const CodepointInfo* cps = scratch.codepoints;
+  size_t count = collected;
+  trimSurroundingPunctuationAndFootnote(&cps, &count);
+  const auto* hyphenator = cachedHyphenator_;
+
+  appendExplicitBreaks(cps, count, out);
+  if (!out.empty()) {
+    return;
+  }
+
+  size_t indexCount = 0;
+  if (hyphenator) {
+    indexCount = hyphenator->breakIndexes(cps, count, scratch.liang, scratch.indexes, BreakList::kCapacity);
+  }
+
+  if (indexCount > 0) {
+    for (size_t i = 0; i < indexCount; ++i) {
+      out.push(byteOffsetForIndex(cps, count, scratch.indexes[i]), true);
+    }
+    return;
+  }
+
+  if (includeFallback) {
+    const size_t minPrefix = hyphenator ? hyphenator->minPrefix() : LiangWordConfig::kDefaultMinPrefix;
+    const size_t minSuffix = hyphenator ? hyphenator->minSuffix() : LiangWordConfig::kDefaultMinSuffix;
+    for (size_t idx = minPrefix; idx + minSuffix <= count; ++idx) {
+      out.push(byteOffsetForIndex(cps, count, idx), true);
+    }
+  }
+}
+
 void Hyphenator::setPreferredLanguage(const std::string& lang) { cachedHyphenator_ = hyphenatorForLanguage(lang); }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "LiangHyphenation.h"
+
 class LanguageHyphenator;
 
 class Hyphenator {
@@ -16,8 +19,54 @@ class Hyphenator {
   // minimum prefix/suffix constraints are returned even if no language-specific rule matches.
   static std::vector<BreakInfo> breakOffsets(const std::string& word, bool includeFallback);
 
+  // Fixed-capacity break list filled by the allocation-free breakOffsets overload. Offsets fit in a byte because the
+  // parser never emits words longer than MAX_WORD_SIZE (200) bytes.
+  class BreakList {
+   public:
+    static constexpr size_t kCapacity = 200;
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    BreakInfo operator[](const size_t i) const { return {offsets_[i], ((hyphenMask_[i / 8] >> (i % 8)) & 1u) != 0}; }
+
+    void clear() { count_ = 0; }
+    bool push(const size_t byteOffset, const bool requiresInsertedHyphen) {
+      if (count_ == kCapacity || byteOffset > UINT8_MAX) {
+        return false;
+      }
+      offsets_[count_] = static_cast<uint8_t>(byteOffset);
+      const uint8_t bit = static_cast<uint8_t>(1u << (count_ % 8));
+      if (requiresInsertedHyphen) {
+        hyphenMask_[count_ / 8] |= bit;
+      } else {
+        hyphenMask_[count_ / 8] &= static_cast<uint8_t>(~bit);
+      }
+      ++count_;
+      return true;
+    }
+
+   private:
+    uint8_t offsets_[kCapacity];
+    uint8_t hyphenMask_[(kCapacity + 7) / 8];
+    uint8_t count_ = 0;
+  };
+
+  // Working memory of the allocation-free breakOffsets. Each caller brings its own, so words can be hyphenated on
+  // several tasks at once; at about 3.4 KB it belongs on the heap rather than a task's stack.
+  struct Scratch {
+    CodepointInfo codepoints[BreakList::kCapacity];
+    LiangScratch liang;
+    uint16_t indexes[BreakList::kCapacity];
+  };
+
+  // Same as above without touching the heap: results are written to out, working in scratch. Words longer than
+  // BreakList can address get no breaks.
+  static void breakOffsets(const std::string& word, bool includeFallback, Scratch& scratch, BreakList& out);
+
   // Provide a publication-level language hint (e.g. "en", "en-US", "ru") used to select hyphenation rules.
   static void setPreferredLanguage(const std::string& lang);
+  // Hyphenator selected by the last setPreferredLanguage call, nullptr when the language is unsupported.
+  static const LanguageHyphenator* preferredHyphenator() { return cachedHyphenator_; }
 
  private:
   static const LanguageHyphenator* cachedHyphenator_;
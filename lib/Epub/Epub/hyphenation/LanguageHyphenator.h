@@ -14,8 +14,15 @@ class LanguageHyphenator {
     return liangBreakIndexes(cps, patterns_, config_);
   }
 
+  size_t breakIndexes(const CodepointInfo* cps, const size_t cpCount, LiangScratch& scratch, uint16_t* out,
+                      const size_t maxBreaks) const {
+    return liangBreakIndexes(cps, cpCount, patterns_, config_, scratch, out, maxBreaks);
+  }
+
   size_t minPrefix() const { return config_.minPrefix; }
   size_t minSuffix() const { return config_.minSuffix; }
+  const SerializedHyphenationPatterns& patterns() const { return patterns_; }
+  const LiangWordConfig& config() const { return config_; }
 
  protected:
   const SerializedHyphenationPatterns& patterns_;
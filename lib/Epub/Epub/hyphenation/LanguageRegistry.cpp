@@ -1,45 +1,86 @@
 #include "LanguageRegistry.h"
 
 #include <algorithm>
-#include <array>
 
 #include "HyphenationCommon.h"
-#include "generated/hyph-de.trie.h"
 #include "generated/hyph-en.trie.h"
+// Other languages can be left out of the image with OMIT_HYPHENATION_<LANG> and shipped as
+// /.crosspoint/hyph/<lang>.bin on the SD card instead (see SdHyphenation). English is always built in.
+#ifndef OMIT_HYPHENATION_DE
+#include "generated/hyph-de.trie.h"
+#endif
+#ifndef OMIT_HYPHENATION_ES
 #include "generated/hyph-es.trie.h"
+#endif
+#ifndef OMIT_HYPHENATION_FR
 #include "generated/hyph-fr.trie.h"
+#endif
+#ifndef OMIT_HYPHENATION_RU
 #include "generated/hyph-ru.trie.h"
+#endif
 
 namespace {
 
 // English hyphenation patterns (3/3 minimum prefix/suffix length)
 LanguageHyphenator englishHyphenator(en_us_patterns, isLatinLetter, toLowerLatin, 3, 3);
+#ifndef OMIT_HYPHENATION_FR
 LanguageHyphenator frenchHyphenator(fr_patterns, isLatinLetter, toLowerLatin);
+#endif
+#ifndef OMIT_HYPHENATION_DE
 LanguageHyphenator germanHyphenator(de_patterns, isLatinLetter, toLowerLatin);
+#endif
+#ifndef OMIT_HYPHENATION_RU
 LanguageHyphenator russianHyphenator(ru_ru_patterns, isCyrillicLetter, toLowerCyrillic);
+#endif
+#ifndef OMIT_HYPHENATION_ES
 LanguageHyphenator spanishHyphenator(es_patterns, isLatinLetter, toLowerLatin);
+#endif
 
-using EntryArray = std::array<LanguageEntry, 5>;
+const LanguageEntry kEntries[] = {
+    {"english", "en", &englishHyphenator},
+#ifndef OMIT_HYPHENATION_FR
+    {"french", "fr", &frenchHyphenator},
+#endif
+#ifndef OMIT_HYPHENATION_DE
+    {"german", "de", &germanHyphenator},
+#endif
+#ifndef OMIT_HYPHENATION_RU
+    {"russian", "ru", &russianHyphenator},
+#endif
+#ifndef OMIT_HYPHENATION_ES
+    {"spanish", "es", &spanishHyphenator},
+#endif
+};
+constexpr size_t kEntryCount = sizeof(kEntries) / sizeof(kEntries[0]);
 
-const EntryArray& entries() {
-  static const EntryArray kEntries = {{{"english", "en", &englishHyphenator},
-                                       {"french", "fr", &frenchHyphenator},
-                                       {"german", "de", &germanHyphenator},
-                                       {"russian", "ru", &russianHyphenator},
-                                       {"spanish", "es", &spanishHyphenator}}};
-  return kEntries;
-}
+std::string runtimeTag;
+const LanguageHyphenator* runtimeHyphenator = nullptr;
 
 }  // namespace
 
+std::string primaryLanguageSubtag(const std::string& langTag) {
+  std::string primary;
+  primary.reserve(langTag.size());
+  for (char c : langTag) {
+    if (c == '-' || c == '_') break;
+    if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    primary.push_back(c);
+  }
+  return primary;
+}
+
 const LanguageHyphenator* getLanguageHyphenatorForPrimaryTag(const std::string& primaryTag) {
-  const auto& allEntries = entries();
-  const auto it = std::find_if(allEntries.begin(), allEntries.end(),
+  const auto it = std::find_if(kEntries, kEntries + kEntryCount,
                                [&primaryTag](const LanguageEntry& entry) { return primaryTag == entry.primaryTag; });
-  return (it != allEntries.end()) ? it->hyphenator : nullptr;
+  if (it != kEntries + kEntryCount) {
+    return it->hyphenator;
+  }
+  return (runtimeHyphenator && primaryTag == runtimeTag) ? runtimeHyphenator : nullptr;
 }
 
-LanguageEntryView getLanguageEntries() {
-  const auto& allEntries = entries();
-  return LanguageEntryView{allEntries.data(), allEntries.size()};
+void setRuntimeLanguageHyphenator(const std::string& primaryTag, const LanguageHyphenator* hyphenator) {
+  runtimeTag = hyphenator ? primaryTag : std::string();
+  runtimeHyphenator = hyphenator;
 }
+
+LanguageEntryView getLanguageEntries() { return LanguageEntryView{kEntries, kEntryCount}; }
@@ -19,8 +19,15 @@ struct LanguageEntryView {
   const LanguageEntry* end() const { return data + size; }
 };
 
+// Extracts the lowercase primary subtag of a BCP-47 language tag (e.g. "en-US" -> "en").
+std::string primaryLanguageSubtag(const std::string& langTag);
+
 // Returns the Liang-backed hyphenator for a given primary language tag (e.g., "en", "fr").
 const LanguageHyphenator* getLanguageHyphenatorForPrimaryTag(const std::string& primaryTag);
 
+// Registers a hyphenator loaded at runtime (see SdHyphenation) for a language that isn't compiled in, replacing the
+// previous one. Pass nullptr to unregister. The caller keeps ownership.
+void setRuntimeLanguageHyphenator(const std::string& primaryTag, const LanguageHyphenator* hyphenator);
+
 // Exposes the list of supported languages primarily for tooling/tests.
 LanguageEntryView getLanguageEntries();
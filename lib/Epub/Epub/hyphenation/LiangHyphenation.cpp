@@ -1,17 +1,24 @@
 #include "LiangHyphenation.h"
 
 #include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
 #include <vector>
 
+#include "PagedHyphenationTrie.h"
+
 /*
  * Liang hyphenation pipeline overview (Typst-style binary trie variant)
  * --------------------------------------------------------------------
  * 1.  Input normalization (buildAugmentedWord)
- *     - Accepts a vector of CodepointInfo structs emitted by the EPUB text
+ *     - Accepts a span of CodepointInfo structs emitted by the EPUB text
  *       parser. Each codepoint is validated with LiangWordConfig::isLetter so
  *       we abort early on digits, punctuation, etc. If the word is valid we
- *       build an "augmented" byte sequence: leading '.', lowercase UTF-8 bytes
- *       for every letter, then a trailing '.'. While doing this we capture the
+ *       build an "augmented" byte sequence in a caller-provided LiangScratch:
+ *       leading '.', lowercase UTF-8 bytes for every letter, then a trailing
+ *       '.'. While doing this we capture the
  *       UTF-8 byte offset for each character and a reverse lookup table that
  *       maps UTF-8 byte indexes back to codepoint indexes. This lets the rest
  *       of the algorithm stay byte-oriented (matching the serialized automaton)
@@ -26,6 +33,13 @@
  *       flash memory; no heap allocations besides the stack-local AutomatonState
  *       structs. getAutomaton caches parseAutomaton results per blob pointer so
  *       multiple words hitting the same language only pay the cost once.
+ *       Tries loaded from the SD card have no flash copy; decodeState then
+ *       pulls each node (and its levels) from a PagedHyphenationTrie cache.
+ *     - The generator also emits a HyphenationFastTable: the root and the
+ *       first levels below it flattened into rows indexed by byte class.
+ *       Every start position goes through those nodes, so walkFastTable
+ *       replaces their linear child scans with one table lookup per byte and
+ *       hands over to the packed nodes below.
  *
  * 3.  Pattern application
  *     - We walk the augmented bytes left-to-right. For each starting byte we
@@ -39,88 +53,82 @@
  *
  * 4.  Output filtering
  *     - collectBreakIndexes converts odd-valued score entries back to codepoint
- *       break positions while enforcing `minPrefix`/`minSuffix` constraints from
- *       LiangWordConfig. The caller (language-specific hyphenators) can then
+ *       break positions (written to a caller-provided array) while
+ *       enforcing `minPrefix`/`minSuffix` constraints from LiangWordConfig. The caller (language-specific hyphenators) can then
  *       translate these indexes into renderer glyph offsets, page layout data,
  *       etc.
  *
  * Keeping the entire algorithm small and deterministic is critical on the
- * ESP32-C3: we avoid recursion, dynamic allocations per node, or copying the
- * trie. All lookups stay within the generated blob, which lives in flash, and
- * the working buffers (augmented bytes/scores) scale with the word length rather
- * than the pattern corpus.
+ * ESP32-C3: we avoid recursion, dynamic allocations, or copying the trie. All
+ * lookups stay within the generated blob, which lives in flash, and the working
+ * buffers (augmented bytes/scores) live in a fixed-size LiangScratch sized for
+ * the longest word the parser emits. The std::vector entry point is a thin
+ * convenience wrapper for tooling.
  */
 
 namespace {
 
-struct AugmentedWord {
-  std::vector<uint8_t> bytes;
-  std::vector<size_t> charByteOffsets;
-  std::vector<int32_t> byteToCharIndex;
-
-  bool empty() const { return bytes.empty(); }
-  size_t charCount() const { return charByteOffsets.size(); }
-};
-
-// Encode a single Unicode codepoint into UTF-8 and append to the provided buffer.
-size_t encodeUtf8(uint32_t cp, std::vector<uint8_t>& out) {
-  if (cp <= 0x7Fu) {
-    out.push_back(static_cast<uint8_t>(cp));
-    return 1;
-  }
-  if (cp <= 0x7FFu) {
-    out.push_back(static_cast<uint8_t>(0xC0u | ((cp >> 6) & 0x1Fu)));
-    out.push_back(static_cast<uint8_t>(0x80u | (cp & 0x3Fu)));
-    return 2;
-  }
-  if (cp <= 0xFFFFu) {
-    out.push_back(static_cast<uint8_t>(0xE0u | ((cp >> 12) & 0x0Fu)));
-    out.push_back(static_cast<uint8_t>(0x80u | ((cp >> 6) & 0x3Fu)));
-    out.push_back(static_cast<uint8_t>(0x80u | (cp & 0x3Fu)));
-    return 3;
-  }
-  out.push_back(static_cast<uint8_t>(0xF0u | ((cp >> 18) & 0x07u)));
-  out.push_back(static_cast<uint8_t>(0x80u | ((cp >> 12) & 0x3Fu)));
-  out.push_back(static_cast<uint8_t>(0x80u | ((cp >> 6) & 0x3Fu)));
-  out.push_back(static_cast<uint8_t>(0x80u | (cp & 0x3Fu)));
-  return 4;
+// Encode a single Unicode codepoint into UTF-8 at out[pos]. Returns the position after it, or 0 if it doesn't fit.
+size_t encodeUtf8(const uint32_t cp, uint8_t* out, size_t pos, const size_t capacity) {
+  const size_t length = cp <= 0x7Fu ? 1 : (cp <= 0x7FFu ? 2 : (cp <= 0xFFFFu ? 3 : 4));
+  if (pos + length > capacity) {
+    return 0;
+  }
+  switch (length) {
+    case 1:
+      out[pos++] = static_cast<uint8_t>(cp);
+      break;
+    case 2:
+      out[pos++] = static_cast<uint8_t>(0xC0u | ((cp >> 6) & 0x1Fu));
+      out[pos++] = static_cast<uint8_t>(0x80u | (cp & 0x3Fu));
+      break;
+    case 3:
+      out[pos++] = static_cast<uint8_t>(0xE0u | ((cp >> 12) & 0x0Fu));
+      out[pos++] = static_cast<uint8_t>(0x80u | ((cp >> 6) & 0x3Fu));
+      out[pos++] = static_cast<uint8_t>(0x80u | (cp & 0x3Fu));
+      break;
+    default:
+      out[pos++] = static_cast<uint8_t>(0xF0u | ((cp >> 18) & 0x07u));
+      out[pos++] = static_cast<uint8_t>(0x80u | ((cp >> 12) & 0x3Fu));
+      out[pos++] = static_cast<uint8_t>(0x80u | ((cp >> 6) & 0x3Fu));
+      out[pos++] = static_cast<uint8_t>(0x80u | (cp & 0x3Fu));
+      break;
+  }
+  return pos;
 }
 
-// Build the dotted, lowercase UTF-8 representation plus lookup tables.
-AugmentedWord buildAugmentedWord(const std::vector<CodepointInfo>& cps, const LiangWordConfig& config) {
-  AugmentedWord word;
-  if (cps.empty()) {
-    return word;
+// Build the dotted, lowercase UTF-8 representation plus lookup tables in scratch.
+// Returns the augmented byte count, or 0 when the word contains a non-letter or doesn't fit.
+size_t buildAugmentedWord(const CodepointInfo* cps, const size_t cpCount, const LiangWordConfig& config,
+                          LiangScratch& scratch) {
+  if (cpCount == 0 || cpCount > LiangScratch::kMaxCodepoints) {
+    return 0;
   }
 
-  word.bytes.reserve(cps.size() * 2 + 2);
-  word.charByteOffsets.reserve(cps.size() + 2);
+  size_t byteCount = 0;
+  scratch.charByteOffsets[0] = 0;
+  scratch.bytes[byteCount++] = '.';
 
-  word.charByteOffsets.push_back(0);
-  word.bytes.push_back('.');
-
-  for (const auto& info : cps) {
-    if (!config.isLetter(info.value)) {
-      word.bytes.clear();
-      word.charByteOffsets.clear();
-      word.byteToCharIndex.clear();
-      return word;
+  for (size_t i = 0; i < cpCount; ++i) {
+    if (!config.isLetter(cps[i].value)) {
+      return 0;
+    }
+    scratch.charByteOffsets[i + 1] = static_cast<uint16_t>(byteCount);
+    // Keep one byte back for the trailing '.'
+    byteCount = encodeUtf8(config.toLower(cps[i].value), scratch.bytes, byteCount, LiangScratch::kMaxBytes - 1);
+    if (byteCount == 0) {
+      return 0;
     }
-    word.charByteOffsets.push_back(word.bytes.size());
-    encodeUtf8(config.toLower(info.value), word.bytes);
   }
 
-  word.charByteOffsets.push_back(word.bytes.size());
-  word.bytes.push_back('.');
+  scratch.charByteOffsets[cpCount + 1] = static_cast<uint16_t>(byteCount);
+  scratch.bytes[byteCount++] = '.';
 
-  word.byteToCharIndex.assign(word.bytes.size(), -1);
-  for (size_t i = 0; i < word.charByteOffsets.size(); ++i) {
-    const size_t offset = word.charByteOffsets[i];
-    if (offset < word.byteToCharIndex.size()) {
-      word.byteToCharIndex[offset] = static_cast<int32_t>(i);
-    }
+  memset(scratch.byteToCharIndex, LiangScratch::kNoChar, byteCount);
+  for (size_t i = 0; i < cpCount + 2; ++i) {
+    scratch.byteToCharIndex[scratch.charByteOffsets[i]] = static_cast<uint8_t>(i);
   }
-  return word;
+  return byteCount;
 }
 
 // Decoded view of a single trie node pulled straight out of the serialized blob.
@@ -149,8 +157,10 @@ struct EmbeddedAutomaton {
   const uint8_t* data = nullptr;
   size_t size = 0;
   uint32_t rootOffset = 0;
+  // Nodes come from here instead of data for tries that are not memory mapped
+  PagedHyphenationTrie* paged = nullptr;
 
-  bool valid() const { return data != nullptr && size >= 4 && rootOffset < size; }
+  bool valid() const { return (data != nullptr || paged != nullptr) && size >= 4 && rootOffset < size; }
 };
 
 // Decode the serialized automaton header and root offset.
@@ -172,6 +182,15 @@ EmbeddedAutomaton parseAutomaton(const SerializedHyphenationPatterns& patterns)
   return automaton;
 }
 
+// Paged tries already know their root. They are not cached by descriptor address since they can be unloaded.
+EmbeddedAutomaton pagedAutomaton(const SerializedHyphenationPatterns& patterns) {
+  EmbeddedAutomaton automaton;
+  automaton.paged = patterns.paged;
+  automaton.size = patterns.paged->size();
+  automaton.rootOffset = patterns.paged->rootOffset();
+  return automaton;
+}
+
 // Cache parsed automata per blob pointer to avoid reparsing.
 const EmbeddedAutomaton& getAutomaton(const SerializedHyphenationPatterns& patterns) {
   struct CacheEntry {
@@ -199,6 +218,14 @@ AutomatonState decodeState(const EmbeddedAutomaton& automaton, size_t addr) {
 
   const uint8_t* base = automaton.data + addr;
   size_t remaining = automaton.size - addr;
+  PagedHyphenationTrie::Node pagedNode;
+  if (automaton.paged) {
+    if (!automaton.paged->node(addr, pagedNode)) {
+      return state;
+    }
+    base = pagedNode.bytes;
+    remaining = pagedNode.length;
+  }
   size_t pos = 0;
 
   const uint8_t header = base[pos++];
@@ -234,7 +261,10 @@ AutomatonState decodeState(const EmbeddedAutomaton& automaton, size_t addr) {
     if (offset + levelsLen > automaton.size) {
       return AutomatonState{};
     }
-    levelsPtr = automaton.data + offset;
+    levelsPtr = automaton.paged ? automaton.paged->levels(offset, levelsLen) : automaton.data + offset;
+    if (!levelsPtr) {
+      return AutomatonState{};
+    }
   }
 
   if (pos + childCount > remaining) {
@@ -249,7 +279,8 @@ AutomatonState decodeState(const EmbeddedAutomaton& automaton, size_t addr) {
   }
   const uint8_t* targets = base + pos;
 
-  state.data = automaton.data;
+  // Paged tries have no blob pointer, the copied node bytes stand in for it.
+  state.data = automaton.paged ? base : automaton.data;
   state.size = automaton.size;
   state.addr = addr;
   state.stride = stride;
@@ -300,106 +331,279 @@ bool transition(const EmbeddedAutomaton& automaton, const AutomatonState& state,
   return false;
 }
 
-// Converts odd score positions back into codepoint indexes, honoring min prefix/suffix constraints.
-// Each break corresponds to scores[breakIndex + 1] because of the leading '.' sentinel.
-// Convert odd score entries into hyphen positions while honoring prefix/suffix limits.
-std::vector<size_t> collectBreakIndexes(const std::vector<CodepointInfo>& cps, const std::vector<uint8_t>& scores,
-                                        const size_t minPrefix, const size_t minSuffix) {
-  std::vector<size_t> indexes;
-  const size_t cpCount = cps.size();
-  if (cpCount < 2) {
-    return indexes;
+// Apply a node's packed "dist+level" bytes to the scores of a match that started at byteStart.
+void applyLevels(const uint8_t* levels, const size_t levelsLen, const size_t byteStart, const size_t byteCount,
+                 const size_t charCount, LiangScratch& scratch) {
+  size_t offset = 0;
+  // Each packed byte stores the byte-distance delta and the Liang level digit.
+  for (size_t i = 0; i < levelsLen; ++i) {
+    const uint8_t packed = levels[i];
+    const size_t dist = static_cast<size_t>(packed / 10);
+    const uint8_t level = static_cast<uint8_t>(packed % 10);
+
+    offset += dist;
+    const size_t splitByte = byteStart + offset;
+    if (splitByte >= byteCount) {
+      continue;
+    }
+
+    const uint8_t boundary = scratch.byteToCharIndex[splitByte];
+    if (boundary == LiangScratch::kNoChar) {
+      continue;  // Mid-codepoint byte, wait for the next one.
+    }
+    if (boundary < 2 || boundary + 2u > charCount) {
+      continue;  // Skip splits that land in the leading/trailing sentinels.
+    }
+
+    scratch.scores[boundary] = std::max(scratch.scores[boundary], level);
   }
+}
 
-  for (size_t breakIndex = 1; breakIndex < cpCount; ++breakIndex) {
-    if (breakIndex < minPrefix) {
-      continue;
+// Follow the flattened top levels from the root starting at cursor. Returns false when the match ends inside the
+// table, otherwise `out` is the first packed node below it and cursor points at the next byte to feed.
+bool walkFastTable(const EmbeddedAutomaton& automaton, const HyphenationFastTable& table, const size_t byteStart,
+                   const size_t byteCount, const size_t charCount, LiangScratch& scratch, size_t& cursor,
+                   AutomatonState& out) {
+  size_t row = 0;
+  while (cursor < byteCount) {
+    const uint8_t byteClass = table.byteClasses[scratch.bytes[cursor]];
+    const uint32_t entry = byteClass == 0 ? 0 : table.entries[row * table.classCount + byteClass];
+    if (entry == 0) {
+      return false;
     }
+    ++cursor;
 
-    const size_t suffixCount = cpCount - breakIndex;
-    if (suffixCount < minSuffix) {
-      continue;
+    if ((entry & HyphenationFastTable::kRowFlag) == 0) {
+      out = decodeState(automaton, entry);
+      if (!out.valid()) {
+        return false;
+      }
+      if (out.levels) {
+        applyLevels(out.levels, out.levelsLen, byteStart, byteCount, charCount, scratch);
+      }
+      return true;
     }
 
-    const size_t scoreIdx = breakIndex + 1;
-    if (scoreIdx >= scores.size()) {
-      break;
+    row = entry & ~HyphenationFastTable::kRowFlag;
+    if (row >= table.rowCount) {
+      return false;
     }
-    if ((scores[scoreIdx] & 1u) == 0) {
+    // Same 12-bit offset + 4-bit length packing as the node headers.
+    const uint16_t levelsRef = table.rowLevels[row];
+    const size_t levelsOffset = levelsRef >> 4;
+    const size_t levelsLen = levelsRef & 0x0Fu;
+    if (levelsLen == 0) {
       continue;
     }
-    indexes.push_back(breakIndex);
+    if (table.levelsData) {
+      applyLevels(table.levelsData + levelsOffset, levelsLen, byteStart, byteCount, charCount, scratch);
+    } else if (levelsOffset + levelsLen <= automaton.size) {
+      applyLevels(automaton.data + levelsOffset, levelsLen, byteStart, byteCount, charCount, scratch);
+    }
   }
+  return false;
+}
 
-  return indexes;
+// Child transitions of one node, copied out so the node can be released (paged tries reuse node buffers).
+struct NodeChildren {
+  uint32_t addr = 0;
+  std::vector<std::pair<uint8_t, uint32_t>> children;
+  uint8_t levels[15] = {};
+  uint8_t levelsLen = 0;
+};
+
+bool readNodeChildren(const EmbeddedAutomaton& automaton, const uint32_t addr, NodeChildren& out) {
+  const AutomatonState state = decodeState(automaton, addr);
+  if (!state.valid() || state.levelsLen > sizeof(out.levels)) {
+    return false;
+  }
+  out.addr = addr;
+  out.levelsLen = static_cast<uint8_t>(state.levelsLen);
+  if (state.levels) {
+    memcpy(out.levels, state.levels, state.levelsLen);
+  }
+  out.children.clear();
+  for (size_t idx = 0; idx < state.childCount; ++idx) {
+    const int64_t child = static_cast<int64_t>(addr) + decodeDelta(state.targets + idx * state.stride, state.stride);
+    if (child < 0 || static_cast<size_t>(child) >= automaton.size) {
+      return false;
+    }
+    out.children.emplace_back(state.transitions[idx], static_cast<uint32_t>(child));
+  }
+  return true;
+}
+
+// Converts odd score positions back into codepoint indexes, honoring min prefix/suffix constraints.
+// Each break corresponds to scores[breakIndex + 1] because of the leading '.' sentinel.
+size_t collectBreakIndexes(const size_t cpCount, const uint8_t* scores, const size_t minPrefix,
+                           const size_t minSuffix, uint16_t* out, const size_t maxBreaks) {
+  size_t count = 0;
+  for (size_t breakIndex = std::max<size_t>(1, minPrefix); breakIndex < cpCount && count < maxBreaks; ++breakIndex) {
+    if (cpCount - breakIndex < minSuffix) {
+      break;
+    }
+    if ((scores[breakIndex + 1] & 1u) != 0) {
+      out[count++] = static_cast<uint16_t>(breakIndex);
+    }
+  }
+  return count;
 }
 
 }  // namespace
 
 // Entry point that runs the full Liang pipeline for a single word.
-std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
-                                      const SerializedHyphenationPatterns& patterns, const LiangWordConfig& config) {
-  const auto augmented = buildAugmentedWord(cps, config);
-  if (augmented.empty()) {
-    return {};
+size_t liangBreakIndexes(const CodepointInfo* cps, const size_t cpCount, const SerializedHyphenationPatterns& patterns,
+                         const LiangWordConfig& config, LiangScratch& scratch, uint16_t* out, const size_t maxBreaks) {
+  const size_t byteCount = buildAugmentedWord(cps, cpCount, config, scratch);
+  if (byteCount == 0) {
+    return 0;
   }
 
-  const EmbeddedAutomaton& automaton = getAutomaton(patterns);
+  const EmbeddedAutomaton automaton = patterns.paged ? pagedAutomaton(patterns) : getAutomaton(patterns);
   if (!automaton.valid()) {
-    return {};
+    return 0;
   }
 
   const AutomatonState root = decodeState(automaton, automaton.rootOffset);
   if (!root.valid()) {
-    return {};
+    return 0;
   }
 
   // Liang scores: one entry per augmented char (leading/trailing dots included).
-  std::vector<uint8_t> scores(augmented.charCount(), 0);
-
-  // Walk every starting character position and stream bytes through the trie.
-  for (size_t charStart = 0; charStart < augmented.charByteOffsets.size(); ++charStart) {
-    const size_t byteStart = augmented.charByteOffsets[charStart];
+  const size_t charCount = cpCount + 2;
+  memset(scratch.scores, 0, charCount);
+
+  // Walk every starting character position and stream bytes through the trie. The flattened table, when present,
+  // replaces the root and first levels, which every start position goes through.
+  const HyphenationFastTable* fastTable = patterns.fastTable;
+  for (size_t charStart = 0; charStart < charCount; ++charStart) {
+    const size_t byteStart = scratch.charByteOffsets[charStart];
+    size_t cursor = byteStart;
     AutomatonState state = root;
+    if (fastTable && !walkFastTable(automaton, *fastTable, byteStart, byteCount, charCount, scratch, cursor, state)) {
+      continue;  // Match ended within the flattened levels.
+    }
 
-    for (size_t cursor = byteStart; cursor < augmented.bytes.size(); ++cursor) {
+    for (; cursor < byteCount; ++cursor) {
       AutomatonState next;
-      if (!transition(automaton, state, augmented.bytes[cursor], next)) {
+      if (!transition(automaton, state, scratch.bytes[cursor], next)) {
         break;  // No more matches for this prefix.
       }
       state = next;
 
       if (state.levels && state.levelsLen > 0) {
-        size_t offset = 0;
-        // Each packed byte stores the byte-distance delta and the Liang level digit.
-        for (size_t i = 0; i < state.levelsLen; ++i) {
-          const uint8_t packed = state.levels[i];
-          const size_t dist = static_cast<size_t>(packed / 10);
-          const uint8_t level = static_cast<uint8_t>(packed % 10);
-
-          offset += dist;
-          const size_t splitByte = byteStart + offset;
-          if (splitByte >= augmented.byteToCharIndex.size()) {
-            continue;
-          }
-
-          const int32_t boundary = augmented.byteToCharIndex[splitByte];
-          if (boundary < 0) {
-            continue;  // Mid-codepoint byte, wait for the next one.
-          }
-          if (boundary < 2 || boundary + 2 > static_cast<int32_t>(augmented.charCount())) {
-            continue;  // Skip splits that land in the leading/trailing sentinels.
-          }
-
-          const size_t idx = static_cast<size_t>(boundary);
-          if (idx >= scores.size()) {
-            continue;
-          }
-          scores[idx] = std::max(scores[idx], level);
+        applyLevels(state.levels, state.levelsLen, byteStart, byteCount, charCount, scratch);
+      }
+    }
+  }
+
+  return collectBreakIndexes(cpCount, scratch.scores, config.minPrefix, config.minSuffix, out, maxBreaks);
+}
+
+bool buildHyphenationFastTable(const SerializedHyphenationPatterns& patterns, const size_t maxBytes,
+                               OwnedHyphenationFastTable& out) {
+  const EmbeddedAutomaton automaton = patterns.paged ? pagedAutomaton(patterns) : getAutomaton(patterns);
+  if (!automaton.valid()) {
+    return false;
+  }
+
+  // Class 0 is reserved for "no transition"
+  const auto countClasses = [](const std::vector<NodeChildren>& nodes, uint8_t* classes) {
+    memset(classes, 0, 256);
+    size_t count = 1;
+    for (const auto& node : nodes) {
+      for (const auto& child : node.children) {
+        if (classes[child.first] == 0) {
+          classes[child.first] = 1;
+          count++;
+        }
+      }
+    }
+    return count;
+  };
+  const auto tableBytes = [](const size_t rowCount, const size_t classCount) {
+    return 256 + rowCount * (classCount * sizeof(uint32_t) + sizeof(uint16_t)) + rowCount * 15;
+  };
+
+  std::vector<NodeChildren> rows(1);
+  if (!readNodeChildren(automaton, automaton.rootOffset, rows[0])) {
+    return false;
+  }
+  uint8_t classes[256];
+  size_t classCount = countClasses(rows, classes);
+  if (tableBytes(1, classCount) > maxBytes) {
+    return false;
+  }
+
+  // Go one level deeper at a time while the table still fits
+  size_t levelStart = 0;
+  while (true) {
+    std::vector<NodeChildren> deeper = rows;
+    for (size_t i = levelStart; i < rows.size(); ++i) {
+      for (const auto& child : rows[i].children) {
+        deeper.emplace_back();
+        if (!readNodeChildren(automaton, child.second, deeper.back())) {
+          return false;
+        }
+      }
+    }
+    uint8_t deeperClasses[256];
+    const size_t deeperClassCount = countClasses(deeper, deeperClasses);
+    if (deeper.size() == rows.size() || deeper.size() > UINT16_MAX || deeperClassCount > UINT8_MAX ||
+        tableBytes(deeper.size(), deeperClassCount) > maxBytes) {
+      break;
+    }
+    levelStart = rows.size();
+    rows = std::move(deeper);
+    classCount = deeperClassCount;
+    memcpy(classes, deeperClasses, sizeof(classes));
+  }
+
+  // Number the classes in byte order, like the generator
+  out.byteClasses.reset(new (std::nothrow) uint8_t[256]);
+  out.entries.reset(new (std::nothrow) uint32_t[rows.size() * classCount]);
+  out.rowLevels.reset(new (std::nothrow) uint16_t[rows.size()]);
+  out.levels.reset(new (std::nothrow) uint8_t[rows.size() * sizeof(NodeChildren::levels)]);
+  if (!out.byteClasses || !out.entries || !out.rowLevels || !out.levels) {
+    return false;
+  }
+  uint8_t nextClass = 1;
+  for (size_t byte = 0; byte < 256; ++byte) {
+    out.byteClasses[byte] = classes[byte] ? nextClass++ : 0;
+  }
+
+  memset(out.entries.get(), 0, rows.size() * classCount * sizeof(uint32_t));
+  size_t levelsSize = 0;
+  for (size_t row = 0; row < rows.size(); ++row) {
+    for (const auto& child : rows[row].children) {
+      uint32_t entry = child.second;
+      for (size_t target = 1; target < rows.size(); ++target) {
+        if (rows[target].addr == child.second) {
+          entry = HyphenationFastTable::kRowFlag | static_cast<uint32_t>(target);
+          break;
         }
       }
+      out.entries[row * classCount + out.byteClasses[child.first]] = entry;
     }
+    memcpy(out.levels.get() + levelsSize, rows[row].levels, rows[row].levelsLen);
+    out.rowLevels[row] = rows[row].levelsLen == 0 ? 0 : static_cast<uint16_t>((levelsSize << 4) | rows[row].levelsLen);
+    levelsSize += rows[row].levelsLen;
   }
 
-  return collectBreakIndexes(cps, scores, config.minPrefix, config.minSuffix);
+  out.table.byteClasses = out.byteClasses.get();
+  out.table.entries = out.entries.get();
+  out.table.rowLevels = out.rowLevels.get();
+  out.table.rowCount = static_cast<uint16_t>(rows.size());
+  out.table.classCount = static_cast<uint8_t>(classCount);
+  out.table.levelsData = out.levels.get();
+  return true;
+}
+
+std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
+                                      const SerializedHyphenationPatterns& patterns, const LiangWordConfig& config) {
+  const std::unique_ptr<LiangScratch> scratch(new LiangScratch);
+  uint16_t indexes[LiangScratch::kMaxCodepoints];
+  const size_t count =
+      liangBreakIndexes(cps.data(), cps.size(), patterns, config, *scratch, indexes, LiangScratch::kMaxCodepoints);
+  return std::vector<size_t>(indexes, indexes + count);
 }
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "HyphenationCommon.h"
@@ -33,6 +34,40 @@ struct LiangWordConfig {
       : isLetter(letterFn), toLower(lowerFn), minPrefix(prefix), minSuffix(suffix) {}
 };
 
+// Fixed-capacity working memory for the allocation-free evaluator. Sized for the longest word the EPUB parser emits
+// (MAX_WORD_SIZE bytes, so at most that many codepoints); longer words simply get no breaks.
+struct LiangScratch {
+  static constexpr size_t kMaxCodepoints = 200;
+  // Dotted, lowercased UTF-8. Every letter the built-in languages accept lowercases to at most 2 bytes.
+  static constexpr size_t kMaxBytes = kMaxCodepoints * 2 + 2;
+  static constexpr uint8_t kNoChar = 0xFF;
+
+  uint8_t bytes[kMaxBytes];
+  uint16_t charByteOffsets[kMaxCodepoints + 2];
+  // Augmented char index starting at each byte, kNoChar for continuation bytes
+  uint8_t byteToCharIndex[kMaxBytes];
+  uint8_t scores[kMaxCodepoints + 2];
+};
+
+// HyphenationFastTable built at runtime, for tries that don't come with a generated one (SD card languages).
+struct OwnedHyphenationFastTable {
+  HyphenationFastTable table{};
+  std::unique_ptr<uint8_t[]> byteClasses;
+  std::unique_ptr<uint32_t[]> entries;
+  std::unique_ptr<uint16_t[]> rowLevels;
+  std::unique_ptr<uint8_t[]> levels;
+};
+
+// Flattens the top levels of the trie, going one level deeper at a time while the table fits in maxBytes, the same
+// way generate_hyphenation_trie.py does. Returns false if not even the root row fits or the trie can't be read.
+bool buildHyphenationFastTable(const SerializedHyphenationPatterns& patterns, size_t maxBytes,
+                               OwnedHyphenationFastTable& out);
+
 // Shared Liang pattern evaluator used by every language-specific hyphenator.
 std::vector<size_t> liangBreakIndexes(const std::vector<CodepointInfo>& cps,
                                       const SerializedHyphenationPatterns& patterns, const LiangWordConfig& config);
+
+// Allocation-free evaluator for the layout hot path. Writes up to maxBreaks codepoint break indexes (ascending) into
+// out and returns how many were written.
+size_t liangBreakIndexes(const CodepointInfo* cps, size_t cpCount, const SerializedHyphenationPatterns& patterns,
+                         const LiangWordConfig& config, LiangScratch& scratch, uint16_t* out, size_t maxBreaks);
@@ -0,0 +1,335 @@
+#include "PagedHyphenationTrie.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Header byte, overflowed child count, levels reference and 255 children with 3 byte targets.
+constexpr size_t kMaxNodeBytes = 1 + 1 + 2 + 255 * 4;
+constexpr size_t kMaxLevelsBytes = 15;
+constexpr uint32_t kNoPage = UINT32_MAX;
+// The levels list starts right after the root offset and is well under 1 KB in every bundled language.
+constexpr size_t kPinnedLevelsBytes = 1024;
+// Address and start of each pinned node, the hash slots come on top
+constexpr size_t kPinnedIndexBytes = sizeof(uint32_t) + sizeof(uint16_t);
+// Header byte and levels reference of a node without children
+constexpr size_t kMinNodeBytes = 3;
+
+static_assert(PagedHyphenationTrie::kPinnedBytes <= UINT16_MAX, "Pinned node starts are stored as uint16_t");
+
+struct NodeLayout {
+  bool hasLevels;
+  uint8_t stride;
+  size_t childCount;
+  size_t levelsRefPos;
+  size_t length;
+};
+
+// Only the fields that determine the node length and where its parts are, decodeState in LiangHyphenation.cpp
+// does the rest. header[1] is only read when the child count overflows into it.
+NodeLayout parseLayout(const uint8_t* header) {
+  NodeLayout layout{};
+  layout.hasLevels = (header[0] >> 7) != 0;
+  layout.stride = static_cast<uint8_t>((header[0] >> 5) & 0x03u);
+  if (layout.stride == 0) {
+    layout.stride = 1;
+  }
+  layout.childCount = header[0] & 0x1Fu;
+  layout.length = 1;
+  if (layout.childCount == 31u) {
+    layout.childCount = header[1];
+    layout.length++;
+  }
+  layout.levelsRefPos = layout.length;
+  if (layout.hasLevels) {
+    layout.length += 2;
+  }
+  layout.length += layout.childCount * (1 + layout.stride);
+  return layout;
+}
+
+// Signed distance from a node to its index-th child, same encoding as decodeDelta in LiangHyphenation.cpp
+int32_t childDelta(const uint8_t* bytes, const NodeLayout& layout, const size_t index) {
+  const uint8_t* target = bytes + layout.levelsRefPos + (layout.hasLevels ? 2 : 0) + layout.childCount +
+                          index * layout.stride;
+  if (layout.stride == 1) {
+    return static_cast<int8_t>(target[0]);
+  }
+  if (layout.stride == 2) {
+    return static_cast<int16_t>((static_cast<uint16_t>(target[0]) << 8) | static_cast<uint16_t>(target[1]));
+  }
+  return ((static_cast<int32_t>(target[0]) << 16) | (static_cast<int32_t>(target[1]) << 8) |
+          static_cast<int32_t>(target[2])) -
+         (1 << 23);
+}
+
+// Hash slots for count pinned nodes, at most half of them used
+size_t pinnedSlotCount(const size_t count) {
+  size_t slots = 1;
+  while (slots < count * 2) {
+    slots *= 2;
+  }
+  return slots;
+}
+
+// RAM taken by count pinned nodes of nodeBytes in total, with their index
+size_t pinnedFootprint(const size_t count, const size_t nodeBytes) {
+  return nodeBytes + count * kPinnedIndexBytes + pinnedSlotCount(count) * sizeof(uint16_t);
+}
+
+}  // namespace
+
+struct PagedHyphenationTrie::Page {
+  uint32_t index = kNoPage;
+  uint16_t length = 0;
+  uint8_t bytes[kPageSize];
+};
+
+PagedHyphenationTrie::PagedHyphenationTrie(std::unique_ptr<HyphenationTrieSource> source)
+    : source_(std::move(source)) {}
+
+PagedHyphenationTrie::~PagedHyphenationTrie() = default;
+
+bool PagedHyphenationTrie::open() {
+  static_assert(kPageCount <= INT8_MAX, "Page slots are stored as int8_t");
+  if (!source_) {
+    return false;
+  }
+  size_ = source_->size();
+  if (size_ < 5) {
+    return false;
+  }
+
+  const size_t pageTotal = (size_ + kPageSize - 1) / kPageSize;
+  pages_.reset(new (std::nothrow) Page[kPageCount]);
+  pageUsed_.reset(new (std::nothrow) uint8_t[kPageCount]());
+  pageSlots_.reset(new (std::nothrow) int8_t[pageTotal]);
+  straddling_.reset(new (std::nothrow) uint8_t[kMaxNodeBytes]);
+  straddlingLevels_.reset(new (std::nothrow) uint8_t[kMaxLevelsBytes]);
+  if (!pages_ || !pageUsed_ || !pageSlots_ || !straddling_ || !straddlingLevels_) {
+    return false;
+  }
+  memset(pageSlots_.get(), -1, pageTotal);
+
+  uint8_t header[4];
+  const uint8_t* headerBytes = bytesAt(0, sizeof(header), header);
+  if (!headerBytes) {
+    return false;
+  }
+  rootOffset_ = (static_cast<uint32_t>(headerBytes[0]) << 24) | (static_cast<uint32_t>(headerBytes[1]) << 16) |
+                (static_cast<uint32_t>(headerBytes[2]) << 8) | static_cast<uint32_t>(headerBytes[3]);
+  if (rootOffset_ >= size_) {
+    return false;
+  }
+
+  // Pin the start of the blob, where the shared levels list lives, so level lookups don't compete with nodes
+  levelsPinned_ = std::min(size_, kPinnedLevelsBytes);
+  levels_.reset(new (std::nothrow) uint8_t[levelsPinned_]);
+  if (!levels_ || !source_->read(0, levels_.get(), levelsPinned_)) {
+    return false;
+  }
+  return pinLevels();
+}
+
+bool PagedHyphenationTrie::pinLevels() {
+  // Walk down from the root a level at a time and keep each level whose nodes all fit in the budget
+  std::vector<uint32_t> kept;
+  std::vector<uint32_t> level{rootOffset_};
+  size_t nodeBytes = 0;
+  while (!level.empty()) {
+    std::vector<uint32_t> next;
+    size_t levelBytes = 0;
+    size_t levelCount = 0;
+    bool fits = true;
+    for (const uint32_t addr : level) {
+      Node node;
+      if (!loadNode(addr, node)) {
+        return false;
+      }
+      levelBytes += node.length;
+      ++levelCount;
+      if (pinnedFootprint(kept.size() + levelCount, nodeBytes + levelBytes) > kPinnedBytes) {
+        fits = false;
+        break;
+      }
+      const NodeLayout layout = parseLayout(node.bytes);
+      // Collect the next level only while it could still fit
+      const size_t nextCount = next.size() + layout.childCount;
+      if (pinnedFootprint(kept.size() + level.size() + nextCount, nodeBytes + nextCount * kMinNodeBytes) >
+          kPinnedBytes) {
+        continue;
+      }
+      for (size_t i = 0; i < layout.childCount; ++i) {
+        const int64_t child = static_cast<int64_t>(addr) + childDelta(node.bytes, layout, i);
+        if (child > 0 && static_cast<size_t>(child) < size_) {
+          next.push_back(static_cast<uint32_t>(child));
+        }
+      }
+    }
+    if (!fits) {
+      break;
+    }
+    nodeBytes += levelBytes;
+    kept.insert(kept.end(), level.begin(), level.end());
+    std::sort(kept.begin(), kept.end());
+    ++pinnedLevels_;
+
+    // Nodes can be shared between parents, keep each once
+    std::sort(next.begin(), next.end());
+    next.erase(std::unique(next.begin(), next.end()), next.end());
+    const auto pinnedAlready = [&kept](const uint32_t addr) {
+      return std::binary_search(kept.begin(), kept.end(), addr);
+    };
+    next.erase(std::remove_if(next.begin(), next.end(), pinnedAlready), next.end());
+    level = std::move(next);
+  }
+
+  const size_t slotCount = pinnedSlotCount(kept.size());
+  pinnedAddrs_.reset(new (std::nothrow) uint32_t[kept.size()]);
+  pinnedStarts_.reset(new (std::nothrow) uint16_t[kept.size() + 1]);
+  pinnedSlots_.reset(new (std::nothrow) uint16_t[slotCount]());
+  pinned_.reset(new (std::nothrow) uint8_t[nodeBytes]);
+  if (!pinnedAddrs_ || !pinnedStarts_ || !pinnedSlots_ || !pinned_) {
+    return false;
+  }
+  pinnedSlotMask_ = slotCount - 1;
+  // In address order, so each page is read once
+  size_t start = 0;
+  for (size_t i = 0; i < kept.size(); ++i) {
+    Node node;
+    if (!loadNode(kept[i], node)) {
+      return false;
+    }
+    memcpy(pinned_.get() + start, node.bytes, node.length);
+    pinnedAddrs_[i] = kept[i];
+    pinnedStarts_[i] = static_cast<uint16_t>(start);
+    size_t slot = pinnedSlot(kept[i]);
+    while (pinnedSlots_[slot] != 0) {
+      slot = (slot + 1) & pinnedSlotMask_;
+    }
+    pinnedSlots_[slot] = static_cast<uint16_t>(i + 1);
+    start += node.length;
+  }
+  pinnedStarts_[kept.size()] = static_cast<uint16_t>(start);
+  return true;
+}
+
+const uint8_t* PagedHyphenationTrie::page(const uint32_t index, size_t& length) {
+  const int8_t slot = pageSlots_[index];
+  if (slot >= 0) {
+    Page& cached = pages_[slot];
+    pageUsed_[slot] = 1;
+    length = cached.length;
+    return cached.bytes;
+  }
+
+  // Clock replacement: pass over the pages used since the hand last went by, giving each a second chance
+  while (pageUsed_[pageHand_]) {
+    pageUsed_[pageHand_] = 0;
+    pageHand_ = (pageHand_ + 1) % kPageCount;
+  }
+  const size_t victim = pageHand_;
+  pageHand_ = (pageHand_ + 1) % kPageCount;
+  Page& loaded = pages_[victim];
+  if (loaded.index != kNoPage) {
+    pageSlots_[loaded.index] = -1;
+    loaded.index = kNoPage;
+  }
+
+  const size_t pageStart = static_cast<size_t>(index) * kPageSize;
+  const size_t pageLength = std::min(kPageSize, size_ - pageStart);
+  if (!source_->read(pageStart, loaded.bytes, pageLength)) {
+    return nullptr;
+  }
+  stats_.pageReads++;
+  loaded.index = index;
+  loaded.length = static_cast<uint16_t>(pageLength);
+  pageUsed_[victim] = 1;
+  pageSlots_[index] = static_cast<int8_t>(victim);
+  length = pageLength;
+  return loaded.bytes;
+}
+
+const uint8_t* PagedHyphenationTrie::bytesAt(size_t offset, size_t len, uint8_t* scratch) {
+  if (offset + len > size_) {
+    return nullptr;
+  }
+
+  size_t pageLength = 0;
+  const uint8_t* first = page(static_cast<uint32_t>(offset / kPageSize), pageLength);
+  if (!first) {
+    return nullptr;
+  }
+  const size_t pageOffset = offset % kPageSize;
+  if (pageOffset + len <= pageLength) {
+    return first + pageOffset;
+  }
+
+  uint8_t* dst = scratch;
+  while (len > 0) {
+    const uint8_t* bytes = page(static_cast<uint32_t>(offset / kPageSize), pageLength);
+    if (!bytes) {
+      return nullptr;
+    }
+    const size_t chunk = std::min(len, pageLength - offset % kPageSize);
+    memcpy(dst, bytes + offset % kPageSize, chunk);
+    dst += chunk;
+    offset += chunk;
+    len -= chunk;
+  }
+  return scratch;
+}
+
+bool PagedHyphenationTrie::loadNode(const size_t addr, Node& out) {
+  size_t pageLength = 0;
+  const uint8_t* pageBytes = page(static_cast<uint32_t>(addr / kPageSize), pageLength);
+  if (!pageBytes) {
+    return false;
+  }
+  const size_t pageOffset = addr % kPageSize;
+
+  const uint8_t* header = pageOffset + 2 <= pageLength
+                              ? pageBytes + pageOffset
+                              : bytesAt(addr, std::min<size_t>(2, size_ - addr), straddling_.get());
+  if (!header) {
+    return false;
+  }
+  const size_t length = parseLayout(header).length;
+
+  const uint8_t* bytes =
+      pageOffset + length <= pageLength ? pageBytes + pageOffset : bytesAt(addr, length, straddling_.get());
+  if (!bytes) {
+    return false;
+  }
+  out.bytes = bytes;
+  out.length = length;
+  return true;
+}
+
+bool PagedHyphenationTrie::node(const size_t addr, Node& out) {
+  if (addr >= size_) {
+    return false;
+  }
+  stats_.nodeLookups++;
+  for (size_t slot = pinnedSlot(addr); pinnedSlots_[slot] != 0; slot = (slot + 1) & pinnedSlotMask_) {
+    const size_t index = pinnedSlots_[slot] - 1u;
+    if (pinnedAddrs_[index] == addr) {
+      stats_.pinnedLookups++;
+      out.bytes = pinned_.get() + pinnedStarts_[index];
+      out.length = pinnedStarts_[index + 1] - pinnedStarts_[index];
+      return true;
+    }
+  }
+  return loadNode(addr, out);
+}
+
+const uint8_t* PagedHyphenationTrie::levels(const size_t offset, const size_t length) {
+  // The levels list sits at the start of the blob, which is normally pinned. Otherwise the node's own page was
+  // just used and can't be the one evicted by this read.
+  return offset + length <= levelsPinned_ ? levels_.get() + offset
+                                          : bytesAt(offset, length, straddlingLevels_.get());
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Random access to a serialized trie blob that is not memory mapped (e.g. a file on the SD card).
+class HyphenationTrieSource {
+ public:
+  virtual ~HyphenationTrieSource() = default;
+  virtual size_t size() const = 0;
+  // Read len bytes at offset into dst. Returns false on a short read.
+  virtual bool read(size_t offset, uint8_t* dst, size_t len) = 0;
+};
+
+// Serves trie nodes out of a HyphenationTrieSource for the Liang evaluator. The blob is read in fixed-size pages
+// kept in a small cache with clock replacement; nodes are handed out in place from their page, and only nodes
+// straddling a page boundary are copied. Every match walks down from the root, so the top levels of the trie are
+// pinned in RAM, as many whole levels as fit in kPinnedBytes, and only the deeper nodes go through the page cache.
+//
+// Pointers returned by node() stay valid until the next node() call. That is all the evaluator needs: it is done
+// with a node once it has read its levels and located the child to follow.
+class PagedHyphenationTrie {
+ public:
+  static constexpr size_t kPageSize = 512;
+  static constexpr size_t kPageCount = 24;
+  // Pinned node bytes and their index
+  static constexpr size_t kPinnedBytes = 32 * 1024;
+
+  struct Node {
+    const uint8_t* bytes = nullptr;  // Serialized node, same layout as in the blob
+    size_t length = 0;
+  };
+
+  struct Stats {
+    uint32_t nodeLookups = 0;
+    // Node lookups answered by the pinned levels
+    uint32_t pinnedLookups = 0;
+    uint32_t pageReads = 0;
+  };
+
+  explicit PagedHyphenationTrie(std::unique_ptr<HyphenationTrieSource> source);
+  ~PagedHyphenationTrie();
+
+  PagedHyphenationTrie(const PagedHyphenationTrie&) = delete;
+  PagedHyphenationTrie& operator=(const PagedHyphenationTrie&) = delete;
+
+  // Reads the root offset and pins the top levels of the trie. Must succeed before node() is used.
+  bool open();
+
+  size_t size() const { return size_; }
+  uint32_t rootOffset() const { return rootOffset_; }
+  // Number of trie levels, from the root down, whose nodes are pinned
+  size_t pinnedLevels() const { return pinnedLevels_; }
+  bool node(size_t addr, Node& out);
+  // The levels bytes a node refers to, nullptr on a failed read. Valid until the next node() or levels() call.
+  const uint8_t* levels(size_t offset, size_t length);
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Page;
+
+  const uint8_t* page(uint32_t index, size_t& length);
+  // Pointer to len bytes at offset, copied into scratch when they cross a page boundary.
+  const uint8_t* bytesAt(size_t offset, size_t len, uint8_t* scratch);
+  bool loadNode(size_t addr, Node& out);
+  bool pinLevels();
+  size_t pinnedSlot(const uint32_t addr) const { return (addr * 2654435761u >> 16) & pinnedSlotMask_; }
+
+  std::unique_ptr<HyphenationTrieSource> source_;
+  size_t size_ = 0;
+  uint32_t rootOffset_ = 0;
+  std::unique_ptr<Page[]> pages_;
+  // Whether each cache slot was used since the clock hand last passed it
+  std::unique_ptr<uint8_t[]> pageUsed_;
+  size_t pageHand_ = 0;
+  // Cache slot holding each page of the blob, or -1
+  std::unique_ptr<int8_t[]> pageSlots_;
+  std::unique_ptr<uint8_t[]> levels_;
+  size_t levelsPinned_ = 0;
+  // Pinned nodes sorted by address, the bytes of node i are pinned_[pinnedStarts_[i], pinnedStarts_[i + 1])
+  std::unique_ptr<uint32_t[]> pinnedAddrs_;
+  std::unique_ptr<uint16_t[]> pinnedStarts_;
+  // Open addressing table of pinned node indexes plus one, 0 marks an empty slot
+  std::unique_ptr<uint16_t[]> pinnedSlots_;
+  size_t pinnedSlotMask_ = 0;
+  std::unique_ptr<uint8_t[]> pinned_;
+  size_t pinnedLevels_ = 0;
+  std::unique_ptr<uint8_t[]> straddling_;
+  std::unique_ptr<uint8_t[]> straddlingLevels_;
+  Stats stats_;
+};
@@ -0,0 +1,118 @@
+#include "SdHyphenation.h"
+
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "HyphenationCache.h"
+#include "HyphenationCommon.h"
+#include "LanguageRegistry.h"
+#include "PagedHyphenationTrie.h"
+
+namespace {
+
+constexpr char HYPH_DIR[] = "/.crosspoint/hyph";
+// RAM budget for flattening the top trie levels of an SD language, the same default the generator uses for flash
+constexpr size_t FAST_TABLE_BYTES = 8192;
+
+class SdTrieSource : public HyphenationTrieSource {
+ public:
+  explicit SdTrieSource(FsFile file) : file(std::move(file)), fileSize(this->file.size()) {}
+  ~SdTrieSource() override { file.close(); }
+
+  size_t size() const override { return fileSize; }
+
+  bool read(const size_t offset, uint8_t* dst, const size_t len) override {
+    if (!file.seek(offset)) {
+      return false;
+    }
+    return file.read(dst, len) == static_cast<int>(len);
+  }
+
+ private:
+  FsFile file;
+  size_t fileSize;
+};
+
+struct LoadedLanguage {
+  std::string primaryTag;
+  std::unique_ptr<PagedHyphenationTrie> trie;
+  SerializedHyphenationPatterns patterns{nullptr, 0};
+  OwnedHyphenationFastTable fastTable;
+  std::unique_ptr<LanguageHyphenator> hyphenator;
+};
+
+std::unique_ptr<LoadedLanguage> loaded;
+
+bool usesCyrillic(const std::string& primaryTag) {
+  return primaryTag == "ru" || primaryTag == "uk" || primaryTag == "be" || primaryTag == "bg" ||
+         primaryTag == "sr" || primaryTag == "mk";
+}
+
+}  // namespace
+
+void SdHyphenation::prepareLanguage(const std::string& langTag) {
+  const std::string primaryTag = primaryLanguageSubtag(langTag);
+  if (loaded && loaded->primaryTag == primaryTag) {
+    return;
+  }
+  if (primaryTag.empty() || getLanguageHyphenatorForPrimaryTag(primaryTag)) {
+    return;  // Unknown or compiled in, keep any SD language around in case the next book wants it
+  }
+
+  const std::string path = std::string(HYPH_DIR) + "/" + primaryTag + ".bin";
+  if (!SdMan.exists(path.c_str())) {
+    return;
+  }
+
+  unload();
+  FsFile file;
+  if (!SdMan.openFileForRead("HYP", path, file)) {
+    return;
+  }
+
+  std::unique_ptr<LoadedLanguage> language(new (std::nothrow) LoadedLanguage);
+  if (!language) {
+    file.close();
+    return;
+  }
+  language->primaryTag = primaryTag;
+  language->trie.reset(new (std::nothrow) PagedHyphenationTrie(
+      std::unique_ptr<HyphenationTrieSource>(new (std::nothrow) SdTrieSource(std::move(file)))));
+  if (!language->trie || !language->trie->open()) {
+    Serial.printf("[%lu] [HYP] Failed to open %s\n", millis(), path.c_str());
+    return;
+  }
+
+  language->patterns.size = language->trie->size();
+  language->patterns.paged = language->trie.get();
+  if (buildHyphenationFastTable(language->patterns, FAST_TABLE_BYTES, language->fastTable)) {
+    language->patterns.fastTable = &language->fastTable.table;
+  }
+
+  const bool cyrillic = usesCyrillic(primaryTag);
+  language->hyphenator.reset(new (std::nothrow) LanguageHyphenator(
+      language->patterns, cyrillic ? isCyrillicLetter : isLatinLetter, cyrillic ? toLowerCyrillic : toLowerLatin));
+  if (!language->hyphenator) {
+    return;
+  }
+
+  setRuntimeLanguageHyphenator(primaryTag, language->hyphenator.get());
+  Serial.printf("[%lu] [HYP] Loaded %s from SD (%u bytes, %u fast rows, %u pinned levels)\n", millis(),
+                primaryTag.c_str(), static_cast<uint32_t>(language->patterns.size), language->fastTable.table.rowCount,
+                static_cast<uint32_t>(language->trie->pinnedLevels()));
+  loaded = std::move(language);
+}
+
+void SdHyphenation::unload() {
+  if (!loaded) {
+    return;
+  }
+  setRuntimeLanguageHyphenator(loaded->primaryTag, nullptr);
+  // Cached results are keyed by hyphenator address, which a later language could reuse
+  HyphenationCache::clear();
+  loaded.reset();
+}
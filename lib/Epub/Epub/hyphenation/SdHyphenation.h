@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+// Hyphenation languages that are not compiled into the firmware, loaded on demand from
+// /.crosspoint/hyph/<lang>.bin (a serialized trie in the same format generate_hyphenation_trie.py embeds).
+// Only one such language is resident at a time; its nodes are read through a PagedHyphenationTrie.
+class SdHyphenation {
+ public:
+  // Make the language of langTag available to Hyphenator if it isn't compiled in and a trie for it is on the SD
+  // card. Unloads the previously loaded SD language when switching. Call before Hyphenator::setPreferredLanguage.
+  static void prepareLanguage(const std::string& langTag);
+  // Free the loaded language, if any.
+  static void unload();
+};
@@ -3,8 +3,30 @@
 #include <cstddef>
 #include <cstdint>
 
+// Flattened copy of the top trie levels, generated next to the blob by generate_hyphenation_trie.py.
+// Each row mirrors one node: entries[row * classCount + byteClasses[byte]] is 0 when there is no transition,
+// kRowFlag | childRow when the child is flattened too, or the blob address of the child node otherwise.
+// rowLevels holds the node's packed levels reference (12-bit offset, 4-bit length) or 0.
+struct HyphenationFastTable {
+  static constexpr uint32_t kRowFlag = 0x80000000u;
+
+  const std::uint8_t* byteClasses;  // 256 entries, class 0 never has a transition
+  const std::uint32_t* entries;
+  const std::uint16_t* rowLevels;
+  uint16_t rowCount;
+  uint8_t classCount;
+  // Bytes the rowLevels offsets index into. Null means the trie blob itself, as for generated tables.
+  const std::uint8_t* levelsData = nullptr;
+};
+
+class PagedHyphenationTrie;
+
 // Lightweight descriptor that points at a serialized Liang hyphenation trie stored in flash.
 struct SerializedHyphenationPatterns {
   const std::uint8_t* data;
   size_t size;
+  // Optional, the packed trie is walked from the root when absent.
+  const HyphenationFastTable* fastTable = nullptr;
+  // Set instead of data for tries read on demand from storage (see PagedHyphenationTrie).
+  PagedHyphenationTrie* paged = nullptr;
 };
@@ -10865,7 +10865,184 @@ alignas(4) constexpr uint8_t de_trie_data[] = {
     0x7F, 0xD7, 0xDB, 0x7F, 0xDD, 0x75, 0x7F, 0xE7, 0xD3, 0x7F, 0xEB, 0xDF, 0x7F, 0xEF, 0xED, 0x7F, 0xFF, 0x95,
 };
 
+constexpr uint8_t de_fast_classes[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12,
+    0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x00, 0x1D, 0x1E, 0x00, 0x1F, 0x00, 0x00, 0x20, 0x21, 0x22, 0x23,
+    0x24, 0x00, 0x25, 0x00, 0x26, 0x00, 0x27, 0x00, 0x28, 0x00, 0x00, 0x29, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x2B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+constexpr uint32_t de_fast_entries[] = {
+    0x00000000, 0x80000001, 0x80000002, 0x80000004, 0x80000005, 0x80000006, 0x80000007, 0x80000008, 0x80000009,
+    0x8000000A, 0x8000000B, 0x8000000C, 0x8000000D, 0x8000000E, 0x8000000F, 0x80000010, 0x80000011, 0x80000012,
+    0x80000013, 0x80000014, 0x80000015, 0x80000016, 0x80000017, 0x80000018, 0x80000019, 0x8000001A, 0x8000001B,
+    0x8000001C, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x80000003, 0x00000000,
+    0x00000000, 0x000006B3, 0x0000086F, 0x000008B1, 0x00000A23, 0x00000D38, 0x00000E35, 0x00000F35, 0x00001031,
+    0x00001094, 0x000010B8, 0x0000110F, 0x00001236, 0x0000136C, 0x00001446, 0x000014FA, 0x0000159A, 0x00000000,
+    0x000016D9, 0x00001872, 0x00001A4C, 0x00001AFD, 0x00001B2D, 0x00001BF1, 0x00001C01, 0x00001C0C, 0x00001CB6,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000701, 0x00000000, 0x00000000,
+    0x00001DE1, 0x00002040, 0x00002295, 0x00002409, 0x000027BA, 0x00002991, 0x00002B8F, 0x00002D6F, 0x00002E8E,
+    0x00002EBD, 0x00002FFE, 0x000035C6, 0x00003849, 0x00003E78, 0x00003EE0, 0x00003FAB, 0x00003FDA, 0x00004567,
+    0x00004861, 0x00004BAA, 0x00004F98, 0x00005000, 0x00005016, 0x00005035, 0x0000505B, 0x00005096, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00001E15, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00005CCA, 0x00002307,
+    0x00005782, 0x0000573C, 0x00001EFC, 0x000057A9, 0x0000578E, 0x000057B2, 0x000057AE, 0x00002307, 0x00002307,
+    0x000057B8, 0x000057C2, 0x00005AC5, 0x00006272, 0x00000000, 0x00000000, 0x00000000, 0x000065ED, 0x000066C9,
+    0x000066E1, 0x000066FA, 0x00006CC9, 0x00006D2E, 0x00006D5E, 0x00006D6A, 0x00006E96, 0x00006ED2, 0x00006ED7,
+    0x000070B3, 0x000070D2, 0x000070DE, 0x00007216, 0x00007252, 0x00001E22, 0x0000746F, 0x000076D8, 0x00007733,
+    0x000078D5, 0x00001E22, 0x00007910, 0x00000000, 0x00007935, 0x00007957, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x0000667E, 0x00000000, 0x00000000, 0x00007A02, 0x00000000, 0x00007A4A,
+    0x00007A53, 0x00007AD4, 0x00001D70, 0x00001D18, 0x00007F60, 0x00007FB9, 0x00000000, 0x000081AE, 0x00008229,
+    0x00008234, 0x00000000, 0x000082DA, 0x00002285, 0x00001E22, 0x0000833B, 0x0000835D, 0x0000837F, 0x000083A7,
+    0x00007038, 0x00000000, 0x00001E22, 0x000083BE, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00007A39, 0x00000000, 0x00000000, 0x00008872, 0x0000894C, 0x00008963, 0x000089A7,
+    0x0000918E, 0x000091DB, 0x00009216, 0x00009236, 0x0000949A, 0x00001E22, 0x000094DC, 0x0000951B, 0x00002285,
+    0x00009545, 0x000096C9, 0x0000635C, 0x00001E22, 0x000099EF, 0x00009CC7, 0x00009D65, 0x00009EF8, 0x00009F35,
+    0x00009F64, 0x00000000, 0x00009F92, 0x00001E5E, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00008945, 0x00000000, 0x00000000, 0x0000A1D0, 0x0000A3E0, 0x0000A594, 0x0000A701, 0x0000A91C,
+    0x0000AAF7, 0x0000AC68, 0x0000AFB2, 0x0000B63F, 0x0000B691, 0x0000B76F, 0x0000BE0A, 0x0000C01A, 0x0000C7C6,
+    0x0000C8C8, 0x0000C9C9, 0x0000CA0C, 0x0000D40F, 0x0000D8EF, 0x0000DC21, 0x0000DED1, 0x0000DF40, 0x0000DFA4,
+    0x0000E00F, 0x0000E049, 0x0000E081, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x0000A22B, 0x00000000, 0x00000000, 0x0000E382, 0x0000E496, 0x000066E1, 0x0000E4A1, 0x0000E8EC, 0x0000EA4C,
+    0x0000EA9C, 0x0000EAAF, 0x0000EC97, 0x0000ECDF, 0x0000ECEE, 0x0000EE62, 0x0000EEA0, 0x0000EEAB, 0x0000EF9E,
+    0x0000635C, 0x00001E22, 0x0000F18F, 0x0000F3BC, 0x0000F5E6, 0x0000F717, 0x00001E22, 0x00001E22, 0x00000000,
+    0x00001D70, 0x0000F75A, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000E472,
+    0x00000000, 0x00000000, 0x0000FAD6, 0x0000FB72, 0x00002285, 0x0000FBF4, 0x000101E8, 0x00010244, 0x00010269,
+    0x000102B2, 0x00010411, 0x00001E22, 0x0001045F, 0x000106E2, 0x0001072C, 0x00010816, 0x00010962, 0x000109A3,
+    0x000109AE, 0x00010C07, 0x00010F03, 0x00010F6C, 0x000110E4, 0x00011115, 0x0001111C, 0x00000000, 0x00003175,
+    0x00011133, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000FB5F, 0x00000000,
+    0x00000000, 0x00011708, 0x00011845, 0x00011853, 0x0001185E, 0x00011E3B, 0x00011E93, 0x00011EAD, 0x00011EDF,
+    0x000120FD, 0x00000000, 0x0001214E, 0x000123FA, 0x0001256A, 0x000126E8, 0x00012942, 0x00012997, 0x00000000,
+    0x00012D31, 0x00013147, 0x00013678, 0x000138C5, 0x00001E22, 0x00013945, 0x00000000, 0x0001397E, 0x000139A4,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00011826, 0x00000000, 0x00000000,
+    0x00013CA0, 0x00013E9C, 0x00014032, 0x00014161, 0x000146C5, 0x0001487B, 0x00014ABA, 0x00014B51, 0x00014B85,
+    0x00014BB1, 0x00014DCB, 0x00015172, 0x0001533C, 0x000158F3, 0x00015A34, 0x00015AF6, 0x00000000, 0x00015CE1,
+    0x000161B2, 0x00016659, 0x0001669A, 0x000167B9, 0x000167DC, 0x000167F1, 0x00001D70, 0x000168A1, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00013D4E, 0x00000000, 0x00000000, 0x00016973,
+    0x00000000, 0x00000000, 0x00001E22, 0x00016A21, 0x00000000, 0x00000000, 0x00000000, 0x00016A46, 0x00000000,
+    0x00000000, 0x00000000, 0x00002285, 0x00000000, 0x00016A93, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00016AC4, 0x00016B18, 0x00001E22, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00016FAB, 0x00017063,
+    0x00017076, 0x00017089, 0x00017591, 0x000175E9, 0x0001760B, 0x00017626, 0x00017799, 0x000177DA, 0x00017805,
+    0x00017A21, 0x00017A50, 0x00017AEC, 0x00017D4B, 0x00017D9B, 0x00011533, 0x00017F53, 0x0001820D, 0x00018452,
+    0x00018637, 0x00011115, 0x00001E22, 0x00000000, 0x00018672, 0x00018694, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00017057, 0x00000000, 0x00000000, 0x00018E9B, 0x00019156, 0x00019200,
+    0x00019441, 0x00019C58, 0x00019D37, 0x00019DA7, 0x00019DDD, 0x0001A195, 0x00001E22, 0x0001A25F, 0x0001A5C8,
+    0x0001A72E, 0x0001A786, 0x0001A9DC, 0x0001AA74, 0x00001E22, 0x0001AAD6, 0x0001AE09, 0x0001B1B6, 0x0001B4DE,
+    0x0001B52C, 0x00001E22, 0x00001E22, 0x0001B560, 0x0001B67F, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x0001902C, 0x00000000, 0x00000000, 0x0001BCF3, 0x0001BDFD, 0x0001BE1C, 0x0001BE9B,
+    0x0001C317, 0x0001C36D, 0x0001C37C, 0x0001C395, 0x0001C5B2, 0x0001C5FD, 0x0000635C, 0x0001C612, 0x0001C7C9,
+    0x0001C80F, 0x0001C988, 0x0001CAC2, 0x00001E22, 0x0001CAF8, 0x0001CC4A, 0x0001CDC7, 0x0001CF4D, 0x00001E22,
+    0x0001CFA8, 0x00000000, 0x0001CFB6, 0x00001E5E, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x0001BDC0, 0x00000000, 0x00000000, 0x0001D6B4, 0x0001D891, 0x0001D8F5, 0x0001DB72, 0x0001E232,
+    0x0001E322, 0x0001E531, 0x0001E593, 0x0001E875, 0x000177DA, 0x0001EAE2, 0x0001EB4D, 0x0001EB84, 0x0001ECDC,
+    0x0001EF3B, 0x0001EFAA, 0x00001E22, 0x0001EFFF, 0x0001F4F3, 0x0001F8C2, 0x0001FA7F, 0x0001FADB, 0x0001FAFD,
+    0x00001D70, 0x0001FB16, 0x0001FC85, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x0001D819, 0x00000000, 0x00000000, 0x0001FD88, 0x0001FF71, 0x000200C2, 0x000201AC, 0x000203FB, 0x00020588,
+    0x0002066A, 0x000207F3, 0x0002086F, 0x0002089B, 0x00020921, 0x00020C02, 0x00020DC9, 0x0002115D, 0x00021222,
+    0x000213D8, 0x00000000, 0x000219E5, 0x00021CBD, 0x00021F52, 0x00022013, 0x00022052, 0x00022079, 0x000220A8,
+    0x000220C9, 0x00022101, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0001FE0C,
+    0x00000000, 0x00000000, 0x00022493, 0x00001E22, 0x00022594, 0x0002259B, 0x0002283E, 0x00022A69, 0x00022AAF,
+    0x00022B73, 0x00022D41, 0x00001E22, 0x00022D7B, 0x00022DF3, 0x00022E12, 0x00022E1D, 0x00023000, 0x00023176,
+    0x00000000, 0x00023379, 0x00023423, 0x00023594, 0x000236C4, 0x00001E22, 0x000236FF, 0x00000000, 0x00023706,
+    0x00001E22, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0002258B, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00001E22, 0x00000000, 0x00023790, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00024084, 0x000243AD, 0x00024461, 0x000246BA, 0x0002505E, 0x00025159, 0x00025373, 0x00025428, 0x00025890,
+    0x00001E22, 0x00025A7F, 0x00025B46, 0x00025D3E, 0x00025F50, 0x00026312, 0x000263AD, 0x00001E22, 0x000264DD,
+    0x00026817, 0x00026BD0, 0x00026EE7, 0x00026F46, 0x00026F68, 0x00002285, 0x00026F79, 0x000270FC, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00024238, 0x00000000, 0x00000000, 0x000276FB,
+    0x00027877, 0x00027CD4, 0x00027D2C, 0x000284EA, 0x0002855B, 0x000285A3, 0x00028658, 0x000289A5, 0x000177DA,
+    0x00028B50, 0x00028C01, 0x00028C7E, 0x00028CB7, 0x00028EC8, 0x000292C8, 0x00011533, 0x00029340, 0x000296D1,
+    0x0002A221, 0x0002A450, 0x0002A4A1, 0x0002A4D4, 0x00000000, 0x0002A4FF, 0x0002A57E, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00027826, 0x00000000, 0x00000000, 0x0002AEA0, 0x0002B0AC,
+    0x0002B0E9, 0x0002B10E, 0x0002BC05, 0x0002BC70, 0x0002BCCE, 0x0002BE7E, 0x0002C30C, 0x00001E22, 0x0002C34E,
+    0x0002C392, 0x0002C3DD, 0x0002C408, 0x0002C7AE, 0x0002C80C, 0x00001E22, 0x0002CD37, 0x0002D186, 0x0002D48D,
+    0x0002D7BC, 0x0002D806, 0x0002D834, 0x00002285, 0x0002D848, 0x0002D9A5, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x0002B06F, 0x00000000, 0x00000000, 0x0002DB4D, 0x0002DCA4, 0x0002DE97,
+    0x0002DF1F, 0x0002E368, 0x0002E573, 0x0002E751, 0x0002E7F3, 0x0002E881, 0x000067CB, 0x0002E930, 0x0002EAF7,
+    0x0002ECAF, 0x0002F096, 0x0002F122, 0x0002F1D2, 0x00000000, 0x0002F585, 0x0002F946, 0x0002FC11, 0x0002FC5E,
+    0x0002FC7B, 0x00000000, 0x0002FC8F, 0x0002FC9E, 0x0002FD06, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x0002DBB7, 0x00000000, 0x00000000, 0x0002FE8D, 0x00001E5E, 0x00002285, 0x0002FEC2,
+    0x00030050, 0x00030091, 0x00001E5E, 0x00002285, 0x0003015B, 0x00001E22, 0x0000635C, 0x00030195, 0x000301A0,
+    0x00002285, 0x0003022F, 0x00030254, 0x00001E22, 0x00030265, 0x00030283, 0x00001E5E, 0x000302B6, 0x00001E22,
+    0x00001E22, 0x00000000, 0x00000000, 0x00001E22, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00030251, 0x00000000, 0x00000000, 0x00030526, 0x000305D8, 0x00002285, 0x00001E22, 0x000309CD,
+    0x00002285, 0x00001E22, 0x00030A11, 0x00030B28, 0x00001D15, 0x00002285, 0x00002285, 0x00002285, 0x00030B5A,
+    0x00030BF2, 0x00002285, 0x00001E22, 0x00030BFF, 0x00030C16, 0x00030C2D, 0x00030CFC, 0x00000000, 0x00001E22,
+    0x00000000, 0x00000000, 0x00001E22, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x000305D1, 0x00000000, 0x00000000, 0x00030DC5, 0x00001E5E, 0x00030E00, 0x00030E13, 0x00030E4C, 0x00030E7B,
+    0x00001E5E, 0x00002285, 0x00030EDB, 0x00000000, 0x00030F0E, 0x00030F15, 0x00030F28, 0x00002285, 0x00030F3E,
+    0x00030F81, 0x00000000, 0x00002285, 0x00030F98, 0x000310B5, 0x000310FA, 0x00031111, 0x00001E22, 0x00000000,
+    0x00031120, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00030F5B,
+    0x00000000, 0x00000000, 0x000311B4, 0x0000252A, 0x000311E6, 0x00031201, 0x0003122D, 0x00031250, 0x0003125C,
+    0x00031265, 0x0000635C, 0x00000000, 0x0003126C, 0x000312E4, 0x00031325, 0x0003136F, 0x000313C5, 0x00031420,
+    0x00000000, 0x00031464, 0x000314C3, 0x00031505, 0x00031513, 0x0003151D, 0x00031526, 0x00001D70, 0x00001D70,
+    0x00031530, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000311DA, 0x00000000,
+    0x00000000, 0x0003170B, 0x000317F9, 0x00002285, 0x00031822, 0x00031D6D, 0x00031DB6, 0x00031DDE, 0x00031DE3,
+    0x00031F2D, 0x00001E22, 0x00031F6E, 0x00031F96, 0x00031FAA, 0x00031FBA, 0x00032079, 0x000320BE, 0x00001E22,
+    0x000320C5, 0x000320E8, 0x00032185, 0x0003232F, 0x00001E22, 0x0003246D, 0x00000000, 0x00032487, 0x000324C0,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000317EB,
+};
+
+constexpr uint16_t de_fast_levels[] = {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x07B1, 0x0000, 0x07B1, 0x0000, 0x0000, 0x07B1, 0x0000, 0x0000, 0x07B1, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x07B1, 0x0000, 0x0000, 0x07B1, 0x0000, 0x07B1, 0x07B1, 0x0000, 0x0000,
+    0x07B1,
+};
+
+constexpr HyphenationFastTable de_fast_table = {
+    de_fast_classes,
+    de_fast_entries,
+    de_fast_levels,
+    29,
+    44,
+};
+
 constexpr SerializedHyphenationPatterns de_patterns = {
     de_trie_data,
     sizeof(de_trie_data),
+    &de_fast_table,
 };
@@ -1428,7 +1428,129 @@ alignas(4) constexpr uint8_t en_us_trie_data[] = {
     0x1F, 0xFF, 0x55, 0xFF, 0xDB,
 };
 
+constexpr uint8_t en_us_fast_classes[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12,
+    0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+constexpr uint32_t en_us_fast_entries[] = {
+    0x00000000, 0x80000001, 0x80000002, 0x80000003, 0x80000004, 0x80000005, 0x80000006, 0x80000007, 0x80000008,
+    0x80000009, 0x8000000A, 0x8000000B, 0x8000000C, 0x8000000D, 0x8000000E, 0x8000000F, 0x80000010, 0x80000011,
+    0x80000012, 0x80000013, 0x80000014, 0x80000015, 0x80000016, 0x80000017, 0x80000018, 0x80000019, 0x8000001A,
+    0x8000001B, 0x00000000, 0x00000000, 0x000002EA, 0x00000347, 0x000003A9, 0x000003F9, 0x00000472, 0x000004A5,
+    0x000004D9, 0x00000539, 0x0000057B, 0x0000058B, 0x00000902, 0x000005D8, 0x0000065A, 0x0000068C, 0x000006C2,
+    0x00000712, 0x00000000, 0x0000077D, 0x000007EE, 0x0000086C, 0x000008AF, 0x000008D3, 0x000008E5, 0x00000000,
+    0x000002B9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000995, 0x000009EF, 0x00000A3E, 0x00000A57,
+    0x00000A68, 0x00000AA1, 0x00000ABA, 0x00000ADC, 0x00000AEE, 0x00000AF5, 0x00000B54, 0x00000BC0, 0x00000CDD,
+    0x0000094D, 0x00000D59, 0x00000D72, 0x00000E42, 0x00000EAB, 0x00000F9A, 0x00000FE1, 0x00001026, 0x00001037,
+    0x0000104B, 0x0000104E, 0x0000105C, 0x00000000, 0x00000000, 0x000010FB, 0x00001127, 0x00000000, 0x0000112E,
+    0x0000117F, 0x000011A4, 0x00000000, 0x000011A7, 0x0000121C, 0x00000AEE, 0x000009E5, 0x00001268, 0x0000112E,
+    0x00001275, 0x000012CB, 0x0000094D, 0x00000000, 0x000012FC, 0x00001303, 0x00001309, 0x00001364, 0x00000AEE,
+    0x0000137D, 0x00000000, 0x00001380, 0x00000000, 0x00000000, 0x00000000, 0x00001444, 0x00000000, 0x00001479,
+    0x00000000, 0x000014CB, 0x00000000, 0x00000000, 0x00001552, 0x000015CF, 0x00000000, 0x000015FC, 0x00001626,
+    0x00000000, 0x00000950, 0x00001693, 0x00000000, 0x00000AEE, 0x0000171F, 0x0000172F, 0x0000175A, 0x000017C6,
+    0x00000000, 0x00000000, 0x00000000, 0x000017E5, 0x000002B9, 0x00000000, 0x00000000, 0x0000184D, 0x00000AEE,
+    0x00000950, 0x0000187E, 0x0000197B, 0x0000112E, 0x000019B8, 0x000019C5, 0x00001A45, 0x00000AEE, 0x00001A76,
+    0x00001A97, 0x00000AEE, 0x00001AAA, 0x00001ADA, 0x00000AEE, 0x00000000, 0x00001B69, 0x00001B7E, 0x00001B8E,
+    0x00001BCB, 0x00000AEE, 0x00000AEE, 0x00000000, 0x00001BF0, 0x00000000, 0x00000000, 0x00000000, 0x00001CBA,
+    0x00001CEE, 0x00001D74, 0x00001DD2, 0x00001DFB, 0x00001E53, 0x00001E80, 0x00001E96, 0x00001EB6, 0x00001ED7,
+    0x00001EE0, 0x00001F86, 0x00001FFB, 0x00002088, 0x000020CF, 0x00002137, 0x00002163, 0x0000223C, 0x00002334,
+    0x000023B2, 0x000023E7, 0x0000243E, 0x00002462, 0x0000246F, 0x00002473, 0x00000000, 0x00000000, 0x00000000,
+    0x000024F2, 0x0000137D, 0x00000000, 0x0000094D, 0x0000253D, 0x0000256A, 0x00000000, 0x0000094D, 0x000025E9,
+    0x00000000, 0x00000000, 0x00002625, 0x0000094D, 0x0000094D, 0x00002659, 0x0000137D, 0x00000000, 0x00002672,
+    0x000011BE, 0x0000267F, 0x00002693, 0x00000000, 0x00000000, 0x00000000, 0x000017E5, 0x00000000, 0x00000000,
+    0x00000000, 0x00002711, 0x000009CB, 0x00000000, 0x000009E5, 0x00002778, 0x00000000, 0x00002797, 0x000027B2,
+    0x000027F3, 0x00000000, 0x00000000, 0x0000284D, 0x00002858, 0x0000289C, 0x000028CD, 0x000009CB, 0x00000000,
+    0x00002931, 0x00002943, 0x00002949, 0x00002963, 0x00000000, 0x000009CB, 0x00000000, 0x00002979, 0x00000000,
+    0x00000000, 0x00000000, 0x00002A38, 0x00000AEE, 0x00000000, 0x00000000, 0x00002ABF, 0x00000AEE, 0x00000000,
+    0x00000AEE, 0x00002B2C, 0x00000000, 0x0000094D, 0x00002B57, 0x00002B60, 0x00002B6D, 0x00002BD4, 0x0000137D,
+    0x00000000, 0x00002BF0, 0x00002BF9, 0x00002C11, 0x00002C28, 0x00000000, 0x00002C3C, 0x00000000, 0x00002C55,
+    0x00000000, 0x00000000, 0x00000000, 0x00002CBA, 0x00002CF8, 0x00002D65, 0x00002DC1, 0x00002DFA, 0x00002E2E,
+    0x00002E81, 0x000009CB, 0x00002E9F, 0x00002EA2, 0x0000094D, 0x00002EDE, 0x00002F39, 0x00002FF8, 0x00003048,
+    0x0000307D, 0x000030A3, 0x000030EB, 0x00003177, 0x00003232, 0x00000AEE, 0x00003277, 0x0000137D, 0x00000C84,
+    0x0000094D, 0x00003287, 0x00000000, 0x00000000, 0x000032F7, 0x00000000, 0x00000000, 0x00000000, 0x00003317,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00003323, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000332B, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00003337, 0x00000AEE, 0x00000000, 0x00000000,
+    0x0000335F, 0x000009CB, 0x00000000, 0x000009E5, 0x000033A5, 0x00000000, 0x000009E5, 0x000033C1, 0x00000AEE,
+    0x000033CA, 0x000033DB, 0x00000000, 0x00000000, 0x000033E8, 0x000033F0, 0x00000950, 0x00000000, 0x00000000,
+    0x00000AEE, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00003482, 0x000034A4, 0x000034BA,
+    0x000034DE, 0x00003590, 0x000035B5, 0x000035C1, 0x000011BE, 0x00003658, 0x0000094D, 0x00003692, 0x000036D5,
+    0x000036FB, 0x00003707, 0x0000378A, 0x000037C6, 0x00000000, 0x0000112E, 0x000037D8, 0x00003818, 0x00003874,
+    0x000038A3, 0x000018BE, 0x00000000, 0x000038BF, 0x00000000, 0x00000000, 0x00000000, 0x000039B1, 0x000039E5,
+    0x0000137D, 0x00000000, 0x00003A8B, 0x0000112E, 0x00000000, 0x000011A4, 0x00003B41, 0x00000000, 0x0000094D,
+    0x0000112E, 0x00003B6A, 0x00003B73, 0x00003C26, 0x00003C90, 0x00000000, 0x000011A7, 0x00003CB6, 0x0000094D,
+    0x00003CDA, 0x00000000, 0x0000094D, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00003D99,
+    0x00001AAA, 0x00003DED, 0x00003E32, 0x00003EBA, 0x00003EFB, 0x00003F44, 0x00003F66, 0x00003FB9, 0x00000AEE,
+    0x00003FE9, 0x00003FF8, 0x00004004, 0x00004010, 0x000040D9, 0x0000410E, 0x00000AEE, 0x00004117, 0x00004141,
+    0x00004190, 0x000041BC, 0x000019C5, 0x00001C3F, 0x00000000, 0x000041D8, 0x000041DF, 0x00000000, 0x00000000,
+    0x0000423F, 0x0000426A, 0x000042B5, 0x000042FD, 0x00004317, 0x00004333, 0x00004374, 0x0000438D, 0x000043B3,
+    0x00000950, 0x000043D5, 0x00004467, 0x000044F1, 0x0000457D, 0x000045AF, 0x000045F4, 0x00000AEE, 0x000046A1,
+    0x00004715, 0x0000477D, 0x000047A6, 0x000047E3, 0x000047F1, 0x00004811, 0x00004801, 0x00000000, 0x00000000,
+    0x00000000, 0x000048ED, 0x0000112E, 0x00000000, 0x000009E5, 0x00004980, 0x0000094D, 0x0000094D, 0x000049ED,
+    0x00004A5B, 0x00000000, 0x00004A77, 0x00004AA7, 0x0000112E, 0x000011BE, 0x00004B07, 0x00004B45, 0x00000000,
+    0x00004BEB, 0x00004C0F, 0x00004C34, 0x00004C70, 0x00000000, 0x000009CB, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00004D0D, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00004DAE, 0x00004E02, 0x00004E26, 0x00004E47, 0x00004F40, 0x00004F77,
+    0x00004F9A, 0x00004FAC, 0x00005075, 0x000009CB, 0x000050BB, 0x000050E8, 0x00005110, 0x00005142, 0x000051DE,
+    0x00005225, 0x00000000, 0x00005252, 0x00005296, 0x000052FD, 0x00005324, 0x0000535D, 0x00000AEE, 0x00000000,
+    0x0000536B, 0x00005379, 0x00000000, 0x00000000, 0x00005413, 0x0000137D, 0x000054C4, 0x0000137D, 0x00005589,
+    0x000011A7, 0x000011BE, 0x000055E7, 0x00005649, 0x00000000, 0x00005688, 0x000056A7, 0x000056D4, 0x00001C3F,
+    0x00005730, 0x000057C1, 0x000057E4, 0x00000AEE, 0x0000583F, 0x00005937, 0x00005978, 0x0000094D, 0x0000599F,
+    0x00000000, 0x000059BC, 0x00000000, 0x00000000, 0x00000000, 0x00005AA9, 0x000018BE, 0x00005AF5, 0x0000112E,
+    0x00005BAF, 0x000018BE, 0x0000112E, 0x00005C5E, 0x00005CF9, 0x00000000, 0x00000000, 0x00005D49, 0x00005D58,
+    0x00003707, 0x00005DA4, 0x0000112E, 0x00000000, 0x00005EB5, 0x00005ECB, 0x00005EE6, 0x00005F20, 0x0000094D,
+    0x00005F44, 0x00000000, 0x00005F61, 0x00001BB9, 0x00000000, 0x00000000, 0x00005FD8, 0x0000600A, 0x00006018,
+    0x00006052, 0x00006077, 0x0000607E, 0x00006089, 0x00000000, 0x000060A0, 0x00000950, 0x0000094D, 0x000060FA,
+    0x00006133, 0x0000616C, 0x00006185, 0x000061AF, 0x00000000, 0x00006212, 0x0000626C, 0x000062D8, 0x000062EB,
+    0x000019C5, 0x00000000, 0x00001547, 0x00000000, 0x00000A24, 0x00000000, 0x00000000, 0x00006372, 0x00000000,
+    0x00000000, 0x00000000, 0x0000640C, 0x00000000, 0x00000000, 0x00000000, 0x0000649F, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x0000650C, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000A85, 0x00000000, 0x00000000, 0x00000A6D, 0x00000000, 0x00000000, 0x00000000, 0x00006564,
+    0x00000AEE, 0x000009CB, 0x00000000, 0x000065A5, 0x00000000, 0x00000000, 0x000002E2, 0x000065D5, 0x00000000,
+    0x00000A6D, 0x000065F4, 0x00000000, 0x0000436A, 0x00006606, 0x00000950, 0x00000000, 0x00006631, 0x00006636,
+    0x0000094D, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000009E5, 0x00000000, 0x00000000, 0x00000000,
+    0x00006680, 0x00000000, 0x00006697, 0x00000000, 0x000066A7, 0x00000000, 0x00000000, 0x000066BA, 0x000066CC,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00002115, 0x000066F0, 0x0000670B, 0x00000000,
+    0x00000000, 0x000066F7, 0x000066FD, 0x00000000, 0x00000000, 0x000009E5, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00006732, 0x00000AEE, 0x00006750, 0x00000AEE, 0x00006771, 0x00000000, 0x00000E1C, 0x000011A7,
+    0x00000AEE, 0x00000000, 0x00000000, 0x0000677E, 0x0000679F, 0x000067A9, 0x000067C0, 0x000067EA, 0x00000000,
+    0x000067FA, 0x0000681E, 0x0000683F, 0x00000000, 0x00000000, 0x00000AEE, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x0000687A, 0x0000094D, 0x00000000, 0x00000000, 0x0000688B, 0x00000000, 0x00000000,
+    0x00000000, 0x000068A2, 0x00000000, 0x00000000, 0x00000B44, 0x0000094D, 0x00000000, 0x000068B7, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x000002B9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x000068C3,
+};
+
+constexpr uint16_t en_us_fast_levels[] = {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+};
+
+constexpr HyphenationFastTable en_us_fast_table = {
+    en_us_fast_classes,
+    en_us_fast_entries,
+    en_us_fast_levels,
+    28,
+    28,
+};
+
 constexpr SerializedHyphenationPatterns en_us_patterns = {
     en_us_trie_data,
     sizeof(en_us_trie_data),
+    &en_us_fast_table,
 };
@@ -728,7 +728,152 @@ alignas(4) constexpr uint8_t es_trie_data[] = {
     0x4F, 0xFD, 0x7C, 0xFF, 0xB0, 0xFF, 0xF9,
 };
 
+constexpr uint8_t es_fast_classes[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12,
+    0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1D, 0x00,
+    0x00, 0x00, 0x1E, 0x00, 0x00, 0x00, 0x1F, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+constexpr uint32_t es_fast_entries[] = {
+    0x00000000, 0x80000002, 0x80000019, 0x80000001, 0x80000003, 0x80000004, 0x8000001A, 0x80000005, 0x80000006,
+    0x80000007, 0x8000001B, 0x80000008, 0x80000009, 0x8000000A, 0x8000000B, 0x8000000C, 0x80000018, 0x8000000D,
+    0x8000000E, 0x8000000F, 0x80000010, 0x80000011, 0x8000001C, 0x80000012, 0x80000013, 0x80000014, 0x80000015,
+    0x80000016, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x80000017, 0x00000000, 0x0000011D,
+    0x00000000, 0x00000120, 0x00000126, 0x00000120, 0x00000000, 0x0000012F, 0x00000134, 0x00000120, 0x0000021F,
+    0x00000120, 0x00000120, 0x0000014C, 0x00000134, 0x00000120, 0x00000000, 0x00000139, 0x00000120, 0x0000014C,
+    0x00000120, 0x00000142, 0x00000255, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000D49, 0x00000301,
+    0x00000459, 0x000004DB, 0x00000E4C, 0x000004E2, 0x000004E2, 0x00000CDB, 0x00001085, 0x000004E2, 0x000004E2,
+    0x000004E2, 0x0000054C, 0x000004E2, 0x00000000, 0x000007D6, 0x000004E2, 0x00000A4A, 0x00000C1A, 0x00000CBB,
+    0x00000000, 0x000004E2, 0x000004E2, 0x000004E2, 0x000004E2, 0x000004E2, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x00001229, 0x00000120, 0x00000126, 0x00000120,
+    0x00001287, 0x0000012F, 0x00000134, 0x000010FC, 0x000012CE, 0x00000120, 0x00000120, 0x00001148, 0x00000134,
+    0x000010DE, 0x00001206, 0x00000139, 0x00000120, 0x0000119B, 0x00000120, 0x000010EA, 0x00001241, 0x00000120,
+    0x00000120, 0x00000120, 0x00000120, 0x000010F6, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x000012EA, 0x00000000, 0x0000011D, 0x00000000, 0x00000120, 0x00000126, 0x00000120, 0x0000189E, 0x0000012F,
+    0x00000134, 0x00000120, 0x000018BF, 0x00000120, 0x00000120, 0x00000120, 0x00000134, 0x00000120, 0x00000000,
+    0x00000139, 0x00000120, 0x0000014C, 0x00000120, 0x00000142, 0x00000000, 0x00000120, 0x00000120, 0x00000120,
+    0x00000120, 0x00000120, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x0000011D, 0x0000193C, 0x00000120, 0x00000120, 0x00000120, 0x0000190D, 0x00000120, 0x00000120, 0x00000120,
+    0x00001918, 0x00000120, 0x00000120, 0x0000014C, 0x00000120, 0x00000120, 0x00001922, 0x00000120, 0x00000120,
+    0x0000014C, 0x00000120, 0x000010F6, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x00001A7D,
+    0x00000120, 0x00000120, 0x00000120, 0x00001AA1, 0x00000120, 0x00000120, 0x00000120, 0x00001AB1, 0x00000120,
+    0x00000120, 0x00001990, 0x00000120, 0x000010F6, 0x00001A6C, 0x00000120, 0x00000120, 0x00001A0F, 0x00000120,
+    0x00000120, 0x00001ABD, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x00001B4E, 0x00000120, 0x00000120,
+    0x00000120, 0x00001BA0, 0x00000120, 0x00000120, 0x00000120, 0x00001C26, 0x00000120, 0x00000120, 0x00000120,
+    0x00000120, 0x00000120, 0x00001C37, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00001B34,
+    0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000000,
+    0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120,
+    0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120,
+    0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x0000011D, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120,
+    0x00000120, 0x00001CD5, 0x00000120, 0x00000120, 0x0000014C, 0x00000120, 0x00000120, 0x00000000, 0x00000120,
+    0x00000120, 0x0000014C, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120,
+    0x00000120, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D,
+    0x00000000, 0x00000120, 0x00000126, 0x00000120, 0x00001D66, 0x0000012F, 0x00000134, 0x00000120, 0x00001D7D,
+    0x00000120, 0x00000120, 0x00001D21, 0x00000134, 0x00000120, 0x00001D94, 0x00000139, 0x00000120, 0x00000120,
+    0x00000120, 0x00000142, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x00001E72, 0x00000120,
+    0x00000126, 0x00000120, 0x00001E22, 0x0000012F, 0x00000134, 0x00000120, 0x00001EB4, 0x00000120, 0x00000120,
+    0x00000120, 0x00000134, 0x000010F6, 0x00001EC8, 0x00000139, 0x00000120, 0x00000120, 0x00000120, 0x00000142,
+    0x00001EC5, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x00001F49, 0x00000120, 0x00000126, 0x00000120,
+    0x00001F53, 0x0000012F, 0x00000134, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000134,
+    0x00000120, 0x00001F42, 0x00000139, 0x00000120, 0x00000120, 0x00000120, 0x00001F32, 0x00000000, 0x00000120,
+    0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x0000011D, 0x00002125, 0x00000120, 0x00000120, 0x00000120, 0x000020B2, 0x00000120,
+    0x00000120, 0x00000120, 0x00002130, 0x00000120, 0x00000120, 0x00001FDE, 0x00000120, 0x000010F6, 0x00002213,
+    0x00000120, 0x00000120, 0x00002034, 0x00001FBE, 0x00001FC7, 0x00002083, 0x00000120, 0x00000120, 0x00000120,
+    0x00000120, 0x00000120, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x0000011D, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120,
+    0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120,
+    0x00000120, 0x00000120, 0x00000120, 0x00002278, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x0000231A,
+    0x00000120, 0x00000126, 0x00000120, 0x00002302, 0x0000012F, 0x00000134, 0x00000120, 0x00000000, 0x00000120,
+    0x00000120, 0x00000120, 0x000022C7, 0x00000120, 0x00002324, 0x00000139, 0x00000120, 0x0000014C, 0x00000120,
+    0x00000142, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x000023EC, 0x00000120, 0x00000126,
+    0x00000120, 0x0000242A, 0x0000012F, 0x00000134, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120,
+    0x00000134, 0x00000120, 0x00002463, 0x00002376, 0x00000120, 0x00000120, 0x00000120, 0x000023CC, 0x000024FD,
+    0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x0000275C, 0x00000120, 0x00000126, 0x00000120, 0x0000273F,
+    0x0000012F, 0x00000134, 0x00000120, 0x00002759, 0x00000120, 0x00000120, 0x0000272A, 0x00000134, 0x00000120,
+    0x00002760, 0x00000139, 0x00000120, 0x000026C9, 0x00002724, 0x00000142, 0x00002768, 0x00000120, 0x00000120,
+    0x0000272A, 0x00000120, 0x0000271B, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00002778,
+    0x00000000, 0x0000011D, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120,
+    0x00000120, 0x000027D2, 0x00000120, 0x00000120, 0x0000014C, 0x00000120, 0x00000120, 0x00000000, 0x00000120,
+    0x00000120, 0x0000014C, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120,
+    0x00000120, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D,
+    0x00002821, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000000,
+    0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120,
+    0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x00000000, 0x00000120,
+    0x00000126, 0x00000120, 0x0000286D, 0x0000012F, 0x00000134, 0x00000120, 0x00001CD5, 0x00000120, 0x00000120,
+    0x00000120, 0x00000134, 0x00000120, 0x00000000, 0x00000139, 0x00000120, 0x00000120, 0x00000120, 0x00000142,
+    0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x00000000, 0x00000120, 0x00000126, 0x00000120,
+    0x00000000, 0x0000012F, 0x00000134, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000134,
+    0x00000120, 0x00000000, 0x00000139, 0x00000120, 0x00000120, 0x00000120, 0x00000142, 0x00000000, 0x00000120,
+    0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x0000011D, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000120,
+    0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00002904,
+    0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000120, 0x00000000, 0x00000120, 0x00000120, 0x00000120,
+    0x00000120, 0x00000120, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00002AE5, 0x000029C4, 0x00002A29, 0x00002950, 0x00002B10, 0x00000000, 0x00000000, 0x0000011D, 0x00002B3E,
+    0x00000000, 0x00002BBC, 0x00000000, 0x00002B39, 0x00000000, 0x00000000, 0x00000000, 0x00002C43, 0x00000000,
+    0x00000000, 0x00002B83, 0x00002BBF, 0x00002BC3, 0x00002C08, 0x00002BCD, 0x00000000, 0x00002BFD, 0x00002BA8,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00002B4C, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000011D, 0x00002C70, 0x00002D98, 0x00002DF2,
+    0x00002DBA, 0x00002DFC, 0x00002E13, 0x00002DFC, 0x00000000, 0x00002C83, 0x00000000, 0x00000000, 0x00002E30,
+    0x00002CCC, 0x00002CDA, 0x00002956, 0x00002E1A, 0x00000000, 0x00002D73, 0x00002CA4, 0x00002CEA, 0x00002E22,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00002E48, 0x00000000, 0x0000011D, 0x000030C0, 0x00000000, 0x000030F5, 0x00003080, 0x0000309A,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00003273, 0x00002EBE, 0x00002EDE,
+    0x00002E8B, 0x00000000, 0x00000000, 0x0000305E, 0x00002EA6, 0x00003102, 0x00003106, 0x00000000, 0x00000000,
+    0x0000324D, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000030D3,
+    0x00000000, 0x00000000, 0x00003490, 0x00003465, 0x00003473, 0x00003330, 0x000034A1, 0x00000000, 0x00003311,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00003446, 0x000034A5, 0x00000000,
+    0x00000000, 0x00000000, 0x00003357, 0x0000349D, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x000034D5, 0x00000000, 0x000034F2, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x000034D2, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+};
+
+constexpr uint16_t es_fast_levels[] = {
+    0x0000, 0x0041, 0x0000, 0x0041, 0x0041, 0x0041, 0x0041, 0x0000, 0x0041, 0x0041, 0x0041, 0x0041, 0x0041, 0x0041,
+    0x0041, 0x0041, 0x0041, 0x0041, 0x0041, 0x0041, 0x0041, 0x0041, 0x0041, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000,
+};
+
+constexpr HyphenationFastTable es_fast_table = {
+    es_fast_classes,
+    es_fast_entries,
+    es_fast_levels,
+    29,
+    34,
+};
+
 constexpr SerializedHyphenationPatterns es_patterns = {
     es_trie_data,
     sizeof(es_trie_data),
+    &es_fast_table,
 };
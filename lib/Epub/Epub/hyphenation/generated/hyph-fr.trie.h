@@ -377,7 +377,162 @@ alignas(4) constexpr uint8_t fr_trie_data[] = {
     0xDD, 0xFF, 0x35, 0xFF, 0x58, 0xFF, 0x65, 0xFF, 0x88, 0xFF, 0xAA, 0xFF, 0xDE, 0xFF, 0xEA,
 };
 
+constexpr uint8_t fr_fast_classes[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13,
+    0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1D, 0x00, 0x00, 0x00, 0x00, 0x1E, 0x1F, 0x20, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x22, 0x00, 0x23, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+constexpr uint32_t fr_fast_entries[] = {
+    0x00000000, 0x80000001, 0x80000002, 0x80000003, 0x80000004, 0x80000006, 0x8000000D, 0x8000000C, 0x8000000F,
+    0x80000010, 0x80000014, 0x8000000B, 0x80000007, 0x80000019, 0x80000017, 0x80000008, 0x8000001B, 0x80000012,
+    0x8000000A, 0x8000001A, 0x80000009, 0x80000011, 0x8000000E, 0x80000015, 0x80000016, 0x80000013, 0x80000018,
+    0x8000001C, 0x8000001D, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x80000005, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x0000014B, 0x00000000, 0x00000000, 0x00000000, 0x0000018C, 0x00000000,
+    0x00000000, 0x00000000, 0x00000287, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000002B6,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000002C1, 0x00000000, 0x00000000, 0x00000000,
+    0x000002C1, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000016C, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x000002ED, 0x0000036E, 0x00000406, 0x0000053F, 0x0000018C, 0x00000000,
+    0x00000906, 0x00000000, 0x00000568, 0x00000000, 0x000008CF, 0x00000A39, 0x00000663, 0x00000913, 0x000008C3,
+    0x000007CE, 0x00000000, 0x00000A2E, 0x000008AA, 0x000008E9, 0x000002C1, 0x00000000, 0x00000000, 0x00000000,
+    0x000002C1, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000322, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000A90, 0x00000B8A, 0x00000A97, 0x00000000, 0x00000000,
+    0x00000B95, 0x00000000, 0x00000BBD, 0x00000000, 0x00000000, 0x00000AC1, 0x00000BBA, 0x00000B0A, 0x00000000,
+    0x00000B1F, 0x00000000, 0x00000B52, 0x00000B63, 0x00000000, 0x00000BBD, 0x00000B9C, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000AA6, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000C11, 0x00000000,
+    0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000C21, 0x00000000, 0x00000000, 0x00000C39,
+    0x00000000, 0x00000000, 0x00000C3E, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000BEC, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000BBD, 0x00000AA9, 0x00000BBD, 0x00000D03, 0x00000BBD, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000D4F, 0x00000000, 0x00000EC2, 0x00000000, 0x00000C11, 0x00000000,
+    0x00000000, 0x00000DA9, 0x00000DD7, 0x00000000, 0x00000DDF, 0x00000DFD, 0x00000000, 0x00000000, 0x00000E93,
+    0x00000000, 0x00000000, 0x00000C21, 0x00000000, 0x00000000, 0x00000EB3, 0x00000000, 0x00000000, 0x00000000,
+    0x00000EB8, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000BEC, 0x00000EAB,
+    0x00000000, 0x00000000, 0x00000000, 0x00000EED, 0x00000000, 0x00000000, 0x00000000, 0x00000C1A, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000C08, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000F7E, 0x00000000,
+    0x00000000, 0x00000000, 0x00000F1B, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000F9B, 0x00000F55,
+    0x00000000, 0x00000000, 0x00000000, 0x00000F9E, 0x00000000, 0x00000F0A, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000F68, 0x00000EAB,
+    0x00000000, 0x00000000, 0x00000000, 0x00001034, 0x00000000, 0x00000B9C, 0x00000000, 0x0000100E, 0x00000000,
+    0x00000000, 0x0000105C, 0x00000FFE, 0x00000000, 0x00000000, 0x00000000, 0x00000B9C, 0x00000000, 0x00000AA9,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00001020, 0x00000000, 0x00000000, 0x00000000,
+    0x00001044, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000FE4, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x0000112F, 0x00000000, 0x00000000, 0x00000000, 0x00001180, 0x00000000,
+    0x00000000, 0x000011E5, 0x00000EB8, 0x00000000, 0x00000000, 0x0000116D, 0x00000000, 0x00001208, 0x00001166,
+    0x00000000, 0x00000000, 0x000010D1, 0x00001214, 0x00001220, 0x000010F7, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000011A9, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00001308, 0x00001311, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000130D, 0x000012F1, 0x0000129A, 0x0000131F,
+    0x00000000, 0x00000000, 0x00000000, 0x000012C5, 0x00000000, 0x00000000, 0x00001324, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000AA6, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000136B, 0x00000000,
+    0x00000000, 0x00000000, 0x00000BBD, 0x00001356, 0x00000000, 0x00001377, 0x00000000, 0x00000000, 0x00001389,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000AA9, 0x00000000, 0x0000139C, 0x00000000, 0x00000000, 0x000013CD, 0x00000C11, 0x00000000,
+    0x00000000, 0x0000141A, 0x00001405, 0x00000000, 0x00000000, 0x00001423, 0x00000000, 0x00000000, 0x00000AA9,
+    0x00000000, 0x00000000, 0x00000C21, 0x00000F9E, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000013B7, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00001494, 0x00000000, 0x0000156D, 0x00000000, 0x000014C1, 0x00000000,
+    0x00000000, 0x000014F3, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00001522,
+    0x00000000, 0x00000000, 0x0000147E, 0x00000000, 0x00001570, 0x00001516, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000154A, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x0000139C, 0x00000000, 0x00000000, 0x00000000, 0x00000C11, 0x00000000,
+    0x00000000, 0x00000000, 0x000015B9, 0x00000000, 0x00000000, 0x000015C2, 0x00000000, 0x00000000, 0x00000AA9,
+    0x00000000, 0x00000000, 0x000015CF, 0x00000F9E, 0x00000000, 0x0000139C, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000159C, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000C11, 0x00000000,
+    0x00000000, 0x000015F7, 0x00000DD7, 0x00000000, 0x00000000, 0x00000C21, 0x00000000, 0x00000C21, 0x00000AA9,
+    0x00000000, 0x00000000, 0x00001621, 0x00000F9E, 0x00000000, 0x0000162A, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000BEC, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00001717, 0x00000000, 0x00001663, 0x00000000,
+    0x00000000, 0x00001724, 0x00000AA9, 0x00000000, 0x00000000, 0x000016F7, 0x00000000, 0x00000000, 0x00000AA9,
+    0x000016D8, 0x00000000, 0x00000000, 0x00000000, 0x00001789, 0x0000169C, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000BEC, 0x00000EAB,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00001805, 0x0000180C, 0x00001570, 0x00000000, 0x00000000,
+    0x000017D2, 0x00000000, 0x00001813, 0x00000000, 0x00000000, 0x00000000, 0x000017F1, 0x00000000, 0x00000000,
+    0x000017D5, 0x00000000, 0x00000BBD, 0x00001856, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000185D,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000AA6, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00001886, 0x00000000, 0x00000000, 0x00000000, 0x00000C11, 0x00000000,
+    0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000AA9,
+    0x00000000, 0x00000000, 0x00000AC6, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000F7E, 0x00000000,
+    0x00000000, 0x00000000, 0x00000DD7, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000AA9,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000139C, 0x00000000, 0x00000000, 0x00000000,
+    0x00001908, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000018B8, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000B9C, 0x00000000, 0x00001923, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00001934, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x0000193B, 0x00000000, 0x00000000, 0x00000B9C, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00001961, 0x00000000, 0x00000000, 0x00000000, 0x0000198E, 0x00000000,
+    0x00000000, 0x00000000, 0x0000196A, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000019CC,
+    0x00000000, 0x00000000, 0x00000C21, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000019AC, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x000019FE, 0x00000000, 0x00000000, 0x00000000, 0x00000C11, 0x00000000,
+    0x00000000, 0x00000000, 0x00000DD7, 0x00000000, 0x00000000, 0x000019F3, 0x00001A26, 0x00000000, 0x00000AA9,
+    0x00000000, 0x00000000, 0x00000000, 0x000012BE, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00001A03, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000141F, 0x00000000,
+    0x00000000, 0x00000000, 0x00001A48, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000C11, 0x00000000,
+    0x00000000, 0x00001A53, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000AA9,
+    0x00000000, 0x00000000, 0x00000AC6, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000BEC, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00001A75, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000C11, 0x00000000,
+    0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000AA9,
+    0x00000000, 0x00000000, 0x00000000, 0x00001A9B, 0x00000000, 0x00001A88, 0x00000000, 0x00000000, 0x000012F6,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000BEC, 0x00000EAB,
+    0x00000000, 0x00000000, 0x00000000, 0x00001AC4, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00001ACF, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000C11, 0x00000000,
+    0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000AA9,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000AA9, 0x00000000, 0x00000000, 0x00000000,
+    0x00000AA9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00001AD7, 0x00000000,
+};
+
+constexpr uint16_t fr_fast_levels[] = {
+    0x0000, 0x0042, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00E1, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00E1, 0x0000,
+    0x0000, 0x0000,
+};
+
+constexpr HyphenationFastTable fr_fast_table = {
+    fr_fast_classes,
+    fr_fast_entries,
+    fr_fast_levels,
+    30,
+    36,
+};
+
 constexpr SerializedHyphenationPatterns fr_patterns = {
     fr_trie_data,
     sizeof(fr_trie_data),
+    &fr_fast_table,
 };
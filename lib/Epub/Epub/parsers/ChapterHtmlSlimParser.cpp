@@ -5,46 +5,95 @@
 #include <SDCardManager.h>
 #include <expat.h>
 
-#include "../Page.h"
+#include <algorithm>
+#include <new>
 
-const char* HEADER_TAGS[] = {"h1", "h2", "h3", "h4", "h5", "h6"};
-constexpr int NUM_HEADER_TAGS = sizeof(HEADER_TAGS) / sizeof(HEADER_TAGS[0]);
+#include "../DomPosition.h"
+#include "../Page.h"
 
 // Minimum file size (in bytes) to show indexing popup - smaller chapters don't benefit from it
 constexpr size_t MIN_SIZE_FOR_POPUP = 50 * 1024;  // 50KB
 
-const char* BLOCK_TAGS[] = {"p", "li", "div", "br", "blockquote"};
-constexpr int NUM_BLOCK_TAGS = sizeof(BLOCK_TAGS) / sizeof(BLOCK_TAGS[0]);
-
-const char* BOLD_TAGS[] = {"b", "strong"};
-constexpr int NUM_BOLD_TAGS = sizeof(BOLD_TAGS) / sizeof(BOLD_TAGS[0]);
-
-const char* ITALIC_TAGS[] = {"i", "em"};
-constexpr int NUM_ITALIC_TAGS = sizeof(ITALIC_TAGS) / sizeof(ITALIC_TAGS[0]);
-
-const char* UNDERLINE_TAGS[] = {"u", "ins"};
-constexpr int NUM_UNDERLINE_TAGS = sizeof(UNDERLINE_TAGS) / sizeof(UNDERLINE_TAGS[0]);
-
-const char* IMAGE_TAGS[] = {"img"};
-constexpr int NUM_IMAGE_TAGS = sizeof(IMAGE_TAGS) / sizeof(IMAGE_TAGS[0]);
-
-const char* SKIP_TAGS[] = {"head"};
-constexpr int NUM_SKIP_TAGS = sizeof(SKIP_TAGS) / sizeof(SKIP_TAGS[0]);
+// Categories of the tags the parser acts on, combined into one bitmask per element
+enum TagCategory : uint16_t {
+  TAG_HEADER = 1 << 0,      // h1 - h6
+  TAG_BLOCK = 1 << 1,       // p, li, div, br, blockquote
+  TAG_BOLD = 1 << 2,        // b, strong
+  TAG_ITALIC = 1 << 3,      // i, em
+  TAG_UNDERLINE = 1 << 4,   // u, ins
+  TAG_IMAGE = 1 << 5,       // img
+  TAG_SKIP = 1 << 6,        // head
+  TAG_TABLE = 1 << 7,       // table
+  TAG_LINE_BREAK = 1 << 8,  // br
+  TAG_LIST_ITEM = 1 << 9,   // li
+};
+
+constexpr uint16_t HEADER_OR_BLOCK = TAG_HEADER | TAG_BLOCK;
+// Closing any of these ends the current word
+constexpr uint16_t FLUSHING_TAGS = HEADER_OR_BLOCK | TAG_BOLD | TAG_ITALIC | TAG_UNDERLINE | TAG_TABLE | TAG_IMAGE;
 
 bool isWhitespace(const char c) { return c == ' ' || c == '\r' || c == '\n' || c == '\t'; }
 
-// given the start and end of a tag, check to see if it matches a known tag
-bool matches(const char* tag_name, const char* possible_tags[], const int possible_tag_count) {
-  for (int i = 0; i < possible_tag_count; i++) {
-    if (strcmp(tag_name, possible_tags[i]) == 0) {
-      return true;
+// Classify a tag name with a switch on its length and first character, so each element costs at most one
+// short memcmp instead of a strcmp against every known tag. Unknown tags return 0.
+uint16_t classifyTag(const char* name) {
+  size_t len = 0;
+  while (name[len] != '\0') {
+    if (++len > 10) {
+      return 0;  // longer than any tag we know
     }
   }
-  return false;
-}
 
-bool isHeaderOrBlock(const char* name) {
-  return matches(name, HEADER_TAGS, NUM_HEADER_TAGS) || matches(name, BLOCK_TAGS, NUM_BLOCK_TAGS);
+  switch (len) {
+    case 1:
+      switch (name[0]) {
+        case 'p':
+          return TAG_BLOCK;
+        case 'b':
+          return TAG_BOLD;
+        case 'i':
+          return TAG_ITALIC;
+        case 'u':
+          return TAG_UNDERLINE;
+        default:
+          return 0;
+      }
+    case 2:
+      if (name[0] == 'h' && name[1] >= '1' && name[1] <= '6') {
+        return TAG_HEADER;
+      }
+      if (name[0] == 'l' && name[1] == 'i') {
+        return TAG_BLOCK | TAG_LIST_ITEM;
+      }
+      if (name[0] == 'b' && name[1] == 'r') {
+        return TAG_BLOCK | TAG_LINE_BREAK;
+      }
+      if (name[0] == 'e' && name[1] == 'm') {
+        return TAG_ITALIC;
+      }
+      return 0;
+    case 3:
+      if (memcmp(name, "div", 3) == 0) {
+        return TAG_BLOCK;
+      }
+      if (memcmp(name, "img", 3) == 0) {
+        return TAG_IMAGE;
+      }
+      if (memcmp(name, "ins", 3) == 0) {
+        return TAG_UNDERLINE;
+      }
+      return 0;
+    case 4:
+      return memcmp(name, "head", 4) == 0 ? TAG_SKIP : 0;
+    case 5:
+      return memcmp(name, "table", 5) == 0 ? TAG_TABLE : 0;
+    case 6:
+      return memcmp(name, "strong", 6) == 0 ? TAG_BOLD : 0;
+    case 10:
+      return memcmp(name, "blockquote", 10) == 0 ? TAG_BLOCK : 0;
+    default:
+      return 0;
+  }
 }
 
 // Update effective bold/italic/underline based on block style and inline style stack
@@ -69,6 +118,13 @@ void ChapterHtmlSlimParser::updateEffectiveInlineStyle() {
   }
 }
 
+void ChapterHtmlSlimParser::addPlaceholderText(const std::string& text) {
+  // Search offsets count the document's own text, which the placeholder would otherwise shift for the rest of it
+  const uint32_t documentOffset = textOffset;
+  characterData(this, text.c_str(), static_cast<int>(text.length()));
+  textOffset = documentOffset;
+}
+
 // flush the contents of partWordBuffer to currentTextBlock
 void ChapterHtmlSlimParser::flushPartWordBuffer() {
   // Determine font style from depth-based tracking and CSS effective style
@@ -105,83 +161,210 @@ void ChapterHtmlSlimParser::startNewTextBlock(const BlockStyle& blockStyle) {
       // This handles cases like <div style="margin-bottom:2em"><h1>text</h1></div> where the
       // div's margin should be preserved, even though it has no direct text content.
       currentTextBlock->setBlockStyle(currentTextBlock->getBlockStyle().getCombinedBlockStyle(blockStyle));
+      // The text that follows belongs to the innermost element
+      currentBlockPosition = encodePosition();
+      blockTextOffset = textOffset;
       return;
     }
 
     makePages();
   }
   currentTextBlock.reset(new ParsedText(extraParagraphSpacing, hyphenationEnabled, blockStyle));
+  currentBlockPosition = encodePosition();
+  blockTextOffset = textOffset;
+}
+
+void ChapterHtmlSlimParser::startNewPage(const uint32_t pageTextOffset) {
+  currentPage.reset(new Page());
+  currentPageNextY = 0;
+  currentPage->position = currentBlockPosition;
+  currentPage->textOffset = pageTextOffset;
+}
+
+void ChapterHtmlSlimParser::pushPathLevel(const char* name) {
+  // A chapter only uses a handful of tag names, so they are interned and compared by index
+  uint16_t nameId = 0;
+  while (nameId < tagNames.size() && (tagNames[nameId][0] != name[0] || strcmp(tagNames[nameId].c_str(), name) != 0)) {
+    nameId++;
+  }
+  if (nameId == tagNames.size()) {
+    tagNames.emplace_back(name);
+    if (tagNames.back() == "body") {
+      bodyName = nameId;
+    }
+  }
+  if (static_cast<int>(nameId) == bodyName) {
+    textOffset = 0;
+  }
+
+  uint16_t index = 1;
+  if (pathDepth > 0) {
+    auto& siblings = pathLevels[pathDepth - 1].childCounts;
+    const auto sibling = std::find_if(siblings.begin(), siblings.end(),
+                                      [nameId](const std::pair<uint16_t, uint16_t>& s) { return s.first == nameId; });
+    if (sibling == siblings.end()) {
+      siblings.emplace_back(nameId, 1);
+    } else {
+      if (sibling->second < UINT16_MAX) {
+        sibling->second++;
+      }
+      index = sibling->second;
+    }
+  }
+
+  if (pathLevels.size() == pathDepth) {
+    pathLevels.emplace_back();
+  }
+  PathLevel& level = pathLevels[pathDepth++];
+  level.name = nameId;
+  level.index = index;
+  level.childCounts.clear();
+}
+
+void ChapterHtmlSlimParser::queueStartedElementId() {
+  if (!startedElementId.empty()) {
+    pendingAnchors.push_back(std::move(startedElementId));
+    startedElementId.clear();
+  }
+}
+
+void ChapterHtmlSlimParser::attachPendingAnchors() {
+  for (auto& id : pendingAnchors) {
+    currentPage->anchors.push_back(std::move(id));
+  }
+  pendingAnchors.clear();
+}
+
+std::string ChapterHtmlSlimParser::encodePosition() const {
+  std::string position;
+  // Levels below <body>, where KOReader's path within a DocFragment starts
+  size_t level = 0;
+  while (level < pathDepth && static_cast<int>(pathLevels[level].name) != bodyName) {
+    level++;
+  }
+  for (level++; level < pathDepth; level++) {
+    const PathLevel& element = pathLevels[level];
+    const auto& siblings = pathLevels[level - 1].childCounts;
+    const auto siblingNames = static_cast<uint8_t>(std::min<size_t>(siblings.size() - 1, UINT8_MAX));
+    DomPosition::appendLevel(position, tagNames[element.name], element.index, siblingNames);
+    uint8_t written = 0;
+    for (const auto& [name, count] : siblings) {
+      if (name != element.name && written < siblingNames) {
+        DomPosition::appendSibling(position, tagNames[name], count);
+        written++;
+      }
+    }
+  }
+  return position;
 }
 
 void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char* name, const XML_Char** atts) {
   auto* self = static_cast<ChapterHtmlSlimParser*>(userData);
+  self->queueStartedElementId();
+
+  // Classified once here, endElement reads the category back instead of looking at the name again
+  const uint16_t category = classifyTag(name);
+  self->openTagCategories.push_back(category);
+  self->pushPathLevel(name);
 
   // Middle of skip
   if (self->skipUntilDepth < self->depth) {
+    self->cssAncestors.push({});
     self->depth += 1;
     return;
   }
 
-  // Extract class and style attributes for CSS processing
-  std::string classAttr;
-  std::string styleAttr;
+  // Class and style attributes for CSS processing, only copied if a rule lookup actually needs them
+  const char* classAttr = "";
+  const char* styleAttr = "";
   if (atts != nullptr) {
     for (int i = 0; atts[i]; i += 2) {
       if (strcmp(atts[i], "class") == 0) {
         classAttr = atts[i + 1];
       } else if (strcmp(atts[i], "style") == 0) {
         styleAttr = atts[i + 1];
+      } else if (strcmp(atts[i], "id") == 0) {
+        // Link and TOC target, resolved to the page its content starts on
+        self->startedElementId = atts[i + 1];
       }
     }
   }
 
+  // Resolve the rule style before this element joins the ancestors, endElement pops it whichever path returns below
+  CssStyle cssStyle;
+  if (self->cssParser) {
+    const auto cssKey = self->cssParser->elementKey(name, classAttr);
+    cssStyle = self->cssParser->resolveStyle(cssKey, &self->cssAncestors);
+    self->cssAncestors.push(cssKey);
+  } else {
+    self->cssAncestors.push({});
+  }
+
   auto centeredBlockStyle = BlockStyle();
   centeredBlockStyle.textAlignDefined = true;
   centeredBlockStyle.alignment = CssTextAlign::Center;
 
   // Special handling for tables - show placeholder text instead of dropping silently
-  if (strcmp(name, "table") == 0) {
+  if (category & TAG_TABLE) {
     // Add placeholder text
     self->startNewTextBlock(centeredBlockStyle);
 
     self->italicUntilDepth = min(self->italicUntilDepth, self->depth);
     // Advance depth before processing character data (like you would for an element with text)
     self->depth += 1;
-    self->characterData(userData, "[Table omitted]", strlen("[Table omitted]"));
+    self->addPlaceholderText("[Table omitted]");
 
     // Skip table contents (skip until parent as we pre-advanced depth above)
     self->skipUntilDepth = self->depth - 1;
     return;
   }
 
-  if (matches(name, IMAGE_TAGS, NUM_IMAGE_TAGS)) {
-    // TODO: Start processing image tags
+  if (category & TAG_IMAGE) {
     std::string alt = "[Image]";
+    std::string src;
     if (atts != nullptr) {
       for (int i = 0; atts[i]; i += 2) {
         if (strcmp(atts[i], "alt") == 0) {
           if (strlen(atts[i + 1]) > 0) {
             alt = "[Image: " + std::string(atts[i + 1]) + "]";
           }
-          break;
+        } else if (strcmp(atts[i], "src") == 0) {
+          src = atts[i + 1];
         }
       }
     }
 
+    std::string bmpPath;
+    int imageWidth = 0;
+    int imageHeight = 0;
+    if (!src.empty() && self->imageFn && self->imageFn(src, &bmpPath, &imageWidth, &imageHeight)) {
+      // Lay out any text preceding the image so it stays in document order
+      if (self->partWordBufferIndex > 0) {
+        self->flushPartWordBuffer();
+      }
+      self->startNewTextBlock(self->currentTextBlock->getBlockStyle());
+      self->addImageToPage(bmpPath, imageWidth, imageHeight);
+
+      // Skip any image contents (skip until parent as we pre-advance depth)
+      self->depth += 1;
+      self->skipUntilDepth = self->depth - 1;
+      return;
+    }
+
     Serial.printf("[%lu] [EHP] Image alt: %s\n", millis(), alt.c_str());
 
     self->startNewTextBlock(centeredBlockStyle);
     self->italicUntilDepth = min(self->italicUntilDepth, self->depth);
     // Advance depth before processing character data (like you would for an element with text)
     self->depth += 1;
-    self->characterData(userData, alt.c_str(), alt.length());
+    self->addPlaceholderText(alt);
 
     // Skip table contents (skip until parent as we pre-advanced depth above)
     self->skipUntilDepth = self->depth - 1;
     return;
   }
 
-  if (matches(name, SKIP_TAGS, NUM_SKIP_TAGS)) {
+  if (category & TAG_SKIP) {
     // start skip
     self->skipUntilDepth = self->depth;
     self->depth += 1;
@@ -200,23 +383,17 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     }
   }
 
-  // Compute CSS style for this element
-  CssStyle cssStyle;
-  if (self->cssParser) {
-    // Get combined tag + class styles
-    cssStyle = self->cssParser->resolveStyle(name, classAttr);
-    // Merge inline style (highest priority)
-    if (!styleAttr.empty()) {
-      CssStyle inlineStyle = CssParser::parseInlineStyle(styleAttr);
-      cssStyle.applyOver(inlineStyle);
-    }
+  // Merge inline style (highest priority)
+  if (self->cssParser && styleAttr[0] != '\0') {
+    CssStyle inlineStyle = CssParser::parseInlineStyle(styleAttr);
+    cssStyle.applyOver(inlineStyle);
   }
 
   const float emSize = static_cast<float>(self->renderer.getLineHeight(self->fontId)) * self->lineCompression;
   const auto userAlignmentBlockStyle =
       BlockStyle::fromCssStyle(cssStyle, emSize, static_cast<CssTextAlign>(self->paragraphAlignment));
 
-  if (matches(name, HEADER_TAGS, NUM_HEADER_TAGS)) {
+  if (category & TAG_HEADER) {
     self->currentCssStyle = cssStyle;
     auto headerBlockStyle = BlockStyle::fromCssStyle(cssStyle, emSize, CssTextAlign::Center);
     headerBlockStyle.textAlignDefined = true;
@@ -226,8 +403,8 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     self->startNewTextBlock(headerBlockStyle);
     self->boldUntilDepth = std::min(self->boldUntilDepth, self->depth);
     self->updateEffectiveInlineStyle();
-  } else if (matches(name, BLOCK_TAGS, NUM_BLOCK_TAGS)) {
-    if (strcmp(name, "br") == 0) {
+  } else if (category & TAG_BLOCK) {
+    if (category & TAG_LINE_BREAK) {
       if (self->partWordBufferIndex > 0) {
         // flush word preceding <br/> to currentTextBlock before calling startNewTextBlock
         self->flushPartWordBuffer();
@@ -238,11 +415,11 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
       self->startNewTextBlock(userAlignmentBlockStyle);
       self->updateEffectiveInlineStyle();
 
-      if (strcmp(name, "li") == 0) {
+      if (category & TAG_LIST_ITEM) {
         self->currentTextBlock->addWord("\xe2\x80\xa2", EpdFontFamily::REGULAR);
       }
     }
-  } else if (matches(name, UNDERLINE_TAGS, NUM_UNDERLINE_TAGS)) {
+  } else if (category & TAG_UNDERLINE) {
     // Flush buffer before style change so preceding text gets current style
     if (self->partWordBufferIndex > 0) {
       self->flushPartWordBuffer();
@@ -264,7 +441,7 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     }
     self->inlineStyleStack.push_back(entry);
     self->updateEffectiveInlineStyle();
-  } else if (matches(name, BOLD_TAGS, NUM_BOLD_TAGS)) {
+  } else if (category & TAG_BOLD) {
     // Flush buffer before style change so preceding text gets current style
     if (self->partWordBufferIndex > 0) {
       self->flushPartWordBuffer();
@@ -286,7 +463,7 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     }
     self->inlineStyleStack.push_back(entry);
     self->updateEffectiveInlineStyle();
-  } else if (matches(name, ITALIC_TAGS, NUM_ITALIC_TAGS)) {
+  } else if (category & TAG_ITALIC) {
     // Flush buffer before style change so preceding text gets current style
     if (self->partWordBufferIndex > 0) {
       self->flushPartWordBuffer();
@@ -308,7 +485,7 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
     }
     self->inlineStyleStack.push_back(entry);
     self->updateEffectiveInlineStyle();
-  } else if (strcmp(name, "span") == 0 || !isHeaderOrBlock(name)) {
+  } else {
     // Handle span and other inline elements for CSS styling
     if (cssStyle.hasFontWeight() || cssStyle.hasFontStyle() || cssStyle.hasTextDecoration()) {
       // Flush buffer before style change so preceding text gets current style
@@ -341,9 +518,13 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
 
 void XMLCALL ChapterHtmlSlimParser::characterData(void* userData, const XML_Char* s, const int len) {
   auto* self = static_cast<ChapterHtmlSlimParser*>(userData);
+  self->queueStartedElementId();
 
-  // Middle of skip
+  // Middle of skip, still counted so text offsets follow the document rather than what is shown
   if (self->skipUntilDepth < self->depth) {
+    for (int i = 0; i < len; i++) {
+      self->textOffset += !isWhitespace(s[i]);
+    }
     return;
   }
 
@@ -358,6 +539,7 @@ void XMLCALL ChapterHtmlSlimParser::characterData(void* userData, const XML_Char
       // Skip the whitespace char
       continue;
     }
+    self->textOffset++;
 
     // Skip Zero Width No-Break Space / BOM (U+FEFF) = 0xEF 0xBB 0xBF
     const XML_Char FEFF_BYTE_1 = static_cast<XML_Char>(0xEF);
@@ -368,6 +550,7 @@ void XMLCALL ChapterHtmlSlimParser::characterData(void* userData, const XML_Char
       // Check if the next two bytes complete the 3-byte sequence
       if ((i + 2 < len) && (s[i + 1] == FEFF_BYTE_2) && (s[i + 2] == FEFF_BYTE_3)) {
         // Sequence 0xEF 0xBB 0xBF found!
+        self->textOffset += 2;
         i += 2;    // Skip the next two bytes
         continue;  // Move to the next iteration
       }
@@ -388,13 +571,20 @@ void XMLCALL ChapterHtmlSlimParser::characterData(void* userData, const XML_Char
   if (self->currentTextBlock->size() > 750) {
     Serial.printf("[%lu] [EHP] Text block too long, splitting into multiple pages\n", millis());
     self->currentTextBlock->layoutAndExtractLines(
-        self->renderer, self->fontId, self->viewportWidth,
+        self->renderer, self->fontId, self->viewportWidth, *self->layoutScratch,
         [self](const std::shared_ptr<TextBlock>& textBlock) { self->addLineToPage(textBlock); }, false);
   }
 }
 
-void XMLCALL ChapterHtmlSlimParser::endElement(void* userData, const XML_Char* name) {
+void XMLCALL ChapterHtmlSlimParser::endElement(void* userData, const XML_Char* /*name*/) {
   auto* self = static_cast<ChapterHtmlSlimParser*>(userData);
+  self->queueStartedElementId();
+
+  // Expat reports balanced start/end events, so the stack top is always this element
+  const uint16_t category = self->openTagCategories.back();
+  self->openTagCategories.pop_back();
+  self->cssAncestors.pop();
+  self->pathDepth--;
 
   // Check if any style state will change after we decrement depth
   // If so, we MUST flush the partWordBuffer with the CURRENT style first
@@ -406,17 +596,13 @@ void XMLCALL ChapterHtmlSlimParser::endElement(void* userData, const XML_Char* n
   const bool willClearUnderline = self->underlineUntilDepth == self->depth - 1;
 
   const bool styleWillChange = willPopStyleStack || willClearBold || willClearItalic || willClearUnderline;
-  const bool headerOrBlockTag = isHeaderOrBlock(name);
+  const bool headerOrBlockTag = (category & HEADER_OR_BLOCK) != 0;
 
   // Flush buffer with current style BEFORE any style changes
   if (self->partWordBufferIndex > 0) {
     // Flush if style will change OR if we're closing a block/structural element
-    const bool isInlineTag = !headerOrBlockTag && strcmp(name, "table") != 0 &&
-                             !matches(name, IMAGE_TAGS, NUM_IMAGE_TAGS) && self->depth != 1;
-    const bool shouldFlush = styleWillChange || headerOrBlockTag || matches(name, BOLD_TAGS, NUM_BOLD_TAGS) ||
-                             matches(name, ITALIC_TAGS, NUM_ITALIC_TAGS) ||
-                             matches(name, UNDERLINE_TAGS, NUM_UNDERLINE_TAGS) || strcmp(name, "table") == 0 ||
-                             matches(name, IMAGE_TAGS, NUM_IMAGE_TAGS) || self->depth == 1;
+    const bool isInlineTag = (category & (HEADER_OR_BLOCK | TAG_TABLE | TAG_IMAGE)) == 0 && self->depth != 1;
+    const bool shouldFlush = styleWillChange || (category & FLUSHING_TAGS) != 0 || self->depth == 1;
 
     if (shouldFlush) {
       self->flushPartWordBuffer();
@@ -464,6 +650,12 @@ void XMLCALL ChapterHtmlSlimParser::endElement(void* userData, const XML_Char* n
 }
 
 bool ChapterHtmlSlimParser::parseAndBuildPages() {
+  layoutScratch.reset(new (std::nothrow) ParsedText::LayoutScratch);
+  if (!layoutScratch) {
+    Serial.printf("[%lu] [EHP] Couldn't allocate memory for layout\n", millis());
+    return false;
+  }
+
   auto paragraphAlignmentBlockStyle = BlockStyle();
   paragraphAlignmentBlockStyle.textAlignDefined = true;
   // Resolve None sentinel to Justify for initial block (no CSS context yet)
@@ -542,7 +734,11 @@ bool ChapterHtmlSlimParser::parseAndBuildPages() {
 
   // Process last page if there is still text
   if (currentTextBlock) {
+    queueStartedElementId();
     makePages();
+    if (!pendingAnchors.empty()) {
+      attachPendingAnchors();
+    }
     completePageFn(std::move(currentPage));
     currentPage.reset();
     currentTextBlock.reset();
@@ -556,8 +752,12 @@ void ChapterHtmlSlimParser::addLineToPage(std::shared_ptr<TextBlock> line) {
 
   if (currentPageNextY + lineHeight > viewportHeight) {
     completePageFn(std::move(currentPage));
-    currentPage.reset(new Page());
-    currentPageNextY = 0;
+    startNewPage(blockTextOffset);
+  }
+  blockTextOffset += line->textSize();
+
+  if (!pendingAnchors.empty()) {
+    attachPendingAnchors();
   }
 
   // Apply horizontal left inset (margin + padding) as x position offset
@@ -566,6 +766,30 @@ void ChapterHtmlSlimParser::addLineToPage(std::shared_ptr<TextBlock> line) {
   currentPageNextY += lineHeight;
 }
 
+void ChapterHtmlSlimParser::addImageToPage(const std::string& bmpPath, const int width, const int height) {
+  if (!currentPage) {
+    startNewPage(textOffset);
+  }
+
+  // Images are never split, move to a fresh page if this one can't fit it
+  if (currentPageNextY > 0 && currentPageNextY + height > viewportHeight) {
+    completePageFn(std::move(currentPage));
+    startNewPage(textOffset);
+  }
+
+  if (!pendingAnchors.empty()) {
+    attachPendingAnchors();
+  }
+
+  const int16_t xOffset = width < viewportWidth ? static_cast<int16_t>((viewportWidth - width) / 2) : 0;
+  currentPage->elements.push_back(std::make_shared<PageImage>(bmpPath, width, height, xOffset, currentPageNextY));
+  currentPageNextY += height;
+
+  if (extraParagraphSpacing) {
+    currentPageNextY += renderer.getLineHeight(fontId) * lineCompression / 2;
+  }
+}
+
 void ChapterHtmlSlimParser::makePages() {
   if (!currentTextBlock) {
     Serial.printf("[%lu] [EHP] !! No text block to make pages for !!\n", millis());
@@ -573,8 +797,7 @@ void ChapterHtmlSlimParser::makePages() {
   }
 
   if (!currentPage) {
-    currentPage.reset(new Page());
-    currentPageNextY = 0;
+    startNewPage(blockTextOffset);
   }
 
   const int lineHeight = renderer.getLineHeight(fontId) * lineCompression;
@@ -594,7 +817,7 @@ void ChapterHtmlSlimParser::makePages() {
       (horizontalInset < viewportWidth) ? static_cast<uint16_t>(viewportWidth - horizontalInset) : viewportWidth;
 
   currentTextBlock->layoutAndExtractLines(
-      renderer, fontId, effectiveWidth,
+      renderer, fontId, effectiveWidth, *layoutScratch,
       [this](const std::shared_ptr<TextBlock>& textBlock) { addLineToPage(textBlock); });
 
   // Apply bottom spacing after the paragraph (stored in pixels)
@@ -5,6 +5,7 @@
 #include <climits>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "../ParsedText.h"
 #include "../blocks/TextBlock.h"
@@ -16,22 +17,51 @@ class GfxRenderer;
 
 #define MAX_WORD_SIZE 200
 
+// Resolves an <img src> to a cached, pre-scaled BMP. Returns false if the image can't be shown.
+using ImageResolveFn = std::function<bool(const std::string& src, std::string* bmpPath, int* width, int* height)>;
+
 class ChapterHtmlSlimParser {
   const std::string& filepath;
   GfxRenderer& renderer;
   std::function<void(std::unique_ptr<Page>)> completePageFn;
   std::function<void()> popupFn;  // Popup callback
+  ImageResolveFn imageFn;
   int depth = 0;
   int skipUntilDepth = INT_MAX;
   int boldUntilDepth = INT_MAX;
   int italicUntilDepth = INT_MAX;
   int underlineUntilDepth = INT_MAX;
+  // Tag category bitmask of every open element, innermost last
+  std::vector<uint16_t> openTagCategories;
+  // Interned tag and classes of every open element, for selectors with ancestors
+  CssParser::AncestorStack cssAncestors;
+  // Name, same-name index and children seen per name of every open element, for the DomPosition of each page.
+  // Levels past pathDepth are kept so their child counts reuse their capacity.
+  struct PathLevel {
+    uint16_t name = 0;
+    uint16_t index = 0;
+    std::vector<std::pair<uint16_t, uint16_t>> childCounts;
+  };
+  std::vector<PathLevel> pathLevels;
+  size_t pathDepth = 0;
+  std::vector<std::string> tagNames;
+  int bodyName = -1;
+  std::string currentBlockPosition;
+  // Non-whitespace bytes of character data since <body>, and where the next line of the current block starts in them
+  uint32_t textOffset = 0;
+  uint32_t blockTextOffset = 0;
+  // Id of the element just started, queued by the next parser event so a block it starts has begun by then
+  std::string startedElementId;
+  // Ids that land on the page of the next line or image placed
+  std::vector<std::string> pendingAnchors;
   // buffer for building up words from characters, will auto break if longer than this
   // leave one char at end for null pointer
   char partWordBuffer[MAX_WORD_SIZE + 1] = {};
   int partWordBufferIndex = 0;
   bool nextWordContinues = false;  // true when next flushed word attaches to previous (inline element boundary)
   std::unique_ptr<ParsedText> currentTextBlock = nullptr;
+  // Allocated by parseAndBuildPages for laying out text blocks
+  std::unique_ptr<ParsedText::LayoutScratch> layoutScratch = nullptr;
   std::unique_ptr<Page> currentPage = nullptr;
   int16_t currentPageNextY = 0;
   int fontId;
@@ -59,8 +89,16 @@ class ChapterHtmlSlimParser {
 
   void updateEffectiveInlineStyle();
   void startNewTextBlock(const BlockStyle& blockStyle);
+  void startNewPage(uint32_t pageTextOffset);
+  void pushPathLevel(const char* name);
+  std::string encodePosition() const;
+  void queueStartedElementId();
+  void attachPendingAnchors();
   void flushPartWordBuffer();
+  // Text shown in place of content that isn't rendered, left out of textOffset as it isn't in the document
+  void addPlaceholderText(const std::string& text);
   void makePages();
+  void addImageToPage(const std::string& bmpPath, int width, int height);
   // XML callbacks
   static void XMLCALL startElement(void* userData, const XML_Char* name, const XML_Char** atts);
   static void XMLCALL characterData(void* userData, const XML_Char* s, int len);
@@ -73,7 +111,7 @@ class ChapterHtmlSlimParser {
                                  const uint16_t viewportHeight, const bool hyphenationEnabled,
                                  const std::function<void(std::unique_ptr<Page>)>& completePageFn,
                                  const bool embeddedStyle, const std::function<void()>& popupFn = nullptr,
-                                 const CssParser* cssParser = nullptr)
+                                 const CssParser* cssParser = nullptr, const ImageResolveFn& imageFn = nullptr)
 
       : filepath(filepath),
         renderer(renderer),
@@ -86,6 +124,7 @@ class ChapterHtmlSlimParser {
         hyphenationEnabled(hyphenationEnabled),
         completePageFn(completePageFn),
         popupFn(popupFn),
+        imageFn(imageFn),
         cssParser(cssParser),
         embeddedStyle(embeddedStyle) {}
 
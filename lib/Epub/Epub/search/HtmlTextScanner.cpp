@@ -0,0 +1,335 @@
+#include "HtmlTextScanner.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+bool isSpace(const uint8_t c) { return c == ' ' || c == '\r' || c == '\n' || c == '\t'; }
+
+bool isNameChar(const uint8_t c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '#';
+}
+
+bool nameIs(const char* name, const uint8_t length, const char* other) {
+  return strlen(other) == length && memcmp(name, other, length) == 0;
+}
+
+// Formatting tags that can sit inside a word, every other tag separates the text on either side
+bool isInlineTag(const char* name, const uint8_t length) {
+  static const char* const INLINE_TAGS[] = {"a",    "abbr", "b",    "big", "cite", "code",   "em",     "font",
+                                            "i",    "mark", "q",    "s",   "small", "span",  "strike", "strong",
+                                            "sub",  "sup",  "tt",   "u",   "var"};
+  for (const char* tag : INLINE_TAGS) {
+    if (nameIs(name, length, tag)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t encodeUtf8(const uint32_t cp, uint8_t* out) {
+  if (cp < 0x80) {
+    out[0] = static_cast<uint8_t>(cp);
+    return 1;
+  }
+  if (cp < 0x800) {
+    out[0] = static_cast<uint8_t>(0xC0 | cp >> 6);
+    out[1] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+    return 2;
+  }
+  if (cp < 0x10000) {
+    out[0] = static_cast<uint8_t>(0xE0 | cp >> 12);
+    out[1] = static_cast<uint8_t>(0x80 | (cp >> 6 & 0x3F));
+    out[2] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+    return 3;
+  }
+  if (cp < 0x110000) {
+    out[0] = static_cast<uint8_t>(0xF0 | cp >> 18);
+    out[1] = static_cast<uint8_t>(0x80 | (cp >> 12 & 0x3F));
+    out[2] = static_cast<uint8_t>(0x80 | (cp >> 6 & 0x3F));
+    out[3] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+    return 4;
+  }
+  return 0;
+}
+
+// Non-whitespace bytes, the units of a text offset
+uint32_t countText(const uint8_t* text, const size_t length) {
+  uint32_t count = 0;
+  for (size_t i = 0; i < length; i++) {
+    count += text[i] != ' ';
+  }
+  return count;
+}
+}  // namespace
+
+size_t HtmlTextScanner::write(const uint8_t* buffer, const size_t size) {
+  if (stop || cancel.load(std::memory_order_relaxed)) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    const uint8_t c = buffer[i];
+    switch (state) {
+      case State::TEXT:
+        if (c == '<') {
+          state = State::TAG_START;
+        } else if (c == '&') {
+          state = State::ENTITY;
+          pendingLength = 0;
+        } else {
+          text(c);
+        }
+        break;
+
+      case State::TAG_START:
+        tagNameLength = 0;
+        closingTag = c == '/';
+        if (c == '!' || c == '?') {
+          // Comment, doctype, CDATA or processing instruction
+          state = State::MARKUP;
+          pendingLength = 0;
+        } else if (c == '>') {
+          state = State::TEXT;
+        } else {
+          state = State::TAG_NAME;
+          if (!closingTag) {
+            tagName[tagNameLength++] = static_cast<char>(tolower(c));
+          }
+        }
+        break;
+
+      case State::TAG_NAME:
+        if (c == '>') {
+          endTag();
+        } else if (isSpace(c) || c == '/') {
+          state = State::TAG;
+        } else if (tagNameLength < sizeof(tagName)) {
+          tagName[tagNameLength++] = static_cast<char>(tolower(c));
+        }
+        break;
+
+      case State::TAG:
+        if (c == '"' || c == '\'') {
+          quote = static_cast<char>(c);
+          state = State::TAG_QUOTE;
+        } else if (c == '>') {
+          endTag();
+        }
+        break;
+
+      case State::TAG_QUOTE:
+        if (c == quote) {
+          state = State::TAG;
+        }
+        break;
+
+      case State::MARKUP:
+        // "<!--" opens a comment, which may hold '>', anything else ends at the first '>'
+        if (pendingLength < 2 && c == '-') {
+          if (++pendingLength == 2) {
+            state = State::COMMENT;
+            pendingLength = 0;
+          }
+        } else {
+          pendingLength = 2;
+          if (c == '>') {
+            state = State::TEXT;
+          }
+        }
+        break;
+
+      case State::COMMENT:
+        // pendingLength counts the dashes just seen
+        if (c == '>' && pendingLength >= 2) {
+          state = State::TEXT;
+        } else if (c == '-') {
+          pendingLength = std::min<uint8_t>(pendingLength + 1, 2);
+        } else {
+          pendingLength = 0;
+        }
+        break;
+
+      case State::ENTITY:
+        if (c == ';') {
+          decodeEntity();
+          state = State::TEXT;
+        } else if (isNameChar(c) && pendingLength < sizeof(pending)) {
+          pending[pendingLength++] = static_cast<char>(c);
+        } else {
+          // Not an entity after all, keep it as text
+          state = State::TEXT;
+          text('&');
+          for (uint8_t j = 0; j < pendingLength; j++) {
+            text(pending[j]);
+          }
+          i--;
+        }
+        break;
+    }
+    if (stop) {
+      return 0;
+    }
+  }
+  return size;
+}
+
+void HtmlTextScanner::endTag() {
+  state = State::TEXT;
+  if (nameIs(tagName, tagNameLength, "body")) {
+    // Text offsets count from the start of the body, like ChapterHtmlSlimParser's
+    inBody = !closingTag;
+    if (inBody) {
+      fill = 0;
+      searchFrom = 0;
+      windowOffset = 0;
+      textEnd = 0;
+      lastWasSpace = true;
+    }
+    return;
+  }
+  if (!isInlineTag(tagName, tagNameLength)) {
+    space();
+  }
+}
+
+void HtmlTextScanner::decodeEntity() {
+  const char* name = pending;
+  const uint8_t length = pendingLength;
+  uint32_t cp = 0;
+  if (length > 1 && name[0] == '#') {
+    const bool hex = name[1] == 'x' || name[1] == 'X';
+    const std::string digits(name + (hex ? 2 : 1), name + length);
+    cp = static_cast<uint32_t>(strtoul(digits.c_str(), nullptr, hex ? 16 : 10));
+  } else if (nameIs(name, length, "amp")) {
+    cp = '&';
+  } else if (nameIs(name, length, "lt")) {
+    cp = '<';
+  } else if (nameIs(name, length, "gt")) {
+    cp = '>';
+  } else if (nameIs(name, length, "quot")) {
+    cp = '"';
+  } else if (nameIs(name, length, "apos")) {
+    cp = '\'';
+  }
+  // Entities the document's DTD would define are skipped, as the chapter parser does
+
+  uint8_t bytes[4];
+  const size_t count = cp == 0 ? 0 : encodeUtf8(cp, bytes);
+  for (size_t i = 0; i < count; i++) {
+    text(bytes[i]);
+  }
+}
+
+void HtmlTextScanner::text(const uint8_t c) {
+  if (!inBody) {
+    return;
+  }
+  if (isSpace(c)) {
+    space();
+    return;
+  }
+
+  if (utf8Length > 0) {
+    if ((c & 0xC0) == 0x80) {
+      utf8[utf8Length++] = c;
+      if (utf8Length == utf8Expected) {
+        push(utf8, utf8Length);
+        utf8Length = 0;
+      }
+      return;
+    }
+    // Truncated character, kept as it is
+    push(utf8, utf8Length);
+    utf8Length = 0;
+  }
+
+  const size_t length = TextMatcher::charLength(c);
+  if (length == 1) {
+    push(&c, 1);
+    return;
+  }
+  utf8[0] = c;
+  utf8Length = 1;
+  utf8Expected = static_cast<uint8_t>(length);
+}
+
+void HtmlTextScanner::space() {
+  if (!inBody) {
+    return;
+  }
+  if (utf8Length > 0) {
+    push(utf8, utf8Length);
+    utf8Length = 0;
+  }
+  if (!lastWasSpace) {
+    constexpr uint8_t SPACE = ' ';
+    push(&SPACE, 1);
+    lastWasSpace = true;
+  }
+}
+
+void HtmlTextScanner::push(const uint8_t* c, const size_t length) {
+  if (fill + length > WINDOW_SIZE) {
+    search(false);
+  }
+  memcpy(window + fill, c, length);
+  memcpy(folded + fill, c, length);
+  TextMatcher::fold(folded + fill, length);
+  if (listener) {
+    listener->onText(folded + fill, length, textEnd);
+  }
+  if (c[0] != ' ') {
+    textEnd += length;
+  }
+  fill += length;
+  lastWasSpace = false;
+}
+
+void HtmlTextScanner::search(const bool final) {
+  // Until the chapter ends, matches wait for the text that follows them in their snippet
+  const size_t end = final ? fill : (fill > SNIPPET_AFTER ? fill - SNIPPET_AFTER : 0);
+  if (!stop) {
+    searchFrom = matcher.find(folded, searchFrom, end, [this](const size_t start) {
+      const uint32_t offset = windowOffset + countText(window, start);
+      if (!onMatch(offset, snippet(start))) {
+        stop = true;
+      }
+      return !stop;
+    });
+  }
+  if (final) {
+    return;
+  }
+
+  // Keep what the next search still needs: the unsearched tail and the snippet context before it
+  const size_t keep = stop ? fill : std::min(searchFrom > SNIPPET_BEFORE ? searchFrom - SNIPPET_BEFORE : 0, fill);
+  windowOffset += countText(window, keep);
+  memmove(window, window + keep, fill - keep);
+  memmove(folded, folded + keep, fill - keep);
+  fill -= keep;
+  searchFrom -= keep;
+}
+
+std::string HtmlTextScanner::snippet(const size_t start) const {
+  size_t from = start > SNIPPET_BEFORE ? start - SNIPPET_BEFORE : 0;
+  size_t to = std::min(fill, start + matcher.length() + SNIPPET_AFTER);
+  // Whole characters only, the window can start or be cut in the middle of one
+  while (from < start && (window[from] & 0xC0) == 0x80) from++;
+  while (to < fill && to > start && (window[to] & 0xC0) == 0x80) to--;
+  while (from < start && window[from] == ' ') from++;
+  while (to > start && window[to - 1] == ' ') to--;
+  return {reinterpret_cast<const char*>(window + from), to - from};
+}
+
+void HtmlTextScanner::finish() {
+  if (utf8Length > 0) {
+    push(utf8, utf8Length);
+    utf8Length = 0;
+  }
+  search(true);
+}
+
+uint32_t HtmlTextScanner::textLength() const { return textEnd; }
@@ -0,0 +1,96 @@
+#pragma once
+#include <Print.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "TextMatcher.h"
+
+// Receives the text an HtmlTextScanner searches, e.g. to index its words
+class TextListener {
+ public:
+  virtual ~TextListener() = default;
+  // One folded character, or the single space standing for whitespace and block boundaries, at its text offset
+  virtual void onText(const uint8_t* folded, size_t length, uint32_t textOffset) = 0;
+};
+
+/**
+ * Finds a TextMatcher's query in a chapter's XHTML as it streams through, e.g. out of the EPUB's inflater, without
+ * holding more than a small window of its text.
+ *
+ * Markup, comments and everything outside <body> are dropped and entities decoded. Whitespace runs, and tags other
+ * than inline formatting ones, become a single space so a match can't join words from different blocks. Matches are
+ * reported by text offset: the number of non-whitespace bytes of character data since <body>, as counted by
+ * ChapterHtmlSlimParser for the first line of every page, so Section::findTextPage() maps them to pages.
+ */
+class HtmlTextScanner final : public Print {
+ public:
+  // Bytes of text around a match shown in its snippet, trimmed to whole characters
+  static constexpr size_t SNIPPET_BEFORE = 30;
+  static constexpr size_t SNIPPET_AFTER = 50;
+  static constexpr size_t WINDOW_SIZE = 1024;
+
+  // Called per match with its text offset and snippet, returns false to stop scanning
+  using OnMatch = std::function<bool(uint32_t textOffset, const std::string& snippet)>;
+
+  // cancel is polled on every chunk written, set it from another task to abandon the scan
+  explicit HtmlTextScanner(const TextMatcher& matcher, OnMatch onMatch, const std::atomic<bool>& cancel)
+      : matcher(matcher), onMatch(std::move(onMatch)), cancel(cancel) {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  // Returns 0 once cancelled or stopped, which aborts ZipFile::readFileToStream
+  size_t write(const uint8_t* buffer, size_t size) override;
+  // Search the text still held back for context once the chapter has been written
+  void finish();
+  // Pass the text on to listener as well, nullptr to stop
+  void setListener(TextListener* textListener) { listener = textListener; }
+
+  bool stopped() const { return stop; }
+  // Text offset of the end of everything written so far
+  uint32_t textLength() const;
+
+ private:
+  enum class State : uint8_t { TEXT, TAG_START, TAG_NAME, TAG, TAG_QUOTE, MARKUP, COMMENT, ENTITY };
+
+  const TextMatcher& matcher;
+  OnMatch onMatch;
+  const std::atomic<bool>& cancel;
+  TextListener* listener = nullptr;
+  bool stop = false;
+
+  State state = State::TEXT;
+  bool inBody = false;
+  bool closingTag = false;
+  char quote = 0;
+  // Lowercased start of the current tag's name, enough to tell the few names that matter
+  char tagName[8] = {};
+  uint8_t tagNameLength = 0;
+  // Entity name, or the last bytes of a comment to spot its end
+  char pending[12] = {};
+  uint8_t pendingLength = 0;
+  // The UTF-8 character being assembled, pushed into the window once complete
+  uint8_t utf8[4] = {};
+  uint8_t utf8Length = 0;
+  uint8_t utf8Expected = 0;
+  bool lastWasSpace = true;
+
+  // Collapsed text and its folded copy, which are the same length
+  uint8_t window[WINDOW_SIZE] = {};
+  uint8_t folded[WINDOW_SIZE] = {};
+  size_t fill = 0;
+  // First match start in the window not searched yet
+  size_t searchFrom = 0;
+  // Text offset of window[0] and of the end of the window
+  uint32_t windowOffset = 0;
+  uint32_t textEnd = 0;
+
+  void text(uint8_t c);
+  void space();
+  void push(const uint8_t* c, size_t length);
+  void endTag();
+  void decodeEntity();
+  void search(bool final);
+  std::string snippet(size_t start) const;
+};
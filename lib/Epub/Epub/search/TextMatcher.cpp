@@ -0,0 +1,137 @@
+#include "TextMatcher.h"
+
+#include <cstring>
+
+namespace {
+bool isSpace(const char c) { return c == ' ' || c == '\r' || c == '\n' || c == '\t'; }
+
+// Lowercase of a two byte code point, limited to mappings that stay two bytes long
+uint32_t lowercase(const uint32_t cp) {
+  // Latin-1 Supplement, except the multiplication sign
+  if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) return cp + 0x20;
+  // Latin Extended-A pairs, leaving out dotted and dotless i which change length
+  if (cp >= 0x100 && cp <= 0x137) return (cp % 2 == 0 && cp != 0x130) ? cp + 1 : cp;
+  if (cp >= 0x139 && cp <= 0x148) return cp % 2 == 1 ? cp + 1 : cp;
+  if (cp >= 0x14A && cp <= 0x177) return cp % 2 == 0 ? cp + 1 : cp;
+  if (cp == 0x178) return 0xFF;
+  if (cp >= 0x179 && cp <= 0x17E) return cp % 2 == 1 ? cp + 1 : cp;
+  // Greek, with final sigma matching sigma
+  if (cp == 0x386) return 0x3AC;
+  if (cp >= 0x388 && cp <= 0x38A) return cp + 37;
+  if (cp == 0x38C) return 0x3CC;
+  if (cp == 0x38E || cp == 0x38F) return cp + 63;
+  if (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2) return cp + 0x20;
+  if (cp == 0x3C2) return 0x3C3;
+  // Cyrillic
+  if (cp >= 0x400 && cp <= 0x40F) return cp + 0x50;
+  if (cp >= 0x410 && cp <= 0x42F) return cp + 0x20;
+  if (cp >= 0x490 && cp <= 0x4BF) return cp % 2 == 0 ? cp + 1 : cp;
+  return cp;
+}
+}  // namespace
+
+size_t TextMatcher::charLength(const uint8_t lead) {
+  if (lead < 0xC0) return 1;
+  if (lead < 0xE0) return 2;
+  if (lead < 0xF0) return 3;
+  if (lead < 0xF8) return 4;
+  return 1;
+}
+
+TextMatcher::CharClass TextMatcher::charClass(const uint8_t* c, const size_t length) {
+  if (length != charLength(c[0])) {
+    return CharClass::SEPARATOR;
+  }
+  if (length == 1) {
+    const uint8_t lower = c[0] | 0x20;
+    return (c[0] >= '0' && c[0] <= '9') || (lower >= 'a' && lower <= 'z') ? CharClass::WORD : CharClass::SEPARATOR;
+  }
+  if (length == 2) {
+    const uint32_t cp = static_cast<uint32_t>(c[0] & 0x1F) << 6 | (c[1] & 0x3F);
+    // Latin-1 punctuation and symbols, and the multiplication and division signs
+    return (cp >= 0xA0 && cp <= 0xBF) || cp == 0xD7 || cp == 0xF7 ? CharClass::SEPARATOR : CharClass::WORD;
+  }
+  if (length == 3) {
+    const uint32_t cp = static_cast<uint32_t>(c[0] & 0x0F) << 12 | (c[1] & 0x3F) << 6 | (c[2] & 0x3F);
+    // Punctuation, symbols, CJK punctuation and fullwidth forms
+    if ((cp >= 0x2000 && cp <= 0x2BFF) || (cp >= 0x3000 && cp <= 0x303F) || cp >= 0xFE30) {
+      return CharClass::SEPARATOR;
+    }
+    // Thai, Lao, Myanmar, Khmer and CJK are written without spaces between words
+    if ((cp >= 0xE00 && cp <= 0xEFF) || (cp >= 0x1000 && cp <= 0x109F) || (cp >= 0x1780 && cp <= 0x17FF) ||
+        (cp >= 0x2E80 && cp <= 0x9FFF) || (cp >= 0xF900 && cp <= 0xFAFF)) {
+      return CharClass::IDEOGRAPH;
+    }
+    return CharClass::WORD;
+  }
+  // Supplementary ideographs, the rest of the four byte characters are mostly emoji
+  const uint32_t plane = static_cast<uint32_t>(c[0] & 0x07) << 2 | (c[1] & 0x3F) >> 4;
+  return plane == 2 || plane == 3 ? CharClass::IDEOGRAPH : CharClass::SEPARATOR;
+}
+
+void TextMatcher::fold(uint8_t* c, const size_t length) {
+  if (length == 1) {
+    if (c[0] >= 'A' && c[0] <= 'Z') {
+      c[0] += 'a' - 'A';
+    }
+    return;
+  }
+  if (length != 2 || (c[1] & 0xC0) != 0x80) {
+    return;
+  }
+  const uint32_t cp = lowercase(static_cast<uint32_t>(c[0] & 0x1F) << 6 | (c[1] & 0x3F));
+  c[0] = static_cast<uint8_t>(0xC0 | cp >> 6);
+  c[1] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+}
+
+bool TextMatcher::setQuery(const std::string& text, const bool wordStarts) {
+  query.clear();
+  queryLength = 0;
+
+  // Trimmed, with each whitespace run searched for as the single space the scanner turns it into
+  size_t start = 0;
+  size_t end = text.size();
+  while (start < end && isSpace(text[start])) start++;
+  while (end > start && isSpace(text[end - 1])) end--;
+  for (size_t i = start; i < end; i++) {
+    if (!isSpace(text[i])) {
+      query += text[i];
+    } else if (query.back() != ' ') {
+      query += ' ';
+    }
+  }
+  if (query.empty() || query.size() > MAX_QUERY_SIZE) {
+    query.clear();
+    return false;
+  }
+
+  queryLength = query.size();
+  memcpy(folded, query.data(), queryLength);
+  for (size_t i = 0; i < queryLength;) {
+    const size_t length = charLength(folded[i]);
+    if (i + length > queryLength) {
+      break;
+    }
+    fold(folded + i, length);
+    i += length;
+  }
+
+  wordStart = wordStarts && charClass(folded, charLength(folded[0])) == CharClass::WORD;
+
+  memset(skip, static_cast<int>(queryLength), sizeof(skip));
+  for (size_t i = 0; i + 1 < queryLength; i++) {
+    skip[folded[i]] = static_cast<uint8_t>(queryLength - 1 - i);
+  }
+  return true;
+}
+
+bool TextMatcher::matchesAt(const uint8_t* text) const { return memcmp(text, folded, queryLength - 1) == 0; }
+
+bool TextMatcher::startsWord(const uint8_t* text, const size_t at) {
+  if (at == 0) {
+    return true;
+  }
+  size_t lead = at - 1;
+  while (lead > 0 && at - lead < 4 && (text[lead] & 0xC0) == 0x80) lead--;
+  return charClass(text + lead, at - lead) != CharClass::WORD;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Case-insensitive substring search over UTF-8 text with Boyer-Moore-Horspool.
+ *
+ * Text and query are compared after fold(), which lowercases Latin, Greek and Cyrillic letters without changing how
+ * many bytes they take, so an offset into folded text is the same offset into the original. The query is folded and
+ * its whitespace runs collapsed to single spaces once in setQuery(); since UTF-8 is self-synchronizing, a folded query
+ * starting with a whole character only ever matches at character boundaries.
+ *
+ * Searches that use WordIndex ask for word starts: a query starting with a letter or digit then only matches at the
+ * start of a word, so "hay" finds "haystack" but not "ahay", and every query word but the last lines up with a whole
+ * word of the text, which is what the index can look up. Ideographs, and letters of other scripts written without
+ * spaces, are words of one character each. Otherwise any substring matches.
+ */
+class TextMatcher {
+ public:
+  // Folded query bytes, longer queries are rejected
+  static constexpr size_t MAX_QUERY_SIZE = 64;
+
+  // What a character is to word boundaries
+  enum class CharClass : uint8_t { SEPARATOR, WORD, IDEOGRAPH };
+
+  // False if the query is empty or too long once folded. With wordStarts, matches have to start a word
+  bool setQuery(const std::string& query, bool wordStarts = false);
+  size_t length() const { return queryLength; }
+  const std::string& getQuery() const { return query; }
+  // The query as it is matched: folded, trimmed and with single spaces
+  const uint8_t* getFolded() const { return folded; }
+
+  // Lowercase the complete UTF-8 character of length bytes at c in place
+  static void fold(uint8_t* c, size_t length);
+  // Bytes in the UTF-8 character starting with lead, 1 for bytes that can't start one
+  static size_t charLength(uint8_t lead);
+  // Class of the UTF-8 character of length bytes at c, SEPARATOR for truncated ones
+  static CharClass charClass(const uint8_t* c, size_t length);
+
+  /**
+   * Report each match in folded text starting in [from, end - length()], without overlaps, and return the first start
+   * not ruled out yet, where the search resumes once more text follows end. onMatch(start) returns false to stop.
+   * The character before a match is looked at to find word starts, text[0] is taken as the start of the text.
+   */
+  template <typename OnMatch>
+  size_t find(const uint8_t* text, size_t from, const size_t end, OnMatch&& onMatch) const {
+    if (queryLength == 0) {
+      return end;
+    }
+    const uint8_t last = folded[queryLength - 1];
+    while (from + queryLength <= end) {
+      const uint8_t c = text[from + queryLength - 1];
+      if (c == last && matchesAt(text + from) && (!wordStart || startsWord(text, from))) {
+        if (!onMatch(from)) {
+          return from + queryLength;
+        }
+        from += queryLength;
+      } else {
+        from += skip[c];
+      }
+    }
+    return from;
+  }
+
+ private:
+  std::string query;
+  uint8_t folded[MAX_QUERY_SIZE] = {};
+  size_t queryLength = 0;
+  // Whether matches have to start a word
+  bool wordStart = false;
+  // Horspool shift per text byte under the query's last position
+  uint8_t skip[256] = {};
+
+  bool matchesAt(const uint8_t* text) const;
+  static bool startsWord(const uint8_t* text, size_t at);
+};
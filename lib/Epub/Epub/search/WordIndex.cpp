@@ -0,0 +1,824 @@
+#include "WordIndex.h"
+
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+#include <Serialization.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr uint8_t INDEX_VERSION = 2;
+// Term count, postings end, first and end spine item, version
+constexpr uint32_t FOOTER_SIZE = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint16_t) + 1;
+// Offset of the term's record in the postings file
+constexpr uint32_t DICTIONARY_ENTRY_SIZE = sizeof(uint32_t);
+// Runs merged at once
+constexpr size_t MERGE_WAYS = 16;
+
+std::string segmentPath(const std::string& dir, const uint16_t firstSpineIndex, const char* extension) {
+  return dir + "/" + std::to_string(firstSpineIndex) + extension;
+}
+
+std::string scratchPath(const std::string& dir, const int which) {
+  return dir + "/runs" + std::to_string(which) + ".tmp";
+}
+
+int compareTerms(const uint8_t* a, const size_t aLength, const uint8_t* b, const size_t bLength) {
+  const int result = memcmp(a, b, std::min(aLength, bLength));
+  if (result != 0) {
+    return result;
+  }
+  return aLength < bLength ? -1 : aLength > bLength ? 1 : 0;
+}
+
+// Collects small writes into whole buffers for the SD card
+class BufferedWriter {
+  FsFile& file;
+  uint8_t buffer[512] = {};
+  size_t length = 0;
+  uint32_t written = 0;
+  bool ok = true;
+
+ public:
+  explicit BufferedWriter(FsFile& file) : file(file) {}
+
+  bool write(const void* data, const size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+      if (length == sizeof(buffer) && !flush()) {
+        return false;
+      }
+      buffer[length++] = bytes[i];
+    }
+    written += size;
+    return ok;
+  }
+  bool writeVarint(uint32_t value) {
+    uint8_t bytes[5];
+    size_t count = 0;
+    do {
+      bytes[count] = static_cast<uint8_t>(value & 0x7F);
+      value >>= 7;
+      if (value != 0) {
+        bytes[count] |= 0x80;
+      }
+      count++;
+    } while (value != 0);
+    return write(bytes, count);
+  }
+  bool flush() {
+    if (length > 0 && file.write(buffer, length) != length) {
+      ok = false;
+    }
+    length = 0;
+    return ok;
+  }
+  uint32_t position() const { return written; }
+};
+
+// Reads a range of a file through a small buffer, sharing the file with the other readers of a query or merge
+class BufferedReader {
+  FsFile* file;
+  uint32_t position;
+  uint32_t end;
+  uint8_t buffer[64] = {};
+  size_t length = 0;
+  size_t next = 0;
+
+ public:
+  BufferedReader(FsFile& file, const uint32_t start, const uint32_t end) : file(&file), position(start), end(end) {}
+
+  bool atEnd() const { return next == length && position == end; }
+  bool read(uint8_t& byte) {
+    if (next == length) {
+      const size_t count = std::min<uint32_t>(sizeof(buffer), end - position);
+      if (count == 0 || !file->seek(position) || file->read(buffer, count) != static_cast<int>(count)) {
+        return false;
+      }
+      position += count;
+      length = count;
+      next = 0;
+    }
+    byte = buffer[next++];
+    return true;
+  }
+  bool read(uint8_t* bytes, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      if (!read(bytes[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool readVarint(uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      uint8_t byte;
+      if (!read(byte)) {
+        return false;
+      }
+      value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// Where a posting list is at, each posting being stored relative to the one before it
+struct ListPosition {
+  uint16_t spineIndex = 0;
+  uint32_t textOffset = 0;
+};
+
+// Per posting: the spine item delta plus one, then the text offset or, within the same spine item, its delta. 0 ends
+// the list
+bool writePosting(BufferedWriter& out, ListPosition& previous, const uint16_t spineIndex, const uint32_t textOffset) {
+  const uint32_t spineDelta = spineIndex - previous.spineIndex;
+  const uint32_t offset = spineDelta != 0 ? textOffset : textOffset - previous.textOffset;
+  previous = {spineIndex, textOffset};
+  return out.writeVarint(spineDelta + 1) && out.writeVarint(offset);
+}
+
+// Step position to the next posting of a list, or set end at the end of the list. False if it couldn't be read
+bool readPosting(BufferedReader& in, ListPosition& position, bool& end) {
+  uint32_t spineDelta;
+  if (!in.readVarint(spineDelta)) {
+    return false;
+  }
+  end = spineDelta == 0;
+  if (end) {
+    return true;
+  }
+  uint32_t offset;
+  if (!in.readVarint(offset)) {
+    return false;
+  }
+  position.spineIndex = static_cast<uint16_t>(position.spineIndex + spineDelta - 1);
+  position.textOffset = spineDelta != 1 ? offset : position.textOffset + offset;
+  return true;
+}
+
+// Reads one posting list of a segment
+class PostingReader {
+  BufferedReader in;
+  ListPosition position;
+
+ public:
+  PostingReader(FsFile& file, const uint32_t start, const uint32_t end) : in(file, start, end) {}
+
+  uint16_t spineIndex() const { return position.spineIndex; }
+  uint32_t textOffset() const { return position.textOffset; }
+  // Step to the next posting, false at the end of the list
+  bool next() {
+    bool end = false;
+    return readPosting(in, position, end) && !end;
+  }
+};
+
+// The postings of a query word in order, merged from the lists of the terms it is looked up as
+class TermCursor {
+  std::vector<PostingReader> readers;
+  size_t current = 0;
+  bool primed = false;
+
+ public:
+  uint16_t spineIndex = 0;
+  uint32_t textOffset = 0;
+
+  void add(FsFile& file, const uint32_t start, const uint32_t end) { readers.emplace_back(file, start, end); }
+  // Step to the next posting, false once all lists are done
+  bool next() {
+    if (!primed) {
+      primed = true;
+      for (auto it = readers.begin(); it != readers.end();) {
+        it = it->next() ? it + 1 : readers.erase(it);
+      }
+    } else if (!readers[current].next()) {
+      readers.erase(readers.begin() + static_cast<std::ptrdiff_t>(current));
+    }
+    if (readers.empty()) {
+      return false;
+    }
+    current = 0;
+    for (size_t i = 1; i < readers.size(); i++) {
+      const auto& reader = readers[i];
+      const auto& smallest = readers[current];
+      if (reader.spineIndex() < smallest.spineIndex() ||
+          (reader.spineIndex() == smallest.spineIndex() && reader.textOffset() < smallest.textOffset())) {
+        current = i;
+      }
+    }
+    spineIndex = readers[current].spineIndex();
+    textOffset = readers[current].textOffset();
+    return true;
+  }
+};
+
+struct QueryWord {
+  uint8_t term[WordIndex::MAX_TERM_SIZE];
+  size_t length;
+  // Text bytes from the start of a match to the word
+  uint32_t delta;
+  // The last word, which can be the start of a longer one
+  bool prefix;
+};
+
+struct Query {
+  std::vector<QueryWord> words;
+  // Text bytes a match spans
+  uint32_t textBytes = 0;
+  // Nothing but single spaces between the words, so the postings tell matches apart
+  bool answerable = true;
+};
+
+// The query's words and ideographs in the order they appear
+Query parseQuery(const TextMatcher& matcher) {
+  Query parsed;
+  const uint8_t* query = matcher.getFolded();
+  const size_t length = matcher.length();
+  size_t i = 0;
+  while (i < length) {
+    const size_t charLength = std::min(TextMatcher::charLength(query[i]), length - i);
+    const auto charClass = TextMatcher::charClass(query + i, charLength);
+    if (charClass == TextMatcher::CharClass::WORD) {
+      QueryWord word = {};
+      word.delta = parsed.textBytes;
+      while (i < length) {
+        const size_t wordCharLength = std::min(TextMatcher::charLength(query[i]), length - i);
+        if (TextMatcher::charClass(query + i, wordCharLength) != TextMatcher::CharClass::WORD) {
+          break;
+        }
+        memcpy(word.term + word.length, query + i, wordCharLength);
+        word.length += wordCharLength;
+        parsed.textBytes += wordCharLength;
+        i += wordCharLength;
+      }
+      // Unless something follows, the word can go on in the text
+      word.prefix = i == length;
+      parsed.words.push_back(word);
+      continue;
+    }
+    if (charClass == TextMatcher::CharClass::IDEOGRAPH) {
+      QueryWord word = {};
+      memcpy(word.term, query + i, charLength);
+      word.length = charLength;
+      word.delta = parsed.textBytes;
+      word.prefix = false;
+      parsed.words.push_back(word);
+    } else if (query[i] != ' ') {
+      parsed.answerable = false;
+    }
+    if (query[i] != ' ') {
+      parsed.textBytes += charLength;
+    }
+    i += charLength;
+  }
+  return parsed;
+}
+
+// Term of a dictionary entry, and where its postings start
+bool readTerm(FsFile& dictionary, FsFile& postings, const uint32_t index, uint8_t* term, size_t& length,
+              uint32_t& postingsStart) {
+  uint32_t recordOffset = 0;
+  if (!dictionary.seek(1 + DICTIONARY_ENTRY_SIZE * index)) {
+    return false;
+  }
+  serialization::readPod(dictionary, recordOffset);
+  uint8_t termLength = 0;
+  if (!postings.seek(recordOffset) || postings.read(&termLength, 1) != 1 || termLength > WordIndex::MAX_TERM_SIZE ||
+      postings.read(term, termLength) != termLength) {
+    return false;
+  }
+  length = termLength;
+  postingsStart = recordOffset + 1 + termLength;
+  return true;
+}
+
+/**
+ * Posting list starts of the terms a query word is looked up as, binary searched in the dictionary: the word itself,
+ * or every term the last word starts. False if they couldn't be read or are more than MAX_PREFIX_TERMS.
+ */
+bool findTerms(FsFile& dictionary, FsFile& postings, const uint32_t termCount, const QueryWord& word,
+               std::vector<uint32_t>& starts) {
+  starts.clear();
+  uint8_t term[WordIndex::MAX_TERM_SIZE];
+  size_t termLength = 0;
+  uint32_t postingsStart = 0;
+  uint32_t low = 0;
+  uint32_t high = termCount;
+  while (low < high) {
+    const uint32_t mid = low + (high - low) / 2;
+    if (!readTerm(dictionary, postings, mid, term, termLength, postingsStart)) {
+      return false;
+    }
+    if (compareTerms(term, termLength, word.term, word.length) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  for (uint32_t i = low; i < termCount; i++) {
+    if (!readTerm(dictionary, postings, i, term, termLength, postingsStart)) {
+      return false;
+    }
+    const bool matches = word.prefix ? termLength >= word.length && memcmp(term, word.term, word.length) == 0
+                                     : compareTerms(term, termLength, word.term, word.length) == 0;
+    if (!matches) {
+      break;
+    }
+    if (starts.size() == WordIndex::MAX_PREFIX_TERMS) {
+      return false;
+    }
+    starts.push_back(postingsStart);
+    if (!word.prefix) {
+      break;
+    }
+  }
+  return true;
+}
+
+// Receives the terms of a merge in order, each followed by its postings in order
+class TermSink {
+ public:
+  virtual ~TermSink() = default;
+  virtual bool term(const uint8_t* term, size_t length) = 0;
+  virtual bool posting(uint16_t spineIndex, uint32_t textOffset) = 0;
+  virtual bool endTerm() = 0;
+};
+
+/**
+ * Writes a merge's terms and posting lists, leaving out postings of spine items past the committed ones and the terms
+ * left without any. With a dictionary, each term's record offset is added to it.
+ */
+class ListWriter final : public TermSink {
+  BufferedWriter& out;
+  BufferedWriter* dictionary;
+  const uint16_t endSpineIndex;
+  uint8_t pending[WordIndex::MAX_TERM_SIZE] = {};
+  size_t pendingLength = 0;
+  bool written = false;
+  ListPosition previous;
+
+ public:
+  uint32_t termCount = 0;
+
+  ListWriter(BufferedWriter& out, BufferedWriter* dictionary, const uint16_t endSpineIndex)
+      : out(out), dictionary(dictionary), endSpineIndex(endSpineIndex) {}
+
+  bool term(const uint8_t* term, const size_t length) override {
+    memcpy(pending, term, length);
+    pendingLength = length;
+    written = false;
+    return true;
+  }
+  bool posting(const uint16_t spineIndex, const uint32_t textOffset) override {
+    if (spineIndex >= endSpineIndex) {
+      return true;
+    }
+    if (!written) {
+      const uint32_t recordOffset = out.position();
+      const auto length = static_cast<uint8_t>(pendingLength);
+      if ((dictionary && !dictionary->write(&recordOffset, sizeof(recordOffset))) || !out.write(&length, 1) ||
+          !out.write(pending, length)) {
+        return false;
+      }
+      written = true;
+      previous = {};
+      termCount++;
+    }
+    return writePosting(out, previous, spineIndex, textOffset);
+  }
+  bool endTerm() override { return !written || out.writeVarint(0); }
+};
+
+// Merge runs [from, to) of a scratch file into out, the postings of a term that is in several runs in run order
+bool mergeRuns(const std::string& inputPath, const std::vector<uint32_t>& ends, const size_t from, const size_t to,
+               TermSink& out) {
+  struct Cursor {
+    BufferedReader in;
+    uint8_t term[WordIndex::MAX_TERM_SIZE];
+    size_t termLength;
+    bool hasTerm;
+  };
+
+  FsFile input;
+  if (!SdMan.openFileForRead("WDX", inputPath, input)) {
+    return false;
+  }
+  std::vector<Cursor> cursors;
+  cursors.reserve(to - from);
+  for (size_t i = from; i < to; i++) {
+    cursors.push_back({BufferedReader(input, i == 0 ? 0 : ends[i - 1], ends[i]), {}, 0, false});
+  }
+  const auto nextTerm = [](Cursor& cursor) {
+    cursor.hasTerm = false;
+    if (cursor.in.atEnd()) {
+      return true;
+    }
+    uint8_t length = 0;
+    if (!cursor.in.read(length) || length > WordIndex::MAX_TERM_SIZE || !cursor.in.read(cursor.term, length)) {
+      return false;
+    }
+    cursor.termLength = length;
+    cursor.hasTerm = true;
+    return true;
+  };
+
+  bool ok = true;
+  for (auto& cursor : cursors) {
+    ok = ok && nextTerm(cursor);
+  }
+  uint8_t term[WordIndex::MAX_TERM_SIZE];
+  while (ok) {
+    const Cursor* smallest = nullptr;
+    for (const auto& cursor : cursors) {
+      if (cursor.hasTerm &&
+          (!smallest || compareTerms(cursor.term, cursor.termLength, smallest->term, smallest->termLength) < 0)) {
+        smallest = &cursor;
+      }
+    }
+    if (!smallest) {
+      break;
+    }
+    const size_t termLength = smallest->termLength;
+    memcpy(term, smallest->term, termLength);
+    ok = out.term(term, termLength);
+    for (auto& cursor : cursors) {
+      if (!ok || !cursor.hasTerm || compareTerms(cursor.term, cursor.termLength, term, termLength) != 0) {
+        continue;
+      }
+      ListPosition position;
+      bool end = false;
+      while (ok && (ok = readPosting(cursor.in, position, end)) && !end) {
+        ok = out.posting(position.spineIndex, position.textOffset);
+      }
+      ok = ok && nextTerm(cursor);
+    }
+    ok = ok && out.endTerm();
+  }
+  input.close();
+  return ok;
+}
+}  // namespace
+
+uint16_t WordIndex::load() {
+  segments.clear();
+  textLengths.clear();
+  indexed = 0;
+  while (true) {
+    const std::string path = segmentPath(dir, indexed, ".dic");
+    FsFile file;
+    if (!SdMan.exists(path.c_str()) || !SdMan.openFileForRead("WDX", path, file)) {
+      break;
+    }
+    const uint32_t size = file.size();
+    Segment segment = {};
+    uint8_t version = 0;
+    if (size >= 1 + FOOTER_SIZE) {
+      file.seek(size - FOOTER_SIZE);
+      serialization::readPod(file, segment.termCount);
+      serialization::readPod(file, segment.postingsEnd);
+      serialization::readPod(file, segment.firstSpineIndex);
+      serialization::readPod(file, segment.endSpineIndex);
+      serialization::readPod(file, version);
+    }
+    // Anything else is a segment of an older version or one that was never finished, and is rebuilt
+    const uint32_t spineItems = segment.endSpineIndex - segment.firstSpineIndex;
+    if (version != INDEX_VERSION || segment.firstSpineIndex != indexed || segment.endSpineIndex <= indexed ||
+        1 + (segment.termCount + spineItems) * DICTIONARY_ENTRY_SIZE + FOOTER_SIZE != size) {
+      file.close();
+      break;
+    }
+    file.seek(1 + segment.termCount * DICTIONARY_ENTRY_SIZE);
+    for (uint32_t i = 0; i < spineItems; i++) {
+      uint32_t textLength;
+      serialization::readPod(file, textLength);
+      textLengths.push_back(textLength);
+    }
+    file.close();
+    segments.push_back(segment);
+    indexed = segment.endSpineIndex;
+  }
+  return indexed;
+}
+
+bool WordIndex::answers(const TextMatcher& matcher) {
+  const Query query = parseQuery(matcher);
+  return query.answerable && !query.words.empty();
+}
+
+bool WordIndex::findMatches(const TextMatcher& matcher, const std::function<bool(const Hit&)>& onMatch) const {
+  return join(matcher, true, onMatch);
+}
+
+bool WordIndex::findCandidates(const TextMatcher& matcher, std::vector<bool>& candidates) const {
+  candidates.assign(indexed, false);
+  return join(matcher, false, [&candidates](const Hit& hit) {
+    candidates[hit.spineIndex] = true;
+    return true;
+  });
+}
+
+bool WordIndex::join(const TextMatcher& matcher, const bool exact,
+                     const std::function<bool(const Hit&)>& onMatch) const {
+  const Query query = parseQuery(matcher);
+  if (query.words.empty() || (exact && !query.answerable)) {
+    return false;
+  }
+
+  std::vector<uint32_t> starts;
+  for (const auto& segment : segments) {
+    FsFile dictionary;
+    FsFile postings;
+    bool known = SdMan.openFileForRead("WDX", segmentPath(dir, segment.firstSpineIndex, ".dic"), dictionary) &&
+                 SdMan.openFileForRead("WDX", segmentPath(dir, segment.firstSpineIndex, ".idx"), postings);
+    bool found = true;
+    std::vector<TermCursor> cursors;
+    std::vector<uint32_t> deltas;
+    for (const auto& word : query.words) {
+      if (!known || !found) {
+        break;
+      }
+      if (!findTerms(dictionary, postings, segment.termCount, word, starts)) {
+        // Too common a prefix, which only narrows the matches down when they don't have to be exact
+        known = !exact;
+        continue;
+      }
+      found = !starts.empty();
+      cursors.emplace_back();
+      for (const uint32_t start : starts) {
+        cursors.back().add(postings, start, segment.postingsEnd);
+      }
+      deltas.push_back(word.delta);
+    }
+    if (!known && exact) {
+      return false;
+    }
+    if (!known || (found && cursors.empty())) {
+      // Can't rule any of the segment's spine items out
+      for (uint16_t spineIndex = segment.firstSpineIndex; spineIndex < segment.endSpineIndex; spineIndex++) {
+        if (!onMatch({spineIndex, 0})) {
+          return true;
+        }
+      }
+      continue;
+    }
+    if (!found) {
+      continue;
+    }
+
+    // Walk the first word's postings, and the others' alongside to where the rest of the phrase would be
+    bool more = true;
+    for (size_t k = 1; k < cursors.size() && more; k++) {
+      more = cursors[k].next();
+    }
+    Hit last = {0, 0};
+    bool any = false;
+    while (more && cursors[0].next()) {
+      const uint16_t spineIndex = cursors[0].spineIndex;
+      if (cursors[0].textOffset < deltas[0]) {
+        continue;
+      }
+      const uint32_t matchStart = cursors[0].textOffset - deltas[0];
+      bool phrase = true;
+      for (size_t k = 1; k < cursors.size() && more; k++) {
+        const uint32_t target = matchStart + deltas[k];
+        auto& cursor = cursors[k];
+        while (more && (cursor.spineIndex < spineIndex ||
+                        (cursor.spineIndex == spineIndex && cursor.textOffset < target))) {
+          more = cursor.next();
+        }
+        phrase = phrase && more && cursor.spineIndex == spineIndex && cursor.textOffset == target;
+      }
+      if (!phrase || !more || spineIndex >= indexed) {
+        continue;
+      }
+      // Matches don't overlap, as TextMatcher resumes after each one
+      if (exact && any && last.spineIndex == spineIndex && matchStart < last.textOffset + query.textBytes) {
+        continue;
+      }
+      last = {spineIndex, matchStart};
+      any = true;
+      if (!onMatch(last)) {
+        return true;
+      }
+    }
+  }
+  return true;
+}
+
+WordIndexWriter::~WordIndexWriter() {
+  if (started) {
+    runFile.close();
+    removeScratch();
+  }
+}
+
+bool WordIndexWriter::begin() {
+  SdMan.mkdir(dir.c_str());
+  if (!SdMan.openFileForWrite("WDX", scratchPath(dir, 0), runFile)) {
+    return false;
+  }
+  run.reserve(RUN_SIZE);
+  runTerms.reserve(RUN_TERM_BYTES + WordIndex::MAX_TERM_SIZE);
+  started = true;
+  return true;
+}
+
+void WordIndexWriter::startSpineItem(const uint16_t index) {
+  spineIndex = index;
+  inWord = false;
+}
+
+void WordIndexWriter::commitSpineItem(const uint32_t textLength) {
+  endWord();
+  textLengths.resize(spineIndex - firstSpineIndex + 1, 0);
+  textLengths.back() = textLength;
+  endSpineIndex = spineIndex + 1;
+}
+
+void WordIndexWriter::abortSpineItem() {
+  inWord = false;
+  // Postings already in the scratch file are dropped when it is merged
+  while (!run.empty() && run.back().spineIndex == spineIndex) {
+    runTerms.resize(run.back().termStart);
+    run.pop_back();
+  }
+}
+
+void WordIndexWriter::onText(const uint8_t* folded, const size_t length, const uint32_t textOffset) {
+  const auto charClass = TextMatcher::charClass(folded, length);
+  if (charClass != TextMatcher::CharClass::WORD) {
+    endWord();
+    if (charClass == TextMatcher::CharClass::IDEOGRAPH) {
+      add(folded, length, textOffset);
+    }
+    return;
+  }
+  if (!inWord) {
+    inWord = true;
+    wordCut = false;
+    wordLength = 0;
+    wordOffset = textOffset;
+  }
+  // Longer words are posted cut short, only whole characters
+  if (!wordCut && wordLength + length <= WordIndex::MAX_TERM_SIZE) {
+    memcpy(word + wordLength, folded, length);
+    wordLength += length;
+  } else {
+    wordCut = true;
+  }
+}
+
+void WordIndexWriter::endWord() {
+  if (!inWord) {
+    return;
+  }
+  add(word, wordLength, wordOffset);
+  inWord = false;
+}
+
+void WordIndexWriter::add(const uint8_t* term, const size_t length, const uint32_t textOffset) {
+  if (!started) {
+    return;
+  }
+  run.push_back({static_cast<uint32_t>(runTerms.size()), textOffset, spineIndex, static_cast<uint8_t>(length)});
+  runTerms.insert(runTerms.end(), term, term + length);
+  if (run.size() == RUN_SIZE || runTerms.size() >= RUN_TERM_BYTES) {
+    flushRun();
+  }
+}
+
+bool WordIndexWriter::flushRun() {
+  if (run.empty()) {
+    return true;
+  }
+  // By term, and within a term in text order, as postings never share a spine item and text offset
+  const uint8_t* terms = runTerms.data();
+  std::sort(run.begin(), run.end(), [terms](const Posting& a, const Posting& b) {
+    const int order = compareTerms(terms + a.termStart, a.termLength, terms + b.termStart, b.termLength);
+    if (order != 0) return order < 0;
+    if (a.spineIndex != b.spineIndex) return a.spineIndex < b.spineIndex;
+    return a.textOffset < b.textOffset;
+  });
+
+  // Same format as the segment's postings: each term with its list
+  BufferedWriter out(runFile);
+  ListPosition previous;
+  bool ok = true;
+  for (size_t i = 0; i < run.size() && ok; i++) {
+    const Posting& posting = run[i];
+    const uint8_t* term = terms + posting.termStart;
+    if (i == 0 || compareTerms(term, posting.termLength, terms + run[i - 1].termStart, run[i - 1].termLength) != 0) {
+      ok = (i == 0 || out.writeVarint(0)) && out.write(&posting.termLength, 1) && out.write(term, posting.termLength);
+      previous = {};
+    }
+    ok = ok && writePosting(out, previous, posting.spineIndex, posting.textOffset);
+  }
+  ok = ok && out.writeVarint(0) && out.flush();
+  if (ok) {
+    runEnds.push_back((runEnds.empty() ? 0 : runEnds.back()) + out.position());
+    postingCount += run.size();
+  } else {
+    Serial.printf("[%lu] [WDX] Failed to write postings run\n", millis());
+    runFile.close();
+    removeScratch();
+    started = false;
+  }
+  run.clear();
+  runTerms.clear();
+  return ok;
+}
+
+bool WordIndexWriter::finish() {
+  if (!started || endSpineIndex == firstSpineIndex) {
+    return false;
+  }
+  const unsigned long start = millis();
+  const bool flushed = flushRun();
+  runFile.close();
+  started = false;
+  if (!flushed) {
+    removeScratch();
+    return false;
+  }
+
+  // Merge MERGE_WAYS runs at a time into longer ones until the last merge can write the segment
+  int scratch = 0;
+  std::vector<uint32_t> ends = runEnds;
+  bool ok = true;
+  while (ok && ends.size() > MERGE_WAYS) {
+    FsFile output;
+    if (!SdMan.openFileForWrite("WDX", scratchPath(dir, 1 - scratch), output)) {
+      ok = false;
+      break;
+    }
+    BufferedWriter writer(output);
+    ListWriter lists(writer, nullptr, endSpineIndex);
+    std::vector<uint32_t> merged;
+    for (size_t from = 0; from < ends.size() && ok; from += MERGE_WAYS) {
+      ok = mergeRuns(scratchPath(dir, scratch), ends, from, std::min(from + MERGE_WAYS, ends.size()), lists);
+      merged.push_back(writer.position());
+    }
+    ok = writer.flush() && ok;
+    output.close();
+    ends = std::move(merged);
+    scratch = 1 - scratch;
+  }
+  ok = ok && writeSegment(scratchPath(dir, scratch), ends);
+  removeScratch();
+
+  Serial.printf("[%lu] [WDX] %s segment for spine items %u-%u from %u postings in %lu ms\n", millis(),
+                ok ? "Wrote" : "Failed to write", firstSpineIndex, endSpineIndex - 1, postingCount, millis() - start);
+  return ok;
+}
+
+bool WordIndexWriter::writeSegment(const std::string& runsPath, const std::vector<uint32_t>& ends) const {
+  FsFile postingsFile;
+  FsFile dictionaryFile;
+  if (!SdMan.openFileForWrite("WDX", segmentPath(dir, firstSpineIndex, ".idx"), postingsFile)) {
+    return false;
+  }
+  if (!SdMan.openFileForWrite("WDX", segmentPath(dir, firstSpineIndex, ".dic"), dictionaryFile)) {
+    postingsFile.close();
+    return false;
+  }
+  BufferedWriter postings(postingsFile);
+  BufferedWriter dictionary(dictionaryFile);
+  postings.write(&INDEX_VERSION, 1);
+  dictionary.write(&INDEX_VERSION, 1);
+
+  ListWriter lists(postings, &dictionary, endSpineIndex);
+  bool ok = mergeRuns(runsPath, ends, 0, ends.size(), lists);
+
+  const uint32_t postingsEnd = postings.position();
+  ok = postings.flush() && ok;
+  postingsFile.close();
+  for (const uint32_t textLength : textLengths) {
+    ok = ok && dictionary.write(&textLength, sizeof(textLength));
+  }
+  // The footer goes last, a segment without one is never used
+  const uint32_t termCount = lists.termCount;
+  ok = ok && dictionary.write(&termCount, sizeof(termCount)) && dictionary.write(&postingsEnd, sizeof(postingsEnd)) &&
+       dictionary.write(&firstSpineIndex, sizeof(firstSpineIndex)) &&
+       dictionary.write(&endSpineIndex, sizeof(endSpineIndex)) && dictionary.write(&INDEX_VERSION, 1) &&
+       dictionary.flush();
+  dictionaryFile.close();
+  if (!ok) {
+    SdMan.remove(segmentPath(dir, firstSpineIndex, ".dic").c_str());
+    SdMan.remove(segmentPath(dir, firstSpineIndex, ".idx").c_str());
+  }
+  return ok;
+}
+
+void WordIndexWriter::removeScratch() const {
+  for (int i = 0; i < 2; i++) {
+    const std::string path = scratchPath(dir, i);
+    if (SdMan.exists(path.c_str())) {
+      SdMan.remove(path.c_str());
+    }
+  }
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <SdFat.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "HtmlTextScanner.h"
+#include "TextMatcher.h"
+
+/**
+ * Inverted index of a book's words kept in its cache, so searching the book again is answered from the index.
+ *
+ * Words are runs of letters and digits in the folded text HtmlTextScanner searches, and each ideograph on its own.
+ * Every word is posted under its folded bytes, cut to MAX_TERM_SIZE, with the spine item and text offset it is at,
+ * so the words of a phrase can be checked for following each other. A query's last word may be the start of a longer
+ * one and is looked up as every term it starts.
+ *
+ * Queries made of words and ideographs separated by single spaces are answered from the postings alone, with the same
+ * matches a word start TextMatcher finds. Queries with other separators, e.g. "don't", only rule spine items out.
+ *
+ * Search passes build the index as they scan: each pass that gets past the indexed spine items adds a segment for the
+ * ones it finished, `<first spine item>.idx` holding each term followed by its delta-encoded postings and
+ * `<first spine item>.dic` the term dictionary, which is sorted and binary searched from the SD card. Segments follow
+ * on from each other, so a stopped pass is picked up where it left off.
+ */
+class WordIndex {
+ public:
+  // Terms are cut to as many bytes as a query can have, which keeps prefix lookups exact
+  static constexpr size_t MAX_TERM_SIZE = TextMatcher::MAX_QUERY_SIZE;
+  // A query's last word is looked up as at most this many terms, past that the index can't narrow it down
+  static constexpr size_t MAX_PREFIX_TERMS = 128;
+
+  struct Hit {
+    uint16_t spineIndex;
+    uint32_t textOffset;
+  };
+
+  explicit WordIndex(std::string dir) : dir(std::move(dir)) {}
+
+  // Find the segments built so far, returns the number of spine items they cover from the first one
+  uint16_t load();
+  uint16_t indexedSpineItems() const { return indexed; }
+  // Text length of an indexed spine item, as HtmlTextScanner::textLength() gave it
+  uint32_t textLength(uint16_t spineIndex) const { return spineIndex < indexed ? textLengths[spineIndex] : 0; }
+
+  // Whether findMatches() can answer the query
+  static bool answers(const TextMatcher& matcher);
+  /**
+   * Report the query's matches in the indexed spine items in order, onMatch returns false to stop. False if the query
+   * can't be answered from the index, see answers().
+   */
+  bool findMatches(const TextMatcher& matcher, const std::function<bool(const Hit&)>& onMatch) const;
+  /**
+   * Mark which of the indexed spine items the query can match in. False when none of its words can be looked up and
+   * every spine item has to be scanned.
+   */
+  bool findCandidates(const TextMatcher& matcher, std::vector<bool>& candidates) const;
+
+ private:
+  struct Segment {
+    uint16_t firstSpineIndex;
+    uint16_t endSpineIndex;
+    uint32_t termCount;
+    uint32_t postingsEnd;
+  };
+
+  std::string dir;
+  std::vector<Segment> segments;
+  std::vector<uint32_t> textLengths;
+  uint16_t indexed = 0;
+
+  // Report the phrase matches of the query's words, exact ones or ones that can't be ruled out for whole segments
+  bool join(const TextMatcher& matcher, bool exact, const std::function<bool(const Hit&)>& onMatch) const;
+};
+
+/**
+ * Adds a segment to a book's WordIndex from the text of the spine items a search pass scans, in order.
+ *
+ * Postings are gathered RUN_SIZE at a time, sorted by term and appended to a scratch file, and finish() merges the
+ * runs into the segment, so memory use doesn't grow with the book.
+ */
+class WordIndexWriter final : public TextListener {
+ public:
+  static constexpr size_t RUN_SIZE = 512;
+  // Term bytes gathered for a run before it is written, whatever its posting count
+  static constexpr size_t RUN_TERM_BYTES = 4 * 1024;
+
+  explicit WordIndexWriter(std::string dir, uint16_t firstSpineIndex)
+      : dir(std::move(dir)), firstSpineIndex(firstSpineIndex), endSpineIndex(firstSpineIndex) {}
+  ~WordIndexWriter() override;
+
+  bool begin();
+  // The text passed on from now is the given spine item's, which is the one after the last committed
+  void startSpineItem(uint16_t spineIndex);
+  void commitSpineItem(uint32_t textLength);
+  // Leave the current spine item out of the segment, e.g. when its scan was cancelled
+  void abortSpineItem();
+  // Write the segment for the committed spine items, false if there are none or it couldn't be written
+  bool finish();
+
+  void onText(const uint8_t* folded, size_t length, uint32_t textOffset) override;
+
+ private:
+  struct Posting {
+    uint32_t termStart;
+    uint32_t textOffset;
+    uint16_t spineIndex;
+    uint8_t termLength;
+  };
+
+  std::string dir;
+  const uint16_t firstSpineIndex;
+  // One past the last committed spine item
+  uint16_t endSpineIndex;
+  uint16_t spineIndex = 0;
+  bool started = false;
+  // Of the committed spine items
+  std::vector<uint32_t> textLengths;
+
+  // Postings of the run being gathered, and their terms' bytes
+  std::vector<Posting> run;
+  std::vector<uint8_t> runTerms;
+  // Scratch file size at the end of each run
+  std::vector<uint32_t> runEnds;
+  uint32_t postingCount = 0;
+  FsFile runFile;
+
+  // The word being read
+  uint8_t word[WordIndex::MAX_TERM_SIZE] = {};
+  size_t wordLength = 0;
+  uint32_t wordOffset = 0;
+  bool inWord = false;
+  bool wordCut = false;
+
+  void add(const uint8_t* term, size_t length, uint32_t textOffset);
+  void endWord();
+  bool flushRun();
+  bool writeSegment(const std::string& runsPath, const std::vector<uint32_t>& ends) const;
+  void removeScratch() const;
+};
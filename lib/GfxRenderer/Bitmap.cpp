@@ -160,6 +160,40 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
 
   prevRowY += 1;
 
+  if (atkinsonDitherer || fsDitherer) {
+    // Ditherers only exist for 8bpp and up, so every pixel occupies at least one byte and the luminance row can
+    // be built in place without overtaking the pixels still to be read
+    switch (bpp) {
+      case 32:
+        for (int x = 0; x < width; x++) {
+          const uint8_t* p = rowBuffer + x * 4;
+          rowBuffer[x] = (77u * p[2] + 150u * p[1] + 29u * p[0]) >> 8;
+        }
+        break;
+      case 24:
+        for (int x = 0; x < width; x++) {
+          const uint8_t* p = rowBuffer + x * 3;
+          rowBuffer[x] = (77u * p[2] + 150u * p[1] + 29u * p[0]) >> 8;
+        }
+        break;
+      case 8:
+        for (int x = 0; x < width; x++) {
+          rowBuffer[x] = paletteLum[rowBuffer[x]];
+        }
+        break;
+      default:
+        return BmpReaderError::UnsupportedBpp;
+    }
+
+    // Adjust, dither and pack 4 pixels per byte in one pass
+    if (atkinsonDitherer) {
+      atkinsonDitherer->processRow(rowBuffer, data);
+    } else {
+      fsDitherer->processRow(rowBuffer, data);
+    }
+    return BmpReaderError::Ok;
+  }
+
   uint8_t* outPtr = data;
   uint8_t currentOutByte = 0;
   int bitShift = 6;
@@ -168,18 +202,12 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
   // Helper lambda to pack 2bpp color into the output stream
   auto packPixel = [&](const uint8_t lum) {
     uint8_t color;
-    if (atkinsonDitherer) {
-      color = atkinsonDitherer->processPixel(adjustPixel(lum), currentX);
-    } else if (fsDitherer) {
-      color = fsDitherer->processPixel(adjustPixel(lum), currentX);
+    if (bpp > 2) {
+      // Simple quantization or noise dithering
+      color = quantize(adjustPixel(lum), currentX, prevRowY);
     } else {
-      if (bpp > 2) {
-        // Simple quantization or noise dithering
-        color = quantize(adjustPixel(lum), currentX, prevRowY);
-      } else {
-        // do not quantize 2bpp image
-        color = static_cast<uint8_t>(lum >> 6);
-      }
+      // do not quantize 2bpp image
+      color = static_cast<uint8_t>(lum >> 6);
     }
     currentOutByte |= (color << bitShift);
     if (bitShift == 0) {
@@ -240,11 +268,6 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
       return BmpReaderError::UnsupportedBpp;
   }
 
-  if (atkinsonDitherer)
-    atkinsonDitherer->nextRow();
-  else if (fsDitherer)
-    fsDitherer->nextRow();
-
   // Flush remaining bits if width is not a multiple of 4
   if (bitShift != 6) *outPtr = currentOutByte;
 
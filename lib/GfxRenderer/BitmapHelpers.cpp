@@ -1,17 +1,18 @@
 #include "BitmapHelpers.h"
 
+#include <array>
 #include <cstdint>
 
 // Brightness/Contrast adjustments:
 constexpr bool USE_BRIGHTNESS = false;       // true: apply brightness/gamma adjustments
 constexpr int BRIGHTNESS_BOOST = 10;         // Brightness offset (0-50)
 constexpr bool GAMMA_CORRECTION = false;     // Gamma curve (brightens midtones)
-constexpr float CONTRAST_FACTOR = 1.15f;     // Contrast multiplier (1.0 = no change, >1 = more contrast)
+constexpr int CONTRAST_PERCENT = 115;        // Contrast multiplier in percent (100 = no change, >100 = more)
 constexpr bool USE_NOISE_DITHERING = false;  // Hash-based noise dithering
 
 // Integer approximation of gamma correction (brightens midtones)
 // Uses a simple curve: out = 255 * sqrt(in/255) ≈ sqrt(in * 255)
-static inline int applyGamma(int gray) {
+static constexpr int applyGamma(const int gray) {
   if (!GAMMA_CORRECTION) return gray;
   // Fast integer square root approximation for gamma ~0.5 (brightening)
   // This brightens dark/mid tones while preserving highlights
@@ -27,17 +28,15 @@ static inline int applyGamma(int gray) {
 
 // Apply contrast adjustment around midpoint (128)
 // factor > 1.0 increases contrast, < 1.0 decreases
-static inline int applyContrast(int gray) {
+static constexpr int applyContrast(const int gray) {
   // Integer-based contrast: (gray - 128) * factor + 128
-  // Using fixed-point: factor 1.15 ≈ 115/100
-  constexpr int factorNum = static_cast<int>(CONTRAST_FACTOR * 100);
-  int adjusted = ((gray - 128) * factorNum) / 100 + 128;
+  int adjusted = ((gray - 128) * CONTRAST_PERCENT) / 100 + 128;
   if (adjusted < 0) adjusted = 0;
   if (adjusted > 255) adjusted = 255;
   return adjusted;
 }
 // Combined brightness/contrast/gamma adjustment
-int adjustPixel(int gray) {
+static constexpr uint8_t computeAdjustedPixel(int gray) {
   if (!USE_BRIGHTNESS) return gray;
 
   // Order: contrast first, then brightness, then gamma
@@ -51,7 +50,7 @@ int adjustPixel(int gray) {
 }
 // Simple quantization without dithering - divide into 4 levels
 // The thresholds are fine-tuned to the X4 display
-uint8_t quantizeSimple(int gray) {
+static constexpr uint8_t computeQuantizeSimple(const int gray) {
   if (gray < 45) {
     return 0;
   } else if (gray < 70) {
@@ -63,6 +62,19 @@ uint8_t quantizeSimple(int gray) {
   }
 }
 
+template <typename T, T (*Fn)(int)>
+static constexpr std::array<T, 256> makeLut() {
+  std::array<T, 256> lut = {};
+  for (int i = 0; i < 256; i++) {
+    lut[i] = Fn(i);
+  }
+  return lut;
+}
+
+// Built at compile time so they live in flash
+extern constexpr std::array<uint8_t, 256> ADJUST_PIXEL_LUT = makeLut<uint8_t, computeAdjustedPixel>();
+extern constexpr std::array<uint8_t, 256> QUANTIZE_SIMPLE_LUT = makeLut<uint8_t, computeQuantizeSimple>();
+
 // Hash-based noise dithering - survives downsampling without moiré artifacts
 // Uses integer hash to generate pseudo-random threshold per pixel
 static inline uint8_t quantizeNoise(int gray, int x, int y) {
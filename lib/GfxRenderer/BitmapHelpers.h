@@ -1,12 +1,86 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <cstring>
 
+// Brightness/contrast/gamma adjustment and X4-tuned 4-level quantization, precomputed for every gray level
+extern const std::array<uint8_t, 256> ADJUST_PIXEL_LUT;
+extern const std::array<uint8_t, 256> QUANTIZE_SIMPLE_LUT;
+// Value each level of the error diffusion ditherers' 4-level quantization stands for
+constexpr int16_t DITHER_2BIT_VALUES[4] = {15, 30, 80, 210};
+
 // Helper functions
 uint8_t quantize(int gray, int x, int y);
-uint8_t quantizeSimple(int gray);
 uint8_t quantize1bit(int gray, int x, int y);
-int adjustPixel(int gray);
+// gray must be 0-255
+inline uint8_t quantizeSimple(const int gray) { return QUANTIZE_SIMPLE_LUT[gray]; }
+inline int adjustPixel(const int gray) { return ADJUST_PIXEL_LUT[gray]; }
+
+inline int clampGray(const int gray) {
+  // Out of range is rare, so one predictable branch keeps the clamp off the error diffusion's dependency chain
+  if (static_cast<unsigned>(gray) <= 255) [[likely]] return gray;
+  return gray < 0 ? 0 : 255;
+}
+
+// X4-tuned 4-level quantization (thresholds 30/50/140) of a clamped gray level for the row kernels, returns the
+// quantization error. Built from compares rather than a table or branches: the error flows on to the next pixel,
+// so it shouldn't wait on a load, and dithered pixels flip between levels too often to predict.
+inline int quantize2Bit(const int adjusted, uint8_t& level) {
+  const int above30 = adjusted >= 30;
+  const int above50 = adjusted >= 50;
+  const int above140 = adjusted >= 140;
+  level = above30 + above50 + above140;
+  return adjusted - (DITHER_2BIT_VALUES[0] + (DITHER_2BIT_VALUES[1] - DITHER_2BIT_VALUES[0]) * above30 +
+                     (DITHER_2BIT_VALUES[2] - DITHER_2BIT_VALUES[1]) * above50 +
+                     (DITHER_2BIT_VALUES[3] - DITHER_2BIT_VALUES[2]) * above140);
+}
+
+// Register-resident Atkinson state for processing a whole row.
+// Errors flowing right along the row are kept in locals, and each bottom-row entry is written once with the
+// sum of its three contributions instead of three read-modify-writes per pixel.
+class AtkinsonRowState {
+ public:
+  AtkinsonRowState(const int16_t* row0, int16_t* row1, int16_t* row2) : row0(row0 + 2), row1(row1 + 2), row2(row2 + 2) {}
+
+  // Returns 0 (black) or 1 (white)
+  uint8_t step1Bit(const int gray, const int x) {
+    const int adjusted = clampGray(gray + row0[x] + errorBack1 + errorBack2);
+    const uint8_t quantized = adjusted >= 128;
+    diffuse((adjusted - (quantized ? 255 : 0)) >> 3, x);
+    return quantized;
+  }
+
+  // Returns 0-3 (black to white) using the X4-tuned levels
+  uint8_t step2Bit(const int gray, const int x) {
+    const int adjusted = clampGray(gray + row0[x] + errorBack1 + errorBack2);
+    uint8_t level;
+    const int error = quantize2Bit(adjusted, level);
+    diffuse(error >> 3, x);
+    return level;
+  }
+
+  // Flush the pending bottom-row sum of the last pixel
+  void finish(const int width) {
+    if (width > 0) row1[width - 1] += errorBack1 + errorBack2;
+  }
+
+ private:
+  void diffuse(const int error, const int x) {
+    // Bottom-left neighbour is now complete: it received from x - 2, x - 1 and x. At x = 0 this lands in the
+    // padding, as processPixel's does
+    row1[x - 1] += errorBack2 + errorBack1 + error;
+    row2[x] += error;
+    errorBack2 = errorBack1;
+    errorBack1 = error;
+  }
+
+  const int16_t* row0;
+  int16_t* row1;
+  int16_t* row2;
+  int errorBack1 = 0;  // Error of pixel x - 1
+  int errorBack2 = 0;  // Error of pixel x - 2
+};
 
 // 1-bit Atkinson dithering - better quality than noise dithering for thumbnails
 // Error distribution pattern (same as 2-bit but quantizes to 2 levels):
@@ -67,6 +141,32 @@ class Atkinson1BitDitherer {
     return quantized;
   }
 
+  // Dither a full row of raw gray values (adjustPixel is applied here) into 1bpp MSB-first output,
+  // (width + 7) / 8 bytes, then advance to the next row. Same result as processPixel() for every x.
+  void processRow(const uint8_t* gray, uint8_t* out) {
+    AtkinsonRowState state(errorRow0, errorRow1, errorRow2);
+    // Local copy: stores to out may alias members
+    const int width = this->width;
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+      uint8_t packed = 0;
+      for (int i = 0; i < 8; i++) {
+        packed = (packed << 1) | state.step1Bit(ADJUST_PIXEL_LUT[gray[x + i]], x + i);
+      }
+      *out++ = packed;
+    }
+    if (x < width) {
+      uint8_t packed = 0;
+      const int remaining = width - x;
+      for (int i = 0; i < remaining; i++) {
+        packed |= state.step1Bit(ADJUST_PIXEL_LUT[gray[x + i]], x + i) << (7 - i);
+      }
+      *out = packed;
+    }
+    state.finish(width);
+    nextRow();
+  }
+
   void nextRow() {
     int16_t* temp = errorRow0;
     errorRow0 = errorRow1;
@@ -166,6 +266,32 @@ class AtkinsonDitherer {
     return quantized;
   }
 
+  // Dither a full row of raw gray values (adjustPixel is applied here) into 2bpp MSB-first output,
+  // (width + 3) / 4 bytes, then advance to the next row. Same result as processPixel(adjustPixel(gray)) for every x.
+  void processRow(const uint8_t* gray, uint8_t* out) {
+    AtkinsonRowState state(errorRow0, errorRow1, errorRow2);
+    // Local copy: stores to out may alias members
+    const int width = this->width;
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+      uint8_t packed = state.step2Bit(ADJUST_PIXEL_LUT[gray[x]], x) << 6;
+      packed |= state.step2Bit(ADJUST_PIXEL_LUT[gray[x + 1]], x + 1) << 4;
+      packed |= state.step2Bit(ADJUST_PIXEL_LUT[gray[x + 2]], x + 2) << 2;
+      packed |= state.step2Bit(ADJUST_PIXEL_LUT[gray[x + 3]], x + 3);
+      *out++ = packed;
+    }
+    if (x < width) {
+      uint8_t packed = 0;
+      const int remaining = width - x;
+      for (int i = 0; i < remaining; i++) {
+        packed |= state.step2Bit(ADJUST_PIXEL_LUT[gray[x + i]], x + i) << (6 - i * 2);
+      }
+      *out = packed;
+    }
+    state.finish(width);
+    nextRow();
+  }
+
   void nextRow() {
     int16_t* temp = errorRow0;
     errorRow0 = errorRow1;
@@ -285,6 +411,49 @@ class FloydSteinbergDitherer {
     return quantized;
   }
 
+  // Dither a full row of raw gray values (adjustPixel is applied here) into 2bpp MSB-first output,
+  // (width + 3) / 4 bytes, then advance to the next row. Same result as processPixel(adjustPixel(gray)) for every x.
+  void processRow(const uint8_t* gray, uint8_t* out) {
+    // Local copies: stores to out may alias members
+    const int width = this->width;
+    const int16_t* curRow = errorCurRow;
+    int16_t* nextRowErrors = errorNextRow;
+    const bool reverse = isReverseRow();
+    const int step = reverse ? -1 : 1;
+    // Output bytes are complete at the last pixel in scan order
+    const int byteEnd = reverse ? 0 : 3;
+    int x = reverse ? width - 1 : 0;
+    // Error flowing along the row is carried in a register instead of the current row buffer. The bottom-row
+    // entries are summed in registers too: the one behind x is complete once x adds its 3/16, and is stored once.
+    int carry = 0;
+    int pendingBehind = 0;  // Sum for the entry below x - step
+    int pendingBelow = 0;   // Sum for the entry below x
+    uint8_t packed = 0;
+    for (int i = 0; i < width; i++, x += step) {
+      const int adjusted = clampGray(ADJUST_PIXEL_LUT[gray[x]] + curRow[x + 1] + carry);
+      uint8_t quantized;
+      const int error = quantize2Bit(adjusted, quantized);
+
+      carry = (error * 7) >> 4;
+      // Bottom-behind: 3/16, bottom: 5/16, bottom-ahead: 1/16
+      nextRowErrors[x + 1 - step] = pendingBehind + ((error * 3) >> 4);
+      pendingBehind = pendingBelow + ((error * 5) >> 4);
+      pendingBelow = error >> 4;
+
+      packed |= quantized << (6 - ((x & 3) << 1));
+      if ((x & 3) == byteEnd) {
+        out[x >> 2] = packed;
+        packed = 0;
+      }
+    }
+    nextRowErrors[x + 1 - step] = pendingBehind;
+    nextRowErrors[x + 1] = pendingBelow;
+    if (!reverse && (width & 3) != 0) {
+      out[(width - 1) >> 2] = packed;
+    }
+    nextRow();
+  }
+
   // Call at the end of each row to swap buffers
   void nextRow() {
     // Swap buffers
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+class Print;
+class AtkinsonDitherer;
+class FloydSteinbergDitherer;
+class Atkinson1BitDitherer;
+
+// Scales, dithers and writes a single BMP from a stream of decoded 8-bit grayscale rows.
+// Shared by the JPEG and PNG converters. Several stages can be fed from one decode pass,
+// e.g. every thumbnail height at once.
+class BmpOutputStage {
+ public:
+  // Default target size for full screen cover images (portrait display size)
+  static constexpr int TARGET_MAX_WIDTH = 480;
+  static constexpr int TARGET_MAX_HEIGHT = 800;
+
+  // One output of a multi-target conversion
+  struct Target {
+    Print* out;
+    int maxWidth;
+    int maxHeight;
+    bool oneBit;
+    bool crop;
+  };
+  static constexpr int MAX_TARGETS = 4;
+
+  // Work out the output size for a target box. crop = true scales to cover the box (caller crops later),
+  // crop = false scales to fit inside it. Images smaller than the box are never upscaled.
+  static void computeOutputSize(int srcWidth, int srcHeight, int targetWidth, int targetHeight, bool crop,
+                                int* outWidth, int* outHeight);
+
+  BmpOutputStage(Print& bmpOut, int srcWidth, int srcHeight, int outWidth, int outHeight, bool oneBit);
+  ~BmpOutputStage();
+
+  BmpOutputStage(const BmpOutputStage& other) = delete;
+  BmpOutputStage& operator=(const BmpOutputStage& other) = delete;
+
+  // Allocate working buffers and write the BMP header
+  bool begin();
+  // Feed source row y (srcWidth grayscale bytes). Rows must arrive in order, top to bottom.
+  void addSourceRow(const uint8_t* srcRow, int y);
+  // Pad out any rows lost to fixed-point rounding so the pixel data matches the header
+  void finish();
+
+ private:
+  void flushAccumulatedRow();
+  void writeRow();
+
+  Print& bmpOut;
+  const int srcWidth;
+  const int srcHeight;
+  const int outWidth;
+  const int outHeight;
+  const bool oneBit;
+  const bool needsScaling;
+  int bytesPerRow = 0;
+  uint8_t* rowBuffer = nullptr;
+  uint8_t* grayRow = nullptr;
+
+  AtkinsonDitherer* atkinsonDitherer = nullptr;
+  FloydSteinbergDitherer* fsDitherer = nullptr;
+  Atkinson1BitDitherer* atkinson1BitDitherer = nullptr;
+
+  // For scaling: accumulate source rows into scaled output rows
+  uint32_t scaleX_fp = 65536;  // 1.0 in 16.16 fixed point
+  uint32_t scaleY_fp = 65536;
+  uint32_t* rowAccum = nullptr;    // Accumulator for each output X (32-bit for larger sums)
+  uint16_t* rowCount = nullptr;    // Count of source pixels accumulated per output X
+  int currentOutY = 0;             // Current output row being written
+  uint32_t nextOutY_srcStart = 0;  // Source Y where next output row starts (16.16 fixed point)
+};
@@ -1,19 +1,34 @@
 #pragma once
 
+#include "BmpOutputStage.h"
+
 class FsFile;
 class Print;
 class ZipFile;
 
 class JpegToBmpConverter {
+ public:
+  using BmpTarget = BmpOutputStage::Target;
+  static constexpr int MAX_BMP_TARGETS = BmpOutputStage::MAX_TARGETS;
+  // picojpeg's reduce mode decodes one pixel per 8x8 block
+  static constexpr int DC_ONLY_SCALE = 8;
+
+ private:
+
   static unsigned char jpegReadCallback(unsigned char* pBuf, unsigned char buf_size,
                                         unsigned char* pBytes_actually_read, void* pCallback_data);
   static bool jpegFileToBmpStreamInternal(class FsFile& jpegFile, Print& bmpOut, int targetWidth, int targetHeight,
                                           bool oneBit, bool crop = true);
+  static bool jpegFileToBmpStreamsInternal(FsFile& jpegFile, const BmpTarget* targets, int targetCount);
 
  public:
   static bool jpegFileToBmpStream(FsFile& jpegFile, Print& bmpOut, bool crop = true);
-  // Convert with custom target size (for thumbnails)
-  static bool jpegFileToBmpStreamWithSize(FsFile& jpegFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
+  // Convert with custom target size (for thumbnails). With crop = false the image is fit inside the target box.
+  static bool jpegFileToBmpStreamWithSize(FsFile& jpegFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight,
+                                          bool crop = true);
   // Convert to 1-bit BMP (black and white only, no grays) for fast home screen rendering
   static bool jpegFileTo1BitBmpStreamWithSize(FsFile& jpegFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
+  // Convert to up to MAX_BMP_TARGETS BMPs (e.g. all thumbnail heights at once). Outputs at most 1/DC_ONLY_SCALE of
+  // the source share a DC-only decode pass, the rest share a full resolution one.
+  static bool jpegFileToBmpStreams(FsFile& jpegFile, const BmpTarget* targets, int targetCount);
 };
@@ -3,8 +3,12 @@
 #include <HardwareSerial.h>
 #include <MD5Builder.h>
 #include <SDCardManager.h>
+#include <Serialization.h>
 
 namespace {
+constexpr uint8_t HASH_FILE_VERSION = 1;
+constexpr size_t HASH_LENGTH = 32;
+
 // Extract filename from path (everything after last '/')
 std::string getFilename(const std::string& path) {
   const size_t pos = path.rfind('/');
@@ -47,7 +51,61 @@ std::string KOReaderDocumentId::calculate(const std::string& filePath) {
     Serial.printf("[%lu] [KODoc] Failed to open file: %s\n", millis(), filePath.c_str());
     return "";
   }
+  std::string result = calculate(file, filePath);
+  file.close();
+  return result;
+}
+
+std::string KOReaderDocumentId::calculateCached(const std::string& filePath, const std::string& cacheDir) {
+  FsFile file;
+  if (!SdMan.openFileForRead("KODoc", filePath, file)) {
+    Serial.printf("[%lu] [KODoc] Failed to open file: %s\n", millis(), filePath.c_str());
+    return "";
+  }
+  const auto size = static_cast<uint32_t>(file.fileSize());
+  uint16_t date = 0, time = 0;
+  file.getModifyDateTime(&date, &time);
+  const uint32_t mtime = (static_cast<uint32_t>(date) << 16) | time;
+
+  const std::string hashPath = cacheDir + "/kosync.bin";
+  FsFile hashFile;
+  if (SdMan.exists(hashPath.c_str()) && SdMan.openFileForRead("KODoc", hashPath, hashFile)) {
+    uint8_t version = 0;
+    uint32_t cachedSize = 0;
+    uint32_t cachedMtime = 0;
+    serialization::readPod(hashFile, version);
+    serialization::readPod(hashFile, cachedSize);
+    serialization::readPod(hashFile, cachedMtime);
+    std::string cached;
+    if (version == HASH_FILE_VERSION && cachedSize == size && cachedMtime == mtime) {
+      serialization::readString(hashFile, cached);
+    }
+    hashFile.close();
+    if (cached.size() == HASH_LENGTH) {
+      file.close();
+      Serial.printf("[%lu] [KODoc] Cached hash: %s\n", millis(), cached.c_str());
+      return cached;
+    }
+  }
+
+  std::string result = calculate(file, filePath);
+  file.close();
+  if (result.size() != HASH_LENGTH) {
+    return result;
+  }
 
+  SdMan.mkdir(cacheDir.c_str());
+  if (SdMan.openFileForWrite("KODoc", hashPath, hashFile)) {
+    serialization::writePod(hashFile, HASH_FILE_VERSION);
+    serialization::writePod(hashFile, size);
+    serialization::writePod(hashFile, mtime);
+    serialization::writeString(hashFile, result);
+    hashFile.close();
+  }
+  return result;
+}
+
+std::string KOReaderDocumentId::calculate(FsFile& file, const std::string& filePath) {
   const size_t fileSize = file.fileSize();
   Serial.printf("[%lu] [KODoc] Calculating hash for file: %s (size: %zu)\n", millis(), filePath.c_str(), fileSize);
 
@@ -84,8 +142,6 @@ std::string KOReaderDocumentId::calculate(const std::string& filePath) {
     }
   }
 
-  file.close();
-
   // Calculate final hash
   md5.calculate();
   std::string result = md5.toString().c_str();
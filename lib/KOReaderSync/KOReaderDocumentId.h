@@ -1,4 +1,6 @@
 #pragma once
+#include <SdFat.h>
+
 #include <string>
 
 /**
@@ -24,6 +26,16 @@ class KOReaderDocumentId {
    */
   static std::string calculate(const std::string& filePath);
 
+  /**
+   * Calculate the KOReader document hash once per book and keep it in the book's cache directory.
+   * The stored hash is reused while the file's size and modify time are unchanged.
+   *
+   * @param filePath Path to the file (typically an EPUB)
+   * @param cacheDir The book's cache directory
+   * @return 32-character lowercase hex string, or empty string on failure
+   */
+  static std::string calculateCached(const std::string& filePath, const std::string& cacheDir);
+
   /**
    * Calculate document hash from filename only (filename-based sync mode).
    * This is simpler and works when files have the same name across devices.
@@ -42,4 +54,7 @@ class KOReaderDocumentId {
 
   // Calculate offset for index i: 1024 << (2*i)
   static size_t getOffset(int i);
+
+  // Hash the chunks of an open file
+  static std::string calculate(FsFile& file, const std::string& filePath);
 };
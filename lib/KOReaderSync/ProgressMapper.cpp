@@ -1,10 +1,12 @@
 #include "ProgressMapper.h"
 
+#include <Epub/Section.h>
 #include <HardwareSerial.h>
 
 #include <cmath>
 
-KOReaderPosition ProgressMapper::toKOReader(const std::shared_ptr<Epub>& epub, const CrossPointPosition& pos) {
+KOReaderPosition ProgressMapper::toKOReader(const std::shared_ptr<Epub>& epub, const Section::Params& params,
+                                            const CrossPointPosition& pos) {
   KOReaderPosition result;
 
   // Calculate page progress within current spine item
@@ -16,8 +18,8 @@ KOReaderPosition ProgressMapper::toKOReader(const std::shared_ptr<Epub>& epub, c
   // Calculate overall book progress (0.0-1.0)
   result.percentage = epub->calculateProgress(pos.spineIndex, intraSpineProgress);
 
-  // Generate XPath with estimated paragraph position based on page
-  result.xpath = generateXPath(pos.spineIndex, pos.pageNumber, pos.totalPages);
+  // XPath of the first block on the page, recorded when the section was built
+  result.xpath = generateXPath(pos.spineIndex, Section::getPageXPath(epub, pos.spineIndex, params, pos.pageNumber));
 
   // Get chapter info for logging
   const int tocIndex = epub->getTocIndexForSpineIndex(pos.spineIndex);
@@ -29,8 +31,8 @@ KOReaderPosition ProgressMapper::toKOReader(const std::shared_ptr<Epub>& epub, c
   return result;
 }
 
-CrossPointPosition ProgressMapper::toCrossPoint(const std::shared_ptr<Epub>& epub, const KOReaderPosition& koPos,
-                                                int totalPagesInSpine) {
+CrossPointPosition ProgressMapper::toCrossPoint(const std::shared_ptr<Epub>& epub, const Section::Params& params,
+                                                const KOReaderPosition& koPos, int totalPagesInSpine) {
   CrossPointPosition result;
   result.spineIndex = 0;
   result.pageNumber = 0;
@@ -45,8 +47,12 @@ CrossPointPosition ProgressMapper::toCrossPoint(const std::shared_ptr<Epub>& epu
   int xpathSpineIndex = parseDocFragmentIndex(koPos.xpath);
   if (xpathSpineIndex >= 0 && xpathSpineIndex < epub->getSpineItemsCount()) {
     result.spineIndex = xpathSpineIndex;
-    // When we have XPath, go to page 0 of the spine - byte-based page calculation is unreliable
-    result.pageNumber = 0;
+    // Page holding the element from the section's position table, estimated from the percentage if the section
+    // isn't built for the current settings
+    std::vector<DomPosition::Step> path;
+    const int page =
+        DomPosition::parseXPath(koPos.xpath, path) ? Section::findPage(epub, xpathSpineIndex, params, path) : -1;
+    result.pageNumber = page >= 0 ? page : estimatePage(epub, xpathSpineIndex, koPos.percentage, totalPagesInSpine);
   } else {
     // Fall back to percentage-based lookup for both spine and page
     const size_t targetBytes = static_cast<size_t>(bookSize * koPos.percentage);
@@ -61,19 +67,7 @@ CrossPointPosition ProgressMapper::toCrossPoint(const std::shared_ptr<Epub>& epu
     }
 
     // Estimate page number within the spine item using percentage (only when no XPath)
-    if (totalPagesInSpine > 0 && result.spineIndex < epub->getSpineItemsCount()) {
-      const size_t prevCumSize = (result.spineIndex > 0) ? epub->getCumulativeSpineItemSize(result.spineIndex - 1) : 0;
-      const size_t currentCumSize = epub->getCumulativeSpineItemSize(result.spineIndex);
-      const size_t spineSize = currentCumSize - prevCumSize;
-
-      if (spineSize > 0) {
-        const size_t bytesIntoSpine = (targetBytes > prevCumSize) ? (targetBytes - prevCumSize) : 0;
-        const float intraSpineProgress = static_cast<float>(bytesIntoSpine) / static_cast<float>(spineSize);
-        const float clampedProgress = std::max(0.0f, std::min(1.0f, intraSpineProgress));
-        result.pageNumber = static_cast<int>(clampedProgress * totalPagesInSpine);
-        result.pageNumber = std::max(0, std::min(result.pageNumber, totalPagesInSpine - 1));
-      }
-    }
+    result.pageNumber = estimatePage(epub, result.spineIndex, koPos.percentage, totalPagesInSpine);
   }
 
   Serial.printf("[%lu] [ProgressMapper] KOReader -> CrossPoint: %.2f%% at %s -> spine=%d, page=%d\n", millis(),
@@ -82,11 +76,30 @@ CrossPointPosition ProgressMapper::toCrossPoint(const std::shared_ptr<Epub>& epu
   return result;
 }
 
-std::string ProgressMapper::generateXPath(int spineIndex, int pageNumber, int totalPages) {
+int ProgressMapper::estimatePage(const std::shared_ptr<Epub>& epub, const int spineIndex, const float percentage,
+                                 const int totalPagesInSpine) {
+  if (totalPagesInSpine <= 0 || spineIndex >= epub->getSpineItemsCount()) {
+    return 0;
+  }
+  const size_t targetBytes = static_cast<size_t>(epub->getBookSize() * percentage);
+  const size_t prevCumSize = (spineIndex > 0) ? epub->getCumulativeSpineItemSize(spineIndex - 1) : 0;
+  const size_t currentCumSize = epub->getCumulativeSpineItemSize(spineIndex);
+  const size_t spineSize = currentCumSize - prevCumSize;
+  if (spineSize == 0) {
+    return 0;
+  }
+
+  const size_t bytesIntoSpine = (targetBytes > prevCumSize) ? (targetBytes - prevCumSize) : 0;
+  const float intraSpineProgress = static_cast<float>(bytesIntoSpine) / static_cast<float>(spineSize);
+  const float clampedProgress = std::max(0.0f, std::min(1.0f, intraSpineProgress));
+  const int page = static_cast<int>(clampedProgress * totalPagesInSpine);
+  return std::max(0, std::min(page, totalPagesInSpine - 1));
+}
+
+std::string ProgressMapper::generateXPath(const int spineIndex, const std::string& elementPath) {
   // KOReader uses 1-based DocFragment indices
-  // Use a simple xpath pointing to the DocFragment - KOReader will use the percentage for fine positioning
-  // Avoid specifying paragraph numbers as they may not exist in the target document
-  return "/body/DocFragment[" + std::to_string(spineIndex + 1) + "]/body";
+  // Without a recorded element path this points at the DocFragment and KOReader uses the percentage
+  return "/body/DocFragment[" + std::to_string(spineIndex + 1) + "]/body" + elementPath;
 }
 
 int ProgressMapper::parseDocFragmentIndex(const std::string& xpath) {
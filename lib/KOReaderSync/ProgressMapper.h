@@ -1,5 +1,6 @@
 #pragma once
 #include <Epub.h>
+#include <Epub/Section.h>
 
 #include <memory>
 #include <string>
@@ -27,9 +28,11 @@ struct KOReaderPosition {
  * CrossPoint tracks position as (spineIndex, pageNumber).
  * KOReader uses XPath-like strings + percentage.
  *
- * Since CrossPoint discards HTML structure during parsing, we generate
- * synthetic XPath strings based on spine index, using percentage as the
- * primary sync mechanism.
+ * Building a section records the element path of the first block on every
+ * page (see DomPosition), so XPaths point at the block a page starts with and
+ * KOReader XPaths are matched to pages by a binary search of that table.
+ * Percentage is the fallback when the table or the XPath is missing, or the
+ * section was built with other layout settings than the reader's.
  */
 class ProgressMapper {
  public:
@@ -37,32 +40,41 @@ class ProgressMapper {
    * Convert CrossPoint position to KOReader format.
    *
    * @param epub The EPUB book
+   * @param params Layout settings the reader builds sections with
    * @param pos CrossPoint position
    * @return KOReader position
    */
-  static KOReaderPosition toKOReader(const std::shared_ptr<Epub>& epub, const CrossPointPosition& pos);
+  static KOReaderPosition toKOReader(const std::shared_ptr<Epub>& epub, const Section::Params& params,
+                                     const CrossPointPosition& pos);
 
   /**
    * Convert KOReader position to CrossPoint format.
    *
-   * Note: The returned pageNumber may be approximate since different
-   * rendering settings produce different page counts.
+   * Note: The returned pageNumber is only exact when the target section has
+   * been built, otherwise it is page 0 or estimated from the percentage.
    *
    * @param epub The EPUB book
+   * @param params Layout settings the reader builds sections with
    * @param koPos KOReader position
    * @param totalPagesInSpine Total pages in the target spine item (for page estimation)
    * @return CrossPoint position
    */
-  static CrossPointPosition toCrossPoint(const std::shared_ptr<Epub>& epub, const KOReaderPosition& koPos,
-                                         int totalPagesInSpine = 0);
+  static CrossPointPosition toCrossPoint(const std::shared_ptr<Epub>& epub, const Section::Params& params,
+                                         const KOReaderPosition& koPos, int totalPagesInSpine = 0);
 
  private:
+  /**
+   * Estimate the page a book percentage falls on in a spine item of
+   * totalPagesInSpine pages, from the spine items' sizes.
+   */
+  static int estimatePage(const std::shared_ptr<Epub>& epub, int spineIndex, float percentage, int totalPagesInSpine);
+
   /**
    * Generate XPath for KOReader compatibility.
-   * Format: /body/DocFragment[spineIndex+1]/body/p[estimatedParagraph]
-   * Paragraph is estimated based on page position within the chapter.
+   * Format: /body/DocFragment[spineIndex+1]/body followed by the element
+   * path of the block, e.g. /div[1]/p[12].
    */
-  static std::string generateXPath(int spineIndex, int pageNumber, int totalPages);
+  static std::string generateXPath(int spineIndex, const std::string& elementPath);
 
   /**
    * Parse DocFragment index from XPath string.
@@ -0,0 +1,468 @@
+#include "PngRowDecoder.h"
+
+#include <miniz.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace {
+constexpr uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+constexpr uint32_t chunkType(const char* name) {
+  return (static_cast<uint32_t>(name[0]) << 24) | (static_cast<uint32_t>(name[1]) << 16) |
+         (static_cast<uint32_t>(name[2]) << 8) | static_cast<uint32_t>(name[3]);
+}
+
+constexpr uint32_t CHUNK_IHDR = chunkType("IHDR");
+constexpr uint32_t CHUNK_PLTE = chunkType("PLTE");
+constexpr uint32_t CHUNK_TRNS = chunkType("tRNS");
+constexpr uint32_t CHUNK_IDAT = chunkType("IDAT");
+constexpr uint32_t CHUNK_IEND = chunkType("IEND");
+
+enum ColorType : uint8_t { GRAYSCALE = 0, RGB = 2, PALETTE = 3, GRAYSCALE_ALPHA = 4, RGBA = 6 };
+
+inline uint32_t readBigEndian32(const uint8_t* data) {
+  return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+inline uint16_t readBigEndian16(const uint8_t* data) { return static_cast<uint16_t>((data[0] << 8) | data[1]); }
+
+// Same weights as the JPEG converter so covers look alike regardless of format
+inline uint8_t luminance(const uint8_t r, const uint8_t g, const uint8_t b) { return (r * 25 + g * 50 + b * 25) / 100; }
+
+// Composite onto a white page
+inline uint8_t composite(const uint8_t gray, const uint8_t alpha) {
+  return (gray * alpha + 255 * (255 - alpha) + 127) / 255;
+}
+
+inline uint8_t paeth(const int a, const int b, const int c) {
+  const int p = a + b - c;
+  const int pa = abs(p - a);
+  const int pb = abs(p - b);
+  const int pc = abs(p - c);
+  if (pa <= pb && pa <= pc) return a;
+  if (pb <= pc) return b;
+  return c;
+}
+}  // namespace
+
+PngRowDecoder::PngRowDecoder(const ReadCallback readCallback, void* readContext)
+    : readCallback(readCallback), readContext(readContext) {}
+
+PngRowDecoder::~PngRowDecoder() {
+  free(inflator);
+  free(window);
+  free(currentLine);
+  free(previousLine);
+}
+
+bool PngRowDecoder::fail(const char* message) {
+  error = message;
+  return false;
+}
+
+size_t PngRowDecoder::getWorkingMemorySize() const {
+  return sizeof(PngRowDecoder) + sizeof(tinfl_decompressor) + TINFL_LZ_DICT_SIZE + 2 * rowBytes;
+}
+
+bool PngRowDecoder::fillInput() {
+  inputFilled = readCallback(inputBuffer, INPUT_BUFFER_SIZE, readContext);
+  inputPos = 0;
+  return inputFilled > 0;
+}
+
+bool PngRowDecoder::readBytes(uint8_t* dst, size_t length) {
+  while (length > 0) {
+    if (inputPos >= inputFilled && !fillInput()) {
+      return fail("Unexpected end of file");
+    }
+    const size_t available = inputFilled - inputPos;
+    const size_t toCopy = available < length ? available : length;
+    memcpy(dst, inputBuffer + inputPos, toCopy);
+    inputPos += toCopy;
+    dst += toCopy;
+    length -= toCopy;
+  }
+  return true;
+}
+
+bool PngRowDecoder::skipBytes(size_t length) {
+  while (length > 0) {
+    if (inputPos >= inputFilled && !fillInput()) {
+      return fail("Unexpected end of file");
+    }
+    const size_t available = inputFilled - inputPos;
+    const size_t toSkip = available < length ? available : length;
+    inputPos += toSkip;
+    length -= toSkip;
+  }
+  return true;
+}
+
+bool PngRowDecoder::readChunkHeader(uint32_t* length, uint32_t* type) {
+  uint8_t header[8];
+  if (!readBytes(header, sizeof(header))) {
+    return false;
+  }
+  *length = readBigEndian32(header);
+  *type = readBigEndian32(header + 4);
+  if (*length > 0x7FFFFFFF) {
+    return fail("Invalid chunk length");
+  }
+  return true;
+}
+
+bool PngRowDecoder::parseHeader(const uint8_t* data, const uint32_t length) {
+  if (length != 13) {
+    return fail("Invalid IHDR chunk");
+  }
+
+  const uint32_t headerWidth = readBigEndian32(data);
+  const uint32_t headerHeight = readBigEndian32(data + 4);
+  bitDepth = data[8];
+  colorType = data[9];
+  const uint8_t compression = data[10];
+  const uint8_t filterMethod = data[11];
+  const uint8_t interlace = data[12];
+
+  if (headerWidth == 0 || headerHeight == 0 || headerWidth > MAX_IMAGE_WIDTH || headerHeight > MAX_IMAGE_HEIGHT) {
+    return fail("Image dimensions out of range");
+  }
+  if (compression != 0 || filterMethod != 0) {
+    return fail("Unknown compression or filter method");
+  }
+  if (interlace != 0) {
+    return fail("Interlaced PNG not supported");
+  }
+
+  bool validDepth;
+  switch (colorType) {
+    case GRAYSCALE:
+      channels = 1;
+      validDepth = bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16;
+      break;
+    case PALETTE:
+      channels = 1;
+      validDepth = bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8;
+      break;
+    case RGB:
+      channels = 3;
+      validDepth = bitDepth == 8 || bitDepth == 16;
+      break;
+    case GRAYSCALE_ALPHA:
+      channels = 2;
+      validDepth = bitDepth == 8 || bitDepth == 16;
+      break;
+    case RGBA:
+      channels = 4;
+      validDepth = bitDepth == 8 || bitDepth == 16;
+      break;
+    default:
+      return fail("Unknown color type");
+  }
+  if (!validDepth) {
+    return fail("Invalid bit depth for color type");
+  }
+
+  width = static_cast<int>(headerWidth);
+  height = static_cast<int>(headerHeight);
+  const size_t bitsPerPixel = static_cast<size_t>(channels) * bitDepth;
+  rowBytes = (static_cast<size_t>(width) * bitsPerPixel + 7) / 8;
+  filterStride = bitsPerPixel < 8 ? 1 : bitsPerPixel / 8;
+  return true;
+}
+
+bool PngRowDecoder::begin() {
+  uint8_t signature[sizeof(PNG_SIGNATURE)];
+  if (!readBytes(signature, sizeof(signature)) || memcmp(signature, PNG_SIGNATURE, sizeof(signature)) != 0) {
+    return fail("Not a PNG file");
+  }
+
+  bool seenHeader = false;
+  while (true) {
+    uint32_t length;
+    uint32_t type;
+    if (!readChunkHeader(&length, &type)) {
+      return false;
+    }
+
+    if (!seenHeader && type != CHUNK_IHDR) {
+      return fail("IHDR must be the first chunk");
+    }
+
+    if (type == CHUNK_IDAT) {
+      idatRemaining = length;
+      break;
+    }
+    if (type == CHUNK_IEND) {
+      return fail("No image data");
+    }
+
+    if (type == CHUNK_IHDR) {
+      uint8_t data[13];
+      if (length != sizeof(data)) {
+        return fail("Invalid IHDR chunk");
+      }
+      if (!readBytes(data, sizeof(data)) || !parseHeader(data, length)) {
+        return false;
+      }
+      seenHeader = true;
+    } else if (type == CHUNK_PLTE && colorType == PALETTE) {
+      if (length % 3 != 0 || length > 256 * 3) {
+        return fail("Invalid PLTE chunk");
+      }
+      paletteSize = length / 3;
+      for (int i = 0; i < paletteSize; i++) {
+        uint8_t rgb[3];
+        if (!readBytes(rgb, sizeof(rgb))) {
+          return false;
+        }
+        paletteGray[i] = luminance(rgb[0], rgb[1], rgb[2]);
+      }
+    } else if (type == CHUNK_TRNS && colorType == PALETTE) {
+      // One alpha byte per palette entry, missing entries are opaque
+      if (length > paletteSize) {
+        return fail("Invalid tRNS chunk");
+      }
+      for (uint32_t i = 0; i < length; i++) {
+        uint8_t alpha;
+        if (!readBytes(&alpha, 1)) {
+          return false;
+        }
+        paletteGray[i] = composite(paletteGray[i], alpha);
+      }
+    } else if (type == CHUNK_TRNS && (colorType == GRAYSCALE || colorType == RGB)) {
+      // A single fully transparent colour key
+      const uint32_t expected = colorType == GRAYSCALE ? 2 : 6;
+      uint8_t data[6];
+      if (length != expected) {
+        return fail("Invalid tRNS chunk");
+      }
+      if (!readBytes(data, expected)) {
+        return false;
+      }
+      for (uint32_t i = 0; i < expected / 2; i++) {
+        colorKey[i] = readBigEndian16(data + i * 2);
+      }
+      hasColorKey = true;
+    } else if (!skipBytes(length)) {
+      return false;
+    }
+
+    // Chunk CRC
+    if (!skipBytes(4)) {
+      return false;
+    }
+  }
+
+  if (colorType == PALETTE && paletteSize == 0) {
+    return fail("Missing palette");
+  }
+
+  inflator = malloc(sizeof(tinfl_decompressor));
+  window = static_cast<uint8_t*>(malloc(TINFL_LZ_DICT_SIZE));
+  currentLine = static_cast<uint8_t*>(malloc(rowBytes));
+  previousLine = static_cast<uint8_t*>(calloc(rowBytes, 1));  // The row above the first row is all zeros
+  if (!inflator || !window || !currentLine || !previousLine) {
+    return fail("Out of memory");
+  }
+  tinfl_init(static_cast<tinfl_decompressor*>(inflator));
+  return true;
+}
+
+bool PngRowDecoder::nextIdatInput() {
+  // Image data may be split over any number of consecutive IDAT chunks
+  while (idatRemaining == 0) {
+    if (idatFinished) {
+      return false;
+    }
+    uint32_t length;
+    uint32_t type;
+    if (!skipBytes(4) || !readChunkHeader(&length, &type)) {
+      return false;
+    }
+    if (type != CHUNK_IDAT) {
+      idatFinished = true;
+      return false;
+    }
+    idatRemaining = length;
+  }
+
+  if (inputPos >= inputFilled) {
+    return fillInput();
+  }
+  return true;
+}
+
+bool PngRowDecoder::inflateBytes(uint8_t* dst, size_t length) {
+  while (length > 0) {
+    // Drain what the last inflate call produced. Output is always contiguous since the inflator only writes up
+    // to the end of the window before wrapping on the next call.
+    if (windowPending > 0) {
+      const size_t toCopy = windowPending < length ? windowPending : length;
+      memcpy(dst, window + windowReadPos, toCopy);
+      windowReadPos = (windowReadPos + toCopy) & (TINFL_LZ_DICT_SIZE - 1);
+      windowPending -= toCopy;
+      dst += toCopy;
+      length -= toCopy;
+      continue;
+    }
+
+    if (inflateDone) {
+      return fail("Image data ended early");
+    }
+
+    size_t available = inputFilled - inputPos;
+    if (available > idatRemaining) available = idatRemaining;
+    if (available == 0) {
+      if (!nextIdatInput()) {
+        return fail("Truncated image data");
+      }
+      available = inputFilled - inputPos;
+      if (available > idatRemaining) available = idatRemaining;
+    }
+
+    size_t inBytes = available;
+    size_t outBytes = TINFL_LZ_DICT_SIZE - windowWritePos;
+    const tinfl_status status =
+        tinfl_decompress(static_cast<tinfl_decompressor*>(inflator), inputBuffer + inputPos, &inBytes, window,
+                         window + windowWritePos, &outBytes, TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+    inputPos += inBytes;
+    idatRemaining -= inBytes;
+
+    windowReadPos = windowWritePos;
+    windowPending = outBytes;
+    windowWritePos = (windowWritePos + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+    if (status < 0) {
+      return fail("Corrupt image data");
+    }
+    if (status == TINFL_STATUS_DONE) {
+      inflateDone = true;
+    }
+  }
+  return true;
+}
+
+bool PngRowDecoder::unfilterRow(const uint8_t filterType) {
+  uint8_t* cur = currentLine;
+  const uint8_t* prev = previousLine;
+  const size_t bpp = filterStride;
+
+  switch (filterType) {
+    case 0:  // None
+      break;
+    case 1:  // Sub
+      for (size_t i = bpp; i < rowBytes; i++) {
+        cur[i] += cur[i - bpp];
+      }
+      break;
+    case 2:  // Up
+      for (size_t i = 0; i < rowBytes; i++) {
+        cur[i] += prev[i];
+      }
+      break;
+    case 3:  // Average
+      for (size_t i = 0; i < bpp && i < rowBytes; i++) {
+        cur[i] += prev[i] >> 1;
+      }
+      for (size_t i = bpp; i < rowBytes; i++) {
+        cur[i] += (cur[i - bpp] + prev[i]) >> 1;
+      }
+      break;
+    case 4:  // Paeth, with a = c = 0 on the left edge it reduces to Up
+      for (size_t i = 0; i < bpp && i < rowBytes; i++) {
+        cur[i] += prev[i];
+      }
+      for (size_t i = bpp; i < rowBytes; i++) {
+        cur[i] += paeth(cur[i - bpp], prev[i], prev[i - bpp]);
+      }
+      break;
+    default:
+      return fail("Unknown filter type");
+  }
+  return true;
+}
+
+void PngRowDecoder::convertRow(uint8_t* grayOut) const {
+  const uint8_t* line = currentLine;
+
+  if (bitDepth < 8) {
+    // Packed grayscale or palette indices, MSB first
+    const int mask = (1 << bitDepth) - 1;
+    for (int x = 0; x < width; x++) {
+      const int bitOffset = x * bitDepth;
+      const int value = (line[bitOffset >> 3] >> (8 - bitDepth - (bitOffset & 7))) & mask;
+      if (colorType == PALETTE) {
+        grayOut[x] = paletteGray[value];
+      } else if (hasColorKey && value == colorKey[0]) {
+        grayOut[x] = 0xFF;
+      } else {
+        grayOut[x] = value * 255 / mask;
+      }
+    }
+    return;
+  }
+
+  // 8 or 16 bits per sample, use the high byte and keep full precision for colour key comparisons
+  const int sampleBytes = bitDepth / 8;
+  const auto sample = [line, sampleBytes](const int index) -> uint16_t {
+    return sampleBytes == 2 ? readBigEndian16(line + index * 2) : line[index];
+  };
+  const auto high = [line, sampleBytes](const int index) -> uint8_t { return line[index * sampleBytes]; };
+
+  switch (colorType) {
+    case GRAYSCALE:
+      for (int x = 0; x < width; x++) {
+        grayOut[x] = (hasColorKey && sample(x) == colorKey[0]) ? 0xFF : high(x);
+      }
+      break;
+    case PALETTE:
+      for (int x = 0; x < width; x++) {
+        grayOut[x] = paletteGray[line[x]];
+      }
+      break;
+    case RGB:
+      for (int x = 0; x < width; x++) {
+        const int i = x * 3;
+        if (hasColorKey && sample(i) == colorKey[0] && sample(i + 1) == colorKey[1] && sample(i + 2) == colorKey[2]) {
+          grayOut[x] = 0xFF;
+        } else {
+          grayOut[x] = luminance(high(i), high(i + 1), high(i + 2));
+        }
+      }
+      break;
+    case GRAYSCALE_ALPHA:
+      for (int x = 0; x < width; x++) {
+        grayOut[x] = composite(high(x * 2), high(x * 2 + 1));
+      }
+      break;
+    case RGBA:
+      for (int x = 0; x < width; x++) {
+        const int i = x * 4;
+        grayOut[x] = composite(luminance(high(i), high(i + 1), high(i + 2)), high(i + 3));
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+bool PngRowDecoder::readRow(uint8_t* grayOut) {
+  if (currentRow >= height) {
+    return fail("No more rows");
+  }
+
+  uint8_t filterType;
+  if (!inflateBytes(&filterType, 1) || !inflateBytes(currentLine, rowBytes) || !unfilterRow(filterType)) {
+    return false;
+  }
+  convertRow(grayOut);
+
+  // This row becomes the reference for the next one's filters
+  std::swap(currentLine, previousLine);
+  currentRow++;
+  return true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Streaming PNG decoder that produces one 8-bit grayscale row at a time.
+// IDAT data is inflated through a 32KB circular window, so peak memory is the inflate state plus two raw
+// scanlines (current and previous, needed for unfiltering) and a small input buffer.
+// Supports all non-interlaced colour types and bit depths. Transparent pixels are composited onto white.
+// Interlaced (Adam7) images are rejected since their passes can't be emitted a row at a time.
+//
+// Has no Arduino dependencies so it can be exercised by the host tests in test/png_decode_eval.
+class PngRowDecoder {
+ public:
+  // Read up to length bytes into buffer. Returns the number of bytes read, 0 on EOF or error.
+  using ReadCallback = size_t (*)(uint8_t* buffer, size_t length, void* context);
+
+  // Safety limits to prevent memory issues on ESP32 (matches the JPEG converter)
+  static constexpr int MAX_IMAGE_WIDTH = 2048;
+  static constexpr int MAX_IMAGE_HEIGHT = 3072;
+
+  PngRowDecoder(ReadCallback readCallback, void* readContext);
+  ~PngRowDecoder();
+
+  PngRowDecoder(const PngRowDecoder& other) = delete;
+  PngRowDecoder& operator=(const PngRowDecoder& other) = delete;
+
+  // Parse the signature and header chunks up to the first IDAT and allocate working buffers
+  bool begin();
+  // Decode the next row into grayOut (getWidth() bytes)
+  bool readRow(uint8_t* grayOut);
+
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  uint8_t getColorType() const { return colorType; }
+  uint8_t getBitDepth() const { return bitDepth; }
+  // Description of the last failure, for logging
+  const char* getError() const { return error; }
+  // Bytes allocated by begin(), for memory budget checks
+  size_t getWorkingMemorySize() const;
+
+ private:
+  static constexpr size_t INPUT_BUFFER_SIZE = 1024;
+
+  bool fail(const char* message);
+  bool fillInput();
+  bool readBytes(uint8_t* dst, size_t length);
+  bool skipBytes(size_t length);
+  bool readChunkHeader(uint32_t* length, uint32_t* type);
+  bool parseHeader(const uint8_t* data, uint32_t length);
+  bool nextIdatInput();
+  bool inflateBytes(uint8_t* dst, size_t length);
+  bool unfilterRow(uint8_t filterType);
+  void convertRow(uint8_t* grayOut) const;
+
+  ReadCallback readCallback;
+  void* readContext;
+  const char* error = nullptr;
+
+  // Raw stream buffer, shared by chunk parsing and IDAT payloads
+  uint8_t inputBuffer[INPUT_BUFFER_SIZE];
+  size_t inputPos = 0;
+  size_t inputFilled = 0;
+  uint32_t idatRemaining = 0;  // Unread payload bytes of the current IDAT chunk
+  bool idatFinished = false;   // A non-IDAT chunk followed the image data
+
+  // Image header
+  int width = 0;
+  int height = 0;
+  uint8_t bitDepth = 0;
+  uint8_t colorType = 0;
+  uint8_t channels = 0;
+  size_t rowBytes = 0;       // Packed bytes per scanline, excluding the filter byte
+  size_t filterStride = 0;   // Bytes per complete pixel (at least 1), used by the filters
+  int currentRow = 0;
+
+  // Palette luminance with tRNS alpha already composited onto white
+  uint8_t paletteGray[256] = {};
+  uint16_t paletteSize = 0;
+  bool hasColorKey = false;
+  uint16_t colorKey[3] = {};  // tRNS key for grayscale (first entry) or RGB images
+
+  // Inflate state
+  void* inflator = nullptr;       // tinfl_decompressor, kept opaque to avoid leaking miniz into users
+  uint8_t* window = nullptr;      // TINFL_LZ_DICT_SIZE circular output window
+  size_t windowWritePos = 0;      // Where the inflator writes next
+  size_t windowReadPos = 0;       // Next unconsumed output byte
+  size_t windowPending = 0;       // Inflated bytes not yet consumed
+  bool inflateDone = false;
+
+  uint8_t* currentLine = nullptr;
+  uint8_t* previousLine = nullptr;
+};
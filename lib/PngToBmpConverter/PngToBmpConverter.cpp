@@ -0,0 +1,101 @@
+#include "PngToBmpConverter.h"
+
+#include <HardwareSerial.h>
+#include <SdFat.h>
+
+#include <cstdlib>
+
+#include "PngRowDecoder.h"
+
+size_t PngToBmpConverter::pngReadCallback(uint8_t* buffer, const size_t length, void* context) {
+  auto* file = static_cast<FsFile*>(context);
+  const int bytesRead = file->read(buffer, length);
+  return bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0;
+}
+
+bool PngToBmpConverter::pngFileToBmpStreamsInternal(FsFile& pngFile, const BmpTarget* targets,
+                                                    const int targetCount) {
+  if (targetCount <= 0 || targetCount > MAX_BMP_TARGETS) {
+    Serial.printf("[%lu] [PNG] Invalid number of BMP targets (%d), max: %d\n", millis(), targetCount,
+                  MAX_BMP_TARGETS);
+    return false;
+  }
+
+  PngRowDecoder decoder(pngReadCallback, &pngFile);
+  if (!decoder.begin()) {
+    Serial.printf("[%lu] [PNG] PNG decode init failed: %s\n", millis(), decoder.getError());
+    return false;
+  }
+
+  const int width = decoder.getWidth();
+  const int height = decoder.getHeight();
+  Serial.printf("[%lu] [PNG] PNG dimensions: %dx%d, color type: %d, bit depth: %d, working memory: %d bytes\n",
+                millis(), width, height, decoder.getColorType(), decoder.getBitDepth(),
+                static_cast<int>(decoder.getWorkingMemorySize()));
+
+  auto* grayRow = static_cast<uint8_t*>(malloc(width));
+  if (!grayRow) {
+    Serial.printf("[%lu] [PNG] Failed to allocate row buffer (%d bytes)\n", millis(), width);
+    return false;
+  }
+
+  BmpOutputStage* stages[MAX_BMP_TARGETS] = {nullptr};
+  bool success = true;
+  for (int i = 0; i < targetCount && success; i++) {
+    int outWidth;
+    int outHeight;
+    BmpOutputStage::computeOutputSize(width, height, targets[i].maxWidth, targets[i].maxHeight, targets[i].crop,
+                                      &outWidth, &outHeight);
+    Serial.printf("[%lu] [PNG] Converting PNG to %s BMP: %dx%d -> %dx%d (target: %dx%d)\n", millis(),
+                  targets[i].oneBit ? "1-bit" : "2-bit", width, height, outWidth, outHeight, targets[i].maxWidth,
+                  targets[i].maxHeight);
+    stages[i] = new BmpOutputStage(*targets[i].out, width, height, outWidth, outHeight, targets[i].oneBit);
+    success = stages[i]->begin();
+  }
+
+  for (int y = 0; y < height && success; y++) {
+    if (!decoder.readRow(grayRow)) {
+      Serial.printf("[%lu] [PNG] PNG decode failed at row %d: %s\n", millis(), y, decoder.getError());
+      success = false;
+      break;
+    }
+    for (int i = 0; i < targetCount; i++) {
+      stages[i]->addSourceRow(grayRow, y);
+    }
+  }
+
+  for (int i = 0; i < targetCount; i++) {
+    if (stages[i] && success) {
+      stages[i]->finish();
+    }
+    delete stages[i];
+  }
+  free(grayRow);
+
+  if (success) {
+    Serial.printf("[%lu] [PNG] Successfully converted PNG to %d BMP(s)\n", millis(), targetCount);
+  }
+  return success;
+}
+
+bool PngToBmpConverter::pngFileToBmpStream(FsFile& pngFile, Print& bmpOut, const bool crop) {
+  const BmpTarget target = {&bmpOut, BmpOutputStage::TARGET_MAX_WIDTH, BmpOutputStage::TARGET_MAX_HEIGHT, false,
+                            crop};
+  return pngFileToBmpStreamsInternal(pngFile, &target, 1);
+}
+
+bool PngToBmpConverter::pngFileToBmpStreamWithSize(FsFile& pngFile, Print& bmpOut, const int targetMaxWidth,
+                                                   const int targetMaxHeight, const bool crop) {
+  const BmpTarget target = {&bmpOut, targetMaxWidth, targetMaxHeight, false, crop};
+  return pngFileToBmpStreamsInternal(pngFile, &target, 1);
+}
+
+bool PngToBmpConverter::pngFileTo1BitBmpStreamWithSize(FsFile& pngFile, Print& bmpOut, const int targetMaxWidth,
+                                                       const int targetMaxHeight) {
+  const BmpTarget target = {&bmpOut, targetMaxWidth, targetMaxHeight, true, true};
+  return pngFileToBmpStreamsInternal(pngFile, &target, 1);
+}
+
+bool PngToBmpConverter::pngFileToBmpStreams(FsFile& pngFile, const BmpTarget* targets, const int targetCount) {
+  return pngFileToBmpStreamsInternal(pngFile, targets, targetCount);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <BmpOutputStage.h>
+
+#include <cstddef>
+#include <cstdint>
+
+class FsFile;
+class Print;
+
+// Streams a PNG through PngRowDecoder into the same prescale + dither pipeline as JpegToBmpConverter
+class PngToBmpConverter {
+ public:
+  using BmpTarget = BmpOutputStage::Target;
+  static constexpr int MAX_BMP_TARGETS = BmpOutputStage::MAX_TARGETS;
+
+ private:
+  static size_t pngReadCallback(uint8_t* buffer, size_t length, void* context);
+  static bool pngFileToBmpStreamsInternal(FsFile& pngFile, const BmpTarget* targets, int targetCount);
+
+ public:
+  static bool pngFileToBmpStream(FsFile& pngFile, Print& bmpOut, bool crop = true);
+  // Convert with custom target size (for thumbnails). With crop = false the image is fit inside the target box.
+  static bool pngFileToBmpStreamWithSize(FsFile& pngFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight,
+                                         bool crop = true);
+  // Convert to 1-bit BMP (black and white only, no grays) for fast home screen rendering
+  static bool pngFileTo1BitBmpStreamWithSize(FsFile& pngFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
+  // Convert to up to MAX_BMP_TARGETS BMPs from a single decode pass (e.g. all thumbnail heights at once)
+  static bool pngFileToBmpStreams(FsFile& pngFile, const BmpTarget* targets, int targetCount);
+};
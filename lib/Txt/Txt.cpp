@@ -1,13 +1,14 @@
 #include "Txt.h"
 
+#include <BookCacheKey.h>
 #include <FsHelpers.h>
 #include <JpegToBmpConverter.h>
+#include <PngToBmpConverter.h>
 
 Txt::Txt(std::string path, std::string cacheBasePath)
     : filepath(std::move(path)), cacheBasePath(std::move(cacheBasePath)) {
-  // Generate cache path from file path hash
-  const size_t hash = std::hash<std::string>{}(filepath);
-  cachePath = this->cacheBasePath + "/txt_" + std::to_string(hash);
+  // Generate cache path from a content fingerprint, so moving or renaming the file keeps its cache
+  cachePath = this->cacheBasePath + "/txt_" + BookCacheKey::get(this->cacheBasePath, filepath);
 }
 
 bool Txt::load() {
@@ -116,6 +117,7 @@ bool Txt::generateCoverBmp() const {
   const bool isJpg =
       (len >= 4 && (coverImagePath.substr(len - 4) == ".jpg" || coverImagePath.substr(len - 4) == ".JPG")) ||
       (len >= 5 && (coverImagePath.substr(len - 5) == ".jpeg" || coverImagePath.substr(len - 5) == ".JPEG"));
+  const bool isPng = len >= 4 && (coverImagePath.substr(len - 4) == ".png" || coverImagePath.substr(len - 4) == ".PNG");
   const bool isBmp = len >= 4 && (coverImagePath.substr(len - 4) == ".bmp" || coverImagePath.substr(len - 4) == ".BMP");
 
   if (isBmp) {
@@ -164,8 +166,31 @@ bool Txt::generateCoverBmp() const {
     return success;
   }
 
-  // PNG files are not supported (would need a PNG decoder)
-  Serial.printf("[%lu] [TXT] Cover image format not supported (only BMP/JPG/JPEG)\n", millis());
+  if (isPng) {
+    // Convert PNG to BMP, streamed a row at a time
+    Serial.printf("[%lu] [TXT] Generating BMP from PNG cover image\n", millis());
+    FsFile coverPng, coverBmp;
+    if (!SdMan.openFileForRead("TXT", coverImagePath, coverPng)) {
+      return false;
+    }
+    if (!SdMan.openFileForWrite("TXT", getCoverBmpPath(), coverBmp)) {
+      coverPng.close();
+      return false;
+    }
+    const bool success = PngToBmpConverter::pngFileToBmpStream(coverPng, coverBmp);
+    coverPng.close();
+    coverBmp.close();
+
+    if (!success) {
+      Serial.printf("[%lu] [TXT] Failed to generate BMP from PNG cover image\n", millis());
+      SdMan.remove(getCoverBmpPath().c_str());
+    } else {
+      Serial.printf("[%lu] [TXT] Generated BMP from PNG cover image\n", millis());
+    }
+    return success;
+  }
+
+  Serial.printf("[%lu] [TXT] Cover image format not supported (only BMP/JPG/JPEG/PNG)\n", millis());
   return false;
 }
 
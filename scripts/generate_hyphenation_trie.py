@@ -18,6 +18,87 @@ def _format_bytes(blob: bytes, per_line: int = 16) -> str:
     return '\n'.join(lines)
 
 
+def _format_values(values: list[int], width: int, per_line: int) -> str:
+    # Same wrapping as _format_bytes for wider integer arrays.
+    lines = []
+    for i in range(0, len(values), per_line):
+        chunk = ', '.join(f"0x{v:0{width}X}" for v in values[i : i + per_line])
+        lines.append(f"    {chunk},")
+    if not lines:
+        lines.append("    0x0,")
+    return '\n'.join(lines)
+
+
+def _decode_node(blob: bytes, addr: int) -> tuple[int, list[tuple[int, int]]]:
+    # Mirror of decodeState in LiangHyphenation.cpp: returns the packed levels word and (byte, child address) pairs.
+    header = blob[addr]
+    pos = addr + 1
+    stride = (header >> 5) & 0x03 or 1
+    child_count = header & 0x1F
+    if child_count == 31:
+        child_count = blob[pos]
+        pos += 1
+    levels = 0
+    if header >> 7:
+        levels = (blob[pos] << 8) | blob[pos + 1]
+        pos += 2
+    transitions = blob[pos : pos + child_count]
+    pos += child_count
+    children = []
+    for idx, letter in enumerate(transitions):
+        raw = blob[pos + idx * stride : pos + (idx + 1) * stride]
+        if stride == 3:
+            delta = int.from_bytes(raw, 'big') - (1 << 23)
+        else:
+            delta = int.from_bytes(raw, 'big', signed=True)
+        children.append((letter, addr + delta))
+    return levels, children
+
+
+FAST_ROW_FLAG = 1 << 31
+
+
+def build_fast_table(blob: bytes, budget: int) -> tuple[list[int], int, list[int], list[int]]:
+    # Flatten the top of the trie into rows indexed by byte class, going one level deeper at a time while the
+    # table still fits in `budget` bytes. Entries hold FAST_ROW_FLAG | row for flattened children, the packed node
+    # address for everything below the flattened levels, or 0 when there is no transition.
+    root = int.from_bytes(blob[:4], 'big')
+
+    def layout(depth: int) -> tuple[list[int], dict[int, int]]:
+        rows = [root]
+        frontier = [root]
+        for _ in range(depth - 1):
+            frontier = [child for node in frontier for _, child in _decode_node(blob, node)[1]]
+            rows.extend(frontier)
+        alphabet = sorted({letter for node in rows for letter, _ in _decode_node(blob, node)[1]})
+        return rows, {letter: idx + 1 for idx, letter in enumerate(alphabet)}
+
+    def table_bytes(rows: list[int], classes: dict[int, int]) -> int:
+        return 256 + len(rows) * ((len(classes) + 1) * 4 + 2)
+
+    rows, classes = layout(1)
+    depth = 1
+    while True:
+        deeper_rows, deeper_classes = layout(depth + 1)
+        if len(deeper_rows) > 0xFFFF or table_bytes(deeper_rows, deeper_classes) > budget:
+            break
+        rows, classes, depth = deeper_rows, deeper_classes, depth + 1
+
+    byte_classes = [classes.get(b, 0) for b in range(256)]
+    class_count = len(classes) + 1
+    row_index = {node: idx for idx, node in enumerate(rows)}
+    entries = []
+    row_levels = []
+    for node in rows:
+        levels, children = _decode_node(blob, node)
+        row = [0] * class_count
+        for letter, child in children:
+            row[classes[letter]] = FAST_ROW_FLAG | row_index[child] if child in row_index else child
+        entries.extend(row)
+        row_levels.append(levels)
+    return byte_classes, class_count, entries, row_levels
+
+
 def _symbol_from_output(path: pathlib.Path) -> str:
     # Derive a stable C identifier from the destination header name (e.g., hyph-en.trie.h -> en).
     name = path.name
@@ -31,12 +112,14 @@ def _symbol_from_output(path: pathlib.Path) -> str:
     return name
 
 
-def write_header(path: pathlib.Path, blob: bytes, symbol: str) -> None:
-    # Emit a constexpr header containing the raw bytes plus a SerializedHyphenationPatterns descriptor.
+def write_header(path: pathlib.Path, blob: bytes, symbol: str, fast_budget: int) -> None:
+    # Emit a constexpr header containing the raw bytes, the flattened top levels and a
+    # SerializedHyphenationPatterns descriptor.
     path.parent.mkdir(parents=True, exist_ok=True)
     data_symbol = f"{symbol}_trie_data"
     patterns_symbol = f"{symbol}_patterns"
     bytes_literal = _format_bytes(blob)
+    byte_classes, class_count, entries, row_levels = build_fast_table(blob, fast_budget)
     content = f"""#pragma once
 
 #include <cstddef>
@@ -49,9 +132,30 @@ alignas(4) constexpr uint8_t {data_symbol}[] = {{
 {bytes_literal}
 }};
 
+constexpr uint8_t {symbol}_fast_classes[256] = {{
+{_format_bytes(bytes(byte_classes), 19)}
+}};
+
+constexpr uint32_t {symbol}_fast_entries[] = {{
+{_format_values(entries, 8, 9)}
+}};
+
+constexpr uint16_t {symbol}_fast_levels[] = {{
+{_format_values(row_levels, 4, 14)}
+}};
+
+constexpr HyphenationFastTable {symbol}_fast_table = {{
+    {symbol}_fast_classes,
+    {symbol}_fast_entries,
+    {symbol}_fast_levels,
+    {len(row_levels)},
+    {class_count},
+}};
+
 constexpr SerializedHyphenationPatterns {patterns_symbol} = {{
     {data_symbol},
     sizeof({data_symbol}),
+    &{symbol}_fast_table,
 }};
 """
     path.write_text(content)
@@ -63,6 +167,8 @@ def main() -> None:
                         help='Path to a hypher-generated .bin trie')
     parser.add_argument('--output', dest='outputs', action='append', required=True,
                         help='Destination header path (hyph-*.trie.h)')
+    parser.add_argument('--fast-table-budget', type=int, default=8192,
+                        help='Maximum size in bytes of the flattened top-level transition table')
     args = parser.parse_args()
 
     if len(args.inputs) != len(args.outputs):
@@ -74,7 +180,7 @@ def main() -> None:
         blob = src_path.read_bytes()
         out_path = pathlib.Path(dst)
         symbol = _symbol_from_output(out_path)
-        write_header(out_path, blob, symbol)
+        write_header(out_path, blob, symbol, args.fast_table_budget)
         print(f'wrote {dst} ({len(blob)} bytes payload)')
 
 
@@ -171,6 +171,8 @@ class CrossPointSettings {
   uint8_t fadingFix = 0;
   // Use book's embedded CSS styles for EPUB rendering (1 = enabled, 0 = disabled)
   uint8_t embeddedStyle = 1;
+  // Index the words of searched books in their cache so searching them again only scans chapters with matches
+  uint8_t searchIndex = 0;
 
   ~CrossPointSettings() = default;
 
@@ -0,0 +1,689 @@
+#include "LibraryIndex.h"
+
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+#include <Serialization.h>
+#include <ZipFile.h>
+
+#include <algorithm>
+
+#include "util/StringUtils.h"
+
+namespace {
+constexpr uint8_t LIBRARY_INDEX_VERSION = 1;
+constexpr char LIBRARY_INDEX_FILE[] = "/.crosspoint/library.idx";
+constexpr char LIBRARY_INDEX_TMP_FILE[] = "/.crosspoint/library.idx.tmp";
+constexpr char LIBRARY_INDEX_OLD_FILE[] = "/.crosspoint/library.idx.old";
+constexpr char LIBRARY_STRINGS_TMP_FILE[] = "/.crosspoint/library.str.tmp";
+
+constexpr uint32_t HEADER_SIZE = sizeof(uint8_t) + 4 * sizeof(uint32_t);
+// pathHash, dirHash, size, mtime, stringsOffset, format, flags, progress
+constexpr uint32_t RECORD_SIZE = sizeof(uint64_t) + 4 * sizeof(uint32_t) + 3 * sizeof(uint8_t);
+// Order tables store record positions as u16
+constexpr uint32_t MAX_ENTRIES = 65535;
+// Staged changes are merged into the file once this many pile up, e.g. while a new SD card is first browsed
+constexpr size_t MAX_PENDING = 256;
+
+constexpr uint8_t FLAG_METADATA = 0x01;
+
+uint64_t hashPath(const std::string& path) { return ZipFile::fnvHash64(path.c_str(), path.size()); }
+
+std::string parentDir(const std::string& path) {
+  const size_t lastSlash = path.find_last_of('/');
+  if (lastSlash == std::string::npos || lastSlash == 0) {
+    return "/";
+  }
+  return path.substr(0, lastSlash);
+}
+
+uint32_t hashDir(std::string dirPath) {
+  while (dirPath.size() > 1 && dirPath.back() == '/') {
+    dirPath.pop_back();
+  }
+  return static_cast<uint32_t>(hashPath(dirPath));
+}
+
+std::string fileName(const std::string& path) {
+  const size_t lastSlash = path.find_last_of('/');
+  return lastSlash == std::string::npos ? path : path.substr(lastSlash + 1);
+}
+
+char fold(const char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+bool foldedLess(const std::string& a, const std::string& b) {
+  return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](const char x, const char y) {
+    return static_cast<uint8_t>(fold(x)) < static_cast<uint8_t>(fold(y));
+  });
+}
+
+// First 8 case-folded bytes, big-endian, so comparing prefixes agrees with foldedLess
+uint64_t foldedPrefix(const std::string& s) {
+  uint64_t prefix = 0;
+  for (size_t i = 0; i < 8; i++) {
+    prefix = (prefix << 8) | (i < s.size() ? static_cast<uint8_t>(fold(s[i])) : 0);
+  }
+  return prefix;
+}
+
+std::string sortString(const LibraryIndex::Order order, const LibraryEntry& entry) {
+  const std::string& title = entry.title.empty() ? fileName(entry.path) : entry.title;
+  if (order == LibraryIndex::Order::Title) {
+    return title;
+  }
+  // Books without an author go last, then by author and title
+  return (entry.author.empty() ? std::string("\xff") : entry.author) + '\x01' + title;
+}
+
+void writeRecord(FsFile& out, const uint64_t pathHash, const uint32_t stringsOffset, const LibraryEntry& entry) {
+  serialization::writePod(out, pathHash);
+  serialization::writePod(out, hashDir(parentDir(entry.path)));
+  serialization::writePod(out, entry.size);
+  serialization::writePod(out, entry.mtime);
+  serialization::writePod(out, stringsOffset);
+  serialization::writePod(out, static_cast<uint8_t>(entry.format));
+  serialization::writePod(out, static_cast<uint8_t>(entry.hasMetadata ? FLAG_METADATA : 0));
+  serialization::writePod(out, entry.progress);
+}
+
+void writeStrings(FsFile& out, const LibraryEntry& entry) {
+  serialization::writeString(out, entry.path);
+  serialization::writeString(out, entry.title);
+  serialization::writeString(out, entry.author);
+  serialization::writeString(out, entry.coverBmpPath);
+}
+
+void readStrings(FsFile& in, LibraryEntry& entry) {
+  serialization::readString(in, entry.path);
+  serialization::readString(in, entry.title);
+  serialization::readString(in, entry.author);
+  serialization::readString(in, entry.coverBmpPath);
+}
+
+uint32_t stringsSize(const LibraryEntry& entry) {
+  return 4 * sizeof(uint32_t) + entry.path.size() + entry.title.size() + entry.author.size() +
+         entry.coverBmpPath.size();
+}
+
+bool sameStrings(const LibraryEntry& a, const LibraryEntry& b) {
+  return a.path == b.path && a.title == b.title && a.author == b.author && a.coverBmpPath == b.coverBmpPath;
+}
+
+bool sameEntry(const LibraryEntry& a, const LibraryEntry& b) {
+  return sameStrings(a, b) && a.size == b.size && a.mtime == b.mtime && a.format == b.format &&
+         a.hasMetadata == b.hasMetadata && a.progress == b.progress;
+}
+
+bool renameFile(const char* from, const char* to) {
+  FsFile f;
+  if (!SdMan.openFileForRead("LIB", from, f)) {
+    return false;
+  }
+  const bool renamed = f.rename(to);
+  f.close();
+  return renamed;
+}
+
+// Size and FAT modify time of a file, so an index entry can tell when the book was replaced
+void statFile(const std::string& path, LibraryEntry& entry) {
+  FsFile f;
+  if (!SdMan.openFileForRead("LIB", path, f)) {
+    return;
+  }
+  entry.size = static_cast<uint32_t>(f.size());
+  uint16_t date = 0, time = 0;
+  if (f.getModifyDateTime(&date, &time)) {
+    entry.mtime = (static_cast<uint32_t>(date) << 16) | time;
+  }
+  f.close();
+}
+
+LibraryEntry scannedEntry(const LibraryIndex::ScannedFile& scanned) {
+  LibraryEntry entry;
+  entry.path = scanned.path;
+  entry.title = fileName(scanned.path);
+  entry.size = scanned.size;
+  entry.mtime = scanned.mtime;
+  entry.format = LibraryIndex::formatForPath(scanned.path);
+  return entry;
+}
+
+// Write the u16 record positions of one order table. Records are sorted by an 8 byte prefix of their sort string
+// first, only runs sharing a prefix have their full strings read back for an exact order.
+void writeOrderTable(FsFile& out, FsFile& strings, const std::vector<uint32_t>& stringOffsets,
+                     const LibraryIndex::Order order) {
+  struct SortKey {
+    uint64_t prefix;
+    uint16_t position;
+  };
+  const auto count = static_cast<uint32_t>(stringOffsets.size());
+  std::vector<SortKey> keys;
+  keys.reserve(count);
+
+  strings.seek(0);
+  LibraryEntry entry;
+  for (uint32_t i = 0; i < count; i++) {
+    readStrings(strings, entry);
+    keys.push_back({foldedPrefix(sortString(order, entry)), static_cast<uint16_t>(i)});
+  }
+  std::sort(keys.begin(), keys.end(), [](const SortKey& a, const SortKey& b) {
+    return a.prefix < b.prefix || (a.prefix == b.prefix && a.position < b.position);
+  });
+
+  std::vector<std::pair<std::string, uint16_t>> run;
+  for (uint32_t start = 0; start < count;) {
+    uint32_t end = start + 1;
+    while (end < count && keys[end].prefix == keys[start].prefix) {
+      end++;
+    }
+    if (end - start > 1) {
+      run.clear();
+      for (uint32_t i = start; i < end; i++) {
+        strings.seek(stringOffsets[keys[i].position]);
+        readStrings(strings, entry);
+        run.emplace_back(sortString(order, entry), keys[i].position);
+      }
+      std::stable_sort(run.begin(), run.end(), [](const std::pair<std::string, uint16_t>& a,
+                                                  const std::pair<std::string, uint16_t>& b) {
+        return foldedLess(a.first, b.first);
+      });
+      for (uint32_t i = start; i < end; i++) {
+        keys[i].position = run[i - start].second;
+      }
+    }
+    start = end;
+  }
+
+  for (const auto& key : keys) {
+    serialization::writePod(out, key.position);
+  }
+}
+}  // namespace
+
+LibraryIndex LibraryIndex::instance;
+
+uint64_t LibraryIndex::pathHash(const std::string& path) { return hashPath(path); }
+
+LibraryEntry::Format LibraryIndex::formatForPath(const std::string& path) {
+  if (StringUtils::checkFileExtension(path, ".epub")) {
+    return LibraryEntry::Format::Epub;
+  }
+  if (StringUtils::checkFileExtension(path, ".xtch") || StringUtils::checkFileExtension(path, ".xtc")) {
+    return LibraryEntry::Format::Xtc;
+  }
+  if (StringUtils::checkFileExtension(path, ".txt") || StringUtils::checkFileExtension(path, ".md")) {
+    return LibraryEntry::Format::Txt;
+  }
+  return LibraryEntry::Format::Unknown;
+}
+
+bool LibraryIndex::openIndex() {
+  if (opened) {
+    return true;
+  }
+  // A crash while commit() swapped a new index in can leave only the old one, set aside
+  if (!SdMan.exists(LIBRARY_INDEX_FILE) &&
+      !(SdMan.exists(LIBRARY_INDEX_OLD_FILE) && renameFile(LIBRARY_INDEX_OLD_FILE, LIBRARY_INDEX_FILE))) {
+    return false;
+  }
+  if (!SdMan.openFileForRead("LIB", LIBRARY_INDEX_FILE, file)) {
+    return false;
+  }
+
+  uint8_t version;
+  serialization::readPod(file, version);
+  if (version != LIBRARY_INDEX_VERSION) {
+    Serial.printf("[%lu] [LIB] Unknown library index version %u\n", millis(), version);
+    file.close();
+    return false;
+  }
+  serialization::readPod(file, header.count);
+  serialization::readPod(file, header.titleIndexOffset);
+  serialization::readPod(file, header.authorIndexOffset);
+  serialization::readPod(file, header.stringsOffset);
+
+  if (header.count > MAX_ENTRIES || header.titleIndexOffset != HEADER_SIZE + header.count * RECORD_SIZE ||
+      header.authorIndexOffset != header.titleIndexOffset + header.count * sizeof(uint16_t) ||
+      header.stringsOffset != header.authorIndexOffset + header.count * sizeof(uint16_t) ||
+      file.size() < header.stringsOffset) {
+    Serial.printf("[%lu] [LIB] Library index is corrupt, ignoring it\n", millis());
+    file.close();
+    return false;
+  }
+
+  opened = true;
+  return true;
+}
+
+void LibraryIndex::close() {
+  if (file) {
+    file.close();
+  }
+  opened = false;
+}
+
+uint32_t LibraryIndex::getCount() { return openIndex() ? header.count : 0; }
+
+bool LibraryIndex::readRecord(const uint32_t index, Record& out) {
+  if (!openIndex() || index >= header.count) {
+    return false;
+  }
+  file.seek(HEADER_SIZE + index * RECORD_SIZE);
+  serialization::readPod(file, out.pathHash);
+  serialization::readPod(file, out.dirHash);
+  serialization::readPod(file, out.size);
+  serialization::readPod(file, out.mtime);
+  serialization::readPod(file, out.stringsOffset);
+  serialization::readPod(file, out.format);
+  serialization::readPod(file, out.flags);
+  serialization::readPod(file, out.progress);
+  return true;
+}
+
+bool LibraryIndex::readEntry(const Record& record, LibraryEntry& out) {
+  if (!openIndex() || !file.seek(header.stringsOffset + record.stringsOffset)) {
+    return false;
+  }
+  readStrings(file, out);
+  out.size = record.size;
+  out.mtime = record.mtime;
+  out.format = static_cast<LibraryEntry::Format>(record.format);
+  out.hasMetadata = (record.flags & FLAG_METADATA) != 0;
+  out.progress = record.progress;
+  return true;
+}
+
+int32_t LibraryIndex::findRecord(const uint64_t pathHash, Record& out) {
+  if (!openIndex()) {
+    return -1;
+  }
+  uint32_t low = 0;
+  uint32_t high = header.count;
+  while (low < high) {
+    const uint32_t mid = low + (high - low) / 2;
+    if (!readRecord(mid, out)) {
+      return -1;
+    }
+    if (out.pathHash < pathHash) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low < header.count && readRecord(low, out) && out.pathHash == pathHash) {
+    return static_cast<int32_t>(low);
+  }
+  return -1;
+}
+
+LibraryIndex::Change* LibraryIndex::findPending(const uint64_t pathHash) {
+  const auto it =
+      std::find_if(pending.begin(), pending.end(), [&](const Change& change) { return change.pathHash == pathHash; });
+  return it == pending.end() ? nullptr : &*it;
+}
+
+bool LibraryIndex::find(const std::string& path, LibraryEntry& out) {
+  const uint64_t pathHash = hashPath(path);
+  if (const Change* change = findPending(pathHash)) {
+    if (change->removed) {
+      return false;
+    }
+    out = change->entry;
+    return true;
+  }
+
+  Record record;
+  return findRecord(pathHash, record) >= 0 && readEntry(record, out) && out.path == path;
+}
+
+bool LibraryIndex::getSorted(const Order order, const uint32_t position, LibraryEntry& out) {
+  if (!openIndex() || position >= header.count) {
+    return false;
+  }
+  uint16_t index;
+  file.seek((order == Order::Title ? header.titleIndexOffset : header.authorIndexOffset) +
+            position * sizeof(uint16_t));
+  serialization::readPod(file, index);
+
+  Record record;
+  return readRecord(index, record) && readEntry(record, out);
+}
+
+void LibraryIndex::stage(LibraryEntry entry) {
+  const uint64_t pathHash = hashPath(entry.path);
+  if (Change* change = findPending(pathHash)) {
+    change->removed = false;
+    change->entry = std::move(entry);
+  } else {
+    pending.push_back({pathHash, false, std::move(entry)});
+  }
+  if (pending.size() >= MAX_PENDING) {
+    commit();
+  }
+}
+
+void LibraryIndex::recordBook(const std::string& path, const std::string& title, const std::string& author,
+                              const std::string& coverBmpPath) {
+  LibraryEntry previous;
+  const bool known = find(path, previous);
+
+  LibraryEntry entry;
+  entry.path = path;
+  entry.title = title.empty() ? fileName(path) : title;
+  entry.author = author;
+  entry.coverBmpPath = coverBmpPath;
+  entry.format = formatForPath(path);
+  entry.hasMetadata = true;
+  statFile(path, entry);
+  // Progress only survives as long as it's the same file
+  if (known && previous.size == entry.size && previous.mtime == entry.mtime) {
+    entry.progress = previous.progress;
+  }
+
+  if (!known || !sameEntry(previous, entry)) {
+    stage(std::move(entry));
+  }
+}
+
+void LibraryIndex::recordProgress(const std::string& path, const uint8_t progress) {
+  LibraryEntry entry;
+  if (!find(path, entry)) {
+    entry.path = path;
+    entry.title = fileName(path);
+    entry.format = formatForPath(path);
+    statFile(path, entry);
+  } else if (entry.progress == progress) {
+    return;
+  }
+  entry.progress = progress;
+  stage(std::move(entry));
+}
+
+void LibraryIndex::removeBook(const std::string& path) {
+  const uint64_t pathHash = hashPath(path);
+  if (Change* change = findPending(pathHash)) {
+    change->removed = true;
+    return;
+  }
+  Record record;
+  if (findRecord(pathHash, record) >= 0) {
+    LibraryEntry entry;
+    entry.path = path;
+    pending.push_back({pathHash, true, std::move(entry)});
+  }
+}
+
+void LibraryIndex::moveBook(const std::string& oldPath, const std::string& newPath) {
+  LibraryEntry entry;
+  const bool known = find(oldPath, entry);
+  removeBook(oldPath);
+  if (formatForPath(newPath) == LibraryEntry::Format::Unknown) {
+    return;
+  }
+  // Without metadata of its own the book is titled by its file name
+  if (!known || !entry.hasMetadata) {
+    entry.title.clear();
+  }
+  entry.path = newPath;
+  entry.format = formatForPath(newPath);
+  if (entry.title.empty()) {
+    entry.title = fileName(newPath);
+  }
+  // A rename keeps the FAT modify time, so this only fills size and time in for a book the index didn't know
+  statFile(newPath, entry);
+  stage(std::move(entry));
+}
+
+void LibraryIndex::syncDirectory(const std::string& dirPath, const std::vector<ScannedFile>& files) {
+  std::vector<ScannedBook> books;
+  books.reserve(files.size());
+  for (const auto& file : files) {
+    books.push_back({hashPath(file.path), file.size, file.mtime});
+  }
+  const auto changed = syncDirectories({dirPath}, books);
+  for (const auto& file : files) {
+    if (std::binary_search(changed.begin(), changed.end(), hashPath(file.path))) {
+      addScanned(file);
+    }
+  }
+  commit();
+}
+
+std::vector<uint64_t> LibraryIndex::syncDirectories(const std::vector<std::string>& dirPaths,
+                                                    std::vector<ScannedBook>& books) {
+  std::vector<uint32_t> dirHashes;
+  dirHashes.reserve(dirPaths.size());
+  for (const auto& dirPath : dirPaths) {
+    dirHashes.push_back(hashDir(dirPath));
+  }
+  std::sort(dirHashes.begin(), dirHashes.end());
+  std::sort(books.begin(), books.end(),
+            [](const ScannedBook& a, const ScannedBook& b) { return a.pathHash < b.pathHash; });
+
+  // Walk the records and the books in hash order together, collecting removals first since staging may commit
+  std::vector<uint64_t> changed;
+  std::vector<std::string> removed;
+  const uint32_t count = getCount();
+  uint32_t recordIndex = 0;
+  size_t bookIndex = 0;
+  Record record;
+  while (bookIndex < books.size() || recordIndex < count) {
+    if (recordIndex < count && !readRecord(recordIndex, record)) {
+      break;
+    }
+    const bool recordFirst =
+        recordIndex < count && (bookIndex == books.size() || record.pathHash < books[bookIndex].pathHash);
+    if (recordFirst) {
+      if (std::binary_search(dirHashes.begin(), dirHashes.end(), record.dirHash)) {
+        LibraryEntry entry;
+        if (readEntry(record, entry) &&
+            std::binary_search(dirHashes.begin(), dirHashes.end(), hashDir(parentDir(entry.path)))) {
+          removed.push_back(std::move(entry.path));
+        }
+      }
+      recordIndex++;
+      continue;
+    }
+
+    const ScannedBook& book = books[bookIndex];
+    if (recordIndex < count && record.pathHash == book.pathHash) {
+      if (record.size != book.size || record.mtime != book.mtime) {
+        changed.push_back(book.pathHash);
+      }
+      recordIndex++;
+    } else {
+      changed.push_back(book.pathHash);
+    }
+    bookIndex++;
+  }
+
+  if (!removed.empty() || !changed.empty()) {
+    Serial.printf("[%lu] [LIB] %d folders: %d new or changed, %d removed\n", millis(), dirPaths.size(),
+                  changed.size(), removed.size());
+  }
+  for (const auto& path : removed) {
+    removeBook(path);
+  }
+  return changed;
+}
+
+void LibraryIndex::addScanned(const ScannedFile& file) {
+  // Something staged since is newer than the scan
+  if (!findPending(hashPath(file.path))) {
+    stage(scannedEntry(file));
+  }
+}
+
+bool LibraryIndex::patchRecords() {
+  // Records are fixed size, so changes that keep a book's strings, and with them both order tables, can be written
+  // over the book's record. Anything else needs the index rebuilt.
+  std::vector<std::pair<uint32_t, uint32_t>> patches;
+  patches.reserve(pending.size());
+  Record record;
+  LibraryEntry stored;
+  for (const auto& change : pending) {
+    if (change.removed) {
+      return false;
+    }
+    const int32_t index = findRecord(change.pathHash, record);
+    if (index < 0 || !readEntry(record, stored) || !sameStrings(stored, change.entry)) {
+      return false;
+    }
+    patches.emplace_back(static_cast<uint32_t>(index), record.stringsOffset);
+  }
+
+  close();
+  FsFile out = SdMan.open(LIBRARY_INDEX_FILE, O_RDWR);
+  if (!out) {
+    return false;
+  }
+  for (size_t i = 0; i < pending.size(); i++) {
+    out.seek(HEADER_SIZE + patches[i].first * RECORD_SIZE);
+    writeRecord(out, pending[i].pathHash, patches[i].second, pending[i].entry);
+  }
+  out.close();
+  return true;
+}
+
+bool LibraryIndex::commit() {
+  if (pending.empty()) {
+    return true;
+  }
+  const auto start = millis();
+  // Progress, size and modify time updates are the common case, e.g. every time a book is closed
+  if (patchRecords()) {
+    Serial.printf("[%lu] [LIB] Library index updated in place (%d changes) in %lu ms\n", millis(), pending.size(),
+                  millis() - start);
+    pending.clear();
+    return true;
+  }
+  std::sort(pending.begin(), pending.end(),
+            [](const Change& a, const Change& b) { return a.pathHash < b.pathHash; });
+
+  // The merged count is needed up front for the header, a pass over the record hashes gives it
+  const uint32_t oldCount = getCount();
+  uint32_t newCount = 0;
+  Record record;
+  for (uint32_t i = 0, j = 0; i < oldCount || j < pending.size();) {
+    if (i < oldCount && !readRecord(i, record)) {
+      break;
+    }
+    if (j == pending.size() || (i < oldCount && record.pathHash < pending[j].pathHash)) {
+      newCount++;
+      i++;
+      continue;
+    }
+    if (!pending[j].removed) {
+      newCount++;
+    }
+    if (i < oldCount && record.pathHash == pending[j].pathHash) {
+      i++;
+    }
+    j++;
+  }
+  if (newCount > MAX_ENTRIES) {
+    Serial.printf("[%lu] [LIB] Library index full, dropping %d changes\n", millis(), pending.size());
+    pending.clear();
+    return false;
+  }
+
+  SdMan.mkdir("/.crosspoint");
+  FsFile indexFile, stringsFile;
+  if (!SdMan.openFileForWrite("LIB", LIBRARY_INDEX_TMP_FILE, indexFile)) {
+    return false;
+  }
+  if (!SdMan.openFileForWrite("LIB", LIBRARY_STRINGS_TMP_FILE, stringsFile)) {
+    indexFile.close();
+    SdMan.remove(LIBRARY_INDEX_TMP_FILE);
+    return false;
+  }
+
+  const uint32_t titleIndexOffset = HEADER_SIZE + newCount * RECORD_SIZE;
+  const uint32_t authorIndexOffset = titleIndexOffset + newCount * sizeof(uint16_t);
+  const uint32_t stringsOffset = authorIndexOffset + newCount * sizeof(uint16_t);
+  serialization::writePod(indexFile, LIBRARY_INDEX_VERSION);
+  serialization::writePod(indexFile, newCount);
+  serialization::writePod(indexFile, titleIndexOffset);
+  serialization::writePod(indexFile, authorIndexOffset);
+  serialization::writePod(indexFile, stringsOffset);
+
+  // Records go straight into the index file, their strings into a side file appended at the end
+  std::vector<uint32_t> stringOffsets;
+  stringOffsets.reserve(newCount);
+  uint32_t stringsPosition = 0;
+  LibraryEntry entry;
+  const auto emit = [&](const uint64_t pathHash, const LibraryEntry& e) {
+    writeRecord(indexFile, pathHash, stringsPosition, e);
+    writeStrings(stringsFile, e);
+    stringOffsets.push_back(stringsPosition);
+    stringsPosition += stringsSize(e);
+  };
+  for (uint32_t i = 0, j = 0; i < oldCount || j < pending.size();) {
+    if (i < oldCount && !readRecord(i, record)) {
+      break;
+    }
+    if (j == pending.size() || (i < oldCount && record.pathHash < pending[j].pathHash)) {
+      if (readEntry(record, entry)) {
+        emit(record.pathHash, entry);
+      }
+      i++;
+      continue;
+    }
+    if (!pending[j].removed) {
+      emit(pending[j].pathHash, pending[j].entry);
+    }
+    if (i < oldCount && record.pathHash == pending[j].pathHash) {
+      i++;
+    }
+    j++;
+  }
+  stringsFile.close();
+  close();
+
+  bool ok = stringOffsets.size() == newCount && SdMan.openFileForRead("LIB", LIBRARY_STRINGS_TMP_FILE, stringsFile);
+  if (ok) {
+    writeOrderTable(indexFile, stringsFile, stringOffsets, Order::Title);
+    writeOrderTable(indexFile, stringsFile, stringOffsets, Order::Author);
+    uint8_t buffer[512];
+    stringsFile.seek(0);
+    int read;
+    while ((read = stringsFile.read(buffer, sizeof(buffer))) > 0) {
+      if (indexFile.write(buffer, read) != static_cast<size_t>(read)) {
+        ok = false;
+        break;
+      }
+    }
+  }
+  if (stringsFile) {
+    stringsFile.close();
+  }
+  indexFile.close();
+  SdMan.remove(LIBRARY_STRINGS_TMP_FILE);
+
+  if (!ok) {
+    Serial.printf("[%lu] [LIB] Failed to write library index\n", millis());
+    SdMan.remove(LIBRARY_INDEX_TMP_FILE);
+    return false;
+  }
+
+  // Swap the new index in by renames. The old one is only set aside until the new one is in place, and openIndex()
+  // puts it back if a crash came in between, so there is always an index to fall back on.
+  if (SdMan.exists(LIBRARY_INDEX_OLD_FILE)) {
+    SdMan.remove(LIBRARY_INDEX_OLD_FILE);
+  }
+  if (SdMan.exists(LIBRARY_INDEX_FILE) && !renameFile(LIBRARY_INDEX_FILE, LIBRARY_INDEX_OLD_FILE)) {
+    Serial.printf("[%lu] [LIB] Could not set the old library index aside\n", millis());
+    SdMan.remove(LIBRARY_INDEX_TMP_FILE);
+    return false;
+  }
+  if (!renameFile(LIBRARY_INDEX_TMP_FILE, LIBRARY_INDEX_FILE)) {
+    Serial.printf("[%lu] [LIB] Could not move library index into place\n", millis());
+    renameFile(LIBRARY_INDEX_OLD_FILE, LIBRARY_INDEX_FILE);
+    return false;
+  }
+  SdMan.remove(LIBRARY_INDEX_OLD_FILE);
+
+  Serial.printf("[%lu] [LIB] Library index saved (%d entries, %d changes) in %lu ms\n", millis(), newCount,
+                pending.size(), millis() - start);
+  pending.clear();
+  return true;
+}
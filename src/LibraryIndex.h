@@ -0,0 +1,126 @@
+#pragma once
+#include <SdFat.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct LibraryEntry {
+  enum class Format : uint8_t { Unknown = 0, Epub = 1, Xtc = 2, Txt = 3 };
+
+  std::string path;
+  std::string title;  // File name until the book has been opened
+  std::string author;
+  std::string coverBmpPath;
+  uint32_t size = 0;
+  uint32_t mtime = 0;  // FAT modify date in the high half, time in the low half
+  Format format = Format::Unknown;
+  bool hasMetadata = false;  // Title, author and cover come from the book itself
+  uint8_t progress = 0;      // Percent read
+};
+
+/**
+ * Library-wide metadata index in /.crosspoint/library.idx, so listing books with their titles, authors, covers and
+ * progress never has to open the books or their caches.
+ *
+ * The index stays on the SD card. Fixed-size records sorted by path hash are binary searched for lookups, and two
+ * position tables hold the records in title and author order. Changes are staged in RAM. commit() writes changes
+ * that leave titles, authors and paths alone, like reading progress, over their records in place, and merges
+ * anything else into a new file, reading the old one sequentially so memory use doesn't grow with the library.
+ */
+class LibraryIndex {
+  // Static instance
+  static LibraryIndex instance;
+
+ public:
+  enum class Order : uint8_t { Title, Author };
+
+  // Get singleton instance
+  static LibraryIndex& getInstance() { return instance; }
+
+  static LibraryEntry::Format formatForPath(const std::string& path);
+
+  // Look a book up by path, including staged changes
+  bool find(const std::string& path, LibraryEntry& out);
+  // Number of committed entries
+  uint32_t getCount();
+  // The entry at position in title or author order
+  bool getSorted(Order order, uint32_t position, LibraryEntry& out);
+
+  // Record metadata for a book that was just opened, keeping its progress
+  void recordBook(const std::string& path, const std::string& title, const std::string& author,
+                  const std::string& coverBmpPath);
+  void recordProgress(const std::string& path, uint8_t progress);
+  void removeBook(const std::string& path);
+  // Carry a renamed or moved book's entry, with its metadata and progress, over to its new path
+  void moveBook(const std::string& oldPath, const std::string& newPath);
+
+  static uint64_t pathHash(const std::string& path);
+
+  struct ScannedFile {
+    std::string path;
+    uint32_t size;
+    uint32_t mtime;
+  };
+  // A book found by a scan of many directories, without its path so a big library stays small in RAM
+  struct ScannedBook {
+    uint64_t pathHash;
+    uint32_t size;
+    uint32_t mtime;
+  };
+  // Bring the entries of one directory in line with a listing of its books: new or changed files are (re)added
+  // under their file name and entries for files that are gone are removed.
+  void syncDirectory(const std::string& dirPath, const std::vector<ScannedFile>& files);
+  // The same for a set of directories and all their books, in one pass over the index. Entries for books that are
+  // gone are staged for removal, and the sorted path hashes of new or changed books are returned for the caller to
+  // stage with addScanned(). Nothing is committed.
+  std::vector<uint64_t> syncDirectories(const std::vector<std::string>& dirPaths, std::vector<ScannedBook>& books);
+  // Stage a new or changed file found by a scan under its file name, unless something newer is staged already
+  void addScanned(const ScannedFile& file);
+
+  // Merge staged changes into the index file
+  bool commit();
+  // Close the index file kept open for lookups
+  void close();
+
+ private:
+  struct Header {
+    uint32_t count = 0;
+    uint32_t titleIndexOffset = 0;
+    uint32_t authorIndexOffset = 0;
+    uint32_t stringsOffset = 0;
+  };
+  struct Record {
+    uint64_t pathHash = 0;
+    uint32_t dirHash = 0;
+    uint32_t size = 0;
+    uint32_t mtime = 0;
+    uint32_t stringsOffset = 0;
+    uint8_t format = 0;
+    uint8_t flags = 0;
+    uint8_t progress = 0;
+  };
+  struct Change {
+    uint64_t pathHash;
+    bool removed;
+    LibraryEntry entry;
+  };
+
+  FsFile file;
+  Header header;
+  bool opened = false;
+  std::vector<Change> pending;
+
+  bool openIndex();
+  bool readRecord(uint32_t index, Record& out);
+  bool readEntry(const Record& record, LibraryEntry& out);
+  // Binary search for a path hash, returns the record index or -1
+  int32_t findRecord(uint64_t pathHash, Record& out);
+  Change* findPending(uint64_t pathHash);
+  void stage(LibraryEntry entry);
+  // Write pending changes over their records if none of them needs the index rebuilt
+  bool patchRecords();
+};
+
+// Helper macro to access the library index
+#define LIBRARY_INDEX LibraryIndex::getInstance()
@@ -8,6 +8,7 @@
 
 #include <algorithm>
 
+#include "LibraryIndex.h"
 #include "util/StringUtils.h"
 
 namespace {
@@ -85,6 +86,12 @@ RecentBook RecentBooksStore::getDataFromBook(std::string path) const {
 
   Serial.printf("Loading recent book: %s\n", path.c_str());
 
+  // The library index usually knows the book already, which saves opening it
+  LibraryEntry entry;
+  if (LIBRARY_INDEX.find(path, entry) && entry.hasMetadata) {
+    return RecentBook{path, entry.title, entry.author, entry.coverBmpPath};
+  }
+
   // If epub, try to load the metadata for title/author and cover
   if (StringUtils::checkFileExtension(lastBookFileName, ".epub")) {
     Epub epub(path, "/.crosspoint");
@@ -11,8 +11,15 @@
 #include "components/UITheme.h"
 #include "fontIds.h"
 #include "images/Logo120.h"
+#include "util/ScreenSnapshot.h"
 #include "util/StringUtils.h"
 
+namespace {
+// One snapshot per sleep screen mode, each replaced when its screen changes
+constexpr char CUSTOM_SNAPSHOT_SLOT[] = "sleep-custom";
+constexpr char COVER_SNAPSHOT_SLOT[] = "sleep-cover";
+}  // namespace
+
 void SleepActivity::onEnter() {
   Activity::onEnter();
   GUI.drawPopup(renderer, "Entering Sleep...");
@@ -74,16 +81,11 @@ void SleepActivity::renderCustomSleepScreen() const {
       APP_STATE.lastSleepImage = randomFileIndex;
       APP_STATE.saveToFile();
       const auto filename = "/sleep/" + files[randomFileIndex];
-      FsFile file;
-      if (SdMan.openFileForRead("SLP", filename, file)) {
-        Serial.printf("[%lu] [SLP] Randomly loading: /sleep/%s\n", millis(), files[randomFileIndex].c_str());
-        delay(100);
-        Bitmap bitmap(file, true);
-        if (bitmap.parseHeaders() == BmpReaderError::Ok) {
-          renderBitmapSleepScreen(bitmap);
-          dir.close();
-          return;
-        }
+      Serial.printf("[%lu] [SLP] Randomly loading: /sleep/%s\n", millis(), files[randomFileIndex].c_str());
+      delay(100);
+      if (renderBmpFileSleepScreen(filename, true, CUSTOM_SNAPSHOT_SLOT)) {
+        dir.close();
+        return;
       }
     }
   }
@@ -91,12 +93,9 @@ void SleepActivity::renderCustomSleepScreen() const {
 
   // Look for sleep.bmp on the root of the sd card to determine if we should
   // render a custom sleep screen instead of the default.
-  FsFile file;
-  if (SdMan.openFileForRead("SLP", "/sleep.bmp", file)) {
-    Bitmap bitmap(file, true);
-    if (bitmap.parseHeaders() == BmpReaderError::Ok) {
-      Serial.printf("[%lu] [SLP] Loading: /sleep.bmp\n", millis());
-      renderBitmapSleepScreen(bitmap);
+  if (SdMan.exists("/sleep.bmp")) {
+    Serial.printf("[%lu] [SLP] Loading: /sleep.bmp\n", millis());
+    if (renderBmpFileSleepScreen("/sleep.bmp", true, CUSTOM_SNAPSHOT_SLOT)) {
       return;
     }
   }
@@ -121,7 +120,53 @@ void SleepActivity::renderDefaultSleepScreen() const {
   renderer.displayBuffer(HalDisplay::HALF_REFRESH);
 }
 
-void SleepActivity::renderBitmapSleepScreen(const Bitmap& bitmap) const {
+std::string SleepActivity::getSleepSnapshotKey(const std::string& bmpPath, const bool dithering) const {
+  return "sleep|" + ScreenSnapshot::describeSource(bmpPath) + "|o" + std::to_string(renderer.getOrientation()) +
+         "|m" + std::to_string(SETTINGS.sleepScreenCoverMode) + "|f" + std::to_string(SETTINGS.sleepScreenCoverFilter) +
+         "|d" + std::to_string(dithering);
+}
+
+bool SleepActivity::renderSleepSnapshot(ScreenSnapshot& snapshot) const {
+  uint8_t* frameBuffer = renderer.getFrameBuffer();
+  if (!frameBuffer || !snapshot.openForRead() || !snapshot.readPlane(frameBuffer)) {
+    return false;
+  }
+
+  Serial.printf("[%lu] [SLP] Rendering sleep screen from snapshot\n", millis());
+  renderer.displayBuffer(HalDisplay::HALF_REFRESH);
+
+  // The BW image is already on screen, so a failed grayscale read just leaves it as is
+  if (snapshot.getPlaneCount() == 3 && snapshot.readPlane(frameBuffer)) {
+    renderer.copyGrayscaleLsbBuffers();
+    if (snapshot.readPlane(frameBuffer)) {
+      renderer.copyGrayscaleMsbBuffers();
+      renderer.displayGrayBuffer();
+    }
+  }
+  snapshot.close();
+  return true;
+}
+
+bool SleepActivity::renderBmpFileSleepScreen(const std::string& bmpPath, const bool dithering,
+                                             const char* snapshotSlot) const {
+  ScreenSnapshot snapshot(getSleepSnapshotKey(bmpPath, dithering), snapshotSlot);
+  if (renderSleepSnapshot(snapshot)) {
+    return true;
+  }
+
+  FsFile file;
+  if (!SdMan.openFileForRead("SLP", bmpPath, file)) {
+    return false;
+  }
+  Bitmap bitmap(file, dithering);
+  if (bitmap.parseHeaders() != BmpReaderError::Ok) {
+    return false;
+  }
+  renderBitmapSleepScreen(bitmap, &snapshot);
+  return true;
+}
+
+void SleepActivity::renderBitmapSleepScreen(const Bitmap& bitmap, ScreenSnapshot* snapshot) const {
   int x, y;
   const auto pageWidth = renderer.getScreenWidth();
   const auto pageHeight = renderer.getScreenHeight();
@@ -174,6 +219,11 @@ void SleepActivity::renderBitmapSleepScreen(const Bitmap& bitmap) const {
     renderer.invertScreen();
   }
 
+  // Keep each finished plane so the next sleep with the same image and settings skips all of this
+  if (snapshot && snapshot->openForWrite(hasGreyscale ? 3 : 1)) {
+    snapshot->writePlane(renderer.getFrameBuffer());
+  }
+
   renderer.displayBuffer(HalDisplay::HALF_REFRESH);
 
   if (hasGreyscale) {
@@ -181,12 +231,14 @@ void SleepActivity::renderBitmapSleepScreen(const Bitmap& bitmap) const {
     renderer.clearScreen(0x00);
     renderer.setRenderMode(GfxRenderer::GRAYSCALE_LSB);
     renderer.drawBitmap(bitmap, x, y, pageWidth, pageHeight, cropX, cropY);
+    if (snapshot) snapshot->writePlane(renderer.getFrameBuffer());
     renderer.copyGrayscaleLsbBuffers();
 
     bitmap.rewindToData();
     renderer.clearScreen(0x00);
     renderer.setRenderMode(GfxRenderer::GRAYSCALE_MSB);
     renderer.drawBitmap(bitmap, x, y, pageWidth, pageHeight, cropX, cropY);
+    if (snapshot) snapshot->writePlane(renderer.getFrameBuffer());
     renderer.copyGrayscaleMsbBuffers();
 
     renderer.displayGrayBuffer();
@@ -261,14 +313,9 @@ void SleepActivity::renderCoverSleepScreen() const {
     return (this->*renderNoCoverSleepScreen)();
   }
 
-  FsFile file;
-  if (SdMan.openFileForRead("SLP", coverBmpPath, file)) {
-    Bitmap bitmap(file);
-    if (bitmap.parseHeaders() == BmpReaderError::Ok) {
-      Serial.printf("[SLP] Rendering sleep cover: %s\n", coverBmpPath.c_str());
-      renderBitmapSleepScreen(bitmap);
-      return;
-    }
+  Serial.printf("[SLP] Rendering sleep cover: %s\n", coverBmpPath.c_str());
+  if (renderBmpFileSleepScreen(coverBmpPath, false, COVER_SNAPSHOT_SLOT)) {
+    return;
   }
 
   return (this->*renderNoCoverSleepScreen)();
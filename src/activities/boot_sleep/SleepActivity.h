@@ -1,7 +1,10 @@
 #pragma once
+#include <string>
+
 #include "../Activity.h"
 
 class Bitmap;
+class ScreenSnapshot;
 
 class SleepActivity final : public Activity {
  public:
@@ -13,6 +16,9 @@ class SleepActivity final : public Activity {
   void renderDefaultSleepScreen() const;
   void renderCustomSleepScreen() const;
   void renderCoverSleepScreen() const;
-  void renderBitmapSleepScreen(const Bitmap& bitmap) const;
+  void renderBitmapSleepScreen(const Bitmap& bitmap, ScreenSnapshot* snapshot = nullptr) const;
+  bool renderBmpFileSleepScreen(const std::string& bmpPath, bool dithering, const char* snapshotSlot) const;
+  bool renderSleepSnapshot(ScreenSnapshot& snapshot) const;
+  std::string getSleepSnapshotKey(const std::string& bmpPath, bool dithering) const;
   void renderBlankSleepScreen() const;
 };
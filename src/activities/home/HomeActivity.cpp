@@ -13,12 +13,18 @@
 #include "Battery.h"
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "RecentBooksStore.h"
 #include "components/UITheme.h"
 #include "fontIds.h"
+#include "util/ScreenSnapshot.h"
 #include "util/StringUtils.h"
 
+namespace {
+constexpr char HOME_SNAPSHOT_SLOT[] = "home";
+}  // namespace
+
 void HomeActivity::taskTrampoline(void* param) {
   auto* self = static_cast<HomeActivity*>(param);
   self->displayTaskLoop();
@@ -77,9 +83,15 @@ void HomeActivity::loadRecentCovers(int coverHeight) {
             popupRect = GUI.drawPopup(renderer, "Loading...");
           }
           GUI.fillPopupProgress(renderer, popupRect, 10 + progress * (90 / recentBooks.size()));
-          bool success = epub.generateThumbBmp(coverHeight);
+          // Decode the cover once for every theme's thumbnail size so switching themes doesn't redo the work
+          std::vector<int> thumbHeights = UITheme::getInstance().getCoverThumbHeights();
+          if (thumbHeights.front() != coverHeight) {
+            thumbHeights.insert(thumbHeights.begin(), coverHeight);
+          }
+          bool success = epub.generateThumbBmps(thumbHeights);
           if (!success) {
             RECENT_BOOKS.updateBook(book.path, book.title, book.author, "");
+            LIBRARY_INDEX.recordBook(book.path, book.title, book.author, "");
             book.coverBmpPath = "";
           }
           coverRendered = false;
@@ -98,6 +110,7 @@ void HomeActivity::loadRecentCovers(int coverHeight) {
             bool success = xtc.generateThumbBmp(coverHeight);
             if (!success) {
               RECENT_BOOKS.updateBook(book.path, book.title, book.author, "");
+              LIBRARY_INDEX.recordBook(book.path, book.title, book.author, "");
               book.coverBmpPath = "";
             }
             coverRendered = false;
@@ -109,6 +122,10 @@ void HomeActivity::loadRecentCovers(int coverHeight) {
     progress++;
   }
 
+  // Books without a usable cover are remembered, so the library doesn't try them again either
+  LIBRARY_INDEX.commit();
+  LIBRARY_INDEX.close();
+
   recentsLoaded = true;
   recentsLoading = false;
 }
@@ -149,41 +166,55 @@ void HomeActivity::onExit() {
   vSemaphoreDelete(renderingMutex);
   renderingMutex = nullptr;
 
-  // Free the stored cover buffer if any
   freeCoverBuffer();
 }
 
 bool HomeActivity::storeCoverBuffer() {
-  uint8_t* frameBuffer = renderer.getFrameBuffer();
+  const uint8_t* frameBuffer = renderer.getFrameBuffer();
   if (!frameBuffer) {
     return false;
   }
 
-  // Free any existing buffer first
-  freeCoverBuffer();
+  // Re-renders during this visit copy the covers back from RAM, the snapshot is for the next visit
+  const bool kept = keepCoverBuffer(frameBuffer);
+  ScreenSnapshot snapshot(coverSnapshotKey, HOME_SNAPSHOT_SLOT);
+  const bool saved = snapshot.openForWrite(1) && snapshot.writePlane(frameBuffer);
+  return kept || saved;
+}
 
-  const size_t bufferSize = GfxRenderer::getBufferSize();
-  coverBuffer = static_cast<uint8_t*>(malloc(bufferSize));
-  if (!coverBuffer) {
+bool HomeActivity::restoreCoverBuffer() {
+  uint8_t* frameBuffer = renderer.getFrameBuffer();
+  if (!frameBuffer) {
     return false;
   }
 
-  memcpy(coverBuffer, frameBuffer, bufferSize);
-  return true;
-}
+  if (coverBuffer) {
+    memcpy(frameBuffer, coverBuffer, GfxRenderer::getBufferSize());
+    return true;
+  }
 
-bool HomeActivity::restoreCoverBuffer() {
-  if (!coverBuffer) {
+  ScreenSnapshot snapshot(coverSnapshotKey, HOME_SNAPSHOT_SLOT);
+  if (!snapshot.openForRead() || snapshot.getPlaneCount() != 1) {
     return false;
   }
-
-  uint8_t* frameBuffer = renderer.getFrameBuffer();
-  if (!frameBuffer) {
+  if (!snapshot.readPlane(frameBuffer)) {
+    // Don't leave a partially read snapshot under the freshly drawn covers
+    renderer.clearScreen();
     return false;
   }
+  keepCoverBuffer(frameBuffer);
+  return true;
+}
 
+bool HomeActivity::keepCoverBuffer(const uint8_t* frameBuffer) {
   const size_t bufferSize = GfxRenderer::getBufferSize();
-  memcpy(frameBuffer, coverBuffer, bufferSize);
+  if (!coverBuffer) {
+    coverBuffer = static_cast<uint8_t*>(malloc(bufferSize));
+    if (!coverBuffer) {
+      return false;
+    }
+  }
+  memcpy(coverBuffer, frameBuffer, bufferSize);
   return true;
 }
 
@@ -192,7 +223,19 @@ void HomeActivity::freeCoverBuffer() {
     free(coverBuffer);
     coverBuffer = nullptr;
   }
-  coverBufferStored = false;
+}
+
+std::string HomeActivity::getCoverSnapshotKey() const {
+  // Everything drawn before storeCoverBuffer() is called: the theme's cover tiles for the current thumbnails
+  const auto metrics = UITheme::getInstance().getMetrics();
+  std::string key = "home|t" + std::to_string(SETTINGS.uiTheme) + "|o" + std::to_string(renderer.getOrientation());
+  for (const RecentBook& book : recentBooks) {
+    key += "|";
+    if (!book.coverBmpPath.empty()) {
+      key += ScreenSnapshot::describeSource(UITheme::getCoverThumbPath(book.coverBmpPath, metrics.homeCoverHeight));
+    }
+  }
+  return key;
 }
 
 void HomeActivity::loop() {
@@ -253,14 +296,24 @@ void HomeActivity::render() {
   const auto pageHeight = renderer.getScreenHeight();
 
   renderer.clearScreen();
+  if (!coverRendered) {
+    // Covers are about to be drawn, possibly from new thumbnails. A snapshot from an earlier visit with the same
+    // thumbnails saves decoding them again.
+    freeCoverBuffer();
+    coverSnapshotKey = getCoverSnapshotKey();
+    coverBufferStored = true;
+  }
   bool bufferRestored = coverBufferStored && restoreCoverBuffer();
-
-  GUI.drawHeader(renderer, Rect{0, metrics.topPadding, pageWidth, metrics.homeTopPadding}, nullptr);
+  // Without a usable snapshot the theme draws the covers from the thumbnails again
+  coverRendered = bufferRestored;
 
   GUI.drawRecentBookCover(renderer, Rect{0, metrics.homeTopPadding, pageWidth, metrics.homeCoverTileHeight},
                           recentBooks, selectorIndex, coverRendered, coverBufferStored, bufferRestored,
                           std::bind(&HomeActivity::storeCoverBuffer, this));
 
+  // Drawn after the covers so the battery level never ends up in the snapshot
+  GUI.drawHeader(renderer, Rect{0, metrics.topPadding, pageWidth, metrics.homeTopPadding}, nullptr);
+
   // Build menu items dynamically
   std::vector<const char*> menuItems = {"Browse Files", "Recents", "File Transfer", "Settings"};
   if (hasOpdsUrl) {
@@ -4,6 +4,7 @@
 #include <freertos/task.h>
 
 #include <functional>
+#include <string>
 #include <vector>
 
 #include "../Activity.h"
@@ -22,8 +23,9 @@ class HomeActivity final : public Activity {
   bool firstRenderDone = false;
   bool hasOpdsUrl = false;
   bool coverRendered = false;      // Track if cover has been rendered once
-  bool coverBufferStored = false;  // Track if cover buffer is stored
-  uint8_t* coverBuffer = nullptr;  // HomeActivity's own buffer for cover image
+  bool coverBufferStored = false;  // Track if a cover snapshot may be available
+  std::string coverSnapshotKey;    // Identifies the covers currently shown, see getCoverSnapshotKey()
+  uint8_t* coverBuffer = nullptr;  // The covers' frame buffer for re-renders during this visit
   std::vector<RecentBook> recentBooks;
   const std::function<void(const std::string& path)> onSelectBook;
   const std::function<void()> onMyLibraryOpen;
@@ -36,9 +38,11 @@ class HomeActivity final : public Activity {
   [[noreturn]] void displayTaskLoop();
   void render();
   int getMenuItemCount() const;
-  bool storeCoverBuffer();    // Store frame buffer for cover image
-  bool restoreCoverBuffer();  // Restore frame buffer from stored cover
-  void freeCoverBuffer();     // Free the stored cover buffer
+  bool storeCoverBuffer();    // Save frame buffer with cover images in RAM and as a snapshot on SD
+  bool restoreCoverBuffer();  // Restore frame buffer from RAM, or from the snapshot on the first render
+  bool keepCoverBuffer(const uint8_t* frameBuffer);
+  void freeCoverBuffer();
+  std::string getCoverSnapshotKey() const;
   void loadRecentBooks(int maxBooks);
   void loadRecentCovers(int coverHeight);
 
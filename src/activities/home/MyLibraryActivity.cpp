@@ -1,8 +1,12 @@
 #include "MyLibraryActivity.h"
 
 #include <GfxRenderer.h>
+#include <HardwareSerial.h>
 #include <SDCardManager.h>
 
+#include <algorithm>
+
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "components/UITheme.h"
 #include "fontIds.h"
@@ -11,17 +15,25 @@
 namespace {
 constexpr int SKIP_PAGE_MS = 700;
 constexpr unsigned long GO_HOME_MS = 1000;
-}  // namespace
+// Directory entries a library index sync keeps in RAM, bigger folders are indexed as their books are opened
+constexpr size_t MAX_SYNCED_BOOKS = 1024;
+// Books a whole-library sync keeps in RAM (16 bytes each), folders past it are indexed as they are opened
+constexpr size_t MAX_LIBRARY_BOOKS = 4096;
 
-void sortFileList(std::vector<std::string>& strs) {
-  std::sort(begin(strs), end(strs), [](const std::string& str1, const std::string& str2) {
-    if (str1.back() == '/' && str2.back() != '/') return true;
-    if (str1.back() != '/' && str2.back() == '/') return false;
-    return lexicographical_compare(
-        begin(str1), end(str1), begin(str2), end(str2),
-        [](const char& char1, const char& char2) { return tolower(char1) < tolower(char2); });
-  });
+bool isHiddenName(const char* name) { return name[0] == '.' || strcmp(name, "System Volume Information") == 0; }
+
+bool isBookName(const std::string& name) {
+  return StringUtils::checkFileExtension(name, ".epub") || StringUtils::checkFileExtension(name, ".xtch") ||
+         StringUtils::checkFileExtension(name, ".xtc") || StringUtils::checkFileExtension(name, ".txt") ||
+         StringUtils::checkFileExtension(name, ".md");
+}
+
+LibraryIndex::ScannedFile scannedBook(FsFile& file, std::string path) {
+  uint16_t date = 0, time = 0;
+  file.getModifyDateTime(&date, &time);
+  return {std::move(path), static_cast<uint32_t>(file.fileSize()), (static_cast<uint32_t>(date) << 16) | time};
 }
+}  // namespace
 
 void MyLibraryActivity::taskTrampoline(void* param) {
   auto* self = static_cast<MyLibraryActivity*>(param);
@@ -29,38 +41,185 @@ void MyLibraryActivity::taskTrampoline(void* param) {
 }
 
 void MyLibraryActivity::loadFiles() {
-  files.clear();
+  xSemaphoreTake(renderingMutex, portMAX_DELAY);
+  listing.close();
 
   auto root = SdMan.open(basepath.c_str());
   if (!root || !root.isDirectory()) {
     if (root) root.close();
+    xSemaphoreGive(renderingMutex);
     return;
   }
 
-  root.rewindDirectory();
-
+  // Hashing the raw names is much cheaper than filtering and sorting them, and an unchanged stamp means the cached
+  // listing can be reused as is
+  DirectoryListing::Stamp stamp;
+  uint16_t dirDate = 0, dirTime = 0;
+  root.getModifyDateTime(&dirDate, &dirTime);
+  stamp.mtime = (static_cast<uint32_t>(dirDate) << 16) | dirTime;
   char name[500];
+  root.rewindDirectory();
   for (auto file = root.openNextFile(); file; file = root.openNextFile()) {
     file.getName(name, sizeof(name));
-    if (name[0] == '.' || strcmp(name, "System Volume Information") == 0) {
+    stamp.addEntry(name);
+    file.close();
+  }
+  if (listing.open(basepath, stamp)) {
+    root.close();
+    xSemaphoreGive(renderingMutex);
+    return;
+  }
+
+  const std::string dirPrefix = basepath.back() == '/' ? basepath : basepath + "/";
+  std::vector<LibraryIndex::ScannedFile> books;
+  bool tooManyBooks = false;
+  root.rewindDirectory();
+  listing.build(basepath, stamp, [&](std::string& entryName) {
+    for (auto file = root.openNextFile(); file; file = root.openNextFile()) {
+      file.getName(name, sizeof(name));
+      if (isHiddenName(name)) {
+        file.close();
+        continue;
+      }
+
+      if (file.isDirectory()) {
+        entryName = std::string(name) + "/";
+        file.close();
+        return true;
+      }
+      entryName = name;
+      if (isBookName(entryName)) {
+        if (books.size() < MAX_SYNCED_BOOKS) {
+          books.push_back(scannedBook(file, dirPrefix + entryName));
+        } else {
+          tooManyBooks = true;
+        }
+        file.close();
+        return true;
+      }
       file.close();
+    }
+    return false;
+  });
+  root.close();
+  xSemaphoreGive(renderingMutex);
+
+  // Keep the library index in step with what's on the card, only new or changed books are touched
+  if (!tooManyBooks) {
+    LIBRARY_INDEX.syncDirectory(basepath, books);
+  } else {
+    Serial.printf("[%lu] [MYL] Too many books in %s to sync the library index\n", millis(), basepath.c_str());
+  }
+}
+
+void MyLibraryActivity::syncLibrary() {
+  const auto start = millis();
+  const Rect popup = GUI.drawPopup(renderer, "Indexing library...");
+
+  // One walk over the card collects every folder and the hash, size and time of every book in it
+  std::vector<std::string> dirPaths;
+  std::vector<LibraryIndex::ScannedBook> books;
+  std::vector<std::string> pendingDirs{"/"};
+  char name[500];
+  bool tooManyBooks = false;
+  while (!pendingDirs.empty() && !tooManyBooks) {
+    const std::string dirPath = std::move(pendingDirs.back());
+    pendingDirs.pop_back();
+    auto dir = SdMan.open(dirPath.c_str());
+    if (!dir || !dir.isDirectory()) {
+      if (dir) dir.close();
       continue;
     }
 
-    if (file.isDirectory()) {
-      files.emplace_back(std::string(name) + "/");
+    const std::string dirPrefix = dirPath.back() == '/' ? dirPath : dirPath + "/";
+    const size_t firstBook = books.size();
+    for (auto file = dir.openNextFile(); file; file = dir.openNextFile()) {
+      file.getName(name, sizeof(name));
+      if (isHiddenName(name)) {
+        // Nothing to index
+      } else if (file.isDirectory()) {
+        pendingDirs.push_back(dirPrefix + name);
+      } else if (isBookName(name)) {
+        if (books.size() == MAX_LIBRARY_BOOKS) {
+          tooManyBooks = true;
+          file.close();
+          break;
+        }
+        const auto scanned = scannedBook(file, dirPrefix + name);
+        books.push_back({LibraryIndex::pathHash(scanned.path), scanned.size, scanned.mtime});
+      }
+      file.close();
+    }
+    dir.close();
+
+    if (tooManyBooks) {
+      // Only whole folders can be synced, their entries would be taken for removed books otherwise
+      books.resize(firstBook);
+      Serial.printf("[%lu] [MYL] Too many books to sync the library index past %s\n", millis(), dirPath.c_str());
     } else {
-      auto filename = std::string(name);
-      if (StringUtils::checkFileExtension(filename, ".epub") || StringUtils::checkFileExtension(filename, ".xtch") ||
-          StringUtils::checkFileExtension(filename, ".xtc") || StringUtils::checkFileExtension(filename, ".txt") ||
-          StringUtils::checkFileExtension(filename, ".md")) {
-        files.emplace_back(filename);
+      dirPaths.push_back(dirPath);
+    }
+  }
+  GUI.fillPopupProgress(renderer, popup, 40);
+
+  // One pass over the index finds what changed, only those books are looked up again to be staged
+  const auto changed = LIBRARY_INDEX.syncDirectories(dirPaths, books);
+  books.clear();
+  books.shrink_to_fit();
+  if (!changed.empty()) {
+    GUI.fillPopupProgress(renderer, popup, 70);
+    for (const auto& dirPath : dirPaths) {
+      auto dir = SdMan.open(dirPath.c_str());
+      if (!dir || !dir.isDirectory()) {
+        if (dir) dir.close();
+        continue;
       }
+      const std::string dirPrefix = dirPath.back() == '/' ? dirPath : dirPath + "/";
+      for (auto file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        file.getName(name, sizeof(name));
+        if (!isHiddenName(name) && !file.isDirectory() && isBookName(name)) {
+          std::string path = dirPrefix + name;
+          if (std::binary_search(changed.begin(), changed.end(), LibraryIndex::pathHash(path))) {
+            LIBRARY_INDEX.addScanned(scannedBook(file, std::move(path)));
+          }
+        }
+        file.close();
+      }
+      dir.close();
     }
-    file.close();
   }
-  root.close();
-  sortFileList(files);
+  LIBRARY_INDEX.commit();
+  GUI.fillPopupProgress(renderer, popup, 100);
+
+  librarySynced = true;
+  Serial.printf("[%lu] [MYL] Synced library index with %d folders in %lu ms\n", millis(), dirPaths.size(),
+                millis() - start);
+}
+
+int MyLibraryActivity::getListSize() const {
+  return view == View::Folders ? static_cast<int>(listing.size()) : static_cast<int>(LIBRARY_INDEX.getCount());
+}
+
+void MyLibraryActivity::switchView() {
+  xSemaphoreTake(renderingMutex, portMAX_DELAY);
+  switch (view) {
+    case View::Folders:
+      // Folders that were never opened here, or changed from a computer, would be missing from the sorted lists
+      if (!librarySynced) {
+        syncLibrary();
+      }
+      view = View::ByTitle;
+      break;
+    case View::ByTitle:
+      view = View::ByAuthor;
+      break;
+    case View::ByAuthor:
+      view = View::Folders;
+      break;
+  }
+  selectorIndex = 0;
+  xSemaphoreGive(renderingMutex);
+  updateRequired = true;
 }
 
 void MyLibraryActivity::onEnter() {
@@ -93,7 +252,8 @@ void MyLibraryActivity::onExit() {
   vSemaphoreDelete(renderingMutex);
   renderingMutex = nullptr;
 
-  files.clear();
+  listing.close();
+  LIBRARY_INDEX.close();
 }
 
 void MyLibraryActivity::loop() {
@@ -117,25 +277,73 @@ void MyLibraryActivity::loop() {
   const int pageItems = UITheme::getInstance().getNumberOfItemsPerPage(renderer, true, false, true, true);
 
   if (mappedInput.wasReleased(MappedInputManager::Button::Confirm)) {
-    if (files.empty()) {
+    // Long press cycles between folders and the title and author lists
+    if (mappedInput.getHeldTime() >= GO_HOME_MS) {
+      switchView();
+      return;
+    }
+
+    if (view != View::Folders) {
+      LibraryEntry entry;
+      const auto order = view == View::ByTitle ? LibraryIndex::Order::Title : LibraryIndex::Order::Author;
+      if (!LIBRARY_INDEX.getSorted(order, selectorIndex, entry)) {
+        return;
+      }
+      if (SdMan.exists(entry.path.c_str())) {
+        onSelectBook(entry.path);
+        return;
+      }
+      // Deleted behind the index's back
+      xSemaphoreTake(renderingMutex, portMAX_DELAY);
+      LIBRARY_INDEX.removeBook(entry.path);
+      LIBRARY_INDEX.commit();
+      const int count = getListSize();
+      if (static_cast<int>(selectorIndex) >= count) {
+        selectorIndex = count > 0 ? count - 1 : 0;
+      }
+      xSemaphoreGive(renderingMutex);
+      updateRequired = true;
       return;
     }
 
-    if (basepath.back() != '/') basepath += "/";
-    if (files[selectorIndex].back() == '/') {
-      basepath += files[selectorIndex].substr(0, files[selectorIndex].length() - 1);
+    xSemaphoreTake(renderingMutex, portMAX_DELAY);
+    const std::string selected = listing.at(selectorIndex);
+    xSemaphoreGive(renderingMutex);
+    if (selected.empty()) {
+      return;
+    }
+
+    const std::string dirPrefix = basepath.back() == '/' ? basepath : basepath + "/";
+    if (selected.back() == '/') {
+      basepath = dirPrefix + selected.substr(0, selected.length() - 1);
       loadFiles();
       selectorIndex = 0;
       updateRequired = true;
-    } else {
-      onSelectBook(basepath + files[selectorIndex]);
+    } else if (SdMan.exists((dirPrefix + selected).c_str())) {
+      onSelectBook(dirPrefix + selected);
       return;
+    } else {
+      // Renamed without changing the directory's stamp
+      DirectoryListing::invalidate("/.crosspoint", basepath);
+      loadFiles();
+      if (static_cast<int>(selectorIndex) >= getListSize()) {
+        selectorIndex = 0;
+      }
+      updateRequired = true;
     }
   }
 
   if (mappedInput.wasReleased(MappedInputManager::Button::Back)) {
     // Short press: go up one directory, or go home if at root
     if (mappedInput.getHeldTime() < GO_HOME_MS) {
+      if (view != View::Folders) {
+        xSemaphoreTake(renderingMutex, portMAX_DELAY);
+        view = View::Folders;
+        selectorIndex = 0;
+        xSemaphoreGive(renderingMutex);
+        updateRequired = true;
+        return;
+      }
       if (basepath != "/") {
         const std::string oldPath = basepath;
 
@@ -154,7 +362,20 @@ void MyLibraryActivity::loop() {
     }
   }
 
-  int listSize = static_cast<int>(files.size());
+  const int listSize = getListSize();
+  if (listSize == 0) {
+    return;
+  }
+  // Holding a side button jumps to the previous or next starting letter
+  const bool sideUpReleased = mappedInput.wasReleased(MappedInputManager::Button::Up);
+  if (view == View::Folders && skipPage &&
+      (sideUpReleased || mappedInput.wasReleased(MappedInputManager::Button::Down))) {
+    xSemaphoreTake(renderingMutex, portMAX_DELAY);
+    selectorIndex = sideUpReleased ? listing.previousLetter(selectorIndex) : listing.nextLetter(selectorIndex);
+    xSemaphoreGive(renderingMutex);
+    updateRequired = true;
+    return;
+  }
   if (upReleased) {
     if (skipPage) {
       selectorIndex = ((selectorIndex / pageItems - 1) * pageItems + listSize) % listSize;
@@ -191,28 +412,60 @@ void MyLibraryActivity::render() const {
   const auto pageHeight = renderer.getScreenHeight();
   auto metrics = UITheme::getInstance().getMetrics();
 
-  auto folderName = basepath == "/" ? "SD card" : basepath.substr(basepath.rfind('/') + 1).c_str();
-  GUI.drawHeader(renderer, Rect{0, metrics.topPadding, pageWidth, metrics.headerHeight}, folderName);
+  const std::string folderName = basepath == "/" ? "SD card" : basepath.substr(basepath.rfind('/') + 1);
+  const char* headerTitle = view == View::ByTitle    ? "By title"
+                            : view == View::ByAuthor ? "By author"
+                                                     : folderName.c_str();
+  GUI.drawHeader(renderer, Rect{0, metrics.topPadding, pageWidth, metrics.headerHeight}, headerTitle);
 
   const int contentTop = metrics.topPadding + metrics.headerHeight + metrics.verticalSpacing;
   const int contentHeight = pageHeight - contentTop - metrics.buttonHintsHeight - metrics.verticalSpacing * 2;
-  if (files.empty()) {
+  const int listSize = getListSize();
+  if (listSize == 0) {
     renderer.drawText(UI_10_FONT_ID, metrics.contentSidePadding, contentTop + 20, "No books found");
+  } else if (view == View::Folders) {
+    GUI.drawList(
+        renderer, Rect{0, contentTop, pageWidth, contentHeight}, listSize, selectorIndex,
+        [this](int index) { return listing.at(index); }, nullptr, nullptr, nullptr);
   } else {
+    // Only the visible page is read from the index
+    const int pageItems = UITheme::getInstance().getNumberOfItemsPerPage(renderer, true, false, true, true);
+    const int pageStart = static_cast<int>(selectorIndex) / pageItems * pageItems;
+    const auto order = view == View::ByTitle ? LibraryIndex::Order::Title : LibraryIndex::Order::Author;
+    std::vector<LibraryEntry> rows;
+    for (int i = pageStart; i < listSize && i < pageStart + pageItems; i++) {
+      rows.emplace_back();
+      LIBRARY_INDEX.getSorted(order, i, rows.back());
+    }
+    LibraryEntry other;
+    const auto rowAt = [&](const int index) -> const LibraryEntry& {
+      if (index >= pageStart && index - pageStart < static_cast<int>(rows.size())) {
+        return rows[index - pageStart];
+      }
+      // The theme laid out a different page than expected
+      other = LibraryEntry{};
+      LIBRARY_INDEX.getSorted(order, index, other);
+      return other;
+    };
     GUI.drawList(
-        renderer, Rect{0, contentTop, pageWidth, contentHeight}, files.size(), selectorIndex,
-        [this](int index) { return files[index]; }, nullptr, nullptr, nullptr);
+        renderer, Rect{0, contentTop, pageWidth, contentHeight}, listSize, selectorIndex,
+        [&](int index) { return rowAt(index).title; }, [&](int index) { return rowAt(index).author; }, nullptr,
+        [&](int index) {
+          const auto progress = rowAt(index).progress;
+          return progress > 0 ? std::to_string(progress) + "%" : std::string();
+        });
   }
 
   // Help text
-  const auto labels = mappedInput.mapLabels("« Home", "Open", "Up", "Down");
+  const auto labels = mappedInput.mapLabels(view == View::Folders ? "« Home" : "« Files", "Open", "Up", "Down");
   GUI.drawButtonHints(renderer, labels.btn1, labels.btn2, labels.btn3, labels.btn4);
 
   renderer.displayBuffer();
 }
 
 size_t MyLibraryActivity::findEntry(const std::string& name) const {
-  for (size_t i = 0; i < files.size(); i++)
-    if (files[i] == name) return i;
-  return 0;
+  xSemaphoreTake(renderingMutex, portMAX_DELAY);
+  const int32_t index = listing.find(name);
+  xSemaphoreGive(renderingMutex);
+  return index < 0 ? 0 : static_cast<size_t>(index);
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <DirectoryListing.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
@@ -11,6 +12,9 @@
 
 class MyLibraryActivity final : public Activity {
  private:
+  // Folder browsing, or every indexed book sorted by title or author
+  enum class View : uint8_t { Folders, ByTitle, ByAuthor };
+
   TaskHandle_t displayTaskHandle = nullptr;
   SemaphoreHandle_t renderingMutex = nullptr;
 
@@ -19,7 +23,11 @@ class MyLibraryActivity final : public Activity {
 
   // Files state
   std::string basepath = "/";
-  std::vector<std::string> files;
+  // Sorted listing of basepath, paged in from its cache as rows are drawn
+  mutable DirectoryListing listing{"/.crosspoint"};
+  View view = View::Folders;
+  // Whether every folder's books were brought into the library index during this visit
+  bool librarySynced = false;
 
   // Callbacks
   const std::function<void(const std::string& path)> onSelectBook;
@@ -31,7 +39,10 @@ class MyLibraryActivity final : public Activity {
 
   // Data loading
   void loadFiles();
+  void syncLibrary();
   size_t findEntry(const std::string& name) const;
+  int getListSize() const;
+  void switchView();
 
  public:
   explicit MyLibraryActivity(GfxRenderer& renderer, MappedInputManager& mappedInput,
@@ -1,6 +1,7 @@
 #include "EpubReaderActivity.h"
 
 #include <Epub/Page.h>
+#include <Epub/hyphenation/HyphenationCache.h>
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
 #include <SDCardManager.h>
@@ -9,8 +10,10 @@
 #include "CrossPointState.h"
 #include "EpubReaderChapterSelectionActivity.h"
 #include "EpubReaderPercentSelectionActivity.h"
+#include "EpubReaderSearchActivity.h"
 #include "KOReaderCredentialStore.h"
 #include "KOReaderSyncActivity.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "RecentBooksStore.h"
 #include "components/UITheme.h"
@@ -106,6 +109,7 @@ void EpubReaderActivity::onEnter() {
   APP_STATE.openEpubPath = epub->getPath();
   APP_STATE.saveToFile();
   RECENT_BOOKS.addBook(epub->getPath(), epub->getTitle(), epub->getAuthor(), epub->getThumbBmpPath());
+  LIBRARY_INDEX.recordBook(epub->getPath(), epub->getTitle(), epub->getAuthor(), epub->getThumbBmpPath());
 
   // Trigger first update
   updateRequired = true;
@@ -134,8 +138,16 @@ void EpubReaderActivity::onExit() {
   renderingMutex = nullptr;
   APP_STATE.readerActivityLoadCount = 0;
   APP_STATE.saveToFile();
+  if (epub && epub->getBookSize() > 0 && section && section->pageCount > 0) {
+    const float chapterProgress = static_cast<float>(section->currentPage) / static_cast<float>(section->pageCount);
+    const float bookProgress = epub->calculateProgress(currentSpineIndex, chapterProgress) * 100.0f;
+    LIBRARY_INDEX.recordProgress(epub->getPath(), clampPercent(static_cast<int>(bookProgress + 0.5f)));
+  }
+  LIBRARY_INDEX.commit();
   section.reset();
   epub.reset();
+  // The memo holds this book's vocabulary
+  HyphenationCache::clear();
 }
 
 void EpubReaderActivity::loop() {
@@ -379,10 +391,11 @@ void EpubReaderActivity::onReaderMenuConfirm(EpubReaderMenuActivity::MenuAction
             exitActivity();
             updateRequired = true;
           },
-          [this](const int newSpineIndex) {
-            if (currentSpineIndex != newSpineIndex) {
+          [this](const int newSpineIndex, const std::string& anchor) {
+            if (currentSpineIndex != newSpineIndex || !anchor.empty()) {
               currentSpineIndex = newSpineIndex;
               nextPageNumber = 0;
+              pendingAnchor = anchor;
               section.reset();
             }
             exitActivity();
@@ -401,6 +414,26 @@ void EpubReaderActivity::onReaderMenuConfirm(EpubReaderMenuActivity::MenuAction
       xSemaphoreGive(renderingMutex);
       break;
     }
+    case EpubReaderMenuActivity::MenuAction::SEARCH: {
+      xSemaphoreTake(renderingMutex, portMAX_DELAY);
+      exitActivity();
+      enterNewActivity(new EpubReaderSearchActivity(
+          renderer, mappedInput, epub, section ? section->getParams() : Section::Params{},
+          [this] {
+            // Defer exit, this is called from within the search activity's loop
+            pendingSubactivityExit = true;
+          },
+          [this](const int spineIndex, const uint32_t textOffset) {
+            currentSpineIndex = spineIndex;
+            nextPageNumber = 0;
+            pendingTextJump = true;
+            pendingTextOffset = textOffset;
+            section.reset();
+            pendingSubactivityExit = true;
+          }));
+      xSemaphoreGive(renderingMutex);
+      break;
+    }
     case EpubReaderMenuActivity::MenuAction::GO_TO_PERCENT: {
       // Launch the slider-based percent selector and return here on confirm/cancel.
       float bookProgress = 0.0f;
@@ -460,9 +493,10 @@ void EpubReaderActivity::onReaderMenuConfirm(EpubReaderMenuActivity::MenuAction
         xSemaphoreTake(renderingMutex, portMAX_DELAY);
         const int currentPage = section ? section->currentPage : 0;
         const int totalPages = section ? section->pageCount : 0;
+        const Section::Params sectionParams = section ? section->getParams() : Section::Params{};
         exitActivity();
         enterNewActivity(new KOReaderSyncActivity(
-            renderer, mappedInput, epub, epub->getPath(), currentSpineIndex, currentPage, totalPages,
+            renderer, mappedInput, epub, epub->getPath(), currentSpineIndex, currentPage, totalPages, sectionParams,
             [this]() {
               // On cancel - defer exit to avoid use-after-free
               pendingSubactivityExit = true;
@@ -608,6 +642,24 @@ void EpubReaderActivity::renderScreen() {
       cachedChapterTotalPageCount = 0;  // resets to 0 to prevent reading cached progress again
     }
 
+    if (!pendingAnchor.empty()) {
+      // TOC entries inside a chapter open on the page their anchor starts on
+      const int anchorPage = section->findAnchorPage(pendingAnchor);
+      if (anchorPage >= 0 && anchorPage < section->pageCount) {
+        section->currentPage = anchorPage;
+      }
+      pendingAnchor.clear();
+    }
+
+    if (pendingTextJump) {
+      // Search results open on the page their match starts on
+      const int textPage = Section::findTextPage(epub, currentSpineIndex, section->getParams(), pendingTextOffset);
+      if (textPage >= 0 && textPage < section->pageCount) {
+        section->currentPage = textPage;
+      }
+      pendingTextJump = false;
+    }
+
     if (pendingPercentJump && section->pageCount > 0) {
       // Apply the pending percent jump now that we know the new section's page count.
       int newPage = static_cast<int>(pendingSpineProgress * static_cast<float>(section->pageCount));
@@ -687,7 +739,8 @@ void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int or
 
   // grayscale rendering
   // TODO: Only do this if font supports it
-  if (SETTINGS.textAntiAliasing) {
+  // Pages with images always need the gray passes, otherwise the dithered grays collapse to black
+  if (SETTINGS.textAntiAliasing || page->hasImages()) {
     renderer.clearScreen(0x00);
     renderer.setRenderMode(GfxRenderer::GRAYSCALE_LSB);
     page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
@@ -23,6 +23,11 @@ class EpubReaderActivity final : public ActivityWithSubactivity {
   bool pendingPercentJump = false;
   // Normalized 0.0-1.0 progress within the target spine item, computed from book percentage.
   float pendingSpineProgress = 0.0f;
+  // Fragment id to open the next section at, from a TOC entry
+  std::string pendingAnchor;
+  // Text offset to open the next section at, from a search result
+  bool pendingTextJump = false;
+  uint32_t pendingTextOffset = 0;
   bool updateRequired = false;
   bool pendingSubactivityExit = false;  // Defer subactivity exit to avoid use-after-free
   bool pendingGoHome = false;           // Defer go home to avoid race condition with display task
@@ -91,7 +91,7 @@ void EpubReaderChapterSelectionActivity::loop() {
     if (newSpineIndex == -1) {
       onGoBack();
     } else {
-      onSelectSpineIndex(newSpineIndex);
+      onSelectSpineIndex(newSpineIndex, epub->getTocItem(selectorIndex).anchor);
     }
   } else if (mappedInput.wasReleased(MappedInputManager::Button::Back)) {
     onGoBack();
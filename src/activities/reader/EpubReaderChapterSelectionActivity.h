@@ -19,7 +19,8 @@ class EpubReaderChapterSelectionActivity final : public ActivityWithSubactivity
   int selectorIndex = 0;
   bool updateRequired = false;
   const std::function<void()> onGoBack;
-  const std::function<void(int newSpineIndex)> onSelectSpineIndex;
+  // anchor is the fragment id of the TOC entry within the spine item, empty for its start
+  const std::function<void(int newSpineIndex, const std::string& anchor)> onSelectSpineIndex;
   const std::function<void(int newSpineIndex, int newPage)> onSyncPosition;
 
   // Number of items that fit on a page, derived from logical screen height.
@@ -38,7 +39,8 @@ class EpubReaderChapterSelectionActivity final : public ActivityWithSubactivity
                                               const std::shared_ptr<Epub>& epub, const std::string& epubPath,
                                               const int currentSpineIndex, const int currentPage,
                                               const int totalPagesInSpine, const std::function<void()>& onGoBack,
-                                              const std::function<void(int newSpineIndex)>& onSelectSpineIndex,
+                                              const std::function<void(int newSpineIndex, const std::string& anchor)>&
+                                                  onSelectSpineIndex,
                                               const std::function<void(int newSpineIndex, int newPage)>& onSyncPosition)
       : ActivityWithSubactivity("EpubReaderChapterSelection", renderer, mappedInput),
         epub(epub),
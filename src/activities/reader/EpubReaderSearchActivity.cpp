@@ -0,0 +1,490 @@
+#include "EpubReaderSearchActivity.h"
+
+#include <Epub/Section.h>
+#include <Epub/search/HtmlTextScanner.h>
+#include <Epub/search/WordIndex.h>
+#include <GfxRenderer.h>
+
+#include <algorithm>
+
+#include "CrossPointSettings.h"
+#include "MappedInputManager.h"
+#include "activities/util/KeyboardEntryActivity.h"
+#include "components/UITheme.h"
+#include "fontIds.h"
+
+namespace {
+// Time threshold for treating a long press as a page-up/page-down
+constexpr int SKIP_PAGE_MS = 700;
+constexpr int LIST_START_Y = 75;
+constexpr int ROW_HEIGHT = 50;
+}  // namespace
+
+void EpubReaderSearchActivity::taskTrampoline(void* param) {
+  auto* self = static_cast<EpubReaderSearchActivity*>(param);
+  self->displayTaskLoop();
+}
+
+void EpubReaderSearchActivity::searchTaskTrampoline(void* param) {
+  auto* self = static_cast<EpubReaderSearchActivity*>(param);
+  self->runSearch();
+  self->searching = false;
+  // Matches listed from the word index get their snippets as their rows come on screen
+  while (!self->exitRequested) {
+    if (!self->readVisibleSnippets()) {
+      vTaskDelay(50 / portTICK_PERIOD_MS);
+    }
+  }
+  self->taskRunning = false;
+  vTaskDelete(nullptr);
+}
+
+int EpubReaderSearchActivity::getPageItems() const {
+  const bool isPortraitInverted = renderer.getOrientation() == GfxRenderer::Orientation::PortraitInverted;
+  const int hintGutterHeight = isPortraitInverted ? 50 : 0;
+  const int availableHeight = renderer.getScreenHeight() - LIST_START_Y - hintGutterHeight - ROW_HEIGHT;
+  return std::max(1, availableHeight / ROW_HEIGHT);
+}
+
+std::string EpubReaderSearchActivity::getChapterTitle(const int spineIndex) const {
+  const int tocIndex = epub->getTocIndexForSpineIndex(spineIndex);
+  return tocIndex >= 0 ? epub->getTocItem(tocIndex).title : "Section " + std::to_string(spineIndex + 1);
+}
+
+void EpubReaderSearchActivity::onEnter() {
+  ActivityWithSubactivity::onEnter();
+
+  if (!epub) {
+    return;
+  }
+
+  renderingMutex = xSemaphoreCreateMutex();
+  xTaskCreate(&EpubReaderSearchActivity::taskTrampoline, "EpubReaderSearchActivityTask",
+              4096,               // Stack size
+              this,               // Parameters
+              1,                  // Priority
+              &displayTaskHandle  // Task handle
+  );
+  openKeyboard();
+}
+
+void EpubReaderSearchActivity::onExit() {
+  stopSearchTask();
+  ActivityWithSubactivity::onExit();
+
+  // Wait until not rendering to delete task to avoid killing mid-instruction to EPD
+  xSemaphoreTake(renderingMutex, portMAX_DELAY);
+  if (displayTaskHandle) {
+    vTaskDelete(displayTaskHandle);
+    displayTaskHandle = nullptr;
+  }
+  vSemaphoreDelete(renderingMutex);
+  renderingMutex = nullptr;
+  results.clear();
+  resultCount = 0;
+}
+
+void EpubReaderSearchActivity::openKeyboard() {
+  xSemaphoreTake(renderingMutex, portMAX_DELAY);
+  enterNewActivity(new KeyboardEntryActivity(
+      renderer, mappedInput, "Search", matcher.getQuery(), 10, TextMatcher::MAX_QUERY_SIZE, false,
+      [this](const std::string& query) {
+        exitActivity();
+        startSearch(query);
+      },
+      [this] {
+        exitActivity();
+        onGoBack();
+      }));
+  xSemaphoreGive(renderingMutex);
+}
+
+void EpubReaderSearchActivity::startSearch(const std::string& query) {
+  // Searches that use the word index only match at word starts, which is what it can look up
+  if (!matcher.setQuery(query, SETTINGS.searchIndex)) {
+    onGoBack();
+    return;
+  }
+
+  stopSearchTask();
+  results.clear();
+  resultCount = 0;
+  searchedSpineItems = 0;
+  resultsTruncated = false;
+  selectorIndex = 0;
+  cancelRequested = false;
+  exitRequested = false;
+  searching = true;
+  taskRunning = true;
+  updateRequired = true;
+  // Inflating a chapter takes the zip buffers from the heap, the stack holds the scanner and the index write buffers
+  xTaskCreate(&EpubReaderSearchActivity::searchTaskTrampoline, "EpubSearchTask", 8192, this, 1, nullptr);
+}
+
+void EpubReaderSearchActivity::stopSearch() {
+  cancelRequested = true;
+  while (searching) {
+    vTaskDelay(10 / portTICK_PERIOD_MS);
+  }
+}
+
+void EpubReaderSearchActivity::stopSearchTask() {
+  exitRequested = true;
+  cancelRequested = true;
+  while (taskRunning) {
+    vTaskDelay(10 / portTICK_PERIOD_MS);
+  }
+}
+
+void EpubReaderSearchActivity::runSearch() {
+  const unsigned long start = millis();
+  const int spineCount = epub->getSpineItemsCount();
+  const std::string indexDir = epub->getCachePath() + "/search";
+
+  // Matches in the spine items the word index covers are listed from it, or if it can't answer the query those spine
+  // items are only scanned when they can hold one
+  WordIndex index(indexDir);
+  std::vector<bool> candidates;
+  const int indexed = SETTINGS.searchIndex ? index.load() : 0;
+  const bool answered = indexed > 0 && listIndexedMatches(index);
+  const bool narrowed = !answered && indexed > 0 && index.findCandidates(matcher, candidates);
+
+  // The others are indexed as they're scanned, even once the results are full
+  std::unique_ptr<WordIndexWriter> writer;
+  if (SETTINGS.searchIndex && indexed < spineCount) {
+    writer.reset(new WordIndexWriter(indexDir, indexed));
+    if (!writer->begin()) {
+      writer.reset();
+    }
+  }
+
+  int scanned = 0;
+  for (int i = answered ? indexed : 0; i < spineCount && !cancelRequested; i++) {
+    const bool indexing = writer && i >= indexed;
+    if (resultsTruncated && !indexing) {
+      break;
+    }
+    if (!narrowed || i >= indexed || candidates[i]) {
+      searchSpineItem(i, indexing ? writer.get() : nullptr);
+      scanned++;
+    }
+    searchedSpineItems = i + 1;
+    updateRequired = true;
+    // Rows on screen waiting for snippets go first
+    while (!cancelRequested && readVisibleSnippets()) {
+    }
+  }
+  if (writer) {
+    savingIndex = true;
+    updateRequired = true;
+    writer->finish();
+    savingIndex = false;
+  }
+  Serial.printf("[%lu] [ESR] Searched %d of %d spine items (%d %s, %d scanned) in %lu ms, %u results\n", millis(),
+                searchedSpineItems, spineCount, indexed, answered ? "answered from the index" : "indexed", scanned,
+                millis() - start, resultCount.load());
+  updateRequired = true;
+}
+
+void EpubReaderSearchActivity::searchSpineItem(const int spineIndex, WordIndexWriter* writer) {
+  // Matches are collected per chapter so they can be given pages before they're listed
+  std::vector<Result> found;
+  HtmlTextScanner scanner(
+      matcher,
+      [this, &found, spineIndex, writer](const uint32_t textOffset, const std::string& snippet) {
+        if (resultCount + found.size() >= MAX_RESULTS) {
+          resultsTruncated = true;
+          // The index needs the whole chapter
+          return writer != nullptr;
+        }
+        found.push_back({spineIndex, textOffset, -1, 0, "", snippet, true});
+        return true;
+      },
+      cancelRequested);
+  if (writer) {
+    writer->startSpineItem(spineIndex);
+    scanner.setListener(writer);
+  }
+
+  const auto href = epub->getSpineItem(spineIndex).href;
+  const bool read = epub->readItemContentsToStream(href, scanner, 1024);
+  if (cancelRequested) {
+    if (writer) {
+      writer->abortSpineItem();
+    }
+    return;
+  }
+  if (!read && !scanner.stopped()) {
+    // What could be read is still searched and indexed, so indexing can move past the chapter
+    Serial.printf("[%lu] [ESR] Could not read %s\n", millis(), href.c_str());
+  }
+  if (!scanner.stopped()) {
+    scanner.finish();
+  }
+  if (writer) {
+    writer->commitSpineItem(scanner.textLength());
+  }
+  if (found.empty()) {
+    return;
+  }
+
+  const std::string chapterTitle = getChapterTitle(spineIndex);
+  const uint32_t textLength = std::max<uint32_t>(1, scanner.textLength());
+  for (auto& result : found) {
+    result.page = Section::findTextPage(epub, spineIndex, sectionParams, result.textOffset);
+    result.percent = static_cast<int>(static_cast<uint64_t>(result.textOffset) * 100 / textLength);
+    result.chapterTitle = chapterTitle;
+  }
+
+  xSemaphoreTake(renderingMutex, portMAX_DELAY);
+  for (auto& result : found) {
+    results.push_back(std::move(result));
+  }
+  resultCount = results.size();
+  xSemaphoreGive(renderingMutex);
+}
+
+bool EpubReaderSearchActivity::listIndexedMatches(const WordIndex& index) {
+  if (!WordIndex::answers(matcher)) {
+    return false;
+  }
+  int titleSpineIndex = -1;
+  std::string chapterTitle;
+  const bool answered = index.findMatches(matcher, [&](const WordIndex::Hit& hit) {
+    if (cancelRequested) {
+      return false;
+    }
+    if (resultCount >= MAX_RESULTS) {
+      resultsTruncated = true;
+      return false;
+    }
+    if (hit.spineIndex != titleSpineIndex) {
+      titleSpineIndex = hit.spineIndex;
+      chapterTitle = getChapterTitle(hit.spineIndex);
+    }
+    const uint32_t textLength = std::max<uint32_t>(1, index.textLength(hit.spineIndex));
+    Result result = {hit.spineIndex,
+                     hit.textOffset,
+                     Section::findTextPage(epub, hit.spineIndex, sectionParams, hit.textOffset),
+                     static_cast<int>(static_cast<uint64_t>(hit.textOffset) * 100 / textLength),
+                     chapterTitle,
+                     "",
+                     false};
+    xSemaphoreTake(renderingMutex, portMAX_DELAY);
+    results.push_back(std::move(result));
+    resultCount = results.size();
+    xSemaphoreGive(renderingMutex);
+    updateRequired = true;
+    return true;
+  });
+  if (!answered) {
+    // A segment couldn't answer after all, the chapters are scanned instead
+    xSemaphoreTake(renderingMutex, portMAX_DELAY);
+    results.clear();
+    resultCount = 0;
+    resultsTruncated = false;
+    xSemaphoreGive(renderingMutex);
+    return false;
+  }
+  searchedSpineItems = index.indexedSpineItems();
+  updateRequired = true;
+  return true;
+}
+
+bool EpubReaderSearchActivity::readVisibleSnippets() {
+  const int pageItems = getPageItems();
+  int spineIndex = -1;
+  // Matches are listed in text order, so these are ascending
+  std::vector<uint32_t> offsets;
+  xSemaphoreTake(renderingMutex, portMAX_DELAY);
+  const int pageStart = selectorIndex / pageItems * pageItems;
+  const int pageEnd = std::min(pageStart + pageItems, static_cast<int>(results.size()));
+  for (int i = pageStart; i < pageEnd; i++) {
+    const Result& result = results[i];
+    if (!result.hasSnippet && (spineIndex < 0 || result.spineIndex == spineIndex)) {
+      spineIndex = result.spineIndex;
+      offsets.push_back(result.textOffset);
+    }
+  }
+  xSemaphoreGive(renderingMutex);
+  if (offsets.empty()) {
+    return false;
+  }
+
+  // Scanned only as far as the last of them
+  std::vector<std::string> snippets(offsets.size());
+  const uint32_t lastOffset = offsets.back();
+  HtmlTextScanner scanner(
+      matcher,
+      [&offsets, &snippets, lastOffset](const uint32_t textOffset, const std::string& snippet) {
+        const auto it = std::lower_bound(offsets.begin(), offsets.end(), textOffset);
+        if (it != offsets.end() && *it == textOffset) {
+          snippets[it - offsets.begin()] = snippet;
+        }
+        return textOffset < lastOffset;
+      },
+      exitRequested);
+  epub->readItemContentsToStream(epub->getSpineItem(spineIndex).href, scanner, 1024);
+  if (exitRequested) {
+    return true;
+  }
+  if (!scanner.stopped()) {
+    scanner.finish();
+  }
+
+  // Rows whose match wasn't found keep an empty snippet rather than being read again
+  xSemaphoreTake(renderingMutex, portMAX_DELAY);
+  for (auto& result : results) {
+    if (result.hasSnippet || result.spineIndex != spineIndex) {
+      continue;
+    }
+    const auto it = std::lower_bound(offsets.begin(), offsets.end(), result.textOffset);
+    if (it != offsets.end() && *it == result.textOffset) {
+      result.snippet = std::move(snippets[it - offsets.begin()]);
+      result.hasSnippet = true;
+    }
+  }
+  xSemaphoreGive(renderingMutex);
+  updateRequired = true;
+  return true;
+}
+
+void EpubReaderSearchActivity::loop() {
+  if (subActivity) {
+    subActivity->loop();
+    return;
+  }
+
+  const bool prevReleased = mappedInput.wasReleased(MappedInputManager::Button::Up) ||
+                            mappedInput.wasReleased(MappedInputManager::Button::Left);
+  const bool nextReleased = mappedInput.wasReleased(MappedInputManager::Button::Down) ||
+                            mappedInput.wasReleased(MappedInputManager::Button::Right);
+
+  const bool skipPage = mappedInput.getHeldTime() > SKIP_PAGE_MS;
+  const int pageItems = getPageItems();
+
+  xSemaphoreTake(renderingMutex, portMAX_DELAY);
+  const int totalItems = static_cast<int>(results.size());
+  const Result* selected = selectorIndex < totalItems ? &results[selectorIndex] : nullptr;
+  const int selectedSpineIndex = selected ? selected->spineIndex : -1;
+  const uint32_t selectedTextOffset = selected ? selected->textOffset : 0;
+  xSemaphoreGive(renderingMutex);
+
+  if (mappedInput.wasReleased(MappedInputManager::Button::Confirm)) {
+    if (selectedSpineIndex >= 0) {
+      stopSearchTask();
+      onSelectResult(selectedSpineIndex, selectedTextOffset);
+    } else if (!searching) {
+      openKeyboard();
+    }
+  } else if (mappedInput.wasReleased(MappedInputManager::Button::Back)) {
+    if (searching) {
+      // First Back stops the search and keeps what it found
+      stopSearch();
+      updateRequired = true;
+    } else {
+      onGoBack();
+    }
+  } else if (totalItems > 0 && prevReleased) {
+    if (skipPage) {
+      selectorIndex = ((selectorIndex / pageItems - 1) * pageItems + totalItems) % totalItems;
+    } else {
+      selectorIndex = (selectorIndex + totalItems - 1) % totalItems;
+    }
+    updateRequired = true;
+  } else if (totalItems > 0 && nextReleased) {
+    if (skipPage) {
+      selectorIndex = ((selectorIndex / pageItems + 1) * pageItems) % totalItems;
+    } else {
+      selectorIndex = (selectorIndex + 1) % totalItems;
+    }
+    updateRequired = true;
+  }
+}
+
+void EpubReaderSearchActivity::displayTaskLoop() {
+  while (true) {
+    if (updateRequired && !subActivity) {
+      updateRequired = false;
+      xSemaphoreTake(renderingMutex, portMAX_DELAY);
+      renderScreen();
+      xSemaphoreGive(renderingMutex);
+    }
+    vTaskDelay(10 / portTICK_PERIOD_MS);
+  }
+}
+
+void EpubReaderSearchActivity::renderScreen() {
+  renderer.clearScreen();
+
+  const auto pageWidth = renderer.getScreenWidth();
+  const auto orientation = renderer.getOrientation();
+  // Landscape orientation: reserve a horizontal gutter for button hints.
+  const bool isLandscapeCw = orientation == GfxRenderer::Orientation::LandscapeClockwise;
+  const bool isLandscapeCcw = orientation == GfxRenderer::Orientation::LandscapeCounterClockwise;
+  // Inverted portrait: reserve vertical space for hints at the top.
+  const bool isPortraitInverted = orientation == GfxRenderer::Orientation::PortraitInverted;
+  const int hintGutterWidth = (isLandscapeCw || isLandscapeCcw) ? 30 : 0;
+  const int contentX = isLandscapeCw ? hintGutterWidth : 0;
+  const int contentWidth = pageWidth - hintGutterWidth;
+  const int contentY = isPortraitInverted ? 50 : 0;
+  const int pageItems = getPageItems();
+  const int totalItems = static_cast<int>(results.size());
+
+  const std::string title =
+      renderer.truncatedText(UI_12_FONT_ID, ("Search: " + matcher.getQuery()).c_str(), contentWidth - 40,
+                             EpdFontFamily::BOLD);
+  const int titleX =
+      contentX + (contentWidth - renderer.getTextWidth(UI_12_FONT_ID, title.c_str(), EpdFontFamily::BOLD)) / 2;
+  renderer.drawText(UI_12_FONT_ID, titleX, 15 + contentY, title.c_str(), true, EpdFontFamily::BOLD);
+
+  std::string status;
+  if (savingIndex) {
+    status = "Saving search index...";
+  } else if (searching && resultsTruncated) {
+    status = "Indexing " + std::to_string(searchedSpineItems) + "/" + std::to_string(epub->getSpineItemsCount()) +
+             "... first " + std::to_string(totalItems) + " results";
+  } else if (searching) {
+    status = "Searching " + std::to_string(searchedSpineItems) + "/" + std::to_string(epub->getSpineItemsCount()) +
+             "... " + std::to_string(totalItems) + " found";
+  } else if (resultsTruncated) {
+    status = "First " + std::to_string(totalItems) + " results";
+  } else if (totalItems == 0) {
+    status = cancelRequested ? "Search stopped, no results" : "No results";
+  } else {
+    status = std::to_string(totalItems) + (totalItems == 1 ? " result" : " results");
+    if (cancelRequested) {
+      status += " (stopped)";
+    }
+  }
+  renderer.drawCenteredText(UI_10_FONT_ID, 45 + contentY, status.c_str());
+
+  if (totalItems > 0) {
+    const int pageStartIndex = selectorIndex / pageItems * pageItems;
+    renderer.fillRect(contentX, LIST_START_Y + contentY + (selectorIndex % pageItems) * ROW_HEIGHT - 2,
+                      contentWidth - 1, ROW_HEIGHT);
+
+    for (int i = 0; i < pageItems && pageStartIndex + i < totalItems; i++) {
+      const Result& result = results[pageStartIndex + i];
+      const bool isSelected = pageStartIndex + i == selectorIndex;
+      const int displayY = LIST_START_Y + contentY + i * ROW_HEIGHT;
+
+      const std::string where =
+          result.page >= 0 ? "p. " + std::to_string(result.page + 1) : std::to_string(result.percent) + "%";
+      const std::string label =
+          renderer.truncatedText(SMALL_FONT_ID, (result.chapterTitle + " - " + where).c_str(), contentWidth - 40);
+      renderer.drawText(SMALL_FONT_ID, contentX + 20, displayY, label.c_str(), !isSelected);
+
+      const std::string snippet =
+          renderer.truncatedText(UI_10_FONT_ID, result.hasSnippet ? result.snippet.c_str() : "...", contentWidth - 40);
+      renderer.drawText(UI_10_FONT_ID, contentX + 20, displayY + 20, snippet.c_str(), !isSelected);
+    }
+  }
+
+  const auto labels = searching ? mappedInput.mapLabels("Stop", "Open", "Up", "Down")
+                      : totalItems > 0 ? mappedInput.mapLabels("« Back", "Open", "Up", "Down")
+                                       : mappedInput.mapLabels("« Back", "Edit", "", "");
+  GUI.drawButtonHints(renderer, labels.btn1, labels.btn2, labels.btn3, labels.btn4);
+
+  renderer.displayBuffer();
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <Epub.h>
+#include <Epub/Section.h>
+#include <Epub/search/TextMatcher.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../ActivityWithSubactivity.h"
+
+class WordIndex;
+class WordIndexWriter;
+
+/**
+ * Full-text search of the open book.
+ *
+ * After the query is typed, a background task streams each spine item out of the EPUB through an HtmlTextScanner,
+ * so only the inflater's buffers and the scanner's window are held whatever the book's size. Results are listed
+ * chapter by chapter as they come in, with the page they are on when the chapter has been laid out before, and Back
+ * stops a search that is still running.
+ *
+ * With the Search Index setting on, the scan also builds the book's WordIndex, and later searches list the matches in
+ * the chapters it covers straight from it. Their snippets are only read from the chapters once their rows are on
+ * screen, by the search task which stays around for that until the activity exits or a result is opened.
+ */
+class EpubReaderSearchActivity final : public ActivityWithSubactivity {
+ public:
+  // The search stops once this many results are listed
+  static constexpr size_t MAX_RESULTS = 100;
+
+  explicit EpubReaderSearchActivity(GfxRenderer& renderer, MappedInputManager& mappedInput,
+                                    const std::shared_ptr<Epub>& epub, const Section::Params& sectionParams,
+                                    const std::function<void()>& onGoBack,
+                                    const std::function<void(int spineIndex, uint32_t textOffset)>& onSelectResult)
+      : ActivityWithSubactivity("EpubReaderSearch", renderer, mappedInput),
+        epub(epub),
+        sectionParams(sectionParams),
+        onGoBack(onGoBack),
+        onSelectResult(onSelectResult) {}
+  void onEnter() override;
+  void onExit() override;
+  void loop() override;
+
+ private:
+  struct Result {
+    int spineIndex;
+    uint32_t textOffset;
+    // Page in the chapter's section cache, -1 if the chapter hasn't been laid out
+    int page;
+    // How far into the chapter's text the match is, shown when the page isn't known
+    int percent;
+    std::string chapterTitle;
+    std::string snippet;
+    // False for matches from the word index until their snippet is read
+    bool hasSnippet;
+  };
+
+  std::shared_ptr<Epub> epub;
+  // Layout settings of the reader's sections, pages are only looked up in sections built with them
+  Section::Params sectionParams;
+  TaskHandle_t displayTaskHandle = nullptr;
+  SemaphoreHandle_t renderingMutex = nullptr;
+  TextMatcher matcher;
+  // Appended by the search task under renderingMutex
+  std::vector<Result> results;
+  // Size of results, so the search task can check its limit without taking renderingMutex
+  std::atomic<uint32_t> resultCount{0};
+  // The search task is scanning chapters, and is still running to read snippets
+  std::atomic<bool> searching{false};
+  std::atomic<bool> taskRunning{false};
+  // Stop scanning chapters, and stop the search task altogether
+  std::atomic<bool> cancelRequested{false};
+  std::atomic<bool> exitRequested{false};
+  int searchedSpineItems = 0;
+  bool resultsTruncated = false;
+  // The search is over and the word index built along the way is being written
+  bool savingIndex = false;
+  int selectorIndex = 0;
+  bool updateRequired = false;
+  const std::function<void()> onGoBack;
+  const std::function<void(int spineIndex, uint32_t textOffset)> onSelectResult;
+
+  void openKeyboard();
+  void startSearch(const std::string& query);
+  // Stop scanning chapters and wait for it to finish
+  void stopSearch();
+  // Stop the search task altogether and wait for it to exit
+  void stopSearchTask();
+  // List the matches the word index finds, false if it can't answer the query
+  bool listIndexedMatches(const WordIndex& index);
+  // Scan a spine item for matches, indexing its words as well if writer is set
+  void searchSpineItem(int spineIndex, WordIndexWriter* writer);
+  // Read the snippets of the rows on screen in one spine item, false if they all have theirs
+  bool readVisibleSnippets();
+  int getPageItems() const;
+  std::string getChapterTitle(int spineIndex) const;
+
+  static void taskTrampoline(void* param);
+  static void searchTaskTrampoline(void* param);
+  [[noreturn]] void displayTaskLoop();
+  void runSearch();
+  void renderScreen();
+};
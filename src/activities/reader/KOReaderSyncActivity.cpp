@@ -72,13 +72,17 @@ void KOReaderSyncActivity::onWifiSelectionComplete(const bool success) {
   performSync();
 }
 
-void KOReaderSyncActivity::performSync() {
+std::string KOReaderSyncActivity::calculateDocumentHash() const {
   // Calculate document hash based on user's preferred method
   if (KOREADER_STORE.getMatchMethod() == DocumentMatchMethod::FILENAME) {
-    documentHash = KOReaderDocumentId::calculateFromFilename(epubPath);
-  } else {
-    documentHash = KOReaderDocumentId::calculate(epubPath);
+    return KOReaderDocumentId::calculateFromFilename(epubPath);
   }
+  // The binary hash only changes with the file, so it is kept with the book's cache
+  return KOReaderDocumentId::calculateCached(epubPath, epub->getCachePath());
+}
+
+void KOReaderSyncActivity::performSync() {
+  documentHash = calculateDocumentHash();
   if (documentHash.empty()) {
     xSemaphoreTake(renderingMutex, portMAX_DELAY);
     state = SYNC_FAILED;
@@ -121,11 +125,11 @@ void KOReaderSyncActivity::performSync() {
   // Convert remote progress to CrossPoint position
   hasRemoteProgress = true;
   KOReaderPosition koPos = {remoteProgress.progress, remoteProgress.percentage};
-  remotePosition = ProgressMapper::toCrossPoint(epub, koPos, totalPagesInSpine);
+  remotePosition = ProgressMapper::toCrossPoint(epub, sectionParams, koPos, totalPagesInSpine);
 
   // Calculate local progress in KOReader format (for display)
   CrossPointPosition localPos = {currentSpineIndex, currentPage, totalPagesInSpine};
-  localProgress = ProgressMapper::toKOReader(epub, localPos);
+  localProgress = ProgressMapper::toKOReader(epub, sectionParams, localPos);
 
   xSemaphoreTake(renderingMutex, portMAX_DELAY);
   state = SHOWING_RESULT;
@@ -144,7 +148,7 @@ void KOReaderSyncActivity::performUpload() {
 
   // Convert current position to KOReader format
   CrossPointPosition localPos = {currentSpineIndex, currentPage, totalPagesInSpine};
-  KOReaderPosition koPos = ProgressMapper::toKOReader(epub, localPos);
+  KOReaderPosition koPos = ProgressMapper::toKOReader(epub, sectionParams, localPos);
 
   KOReaderProgress progress;
   progress.document = documentHash;
@@ -423,11 +427,7 @@ void KOReaderSyncActivity::loop() {
     if (mappedInput.wasPressed(MappedInputManager::Button::Confirm)) {
       // Calculate hash if not done yet
       if (documentHash.empty()) {
-        if (KOREADER_STORE.getMatchMethod() == DocumentMatchMethod::FILENAME) {
-          documentHash = KOReaderDocumentId::calculateFromFilename(epubPath);
-        } else {
-          documentHash = KOReaderDocumentId::calculate(epubPath);
-        }
+        documentHash = calculateDocumentHash();
       }
       performUpload();
     }
@@ -28,14 +28,15 @@ class KOReaderSyncActivity final : public ActivityWithSubactivity {
 
   explicit KOReaderSyncActivity(GfxRenderer& renderer, MappedInputManager& mappedInput,
                                 const std::shared_ptr<Epub>& epub, const std::string& epubPath, int currentSpineIndex,
-                                int currentPage, int totalPagesInSpine, OnCancelCallback onCancel,
-                                OnSyncCompleteCallback onSyncComplete)
+                                int currentPage, int totalPagesInSpine, const Section::Params& sectionParams,
+                                OnCancelCallback onCancel, OnSyncCompleteCallback onSyncComplete)
       : ActivityWithSubactivity("KOReaderSync", renderer, mappedInput),
         epub(epub),
         epubPath(epubPath),
         currentSpineIndex(currentSpineIndex),
         currentPage(currentPage),
         totalPagesInSpine(totalPagesInSpine),
+        sectionParams(sectionParams),
         remoteProgress{},
         remotePosition{},
         localProgress{},
@@ -65,6 +66,8 @@ class KOReaderSyncActivity final : public ActivityWithSubactivity {
   int currentSpineIndex;
   int currentPage;
   int totalPagesInSpine;
+  // Layout settings of the reader's sections, for looking positions up in them
+  Section::Params sectionParams;
 
   TaskHandle_t displayTaskHandle = nullptr;
   SemaphoreHandle_t renderingMutex = nullptr;
@@ -89,6 +92,7 @@ class KOReaderSyncActivity final : public ActivityWithSubactivity {
   OnSyncCompleteCallback onSyncComplete;
 
   void onWifiSelectionComplete(bool success);
+  std::string calculateDocumentHash() const;
   void performSync();
   void performUpload();
 
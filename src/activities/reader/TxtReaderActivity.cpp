@@ -7,6 +7,7 @@
 
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "RecentBooksStore.h"
 #include "components/UITheme.h"
@@ -17,10 +18,16 @@ constexpr unsigned long goHomeMs = 1000;
 constexpr int statusBarMargin = 25;
 constexpr int progressBarMarginTop = 1;
 constexpr size_t CHUNK_SIZE = 8 * 1024;  // 8KB chunk for reading
+// Pages indexed per step in the display task before it checks for a page turn again
+constexpr int INDEX_PAGES_PER_STEP = 4;
+// Show the indexing popup when a page this far past the indexed ones is opened
+constexpr int INDEX_POPUP_PAGES = 50;
+// Wait before indexing again after the card failed to read
+constexpr int INDEX_RETRY_MS = 1000;
 
 // Cache file magic and version
 constexpr uint32_t CACHE_MAGIC = 0x54585449;  // "TXTI"
-constexpr uint8_t CACHE_VERSION = 2;          // Increment when cache format changes
+constexpr uint8_t CACHE_VERSION = 4;          // Increment when cache format changes
 }  // namespace
 
 void TxtReaderActivity::taskTrampoline(void* param) {
@@ -63,6 +70,7 @@ void TxtReaderActivity::onEnter() {
   APP_STATE.openEpubPath = filePath;
   APP_STATE.saveToFile();
   RECENT_BOOKS.addBook(filePath, fileName, "", "");
+  LIBRARY_INDEX.recordBook(filePath, fileName, "", "");
 
   // Trigger first update
   updateRequired = true;
@@ -89,10 +97,22 @@ void TxtReaderActivity::onExit() {
   }
   vSemaphoreDelete(renderingMutex);
   renderingMutex = nullptr;
+  // Keep the pages found so far so the next open carries on from them
+  if (initialized && !indexComplete) {
+    savePageIndexCache();
+  }
+  const int bookPages = estimatedTotalPages();
+  file.close();
+  free(chunkBuffer);
+  chunkBuffer = nullptr;
   pageOffsets.clear();
   currentPageLines.clear();
   APP_STATE.readerActivityLoadCount = 0;
   APP_STATE.saveToFile();
+  if (txt && bookPages > 0) {
+    LIBRARY_INDEX.recordProgress(txt->getPath(), static_cast<uint8_t>((currentPage + 1) * 100 / bookPages));
+  }
+  LIBRARY_INDEX.commit();
   txt.reset();
 }
 
@@ -135,7 +155,7 @@ void TxtReaderActivity::loop() {
   if (prevTriggered && currentPage > 0) {
     currentPage--;
     updateRequired = true;
-  } else if (nextTriggered && currentPage < totalPages - 1) {
+  } else if (nextTriggered && (currentPage < totalPages - 1 || !indexComplete)) {
     currentPage++;
     updateRequired = true;
   }
@@ -148,6 +168,16 @@ void TxtReaderActivity::displayTaskLoop() {
       xSemaphoreTake(renderingMutex, portMAX_DELAY);
       renderScreen();
       xSemaphoreGive(renderingMutex);
+    } else if (initialized && !indexComplete) {
+      // Index a few more pages between page turns, so a press is never kept waiting for long
+      xSemaphoreTake(renderingMutex, portMAX_DELAY);
+      const bool indexing = extendPageIndex(INDEX_PAGES_PER_STEP);
+      if (indexComplete) {
+        savePageIndexCache();
+      }
+      xSemaphoreGive(renderingMutex);
+      vTaskDelay(indexing ? 1 : INDEX_RETRY_MS / portTICK_PERIOD_MS);
+      continue;
     }
     vTaskDelay(10 / portTICK_PERIOD_MS);
   }
@@ -194,12 +224,23 @@ void TxtReaderActivity::initializeReader() {
   Serial.printf("[%lu] [TRS] Viewport: %dx%d, lines per page: %d\n", millis(), viewportWidth, viewportHeight,
                 linesPerPage);
 
-  // Try to load cached page index first
+  if (!SdMan.openFileForRead("TRS", txt->getPath(), file)) {
+    return;
+  }
+  chunkBuffer = static_cast<uint8_t*>(malloc(CHUNK_SIZE + 1));
+  if (!chunkBuffer) {
+    Serial.printf("[%lu] [TRS] Failed to allocate %zu bytes\n", millis(), CHUNK_SIZE);
+    file.close();
+    return;
+  }
+
+  // Carry on from the cached page index, otherwise start with the first page and index the rest as the book is read
   if (!loadPageIndexCache()) {
-    // Cache not found, build page index
-    buildPageIndex();
-    // Save to cache for next time
-    savePageIndexCache();
+    pageOffsets.clear();
+    pageOffsets.push_back(0);
+    totalPages = 1;
+    indexComplete = false;
+    Serial.printf("[%lu] [TRS] Indexing %zu bytes in the background\n", millis(), txt->getFileSize());
   }
 
   // Load saved progress
@@ -208,43 +249,45 @@ void TxtReaderActivity::initializeReader() {
   initialized = true;
 }
 
-void TxtReaderActivity::buildPageIndex() {
-  pageOffsets.clear();
-  pageOffsets.push_back(0);  // First page starts at offset 0
-
-  size_t offset = 0;
+bool TxtReaderActivity::extendPageIndex(const int maxPages) {
   const size_t fileSize = txt->getFileSize();
+  std::vector<std::string> tempLines;
 
-  Serial.printf("[%lu] [TRS] Building page index for %zu bytes...\n", millis(), fileSize);
-
-  GUI.drawPopup(renderer, "Indexing...");
-
-  while (offset < fileSize) {
-    std::vector<std::string> tempLines;
+  for (int i = 0; i < maxPages && !indexComplete; i++) {
+    const size_t offset = pageOffsets.back();
     size_t nextOffset = offset;
 
-    if (!loadPageAtOffset(offset, tempLines, nextOffset)) {
+    // A page of blank lines has nothing to show but still moves on, only the end of the file ends the index
+    loadPageAtOffset(offset, tempLines, nextOffset);
+    if (nextOffset >= fileSize) {
+      indexComplete = true;
       break;
     }
-
     if (nextOffset <= offset) {
-      // No progress made, avoid infinite loop
-      break;
-    }
-
-    offset = nextOffset;
-    if (offset < fileSize) {
-      pageOffsets.push_back(offset);
-    }
-
-    // Yield to other tasks periodically
-    if (pageOffsets.size() % 20 == 0) {
-      vTaskDelay(1);
+      // The chunk couldn't be read, leave the index open and try again on a later pass
+      Serial.printf("[%lu] [TRS] Page index stopped at %zu, will retry\n", millis(), offset);
+      totalPages = pageOffsets.size();
+      return false;
     }
+    pageOffsets.push_back(nextOffset);
   }
 
   totalPages = pageOffsets.size();
-  Serial.printf("[%lu] [TRS] Built page index: %d pages\n", millis(), totalPages);
+  if (indexComplete) {
+    Serial.printf("[%lu] [TRS] Built page index: %d pages\n", millis(), totalPages);
+  }
+  return !indexComplete;
+}
+
+int TxtReaderActivity::estimatedTotalPages() const {
+  if (indexComplete || pageOffsets.size() < 2) {
+    return totalPages;
+  }
+  // The pages found so far end where the last one starts, in 64 bits as size_t would overflow past a few MB
+  const uint64_t indexedBytes = pageOffsets.back();
+  const uint64_t estimate =
+      (uint64_t{txt->getFileSize()} * (pageOffsets.size() - 1) + indexedBytes - 1) / indexedBytes;
+  return std::max(totalPages, static_cast<int>(estimate));
 }
 
 bool TxtReaderActivity::loadPageAtOffset(size_t offset, std::vector<std::string>& outLines, size_t& nextOffset) {
@@ -257,14 +300,9 @@ bool TxtReaderActivity::loadPageAtOffset(size_t offset, std::vector<std::string>
 
   // Read a chunk from file
   size_t chunkSize = std::min(CHUNK_SIZE, fileSize - offset);
-  auto* buffer = static_cast<uint8_t*>(malloc(chunkSize + 1));
-  if (!buffer) {
-    Serial.printf("[%lu] [TRS] Failed to allocate %zu bytes\n", millis(), chunkSize);
-    return false;
-  }
-
-  if (!txt->readContent(buffer, offset, chunkSize)) {
-    free(buffer);
+  uint8_t* buffer = chunkBuffer;
+  if (!file.seek(offset) || file.read(buffer, chunkSize) != static_cast<int>(chunkSize)) {
+    Serial.printf("[%lu] [TRS] Failed to read %zu bytes at %zu\n", millis(), chunkSize, offset);
     return false;
   }
   buffer[chunkSize] = '\0';
@@ -368,8 +406,6 @@ bool TxtReaderActivity::loadPageAtOffset(size_t offset, std::vector<std::string>
     nextOffset = fileSize;
   }
 
-  free(buffer);
-
   return !outLines.empty();
 }
 
@@ -383,13 +419,25 @@ void TxtReaderActivity::renderScreen() {
     initializeReader();
   }
 
-  if (pageOffsets.empty()) {
+  if (pageOffsets.empty() || !chunkBuffer) {
     renderer.clearScreen();
     renderer.drawCenteredText(UI_12_FONT_ID, 300, "Empty file", true, EpdFontFamily::BOLD);
     renderer.displayBuffer();
     return;
   }
 
+  // Index up to the page being opened, which is only a step or two unless it is the saved progress
+  if (currentPage >= totalPages && !indexComplete) {
+    if (currentPage - totalPages >= INDEX_POPUP_PAGES) {
+      GUI.drawPopup(renderer, "Indexing...");
+    }
+    while (currentPage >= totalPages && extendPageIndex(INDEX_PAGES_PER_STEP)) {
+    }
+    if (indexComplete) {
+      savePageIndexCache();
+    }
+  }
+
   // Bounds check
   if (currentPage < 0) currentPage = 0;
   if (currentPage >= totalPages) currentPage = totalPages - 1;
@@ -515,16 +563,19 @@ void TxtReaderActivity::renderStatusBar(const int orientedMarginRight, const int
   const auto textY = screenHeight - orientedMarginBottom - 4;
   int progressTextWidth = 0;
 
-  const float progress = totalPages > 0 ? (currentPage + 1) * 100.0f / totalPages : 0;
+  const int bookPages = estimatedTotalPages();
+  const float progress = bookPages > 0 ? (currentPage + 1) * 100.0f / bookPages : 0;
+  // Marks the page count as an estimate while the rest of the file is being indexed
+  const char* approx = indexComplete ? "" : "~";
 
   if (showProgressText || showProgressPercentage || showBookPercentage) {
     char progressStr[32];
     if (showProgressPercentage) {
-      snprintf(progressStr, sizeof(progressStr), "%d/%d %.0f%%", currentPage + 1, totalPages, progress);
+      snprintf(progressStr, sizeof(progressStr), "%d/%s%d %.0f%%", currentPage + 1, approx, bookPages, progress);
     } else if (showBookPercentage) {
       snprintf(progressStr, sizeof(progressStr), "%.0f%%", progress);
     } else {
-      snprintf(progressStr, sizeof(progressStr), "%d/%d", currentPage + 1, totalPages);
+      snprintf(progressStr, sizeof(progressStr), "%d/%s%d", currentPage + 1, approx, bookPages);
     }
 
     progressTextWidth = renderer.getTextWidth(SMALL_FONT_ID, progressStr);
@@ -582,7 +633,8 @@ void TxtReaderActivity::loadProgress() {
     uint8_t data[4];
     if (f.read(data, 4) == 4) {
       currentPage = data[0] + (data[1] << 8);
-      if (currentPage >= totalPages) {
+      // Pages past the indexed ones are indexed when the page is rendered
+      if (indexComplete && currentPage >= totalPages) {
         currentPage = totalPages - 1;
       }
       if (currentPage < 0) {
@@ -604,6 +656,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   // - int32_t: font ID (to invalidate cache on font change)
   // - int32_t: screen margin (to invalidate cache on margin change)
   // - uint8_t: paragraph alignment (to invalidate cache on alignment change)
+  // - uint8_t: 1 if the whole file is indexed, 0 if indexing stopped partway
   // - uint32_t: total pages count
   // - N * uint32_t: page offsets
 
@@ -679,8 +732,16 @@ bool TxtReaderActivity::loadPageIndexCache() {
     return false;
   }
 
+  uint8_t complete;
+  serialization::readPod(f, complete);
+
   uint32_t numPages;
   serialization::readPod(f, numPages);
+  if (numPages == 0) {
+    Serial.printf("[%lu] [TRS] Cache has no pages, rebuilding\n", millis());
+    f.close();
+    return false;
+  }
 
   // Read page offsets
   pageOffsets.clear();
@@ -694,7 +755,9 @@ bool TxtReaderActivity::loadPageIndexCache() {
 
   f.close();
   totalPages = pageOffsets.size();
-  Serial.printf("[%lu] [TRS] Loaded page index cache: %d pages\n", millis(), totalPages);
+  indexComplete = complete != 0;
+  Serial.printf("[%lu] [TRS] Loaded page index cache: %d pages%s\n", millis(), totalPages,
+                indexComplete ? "" : " so far");
   return true;
 }
 
@@ -715,6 +778,7 @@ void TxtReaderActivity::savePageIndexCache() const {
   serialization::writePod(f, static_cast<int32_t>(cachedFontId));
   serialization::writePod(f, static_cast<int32_t>(cachedScreenMargin));
   serialization::writePod(f, cachedParagraphAlignment);
+  serialization::writePod(f, static_cast<uint8_t>(indexComplete ? 1 : 0));
   serialization::writePod(f, static_cast<uint32_t>(pageOffsets.size()));
 
   // Write page offsets
@@ -27,6 +27,12 @@ class TxtReaderActivity final : public ActivityWithSubactivity {
   int linesPerPage = 0;
   int viewportWidth = 0;
   bool initialized = false;
+  // Pages are indexed as they are needed and in the display task between page turns, totalPages only counts the
+  // pages found so far until the end of the file is reached
+  bool indexComplete = false;
+  // Kept open while reading, with the buffer pages are read into
+  FsFile file;
+  uint8_t* chunkBuffer = nullptr;
 
   // Cached settings for cache validation (different fonts/margins require re-indexing)
   int cachedFontId = 0;
@@ -41,7 +47,11 @@ class TxtReaderActivity final : public ActivityWithSubactivity {
 
   void initializeReader();
   bool loadPageAtOffset(size_t offset, std::vector<std::string>& outLines, size_t& nextOffset);
-  void buildPageIndex();
+  // Find the start of up to maxPages more pages, returns false once the end of the file is reached or the card fails
+  // to read (the index stays incomplete then, to be extended again later)
+  bool extendPageIndex(int maxPages);
+  // Total pages, extrapolated from the pages found so far while the index is incomplete
+  int estimatedTotalPages() const;
   bool loadPageIndexCache();
   void savePageIndexCache() const;
   void saveProgress() const;
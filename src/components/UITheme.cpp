@@ -53,6 +53,16 @@ int UITheme::getNumberOfItemsPerPage(const GfxRenderer& renderer, bool hasHeader
   return availableHeight / rowHeight;
 }
 
+std::vector<int> UITheme::getCoverThumbHeights() const {
+  std::vector<int> heights = {currentMetrics->homeCoverHeight};
+  for (const ThemeMetrics* metrics : {&BaseMetrics::values, &LyraMetrics::values}) {
+    if (metrics->homeCoverHeight != currentMetrics->homeCoverHeight) {
+      heights.push_back(metrics->homeCoverHeight);
+    }
+  }
+  return heights;
+}
+
 std::string UITheme::getCoverThumbPath(std::string coverBmpPath, int coverHeight) {
   size_t pos = coverBmpPath.find("[HEIGHT]", 0);
   if (pos != std::string::npos) {
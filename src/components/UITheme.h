@@ -21,6 +21,8 @@ class UITheme {
   static int getNumberOfItemsPerPage(const GfxRenderer& renderer, bool hasHeader, bool hasTabBar, bool hasButtonHints,
                                      bool hasSubtitle);
   static std::string getCoverThumbPath(std::string coverBmpPath, int coverHeight);
+  // Cover thumbnail heights used by every theme, current theme first
+  std::vector<int> getCoverThumbHeights() const;
 
  private:
   const ThemeMetrics* currentMetrics;
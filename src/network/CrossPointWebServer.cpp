@@ -1,7 +1,8 @@
 #include "CrossPointWebServer.h"
 
 #include <ArduinoJson.h>
-#include <Epub.h>
+#include <BookCacheKey.h>
+#include <DirectoryListing.h>
 #include <FsHelpers.h>
 #include <SDCardManager.h>
 #include <WiFi.h>
@@ -9,6 +10,7 @@
 
 #include <algorithm>
 
+#include "LibraryIndex.h"
 #include "html/FilesPageHtml.generated.h"
 #include "html/HomePageHtml.generated.h"
 #include "util/StringUtils.h"
@@ -32,17 +34,39 @@ size_t wsUploadSize = 0;
 size_t wsUploadReceived = 0;
 unsigned long wsUploadStartTime = 0;
 bool wsUploadInProgress = false;
+// Cache key of the book the WebSocket upload replaces
+std::string wsReplacedCacheKey;
 String wsLastCompleteName;
 size_t wsLastCompleteSize = 0;
 unsigned long wsLastCompleteAt = 0;
 
-// Helper function to clear epub cache after upload
-void clearEpubCacheIfNeeded(const String& filePath) {
-  // Only clear cache for .epub files
-  if (StringUtils::checkFileExtension(filePath, ".epub")) {
-    Epub(filePath.c_str(), "/.crosspoint").clearCache();
-    Serial.printf("[%lu] [WEB] Cleared epub cache for: %s\n", millis(), filePath.c_str());
+// Cache key of the epub an upload is about to overwrite, empty if there is none. Taken before the file is replaced,
+// since the key comes from the book's content. The key remembered for the path is dropped either way, so whatever
+// is uploaded gets fingerprinted rather than matched on its size
+std::string replacedEpubCacheKey(const String& filePath) {
+  std::string key;
+  if (StringUtils::checkFileExtension(filePath, ".epub") && SdMan.exists(filePath.c_str())) {
+    key = BookCacheKey::get("/.crosspoint", filePath.c_str());
   }
+  BookCacheKey::forget("/.crosspoint", filePath.c_str());
+  return key;
+}
+
+// Helper function to clear the replaced epub's cache after upload, kept when the new file has the same content
+void clearReplacedEpubCache(const String& filePath, const std::string& replacedKey) {
+  if (replacedKey.empty()) {
+    return;
+  }
+  if (SdMan.exists(filePath.c_str()) && BookCacheKey::get("/.crosspoint", filePath.c_str()) == replacedKey) {
+    Serial.printf("[%lu] [WEB] Same content uploaded, keeping epub cache for: %s\n", millis(), filePath.c_str());
+    return;
+  }
+  // Matches the cache directory Epub derives from the key
+  const std::string cachePath = "/.crosspoint/epub_" + replacedKey;
+  if (SdMan.exists(cachePath.c_str())) {
+    SdMan.removeDir(cachePath.c_str());
+  }
+  Serial.printf("[%lu] [WEB] Cleared epub cache for: %s\n", millis(), filePath.c_str());
 }
 
 String normalizeWebPath(const String& inputPath) {
@@ -574,6 +598,7 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
 
     // Check if file already exists - SD operations can be slow
     esp_task_wdt_reset();
+    state.replacedCacheKey = replacedEpubCacheKey(filePath);
     if (SdMan.exists(filePath.c_str())) {
       Serial.printf("[%lu] [WEB] [UPLOAD] Overwriting existing file: %s\n", millis(), filePath.c_str());
       esp_task_wdt_reset();
@@ -649,7 +674,7 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
         String filePath = state.path;
         if (!filePath.endsWith("/")) filePath += "/";
         filePath += state.fileName;
-        clearEpubCacheIfNeeded(filePath);
+        clearReplacedEpubCache(filePath, state.replacedCacheKey);
       }
     }
   } else if (upload.status == UPLOAD_FILE_ABORTED) {
@@ -661,6 +686,8 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
       if (!filePath.endsWith("/")) filePath += "/";
       filePath += state.fileName;
       SdMan.remove(filePath.c_str());
+      // The replaced book is gone as well
+      clearReplacedEpubCache(filePath, state.replacedCacheKey);
     }
     state.error = "Upload aborted";
     Serial.printf("[%lu] [WEB] Upload aborted\n", millis());
@@ -795,11 +822,16 @@ void CrossPointWebServer::handleRename() const {
     return;
   }
 
-  clearEpubCacheIfNeeded(itemPath);
   const bool success = file.rename(newPath.c_str());
   file.close();
 
   if (success) {
+    // Caches are keyed by content, the book keeps its cache under the new name
+    BookCacheKey::relocate("/.crosspoint", itemPath.c_str(), newPath.c_str());
+    LIBRARY_INDEX.moveBook(itemPath.c_str(), newPath.c_str());
+    LIBRARY_INDEX.commit();
+    // Same entry count, so the cached listing of the folder can't tell on its own
+    DirectoryListing::invalidate("/.crosspoint", parentPath.c_str());
     Serial.printf("[%lu] [WEB] Renamed file: %s -> %s\n", millis(), itemPath.c_str(), newPath.c_str());
     server->send(200, "text/plain", "Renamed successfully");
   } else {
@@ -888,11 +920,13 @@ void CrossPointWebServer::handleMove() const {
     return;
   }
 
-  clearEpubCacheIfNeeded(itemPath);
   const bool success = file.rename(newPath.c_str());
   file.close();
 
   if (success) {
+    BookCacheKey::relocate("/.crosspoint", itemPath.c_str(), newPath.c_str());
+    LIBRARY_INDEX.moveBook(itemPath.c_str(), newPath.c_str());
+    LIBRARY_INDEX.commit();
     Serial.printf("[%lu] [WEB] Moved file: %s -> %s\n", millis(), itemPath.c_str(), newPath.c_str());
     server->send(200, "text/plain", "Moved successfully");
   } else {
@@ -972,6 +1006,10 @@ void CrossPointWebServer::handleDelete() const {
   } else {
     // For files, use remove
     success = SdMan.remove(itemPath.c_str());
+    if (success) {
+      LIBRARY_INDEX.removeBook(itemPath);
+      LIBRARY_INDEX.commit();
+    }
   }
 
   if (success) {
@@ -1051,6 +1089,7 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
 
           // Check if file exists and remove it
           esp_task_wdt_reset();
+          wsReplacedCacheKey = replacedEpubCacheKey(filePath);
           if (SdMan.exists(filePath.c_str())) {
             SdMan.remove(filePath.c_str());
           }
@@ -1120,7 +1159,7 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
         String filePath = wsUploadPath;
         if (!filePath.endsWith("/")) filePath += "/";
         filePath += wsUploadFileName;
-        clearEpubCacheIfNeeded(filePath);
+        clearReplacedEpubCache(filePath, wsReplacedCacheKey);
 
         wsServer->sendTXT(num, "DONE");
         lastProgressSent = 0;
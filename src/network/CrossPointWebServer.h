@@ -37,6 +37,8 @@ class CrossPointWebServer {
     size_t size = 0;
     bool success = false;
     String error = "";
+    // Cache key of the book being overwritten, cleared once the upload is in
+    std::string replacedCacheKey;
 
     // Upload write buffer - batches small writes into larger SD card operations
     // 4KB is a good balance: large enough to reduce syscall overhead, small enough
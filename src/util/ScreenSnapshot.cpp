@@ -0,0 +1,127 @@
+#include "ScreenSnapshot.h"
+
+#include <GfxRenderer.h>
+#include <HardwareSerial.h>
+#include <SDCardManager.h>
+#include <Serialization.h>
+
+#include <utility>
+
+namespace {
+constexpr uint8_t SNAPSHOT_FILE_VERSION = 1;
+constexpr char SNAPSHOT_DIR[] = "/.crosspoint/screens";
+}  // namespace
+
+ScreenSnapshot::ScreenSnapshot(std::string key, const char* slot)
+    : key(std::move(key)), path(std::string(SNAPSHOT_DIR) + "/" + slot + ".fb") {}
+
+ScreenSnapshot::~ScreenSnapshot() { close(); }
+
+std::string ScreenSnapshot::describeSource(const std::string& path) {
+  FsFile source;
+  if (!SdMan.openFileForRead("SNP", path, source)) {
+    return path;
+  }
+  // A thumbnail regenerated in place can come out the same size, its modify time tells the two apart
+  uint16_t date = 0;
+  uint16_t time = 0;
+  source.getModifyDateTime(&date, &time);
+  const auto size = source.size();
+  source.close();
+  return path + ":" + std::to_string(size) + ":" + std::to_string((static_cast<uint32_t>(date) << 16) | time);
+}
+
+bool ScreenSnapshot::openForRead() {
+  close();
+  if (!SdMan.exists(path.c_str()) || !SdMan.openFileForRead("SNP", path, file)) {
+    return false;
+  }
+
+  uint8_t version;
+  std::string storedKey;
+  uint32_t planeSize;
+  serialization::readPod(file, version);
+  if (version != SNAPSHOT_FILE_VERSION) {
+    Serial.printf("[%lu] [SNP] Unknown snapshot version %u\n", millis(), version);
+    close();
+    return false;
+  }
+  serialization::readString(file, storedKey);
+  serialization::readPod(file, planeCount);
+  serialization::readPod(file, planeSize);
+
+  const size_t expectedSize = file.position() + static_cast<size_t>(planeCount) * planeSize;
+  if (storedKey != key || planeSize != GfxRenderer::getBufferSize() || planeCount == 0 || planeCount > MAX_PLANES ||
+      file.size() != expectedSize) {
+    Serial.printf("[%lu] [SNP] Snapshot %s is stale or incomplete\n", millis(), path.c_str());
+    close();
+    return false;
+  }
+
+  planesDone = 0;
+  return true;
+}
+
+bool ScreenSnapshot::readPlane(uint8_t* dst) {
+  if (!file || writing || planesDone >= planeCount) {
+    return false;
+  }
+  const size_t planeSize = GfxRenderer::getBufferSize();
+  if (file.read(dst, planeSize) != static_cast<int>(planeSize)) {
+    Serial.printf("[%lu] [SNP] Short read from %s\n", millis(), path.c_str());
+    return false;
+  }
+  planesDone++;
+  return true;
+}
+
+bool ScreenSnapshot::openForWrite(const uint8_t planeCount) {
+  close();
+  if (planeCount == 0 || planeCount > MAX_PLANES) {
+    return false;
+  }
+
+  SdMan.mkdir(SNAPSHOT_DIR);
+  if (!SdMan.openFileForWrite("SNP", path, file)) {
+    return false;
+  }
+
+  writing = true;
+  this->planeCount = planeCount;
+  planesDone = 0;
+  serialization::writePod(file, SNAPSHOT_FILE_VERSION);
+  serialization::writeString(file, key);
+  serialization::writePod(file, planeCount);
+  serialization::writePod(file, static_cast<uint32_t>(GfxRenderer::getBufferSize()));
+  return true;
+}
+
+bool ScreenSnapshot::writePlane(const uint8_t* src) {
+  if (!file || !writing || planesDone >= planeCount) {
+    return false;
+  }
+  const size_t planeSize = GfxRenderer::getBufferSize();
+  if (file.write(src, planeSize) != planeSize) {
+    Serial.printf("[%lu] [SNP] Failed to write plane to %s\n", millis(), path.c_str());
+    close();
+    return false;
+  }
+  planesDone++;
+  if (planesDone == planeCount) {
+    Serial.printf("[%lu] [SNP] Saved snapshot %s (%u planes)\n", millis(), path.c_str(), planeCount);
+    writing = false;
+    file.close();
+  }
+  return true;
+}
+
+void ScreenSnapshot::close() {
+  if (file) {
+    file.close();
+  }
+  if (writing) {
+    // Never leave a partial snapshot behind, the size check would reject it anyway but it wastes space
+    SdMan.remove(path.c_str());
+    writing = false;
+  }
+}
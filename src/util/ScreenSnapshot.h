@@ -0,0 +1,64 @@
+#pragma once
+
+#include <SdFat.h>
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Raw frame buffer snapshots of fully rendered screens, stored on the SD card.
+ * A snapshot holds one or more packed display planes (BW, then the grayscale LSB and MSB planes when present)
+ * exactly as they were handed to the display, so showing the screen again is a sequential read per plane
+ * instead of parsing, scaling and dithering a BMP.
+ *
+ * Each screen keeps its snapshot in a fixed slot file (one for the home screen, one per sleep screen mode), so a
+ * changed screen overwrites the old snapshot rather than leaving it behind. The slot holds a key string that must
+ * capture everything that affects the rendered pixels (source files, orientation, filter settings...), and a
+ * snapshot whose key doesn't match is treated as a miss.
+ */
+class ScreenSnapshot {
+ public:
+  static constexpr uint8_t MAX_PLANES = 3;
+
+  ScreenSnapshot(std::string key, const char* slot);
+  ~ScreenSnapshot();
+
+  ScreenSnapshot(const ScreenSnapshot& other) = delete;
+  ScreenSnapshot& operator=(const ScreenSnapshot& other) = delete;
+
+  /**
+   * Key fragment for a source file: its path, size and modify time, or just the path if it can't be opened.
+   */
+  static std::string describeSource(const std::string& path);
+
+  /**
+   * Open the snapshot and validate its header and size. Returns false if it is missing or doesn't match the key.
+   */
+  bool openForRead();
+  uint8_t getPlaneCount() const { return planeCount; }
+  /**
+   * Read the next plane (GfxRenderer::getBufferSize() bytes) into dst.
+   */
+  bool readPlane(uint8_t* dst);
+
+  /**
+   * Start a new snapshot of planeCount planes, replacing any existing one.
+   */
+  bool openForWrite(uint8_t planeCount);
+  /**
+   * Append the next plane. The snapshot is complete, and only then usable, once every plane has been written.
+   */
+  bool writePlane(const uint8_t* src);
+  /**
+   * Close the file. An incomplete snapshot being written is deleted.
+   */
+  void close();
+
+ private:
+  std::string key;
+  std::string path;
+  FsFile file;
+  bool writing = false;
+  uint8_t planeCount = 0;
+  uint8_t planesDone = 0;
+};
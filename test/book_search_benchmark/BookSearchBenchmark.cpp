@@ -0,0 +1,506 @@
+#include <HtmlTextScanner.h>
+#include <TextMatcher.h>
+#include <WordIndex.h>
+#include <ZipFile.h>
+#include <miniz.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Searches a corpus of EPUBs the way EpubReaderSearchActivity does, streaming every chapter out of ZipFile's inflater
+// through HtmlTextScanner, and reports throughput next to inflating alone. Pass EPUB files or directories holding
+// them; without arguments a synthetic corpus with planted matches is generated and the match counts are checked.
+// Every chapter is also scanned whole and one byte at a time, which must report the same matches as streaming.
+// Each book then gets a WordIndex, built in two passes like an interrupted search would. Queries it can answer must
+// get exactly the matches scanning every chapter finds straight from its postings, the others the same matches from
+// scanning only the chapters it can't rule out. Queries match at word starts as
+// indexed searches do; without the index any substring matches, which is checked on the synthetic corpus.
+
+namespace {
+constexpr int RUNS = 3;
+constexpr int SYNTHETIC_BOOKS = 4;
+constexpr int SYNTHETIC_CHAPTERS = 24;
+constexpr int SYNTHETIC_PARAGRAPHS = 220;
+// Chapters with planted matches, and the matches planted in each
+constexpr int PLANT_EVERY = 3;
+constexpr int NEEDLES_PER_PLANT = 3;
+constexpr int GREETINGS_PER_PLANT = 2;
+// Results listed on a screen
+constexpr size_t SCREEN_ROWS = 8;
+
+using Clock = std::chrono::steady_clock;
+
+const std::atomic<bool> NEVER_CANCELLED{false};
+
+double msSince(const Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+uint32_t hash(uint32_t x) {
+  x = (x ^ 61) ^ (x >> 16);
+  x *= 9;
+  x ^= x >> 4;
+  x *= 0x27d4eb2d;
+  return x ^ (x >> 15);
+}
+
+struct Match {
+  uint32_t textOffset;
+  std::string snippet;
+  bool operator==(const Match& other) const { return textOffset == other.textOffset && snippet == other.snippet; }
+};
+
+class NullSink final : public Print {
+ public:
+  size_t bytes = 0;
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, const size_t size) override {
+    bytes += size;
+    return size;
+  }
+};
+
+struct Chapter {
+  std::string book;
+  std::string name;
+  size_t size;
+};
+
+// Prose with mixed case, accents, entities and inline markup
+std::string makeChapter(const int book, const int chapter) {
+  static const char* const WORDS[] = {"the",     "And",   "river", "Lantern", "café",    "naïve",  "Über",
+                                      "straße",  "time",  "LIGHT", "quiet",   "hay",     "window", "Москва",
+                                      "дорога",  "river", "of",    "a",       "Needles", "stack",  "evening"};
+  constexpr size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+  std::string html =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<!DOCTYPE html>\n<html xmlns=\"http://www.w3.org/1999/xhtml\">\n"
+      "<head><title>needle in the haystack</title></head>\n<body>\n<h1>Chapter " +
+      std::to_string(chapter + 1) + "</h1>\n";
+  const bool planted = chapter % PLANT_EVERY == 0;
+  for (int p = 0; p < SYNTHETIC_PARAGRAPHS; p++) {
+    const uint32_t seed = hash(book * 100003 + chapter * 1009 + p);
+    html += p % 17 == 0 ? "<p class=\"indent\">" : "<p>";
+    const int words = 40 + static_cast<int>(seed % 60);
+    for (int w = 0; w < words; w++) {
+      const uint32_t h = hash(seed + w);
+      if (w > 0) html += h % 11 == 0 ? "\n  " : " ";
+      if (h % 29 == 0) {
+        html += std::string("<em>") + WORDS[(h >> 8) % WORD_COUNT] + "</em>";
+      } else if (h % 37 == 0) {
+        html += "&amp;";
+      } else if (h % 41 == 0) {
+        html += "don&#8217;t";
+      } else {
+        html += WORDS[(h >> 8) % WORD_COUNT];
+      }
+    }
+    html += "</p>\n";
+
+    if (planted && p == SYNTHETIC_PARAGRAPHS / 2) {
+      // Matches: case, whitespace runs, an inline tag and a character reference
+      html += "<p>Then the NEEDLE in the haystack was found.</p>\n";
+      html += "<p>a needle <em>in</em>\n   the Haystack</p>\n";
+      html += "<p>one more needle in the hay&#115;tack</p>\n";
+      html += "<p>ПРИВЕТ мир</p>\n<p>Он сказал: привет   Мир.</p>\n";
+      // Not matches: markup is never text, and matches start words
+      html += "<!-- needle in the haystack --><p><img alt=\"needle in the haystack\" src=\"x.png\"/></p>\n";
+      html += "<p>the aneedle in the haystack</p>\n";
+    }
+  }
+  html += "</body>\n</html>\n";
+  return html;
+}
+
+bool writeSyntheticBook(const std::string& path, const int book) {
+  mz_zip_archive zip = {};
+  if (!mz_zip_writer_init_file(&zip, path.c_str(), 0)) {
+    return false;
+  }
+  bool ok = mz_zip_writer_add_mem(&zip, "mimetype", "application/epub+zip", 20, MZ_NO_COMPRESSION);
+  for (int c = 0; c < SYNTHETIC_CHAPTERS && ok; c++) {
+    const std::string name = "OEBPS/chapter" + std::to_string(c) + ".xhtml";
+    const std::string html = makeChapter(book, c);
+    // One chapter stored rather than deflated, as some packagers do
+    const mz_uint level = c == 1 ? MZ_NO_COMPRESSION : MZ_DEFAULT_LEVEL;
+    ok = mz_zip_writer_add_mem(&zip, name.c_str(), html.data(), html.size(), level);
+  }
+  ok = ok && mz_zip_writer_finalize_archive(&zip);
+  mz_zip_writer_end(&zip);
+  return ok;
+}
+
+bool isChapter(const std::string& name) {
+  for (const char* extension : {".xhtml", ".html", ".htm"}) {
+    const size_t length = strlen(extension);
+    if (name.size() > length && name.compare(name.size() - length, length, extension) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void listChapters(const std::string& book, std::vector<Chapter>& out) {
+  mz_zip_archive zip = {};
+  if (!mz_zip_reader_init_file(&zip, book.c_str(), 0)) {
+    std::cerr << "Skipping " << book << ": not a zip file\n";
+    return;
+  }
+  for (mz_uint i = 0; i < mz_zip_reader_get_num_files(&zip); i++) {
+    mz_zip_archive_file_stat stat;
+    if (mz_zip_reader_file_stat(&zip, i, &stat) && isChapter(stat.m_filename)) {
+      out.push_back({book, stat.m_filename, static_cast<size_t>(stat.m_uncomp_size)});
+    }
+  }
+  mz_zip_reader_end(&zip);
+}
+
+std::string extract(const Chapter& chapter) {
+  mz_zip_archive zip = {};
+  std::string html;
+  if (mz_zip_reader_init_file(&zip, chapter.book.c_str(), 0)) {
+    size_t size = 0;
+    if (void* data = mz_zip_reader_extract_file_to_heap(&zip, chapter.name.c_str(), &size, 0)) {
+      html.assign(static_cast<const char*>(data), size);
+      mz_free(data);
+    }
+    mz_zip_reader_end(&zip);
+  }
+  return html;
+}
+
+// How a chapter's bytes reach the scanner
+enum class Feed { STREAM, WHOLE, BYTES };
+
+std::vector<Match> scan(const TextMatcher& matcher, const Chapter& chapter, const Feed feed, const std::string* html) {
+  std::vector<Match> matches;
+  HtmlTextScanner scanner(
+      matcher,
+      [&matches](const uint32_t textOffset, const std::string& snippet) {
+        matches.push_back({textOffset, snippet});
+        return true;
+      },
+      NEVER_CANCELLED);
+  if (feed == Feed::STREAM) {
+    ZipFile(chapter.book).readFileToStream(chapter.name.c_str(), scanner, 1024);
+  } else if (feed == Feed::WHOLE) {
+    scanner.write(reinterpret_cast<const uint8_t*>(html->data()), html->size());
+  } else {
+    for (const char c : *html) {
+      scanner.write(static_cast<uint8_t>(c));
+    }
+  }
+  scanner.finish();
+  return matches;
+}
+
+// Index chapters [from, to) of a book as one search pass would, leaving out the chapter at abortAt
+bool indexChapters(const std::string& dir, const std::vector<Chapter>& chapters, const size_t bookStart,
+                   const size_t from, const size_t to, const size_t abortAt, const TextMatcher& matcher) {
+  WordIndexWriter writer(dir, static_cast<uint16_t>(from));
+  if (!writer.begin()) {
+    return false;
+  }
+  for (size_t i = from; i < to; i++) {
+    HtmlTextScanner scanner(
+        matcher, [](uint32_t, const std::string&) { return true; }, NEVER_CANCELLED);
+    writer.startSpineItem(static_cast<uint16_t>(i));
+    scanner.setListener(&writer);
+    const Chapter& chapter = chapters[bookStart + i];
+    ZipFile(chapter.book).readFileToStream(chapter.name.c_str(), scanner, 1024);
+    scanner.finish();
+    if (i == abortAt) {
+      writer.abortSpineItem();
+      break;
+    }
+    writer.commitSpineItem(scanner.textLength());
+  }
+  return writer.finish();
+}
+
+void check(const bool condition, const std::string& what, int& failures) {
+  if (!condition) {
+    std::cout << "FAIL: " << what << "\n";
+    failures++;
+  }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  int failures = 0;
+  std::vector<std::string> books;
+  std::string scratch;
+
+  for (int i = 1; i < argc; i++) {
+    const std::filesystem::path path(argv[i]);
+    if (std::filesystem::is_directory(path)) {
+      for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".epub") {
+          books.push_back(entry.path().string());
+        }
+      }
+    } else {
+      books.push_back(path.string());
+    }
+  }
+  std::sort(books.begin(), books.end());
+
+  const bool synthetic = books.empty();
+  if (synthetic) {
+    char scratchTemplate[] = "/tmp/booksearch-XXXXXX";
+    if (!mkdtemp(scratchTemplate)) {
+      std::cerr << "Could not create a scratch directory\n";
+      return 1;
+    }
+    scratch = scratchTemplate;
+    for (int b = 0; b < SYNTHETIC_BOOKS; b++) {
+      books.push_back(scratch + "/book" + std::to_string(b) + ".epub");
+      if (!writeSyntheticBook(books.back(), b)) {
+        std::cerr << "Could not write " << books.back() << "\n";
+        return 1;
+      }
+    }
+  }
+
+  std::vector<Chapter> chapters;
+  for (const auto& book : books) {
+    listChapters(book, chapters);
+  }
+  size_t totalBytes = 0;
+  for (const auto& chapter : chapters) {
+    totalBytes += chapter.size;
+  }
+  if (totalBytes == 0) {
+    std::cerr << "No chapters found\n";
+    return 1;
+  }
+  const double totalMb = static_cast<double>(totalBytes) / (1024.0 * 1024.0);
+
+  // Chapter range of each book, the chapters being its spine items
+  std::vector<std::pair<size_t, size_t>> bookRanges;
+  for (size_t c = 0; c < chapters.size(); c++) {
+    if (c == 0 || chapters[c].book != chapters[c - 1].book) {
+      bookRanges.emplace_back(c, c);
+    }
+    bookRanges.back().second = c + 1;
+  }
+
+  // Baseline: inflating alone
+  double inflateMs = 1e30;
+  for (int run = 0; run < RUNS; run++) {
+    const auto start = Clock::now();
+    for (const auto& chapter : chapters) {
+      NullSink sink;
+      ZipFile(chapter.book).readFileToStream(chapter.name.c_str(), sink, 1024);
+    }
+    inflateMs = std::min(inflateMs, msSince(start));
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "corpus                 " << books.size() << " books, " << chapters.size() << " chapters, " << totalMb
+            << " MiB of XHTML" << (synthetic ? " (synthetic)" : "") << "\n";
+  std::cout << "inflate only           " << totalMb / (inflateMs / 1000.0) << " MiB/s\n";
+
+  // Word index of every book, the first pass stopped halfway through a chapter
+  char indexTemplate[] = "/tmp/booksearch-index-XXXXXX";
+  if (!mkdtemp(indexTemplate)) {
+    std::cerr << "Could not create an index directory\n";
+    return 1;
+  }
+  const std::string indexRoot = indexTemplate;
+  std::vector<std::string> indexDirs;
+  double indexMs = 0;
+  {
+    TextMatcher matcher;
+    matcher.setQuery("index");
+    for (size_t b = 0; b < bookRanges.size(); b++) {
+      indexDirs.push_back(indexRoot + "/book" + std::to_string(b));
+      const size_t count = bookRanges[b].second - bookRanges[b].first;
+      const size_t half = count / 2;
+      const auto start = Clock::now();
+      const bool firstPass = half == 0 || indexChapters(indexDirs[b], chapters, bookRanges[b].first, 0, count, half,
+                                                        matcher);
+      const bool secondPass =
+          indexChapters(indexDirs[b], chapters, bookRanges[b].first, half, count, count, matcher);
+      indexMs += msSince(start);
+      check(firstPass && secondPass, "index written: " + chapters[bookRanges[b].first].book, failures);
+      WordIndex index(indexDirs[b]);
+      check(index.load() == count, "index resumed and complete: " + chapters[bookRanges[b].first].book, failures);
+    }
+  }
+  size_t indexBytes = 0;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(indexRoot)) {
+    if (entry.is_regular_file()) {
+      indexBytes += entry.file_size();
+    }
+  }
+  std::cout << "word index             " << totalMb / (indexMs / 1000.0) << " MiB/s built, "
+            << static_cast<double>(indexBytes) / (1024.0 * 1024.0) << " MiB ("
+            << 100.0 * static_cast<double>(indexBytes) / static_cast<double>(totalBytes) << "% of XHTML)\n";
+
+  const char* const QUERIES[] = {"Needle in the haystack", "needle in the hay", "привет мир", "the", "zebra crossing",
+                                 "don’t", "Lan"};
+  for (const char* query : QUERIES) {
+    TextMatcher matcher;
+    if (!matcher.setQuery(query, true)) {
+      check(false, std::string("query accepted: ") + query, failures);
+      continue;
+    }
+
+    // Inflate and scan, as on the device
+    double searchMs = 1e30;
+    size_t hits = 0;
+    std::vector<std::vector<Match>> streamed(chapters.size());
+    for (int run = 0; run < RUNS; run++) {
+      hits = 0;
+      const auto start = Clock::now();
+      for (size_t c = 0; c < chapters.size(); c++) {
+        streamed[c] = scan(matcher, chapters[c], Feed::STREAM, nullptr);
+        hits += streamed[c].size();
+      }
+      searchMs = std::min(searchMs, msSince(start));
+    }
+
+    // Scan alone from memory, and the same matches however the bytes are split
+    double scanMs = 0;
+    bool sameMatches = true;
+    for (size_t c = 0; c < chapters.size(); c++) {
+      const std::string html = extract(chapters[c]);
+      const auto start = Clock::now();
+      const auto whole = scan(matcher, chapters[c], Feed::WHOLE, &html);
+      scanMs += msSince(start);
+      sameMatches = sameMatches && whole == streamed[c] && scan(matcher, chapters[c], Feed::BYTES, &html) == whole;
+    }
+    check(sameMatches, std::string("matches independent of chunking: ") + query, failures);
+
+    // Through the word index: answered from the postings, or scanning only the chapters it can't rule out
+    const bool answerable = WordIndex::answers(matcher);
+    double indexedMs = 1e30;
+    double snippetMs = 0;
+    size_t indexedScanned = 0;
+    bool sameIndexed = true;
+    for (int run = 0; run < RUNS; run++) {
+      indexedScanned = 0;
+      const auto start = Clock::now();
+      for (size_t b = 0; b < bookRanges.size(); b++) {
+        WordIndex index(indexDirs[b]);
+        index.load();
+        if (answerable) {
+          std::vector<std::vector<uint32_t>> found(bookRanges[b].second - bookRanges[b].first);
+          sameIndexed = index.findMatches(matcher,
+                                          [&found](const WordIndex::Hit& hit) {
+                                            found[hit.spineIndex].push_back(hit.textOffset);
+                                            return true;
+                                          }) &&
+                        sameIndexed;
+          for (size_t c = bookRanges[b].first; c < bookRanges[b].second; c++) {
+            const auto& offsets = found[c - bookRanges[b].first];
+            sameIndexed = sameIndexed && offsets.size() == streamed[c].size();
+            for (size_t m = 0; sameIndexed && m < offsets.size(); m++) {
+              sameIndexed = offsets[m] == streamed[c][m].textOffset;
+            }
+          }
+          continue;
+        }
+        std::vector<bool> candidates;
+        const bool narrowed = index.findCandidates(matcher, candidates);
+        for (size_t c = bookRanges[b].first; c < bookRanges[b].second; c++) {
+          const size_t spineIndex = c - bookRanges[b].first;
+          if (narrowed && spineIndex < candidates.size() && !candidates[spineIndex]) {
+            sameIndexed = sameIndexed && streamed[c].empty();
+            continue;
+          }
+          indexedScanned++;
+          sameIndexed = sameIndexed && scan(matcher, chapters[c], Feed::STREAM, nullptr) == streamed[c];
+        }
+      }
+      indexedMs = std::min(indexedMs, msSince(start));
+    }
+    check(sameIndexed, std::string("indexed search finds the same matches: ") + query, failures);
+
+    // Snippets for a screen of answered matches, read from the first match's chapter up to the last of them
+    if (answerable) {
+      for (size_t c = 0; c < chapters.size(); c++) {
+        if (streamed[c].empty()) {
+          continue;
+        }
+        const uint32_t lastOffset = streamed[c][std::min<size_t>(SCREEN_ROWS, streamed[c].size()) - 1].textOffset;
+        const auto start = Clock::now();
+        HtmlTextScanner scanner(
+            matcher, [lastOffset](const uint32_t textOffset, const std::string&) { return textOffset < lastOffset; },
+            NEVER_CANCELLED);
+        ZipFile(chapters[c].book).readFileToStream(chapters[c].name.c_str(), scanner, 1024);
+        snippetMs = msSince(start);
+        break;
+      }
+    }
+
+    std::cout << "search \"" << query << "\"" << std::string(std::max<int>(1, 22 - static_cast<int>(strlen(query))), ' ')
+              << totalMb / (searchMs / 1000.0) << " MiB/s streamed, " << totalMb / (scanMs / 1000.0)
+              << " MiB/s scan only, " << hits << " hits\n";
+    if (answerable) {
+      std::cout << "  with word index        " << indexedMs << " ms answered from postings, " << snippetMs
+                << " ms for a screen of snippets (" << searchMs << " ms without)\n";
+    } else {
+      std::cout << "  with word index        " << indexedMs << " ms, " << indexedScanned << "/" << chapters.size()
+                << " chapters scanned (" << searchMs << " ms without)\n";
+    }
+
+    if (synthetic) {
+      const int planted = (SYNTHETIC_CHAPTERS + PLANT_EVERY - 1) / PLANT_EVERY * SYNTHETIC_BOOKS;
+      if (strcmp(query, QUERIES[0]) == 0 || strcmp(query, QUERIES[1]) == 0) {
+        check(hits == static_cast<size_t>(planted * NEEDLES_PER_PLANT), "planted needles found", failures);
+        check(answerable, "phrase answered from the index", failures);
+      } else if (strcmp(query, QUERIES[2]) == 0) {
+        check(hits == static_cast<size_t>(planted * GREETINGS_PER_PLANT), "planted greetings found", failures);
+      } else if (strcmp(query, QUERIES[4]) == 0) {
+        check(hits == 0 && answerable, "absent phrase not found", failures);
+      } else if (strcmp(query, QUERIES[5]) == 0) {
+        check(!answerable && hits > 0, "query with punctuation narrowed rather than answered", failures);
+      }
+    }
+  }
+
+  if (synthetic) {
+    const size_t planted = (SYNTHETIC_CHAPTERS + PLANT_EVERY - 1) / PLANT_EVERY * SYNTHETIC_BOOKS;
+    TextMatcher substring;
+    TextMatcher wordStart;
+    substring.setQuery("eedle in the hay");
+    wordStart.setQuery("eedle in the hay", true);
+    size_t substringHits = 0;
+    size_t wordStartHits = 0;
+    for (const auto& chapter : chapters) {
+      substringHits += scan(substring, chapter, Feed::STREAM, nullptr).size();
+      wordStartHits += scan(wordStart, chapter, Feed::STREAM, nullptr).size();
+    }
+    // The planted "aneedle" as well
+    check(substringHits == planted * (NEEDLES_PER_PLANT + 1), "substring search matches inside words", failures);
+    check(wordStartHits == 0, "word start search only matches at word starts", failures);
+  }
+
+  std::cout << "scanner state          " << sizeof(HtmlTextScanner) << " bytes\n";
+
+  std::filesystem::remove_all(indexRoot);
+  if (!scratch.empty()) {
+    const std::string cleanup = "rm -rf " + scratch;
+    if (std::system(cleanup.c_str()) != 0) {
+      std::cerr << "Could not remove " << scratch << "\n";
+    }
+  }
+
+  if (failures > 0) {
+    std::cout << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All checks passed\n";
+  return 0;
+}
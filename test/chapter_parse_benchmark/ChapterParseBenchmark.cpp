@@ -0,0 +1,680 @@
+#include <SdFat.h>
+#include <miniz.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lib/Epub/Epub/Page.h"
+#include "lib/Epub/Epub/css/CssParser.h"
+#include "lib/Epub/Epub/parsers/ChapterHtmlSlimParser.h"
+#include "stubs/GfxRenderer.h"
+
+// Parses a large synthetic XHTML chapter through ChapterHtmlSlimParser with a null renderer (fixed glyph widths,
+// no drawing) and reports throughput. Every finished page is serialized and hashed, so any change to the parser's
+// output shows up as a different checksum.
+//
+// Stylesheets given on the command line, on their own or inside an EPUB, are loaded and timed too: their load memory,
+// and resolveStyle over the book's chapters in document order (or over the classes a bare stylesheet names).
+//
+// Usage: ChapterParseBenchmark [paragraphs] [stylesheet.css | book.epub]...
+
+namespace {
+
+// Every operator new allocation is counted, so the heap a stylesheet load needs at its peak can be measured
+size_t heapInUse = 0;
+size_t heapPeak = 0;
+
+}  // namespace
+
+void* operator new(const size_t size) {
+  auto* block = static_cast<std::max_align_t*>(std::malloc(size + sizeof(std::max_align_t)));
+  if (!block) throw std::bad_alloc();
+  *reinterpret_cast<size_t*>(block) = size;
+  heapInUse += size;
+  heapPeak = std::max(heapPeak, heapInUse);
+  return block + 1;
+}
+
+void operator delete(void* pointer) noexcept {
+  if (!pointer) return;
+  auto* block = static_cast<std::max_align_t*>(pointer) - 1;
+  heapInUse -= *reinterpret_cast<size_t*>(block);
+  std::free(block);
+}
+
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+
+namespace {
+
+constexpr int RUNS = 5;
+constexpr int FONT_ID = 0;
+constexpr uint16_t VIEWPORT_WIDTH = 460;
+constexpr uint16_t VIEWPORT_HEIGHT = 760;
+
+const char* const VOCABULARY[] = {
+    "the",       "of",       "and",        "a",         "to",       "in",          "was",        "he",
+    "that",      "it",       "his",        "her",       "with",     "as",          "had",        "for",
+    "remembered", "afternoon", "lighthouse", "carefully", "beneath", "conversation", "extraordinary", "window",
+    "garden",    "silence",  "returned",   "morning",   "distance", "understood",  "mountains",  "letters",
+    "unquestionably", "river", "stairs",   "whispered", "glass",    "evening",     "certainly",  "harbour"};
+constexpr size_t VOCABULARY_SIZE = sizeof(VOCABULARY) / sizeof(VOCABULARY[0]);
+
+// Publisher stylesheets tend to define a rule for almost every class they use
+constexpr int FILLER_CLASSES = 300;
+
+const char* const STYLESHEET =
+    "@import url(\"fonts.css\");\n"
+    "/* Body text */\n"
+    "@font-face { font-family: \"Body\"; src: url(fonts/body.otf); }\n"
+    "p { text-indent: 1.5em; /* first line */ margin: 0; }\n"
+    "@media amzn-kf8 { p { text-indent: 3em; } }\n"
+    "p.first { text-indent: 0; }\n"
+    ".center { text-align: center; }\n"
+    ".smallcaps { font-variant: small-caps; }\n"
+    ".emph { font-style: italic; }\n"
+    ".heavy { font-weight: bold; }\n"
+    "h2 { text-align: center; margin-top: 2em; }\n"
+    "blockquote { margin-left: 2em; margin-right: 2em; }\n"
+    "span.underline { text-decoration: underline; }\n"
+    "blockquote p { text-align: left; }\n"
+    "section.chapter > h2 span.smallcaps { text-decoration: underline; }\n";
+
+// Context selectors in the style of Standard Ebooks and calibre output (modeled on their patterns, not copied from a
+// particular book), for the lookup benchmark
+const char* const CONTEXT_STYLESHEET =
+    "section > p { text-indent: 1em; }\n"
+    "blockquote p, blockquote > p.first { text-indent: 0; margin-left: 1em; }\n"
+    "header p, footer p, td p { text-indent: 0; text-align: center; }\n"
+    "div.poem p { text-align: left; text-indent: 0; }\n"
+    "div.poem div.stanza > span { margin-left: 1em; }\n"
+    "div.letter p.signature, div.letter > p.salutation { font-style: italic; }\n"
+    "section.chapter h2 span.smallcaps { font-weight: bold; }\n"
+    "body > section.chapter > p.first { text-indent: 0; }\n"
+    "h2 + p, p:first-child { text-indent: 0; }\n"
+    ".calibre1 .c12, .calibre3 span.emph { font-style: normal; }\n"
+    "div.c17 p em { font-weight: bold; }\n";
+uint32_t nextRandom(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+std::string sentence(uint32_t& state) {
+  std::string out;
+  const uint32_t words = 6 + nextRandom(state) % 14;
+  for (uint32_t i = 0; i < words; i++) {
+    const char* word = VOCABULARY[nextRandom(state) % VOCABULARY_SIZE];
+    if (!out.empty()) out += ' ';
+    switch (nextRandom(state) % 24) {
+      case 0:
+        out += "<em>" + std::string(word) + "</em>";
+        break;
+      case 1:
+        out += "<strong>" + std::string(word) + "</strong>";
+        break;
+      case 2:
+        out += "<span class=\"smallcaps\">" + std::string(word) + "</span>";
+        break;
+      case 3:
+        out += "<i>" + std::string(word) + "</i>,";
+        break;
+      case 4:
+        out += "<a href=\"notes.xhtml#n" + std::to_string(nextRandom(state) % 500) + "\" class=\"noteref\">" + word +
+               "</a>";
+        break;
+      case 5:
+        out += "<span class=\"emph heavy\">" + std::string(word) + "</span>";
+        break;
+      case 6:
+        out += std::string(word) + "<sup>" + std::to_string(nextRandom(state) % 90 + 1) + "</sup>";
+        break;
+      case 7:
+        out += "<span style=\"font-weight: bold\">" + std::string(word) + "</span>";
+        break;
+      case 8:
+        out += "<span class=\"underline\">" + std::string(word) + "</span>";
+        break;
+      case 9:
+      case 10:
+        out += "<span class=\"c" + std::to_string(nextRandom(state) % FILLER_CLASSES) + " calibre" +
+               std::to_string(nextRandom(state) % 8) + "\">" + word + "</span>";
+        break;
+      default:
+        out += word;
+    }
+  }
+  out += '.';
+  out[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(out[0])));
+  return out;
+}
+
+std::string makeChapter(const int paragraphs) {
+  uint32_t state = 0x9E3779B9u;
+  std::string html =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+      "<html xmlns=\"http://www.w3.org/1999/xhtml\" xmlns:epub=\"http://www.idpf.org/2007/ops\">\n"
+      "<head><title>Chapter</title><link rel=\"stylesheet\" type=\"text/css\" href=\"style.css\"/></head>\n"
+      "<body>\n<section epub:type=\"chapter\" class=\"chapter\">\n";
+  for (int p = 0; p < paragraphs; p++) {
+    const uint32_t kind = nextRandom(state) % 40;
+    if (p % 60 == 0) {
+      html += "<h2 class=\"chapter-title\" id=\"c" + std::to_string(p) + "\">Part <span class=\"smallcaps\">" +
+              std::to_string(p / 60 + 1) + "</span></h2>\n";
+    }
+    if (kind == 0) {
+      html += "<blockquote><p class=\"first\">" + sentence(state) + "<br/>" + sentence(state) + "</p></blockquote>\n";
+    } else if (kind == 1) {
+      html += "<ul>";
+      for (int i = 0; i < 3; i++) html += "<li>" + sentence(state) + "</li>";
+      html += "</ul>\n";
+    } else if (kind == 2) {
+      html += "<div class=\"center\"><img src=\"images/fig" + std::to_string(p) + ".jpg\" alt=\"Figure " +
+              std::to_string(p) + "\"/></div>\n";
+    } else if (kind == 3) {
+      html += "<span epub:type=\"pagebreak\" role=\"doc-pagebreak\" id=\"page" + std::to_string(p) + "\" title=\"" +
+              std::to_string(p) + "\"/>\n";
+    } else if (kind == 4) {
+      html += "<table><tr><td>" + sentence(state) + "</td></tr></table>\n";
+    } else {
+      html += std::string("<p") + (p % 60 == 0 ? " class=\"first\"" : "") + ">";
+      const uint32_t sentences = 2 + nextRandom(state) % 6;
+      for (uint32_t s = 0; s < sentences; s++) {
+        if (s > 0) html += ' ';
+        html += sentence(state);
+      }
+      html += "</p>\n";
+    }
+  }
+  html += "</section>\n</body>\n</html>\n";
+  return html;
+}
+
+std::string makeStylesheet(const int fillerClasses = FILLER_CLASSES) {
+  std::string css = STYLESHEET;
+  for (int i = 0; i < fillerClasses; i++) {
+    const std::string name = "c" + std::to_string(i);
+    switch (i % 4) {
+      case 0:
+        css += "." + name + " { font-style: italic; }\n";
+        break;
+      case 1:
+        css += "span." + name + " { font-weight: bold; }\n";
+        break;
+      case 2:
+        css += "p." + name + " { margin-left: 1em; text-align: left; }\n";
+        break;
+      default:
+        css += "div." + name + " p, ." + name + ":first-child { text-indent: 0; }\n";
+    }
+  }
+  return css;
+}
+
+bool writeFile(const std::string& path, const std::string& content) {
+  std::ofstream out(path, std::ios::binary);
+  out << content;
+  return static_cast<bool>(out);
+}
+
+struct RunResult {
+  bool ok = false;
+  size_t pages = 0;
+  uint32_t checksum = 2166136261u;
+  double milliseconds = 0.0;
+};
+
+RunResult parseOnce(const std::string& chapterPath, const CssParser& css, GfxRenderer& renderer) {
+  RunResult result;
+  const auto start = std::chrono::steady_clock::now();
+  ChapterHtmlSlimParser parser(
+      chapterPath, renderer, FONT_ID, 1.0f, true, static_cast<uint8_t>(CssTextAlign::Justify), VIEWPORT_WIDTH,
+      VIEWPORT_HEIGHT, false,
+      [&result](std::unique_ptr<Page> page) {
+        FsFile sink;
+        sink.openSink();
+        page->serialize(sink);
+        for (const char c : sink.written) {
+          result.checksum = (result.checksum ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        result.pages++;
+      },
+      true, nullptr, &css);
+  result.ok = parser.parseAndBuildPages();
+  const auto end = std::chrono::steady_clock::now();
+  result.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+  return result;
+}
+
+// Style lookups alone, for the (tag, class) mix the chapter generator produces, optionally inside typical ancestors
+double resolveNanosPerElement(const CssParser& css, const bool withAncestors) {
+  constexpr int LOOKUPS = 200000;
+  const char* const TAGS[] = {"p", "span", "em", "a", "h2", "div", "strong", "sup"};
+  std::vector<std::pair<std::string, std::string>> elements;
+  uint32_t state = 0x2545F491u;
+  for (int i = 0; i < 4096; i++) {
+    const char* tag = TAGS[nextRandom(state) % (sizeof(TAGS) / sizeof(TAGS[0]))];
+    std::string classes;
+    switch (nextRandom(state) % 6) {
+      case 0:
+        break;
+      case 1:
+        classes = "first";
+        break;
+      case 2:
+        classes = "emph heavy";
+        break;
+      case 3:
+        classes = "noteref";
+        break;
+      default:
+        classes = "c" + std::to_string(nextRandom(state) % FILLER_CLASSES) + " calibre" +
+                  std::to_string(nextRandom(state) % 8);
+    }
+    elements.emplace_back(tag, classes);
+  }
+
+  const std::vector<std::vector<std::pair<const char*, const char*>>> CHAINS = {
+      {{"html", ""}, {"body", ""}, {"section", "chapter"}},
+      {{"html", ""}, {"body", ""}, {"section", "chapter"}, {"blockquote", ""}, {"p", "first"}},
+      {{"html", ""}, {"body", "calibre"}, {"div", "poem"}, {"div", "stanza"}},
+      {{"html", ""}, {"body", ""}, {"section", "chapter"}, {"div", "c17 calibre1"}, {"p", ""}},
+  };
+  std::vector<CssParser::AncestorStack> stacks(CHAINS.size());
+  for (size_t i = 0; i < CHAINS.size(); i++) {
+    for (const auto& ancestor : CHAINS[i]) stacks[i].push(css.elementKey(ancestor.first, ancestor.second));
+  }
+
+  uint32_t sink = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < LOOKUPS; i++) {
+    const auto& element = elements[i % elements.size()];
+    const CssStyle style =
+        withAncestors ? css.resolveStyle(css.elementKey(element.first.c_str(), element.second.c_str()),
+                                         &stacks[i % stacks.size()])
+                      : css.resolveStyle(element.first.c_str(), element.second.c_str());
+    sink += style.hasFontWeight() + style.hasTextIndent();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  if (sink == 0xFFFFFFFFu) std::cout << sink;  // keep the loop alive
+  return std::chrono::duration<double, std::nano>(end - start).count() / LOOKUPS;
+}
+
+bool loadStylesheet(CssParser& css, const std::string& stylesheet) {
+  CssParser::StreamLoader loader(css);
+  loader.write(reinterpret_cast<const uint8_t*>(stylesheet.data()), stylesheet.size());
+  loader.finish();
+  return !css.empty();
+}
+
+struct LoadMemory {
+  size_t peakBytes;
+  size_t indexBytes;
+  size_t rules;
+};
+
+// Heap taken while a stylesheet is streamed in 512 byte chunks, at the peak and by the finished index
+LoadMemory measureLoad(const std::string& stylesheet) {
+  CssParser css;
+  const size_t base = heapInUse;
+  heapPeak = base;
+  {
+    CssParser::StreamLoader loader(css);
+    for (size_t pos = 0; pos < stylesheet.size(); pos += 512) {
+      loader.write(reinterpret_cast<const uint8_t*>(stylesheet.data()) + pos,
+                   std::min<size_t>(512, stylesheet.size() - pos));
+    }
+    loader.finish();
+  }
+  return {heapPeak - base, heapInUse - base, css.ruleCount()};
+}
+
+// Descendant and child selectors must match exactly the ancestors CSS says they do
+bool checkContextSelectors() {
+  CssParser css;
+  if (!loadStylesheet(css, "p { text-indent: 1em; }\n"
+                           "div.poem p { text-indent: 0; }\n"
+                           "div.poem > p { text-align: left; }\n"
+                           "blockquote p.note { font-style: italic; }\n"
+                           "section div p, .x ~ p { font-weight: bold; }\n"
+                           "p.note { font-style: normal; }\n")) {
+    return false;
+  }
+  auto resolve = [&css](const std::vector<std::pair<const char*, const char*>>& chain, const char* tag,
+                        const char* classes) {
+    CssParser::AncestorStack ancestors;
+    for (const auto& ancestor : chain) ancestors.push(css.elementKey(ancestor.first, ancestor.second));
+    return css.resolveStyle(css.elementKey(tag, classes), &ancestors);
+  };
+
+  const CssStyle plain = resolve({{"body", ""}}, "p", "");
+  const CssStyle inPoem = resolve({{"body", ""}, {"div", "poem"}}, "p", "");
+  const CssStyle deepInPoem = resolve({{"div", "poem"}, {"blockquote", ""}}, "p", "");
+  const CssStyle note = resolve({{"blockquote", ""}, {"div", ""}}, "p", "note");
+  const CssStyle nested = resolve({{"section", ""}, {"blockquote", ""}, {"div", ""}}, "p", "");
+  const CssStyle outOfOrder = resolve({{"div", ""}, {"section", ""}}, "p", "");
+  return plain.textIndent.value == 1.0f && !plain.hasTextAlign() && inPoem.textIndent.value == 0.0f &&
+         inPoem.hasTextAlign() && deepInPoem.textIndent.value == 0.0f && !deepInPoem.hasTextAlign() &&
+         note.fontStyle == CssFontStyle::Italic && nested.hasFontWeight() && !outOfOrder.hasFontWeight() &&
+         css.ruleCount() == 6;
+}
+
+// One tag of a document, as the parser meets it
+struct TagEvent {
+  bool end;
+  bool selfClosing;
+  std::string tag;
+  std::string classes;
+};
+
+bool hasExtension(const std::string& name, const char* extension) {
+  const size_t length = std::strlen(extension);
+  return name.size() > length && name.compare(name.size() - length, length, extension) == 0;
+}
+
+// Start and end tags of an XHTML document, comments, declarations and processing instructions left out
+void tagEvents(const std::string& html, std::vector<TagEvent>& out) {
+  for (size_t pos = html.find('<'); pos != std::string::npos; pos = html.find('<', pos + 1)) {
+    if (pos + 1 >= html.size() || html[pos + 1] == '!' || html[pos + 1] == '?') continue;
+    const size_t close = html.find('>', pos);
+    if (close == std::string::npos) break;
+    const bool end = html[pos + 1] == '/';
+    const size_t nameStart = pos + (end ? 2 : 1);
+    size_t nameEnd = nameStart;
+    while (nameEnd < close && !std::isspace(static_cast<unsigned char>(html[nameEnd])) && html[nameEnd] != '/') {
+      nameEnd++;
+    }
+    TagEvent event{end, !end && html[close - 1] == '/', html.substr(nameStart, nameEnd - nameStart), ""};
+    const size_t classAttr = html.find("class=", nameEnd);
+    if (!end && classAttr < close && classAttr + 6 < close) {
+      const char quote = html[classAttr + 6];
+      const size_t valueEnd = html.find(quote, classAttr + 7);
+      if (valueEnd < close) event.classes = html.substr(classAttr + 7, valueEnd - classAttr - 7);
+    }
+    out.push_back(std::move(event));
+    pos = close;
+  }
+}
+
+// A p and a span inside a div for every class a stylesheet names, for sheets that come without their book
+void classEvents(const std::string& stylesheet, std::vector<TagEvent>& out) {
+  std::vector<std::string> classes;
+  int depth = 0;
+  for (size_t pos = 0; pos < stylesheet.size(); pos++) {
+    const char c = stylesheet[pos];
+    if (c == '{') depth++;
+    if (c == '}' && depth > 0) depth--;
+    // A dot before a digit is a number, e.g. in a media query
+    if (c != '.' || depth > 0 || pos + 1 >= stylesheet.size() ||
+        std::isdigit(static_cast<unsigned char>(stylesheet[pos + 1]))) {
+      continue;
+    }
+    size_t end = pos + 1;
+    while (end < stylesheet.size() && (std::isalnum(static_cast<unsigned char>(stylesheet[end])) ||
+                                       stylesheet[end] == '-' || stylesheet[end] == '_')) {
+      end++;
+    }
+    if (end > pos + 1) classes.push_back(stylesheet.substr(pos + 1, end - pos - 1));
+    pos = end - 1;
+  }
+  std::sort(classes.begin(), classes.end());
+  classes.erase(std::unique(classes.begin(), classes.end()), classes.end());
+
+  out.push_back({false, false, "body", ""});
+  for (const auto& name : classes) {
+    out.push_back({false, false, "div", ""});
+    out.push_back({false, false, "p", name});
+    out.push_back({false, false, "span", name});
+    out.push_back({true, false, "span", ""});
+    out.push_back({true, false, "p", ""});
+    out.push_back({true, false, "div", ""});
+  }
+  out.push_back({true, false, "body", ""});
+}
+
+// Style lookups as the parser makes them while walking a document: every start tag resolved inside the open ancestors
+double walkNanosPerElement(const CssParser& css, const std::vector<TagEvent>& events, size_t& elements) {
+  constexpr size_t LOOKUPS = 200000;
+  elements = 0;
+  for (const auto& event : events) elements += event.end ? 0 : 1;
+  if (elements == 0) return 0.0;
+
+  uint32_t sink = 0;
+  size_t resolved = 0;
+  const auto start = std::chrono::steady_clock::now();
+  while (resolved < LOOKUPS) {
+    CssParser::AncestorStack ancestors;
+    for (const auto& event : events) {
+      if (event.end) {
+        if (ancestors.size() > 0) ancestors.pop();
+        continue;
+      }
+      const auto key = css.elementKey(event.tag.c_str(), event.classes.c_str());
+      const CssStyle style = css.resolveStyle(key, &ancestors);
+      sink += style.hasFontWeight() + style.hasTextIndent();
+      if (!event.selfClosing) ancestors.push(key);
+      resolved++;
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  if (sink == 0xFFFFFFFFu) std::cout << sink;  // keep the loop alive
+  return std::chrono::duration<double, std::nano>(end - start).count() / resolved;
+}
+
+// Stylesheets of a .css file or of every .css entry of an EPUB, and the tags of the book's chapters
+bool readInput(const std::string& path, std::vector<std::string>& stylesheets, std::vector<TagEvent>& events) {
+  if (!hasExtension(path, ".epub")) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream content;
+    content << in.rdbuf();
+    if (!in) return false;
+    stylesheets.push_back(content.str());
+    classEvents(stylesheets.back(), events);
+    return true;
+  }
+
+  mz_zip_archive zip = {};
+  if (!mz_zip_reader_init_file(&zip, path.c_str(), 0)) return false;
+  for (mz_uint i = 0; i < mz_zip_reader_get_num_files(&zip); i++) {
+    mz_zip_archive_file_stat stat;
+    if (!mz_zip_reader_file_stat(&zip, i, &stat)) continue;
+    const std::string name = stat.m_filename;
+    const bool isStylesheet = hasExtension(name, ".css");
+    if (!isStylesheet && !hasExtension(name, ".xhtml") && !hasExtension(name, ".html") &&
+        !hasExtension(name, ".htm")) {
+      continue;
+    }
+    size_t size = 0;
+    void* data = mz_zip_reader_extract_to_heap(&zip, i, &size, 0);
+    if (!data) continue;
+    const std::string content(static_cast<const char*>(data), size);
+    mz_free(data);
+    if (isStylesheet) {
+      stylesheets.push_back(content);
+    } else {
+      tagEvents(content, events);
+    }
+  }
+  mz_zip_reader_end(&zip);
+  return true;
+}
+
+// Load memory and lookup cost of the stylesheets a command line input brings
+bool reportInput(const std::string& path) {
+  std::vector<std::string> stylesheets;
+  std::vector<TagEvent> events;
+  if (!readInput(path, stylesheets, events)) {
+    std::cerr << "Could not read " << path << std::endl;
+    return false;
+  }
+  if (stylesheets.empty()) {
+    std::cout << path << ": no stylesheets" << std::endl;
+    return true;
+  }
+
+  // Loaded one after the other like a book's linked sheets, measured as one stream
+  std::string joined;
+  CssParser css;
+  for (const auto& stylesheet : stylesheets) {
+    joined += stylesheet;
+    loadStylesheet(css, stylesheet);
+  }
+  const LoadMemory memory = measureLoad(joined);
+  size_t elements = 0;
+  const double nanos = walkNanosPerElement(css, events, elements);
+  std::cout << path << ": " << stylesheets.size() << (stylesheets.size() == 1 ? " stylesheet, " : " stylesheets, ")
+            << joined.size() / 1024 << " KB, " << css.ruleCount() << " rules, peak heap " << memory.peakBytes / 1024
+            << " KB, index " << memory.indexBytes / 1024 << " KB" << std::endl;
+  std::cout << path << ": resolveStyle " << nanos << " ns/element over " << elements << " elements in document order"
+            << std::endl;
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int paragraphs = 4000;
+  std::vector<std::string> inputs;
+  for (int i = 1; i < argc; i++) {
+    char* end = nullptr;
+    const long value = std::strtol(argv[i], &end, 10);
+    if (*argv[i] != '\0' && *end == '\0') {
+      paragraphs = std::max(1, static_cast<int>(value));
+    } else {
+      inputs.emplace_back(argv[i]);
+    }
+  }
+  const std::string chapterPath = "chapter_parse_benchmark.xhtml";
+  const std::string cssPath = "chapter_parse_benchmark.css";
+  const std::string cssCachePath = "chapter_parse_benchmark.cache";
+
+  const std::string chapter = makeChapter(paragraphs);
+  if (!writeFile(chapterPath, chapter) || !writeFile(cssPath, makeStylesheet())) {
+    std::cerr << "Failed to write benchmark input" << std::endl;
+    return 1;
+  }
+
+  CssParser css;
+  FsFile cssFile;
+  if (!cssFile.open(cssPath.c_str()) || !css.loadFromStream(cssFile)) {
+    std::cerr << "Failed to load stylesheet" << std::endl;
+    return 1;
+  }
+  cssFile.close();
+
+  GfxRenderer renderer;
+  RunResult best;
+  for (int run = 0; run < RUNS; run++) {
+    const RunResult result = parseOnce(chapterPath, css, renderer);
+    if (!result.ok || (run > 0 && (result.checksum != best.checksum || result.pages != best.pages))) {
+      std::cerr << "Parse failed or produced unstable output" << std::endl;
+      return 1;
+    }
+    if (run == 0 || result.milliseconds < best.milliseconds) best = result;
+  }
+
+  // Feeding the stylesheet one byte at a time must build the same rules as reading it in chunks
+  CssParser byteFed;
+  {
+    const std::string stylesheet = makeStylesheet();
+    CssParser::StreamLoader loader(byteFed);
+    for (const char c : stylesheet) loader.write(static_cast<uint8_t>(c));
+    loader.finish();
+  }
+  FsFile chunkedRules;
+  chunkedRules.openSink();
+  css.saveToCache(chunkedRules);
+  FsFile byteFedRules;
+  byteFedRules.openSink();
+  byteFed.saveToCache(byteFedRules);
+  if (chunkedRules.written != byteFedRules.written) {
+    std::cerr << "Byte-at-a-time stylesheet parsing differs from chunked parsing" << std::endl;
+    return 1;
+  }
+
+  // Stylesheets loaded one after the other must merge into the same rules as one sheet holding both
+  CssParser joined;
+  CssParser separate;
+  loadStylesheet(joined, makeStylesheet() + CONTEXT_STYLESHEET + makeStylesheet(FILLER_CLASSES / 2));
+  loadStylesheet(separate, makeStylesheet());
+  loadStylesheet(separate, CONTEXT_STYLESHEET);
+  loadStylesheet(separate, makeStylesheet(FILLER_CLASSES / 2));
+  FsFile joinedRules;
+  joinedRules.openSink();
+  joined.saveToCache(joinedRules);
+  FsFile separateRules;
+  separateRules.openSink();
+  separate.saveToCache(separateRules);
+  if (joinedRules.written != separateRules.written) {
+    std::cerr << "Stylesheets loaded separately differ from the same rules loaded as one sheet" << std::endl;
+    return 1;
+  }
+
+  // Rules restored from css_rules.cache must style the chapter exactly like freshly parsed ones
+  FsFile cacheSink;
+  cacheSink.openSink();
+  css.saveToCache(cacheSink);
+  CssParser cachedCss;
+  FsFile cacheFile;
+  const bool cacheLoaded = writeFile(cssCachePath, cacheSink.written) && cacheFile.open(cssCachePath.c_str()) &&
+                           cachedCss.loadFromCache(cacheFile);
+  cacheFile.close();
+  const RunResult cached = parseOnce(chapterPath, cachedCss, renderer);
+
+  std::remove(chapterPath.c_str());
+  std::remove(cssPath.c_str());
+  std::remove(cssCachePath.c_str());
+
+  if (!cacheLoaded || !cached.ok || cached.checksum != best.checksum) {
+    std::cerr << "Styles restored from the rule cache produce different pages" << std::endl;
+    return 1;
+  }
+  if (!checkContextSelectors()) {
+    std::cerr << "Descendant or child selectors resolved to the wrong style" << std::endl;
+    return 1;
+  }
+  CssParser contextCss;
+  if (!loadStylesheet(contextCss, makeStylesheet() + CONTEXT_STYLESHEET)) {
+    std::cerr << "Failed to load context stylesheet" << std::endl;
+    return 1;
+  }
+
+  const double megabytes = static_cast<double>(chapter.size()) / (1024.0 * 1024.0);
+  std::cout << "chapter: " << chapter.size() << " bytes, " << paragraphs << " paragraphs, " << best.pages
+            << " pages" << std::endl;
+  std::cout << std::fixed << std::setprecision(2) << "parse: " << best.milliseconds << " ms (best of " << RUNS
+            << "), " << megabytes / (best.milliseconds / 1000.0) << " MB/s" << std::endl;
+  std::cout << "resolveStyle: " << resolveNanosPerElement(css, false) << " ns/element, "
+            << resolveNanosPerElement(contextCss, true) << " ns/element with ancestors and context rules"
+            << std::endl;
+  // The same sheet linked from every chapter file, and a sheet with eight times the distinct rules
+  std::string repeated;
+  for (int i = 0; i < 8; i++) repeated += makeStylesheet();
+  const std::pair<const char*, std::string> sheets[] = {
+      {"publisher", makeStylesheet()}, {"8x repeated", repeated}, {"8x distinct", makeStylesheet(FILLER_CLASSES * 8)}};
+  for (const auto& [name, stylesheet] : sheets) {
+    const LoadMemory memory = measureLoad(stylesheet);
+    std::cout << "stylesheet " << name << ": " << stylesheet.size() / 1024 << " KB, " << memory.rules
+              << " rules, peak heap " << memory.peakBytes / 1024 << " KB, index " << memory.indexBytes / 1024 << " KB"
+              << std::endl;
+  }
+  for (const auto& input : inputs) {
+    if (!reportInput(input)) return 1;
+  }
+  std::cout << "page checksum: " << std::hex << std::setw(8) << std::setfill('0') << best.checksum << std::endl;
+  return 0;
+}
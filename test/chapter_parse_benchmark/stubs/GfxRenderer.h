@@ -0,0 +1,40 @@
+#pragma once
+
+// Null renderer for host benchmarks: every glyph has the same advance and nothing is drawn.
+
+#include <EpdFontFamily.h>
+#include <HardwareSerial.h>
+#include <SdFat.h>
+
+#include <cstring>
+
+enum class BmpReaderError : uint8_t { Ok = 0, Unsupported };
+
+class Bitmap {
+ public:
+  explicit Bitmap(FsFile&) {}
+  BmpReaderError parseHeaders() { return BmpReaderError::Unsupported; }
+};
+
+class GfxRenderer {
+ public:
+  static constexpr int GLYPH_WIDTH = 10;
+  static constexpr int LINE_HEIGHT = 28;
+
+  int getTextWidth(int, const char* text, EpdFontFamily::Style = EpdFontFamily::REGULAR) const {
+    // Count UTF-8 lead bytes so multi-byte characters are one glyph wide
+    int glyphs = 0;
+    for (const char* p = text; *p; ++p) {
+      glyphs += (static_cast<uint8_t>(*p) & 0xC0) != 0x80;
+    }
+    return glyphs * GLYPH_WIDTH;
+  }
+  int getSpaceWidth(int) const { return GLYPH_WIDTH / 2; }
+  int getTextAdvanceX(int fontId, const char* text) const { return getTextWidth(fontId, text); }
+  int getFontAscenderSize(int) const { return LINE_HEIGHT * 3 / 4; }
+  int getLineHeight(int) const { return LINE_HEIGHT; }
+
+  void drawText(int, int, int, const char*, bool = true, EpdFontFamily::Style = EpdFontFamily::REGULAR) const {}
+  void drawLine(int, int, int, int, bool = true) const {}
+  void drawBitmap(const Bitmap&, int, int, int, int) const {}
+};
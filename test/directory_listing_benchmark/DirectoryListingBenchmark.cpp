@@ -0,0 +1,292 @@
+#include <DirectoryListing.h>
+#include <SDCardManager.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Lists a synthetic 10k entry directory the way MyLibraryActivity used to (every name in a vector, sorted with a
+// per-character tolower comparison) and through DirectoryListing (external merge sort into a paged cache file), checks
+// that both give the same order, and reports build, reopen, paging, lookup and jump-to-letter costs.
+//
+// The entries are real files in a scratch directory, and visits walk it like MyLibraryActivity::loadFiles does: the
+// stamp comes from opening every entry in turn, as openNextFile does, and a cold visit walks it again for the names.
+
+namespace {
+constexpr uint32_t ENTRY_COUNT = 10000;
+constexpr int SORT_RUNS = 5;
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(const Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+uint32_t hash(uint32_t x) {
+  x = (x ^ 61) ^ (x >> 16);
+  x *= 9;
+  x ^= x >> 4;
+  x *= 0x27d4eb2d;
+  return x ^ (x >> 15);
+}
+
+// Book-like file names with mixed case, numbering, some punctuation and a sprinkling of folders
+std::vector<std::string> makeDirectory() {
+  static const char* const AUTHORS[] = {"Austen", "bronte", "Christie", "dickens", "Eliot", "Tolstoy", "twain",
+                                        "Verne",  "Wells",  "woolf",    "Zola",    "Hugo",  "_drafts", "1984 Fans"};
+  static const char* const EXTENSIONS[] = {".epub", ".EPUB", ".xtc", ".txt", ".md"};
+  std::vector<std::string> names;
+  names.reserve(ENTRY_COUNT);
+  for (uint32_t i = 0; i < ENTRY_COUNT; i++) {
+    const uint32_t h = hash(i);
+    const std::string author = AUTHORS[h % (sizeof(AUTHORS) / sizeof(AUTHORS[0]))];
+    if (h % 97 == 0) {
+      names.push_back(author + " collection " + std::to_string(i) + "/");
+      continue;
+    }
+    names.push_back(author + " - Volume " + std::to_string(h % 5000) + " part " + std::to_string(i) +
+                    EXTENSIONS[(h >> 8) % (sizeof(EXTENSIONS) / sizeof(EXTENSIONS[0]))]);
+  }
+  return names;
+}
+
+// MyLibraryActivity's previous sort, kept verbatim as the baseline
+void sortFileList(std::vector<std::string>& strs) {
+  std::sort(begin(strs), end(strs), [](const std::string& str1, const std::string& str2) {
+    if (str1.back() == '/' && str2.back() != '/') return true;
+    if (str1.back() != '/' && str2.back() == '/') return false;
+    return lexicographical_compare(
+        begin(str1), end(str1), begin(str2), end(str2),
+        [](const char& char1, const char& char2) { return tolower(char1) < tolower(char2); });
+  });
+}
+
+size_t heapBytes(const std::vector<std::string>& names) {
+  size_t bytes = names.capacity() * sizeof(std::string);
+  for (const auto& name : names) {
+    // Short names live inside the string object
+    if (name.capacity() > 15) {
+      bytes += name.capacity() + 1;
+    }
+  }
+  return bytes;
+}
+
+bool createEntries(const std::string& dir, const std::vector<std::string>& names) {
+  if (mkdir(dir.c_str(), 0755) != 0) {
+    return false;
+  }
+  for (const auto& name : names) {
+    const std::string path = dir + "/" + name;
+    if (name.back() == '/') {
+      if (mkdir(path.substr(0, path.size() - 1).c_str(), 0755) != 0) {
+        return false;
+      }
+    } else {
+      const int fd = ::open(path.c_str(), O_CREAT | O_WRONLY, 0644);
+      if (fd < 0) {
+        return false;
+      }
+      ::close(fd);
+    }
+  }
+  return true;
+}
+
+// Walks a directory opening every entry, as FsFile::openNextFile does on the card. Folder names get a trailing '/'.
+class EntryWalker {
+  std::string dir;
+  DIR* handle;
+
+ public:
+  explicit EntryWalker(std::string dir) : dir(std::move(dir)), handle(opendir(this->dir.c_str())) {}
+  ~EntryWalker() {
+    if (handle) closedir(handle);
+  }
+
+  bool next(std::string& name) {
+    while (handle) {
+      const dirent* entry = readdir(handle);
+      if (!entry) {
+        return false;
+      }
+      name = entry->d_name;
+      if (name == "." || name == "..") {
+        continue;
+      }
+      const int fd = ::open((dir + "/" + name).c_str(), O_RDONLY);
+      if (fd < 0) {
+        continue;
+      }
+      struct stat info;
+      if (fstat(fd, &info) == 0 && S_ISDIR(info.st_mode)) {
+        name += '/';
+      }
+      ::close(fd);
+      return true;
+    }
+    return false;
+  }
+};
+
+// The stamp MyLibraryActivity::loadFiles checks the cached listing against: folder modify time, entry count and
+// name hash
+DirectoryListing::Stamp readStamp(const std::string& dir) {
+  DirectoryListing::Stamp stamp;
+  struct stat info;
+  if (stat(dir.c_str(), &info) == 0) {
+    stamp.mtime = static_cast<uint32_t>(info.st_mtime);
+  }
+  EntryWalker walker(dir);
+  std::string name;
+  while (walker.next(name)) {
+    stamp.addEntry(name.c_str());
+  }
+  return stamp;
+}
+
+void check(const bool condition, const char* what, int& failures) {
+  if (!condition) {
+    std::cout << "FAIL: " << what << "\n";
+    failures++;
+  }
+}
+}  // namespace
+
+int main() {
+  int failures = 0;
+
+  char rootTemplate[] = "/tmp/dirlisting-XXXXXX";
+  if (!mkdtemp(rootTemplate)) {
+    std::cerr << "Could not create a scratch directory\n";
+    return 1;
+  }
+  hostRoot() = rootTemplate;
+  const std::string cacheDir = "/.crosspoint";
+
+  const auto directory = makeDirectory();
+  const std::string booksDir = std::string(rootTemplate) + "/Books";
+  if (!createEntries(booksDir, directory)) {
+    std::cerr << "Could not create the directory entries\n";
+    return 1;
+  }
+
+  // Baseline: every name in RAM, sorted on each visit
+  double baselineMs = 0;
+  std::vector<std::string> baseline;
+  for (int run = 0; run < SORT_RUNS; run++) {
+    baseline = directory;
+    const auto start = Clock::now();
+    sortFileList(baseline);
+    baselineMs += msSince(start);
+  }
+  baselineMs /= SORT_RUNS;
+
+  // Cold visit: take the stamp, then walk the entries again into runs and a merge
+  DirectoryListing listing(cacheDir);
+  const auto buildStart = Clock::now();
+  const DirectoryListing::Stamp stamp = readStamp(booksDir);
+  EntryWalker walker(booksDir);
+  const bool built = listing.build("/Books", stamp, [&](std::string& name) { return walker.next(name); });
+  const double buildMs = msSince(buildStart);
+  check(built, "build", failures);
+  check(stamp.entryCount == directory.size(), "stamp entry count", failures);
+  check(listing.size() == directory.size(), "entry count", failures);
+
+  // Warm visit: the stamp walk still opens every entry, but nothing is listed or sorted
+  const auto openStart = Clock::now();
+  const DirectoryListing::Stamp warmStamp = readStamp(booksDir);
+  const double stampMs = msSince(openStart);
+  const bool reopened = listing.open("/Books", warmStamp);
+  const double openMs = msSince(openStart);
+  check(reopened, "reopen with the same stamp", failures);
+
+  // Same order as the old sort, paging through every entry
+  const auto scanStart = Clock::now();
+  bool sameOrder = true;
+  for (uint32_t i = 0; i < listing.size(); i++) {
+    sameOrder = sameOrder && listing.at(i) == baseline[i];
+  }
+  const double scanMs = msSince(scanStart);
+  check(sameOrder, "order matches the previous sort", failures);
+  uint32_t dirs = 0;
+  while (dirs < baseline.size() && baseline[dirs].back() == '/') {
+    dirs++;
+  }
+  check(listing.getDirectoryCount() == dirs, "directory count", failures);
+
+  // Lookups, as used when returning to the parent folder
+  const auto findStart = Clock::now();
+  bool found = true;
+  for (uint32_t i = 0; i < 1000; i++) {
+    const uint32_t index = hash(i + 77) % listing.size();
+    found = found && listing.find(baseline[index]) == static_cast<int32_t>(index);
+  }
+  found = found && listing.find("missing.epub") == -1;
+  const double findUs = msSince(findStart) * 1000.0 / 1000;
+  check(found, "find", failures);
+
+  // Jump to letter: each forward jump lands on the first file of the next initial and comes back around
+  uint32_t jumps = 0;
+  bool jumpsValid = true;
+  uint32_t index = 0;
+  do {
+    const uint32_t target = listing.nextLetter(index);
+    if (target != 0) {
+      const char before = static_cast<char>(tolower(baseline[target - 1][0]));
+      const char at = static_cast<char>(tolower(baseline[target][0]));
+      jumpsValid = jumpsValid && (target == dirs || (before != at && (isalpha(before) || isalpha(at))));
+      jumpsValid = jumpsValid && listing.previousLetter(target) < target;
+    }
+    index = target;
+    jumps++;
+  } while (index != 0 && jumps < 64);
+  check(jumpsValid && index == 0, "jump to letter", failures);
+
+  // A changed directory must not reuse the cache
+  check(!listing.open("/Books", {stamp.mtime, stamp.entryCount + 1, stamp.nameHash}), "stale stamp rejected", failures);
+  // Nor one with an entry swapped for another under an unchanged modify time
+  DirectoryListing::Stamp swapped;
+  swapped.mtime = stamp.mtime;
+  EntryWalker swapWalker(booksDir);
+  std::string swapName;
+  while (swapWalker.next(swapName)) {
+    swapped.addEntry(swapped.entryCount == 0 ? "replacement.epub" : swapName.c_str());
+  }
+  check(swapped.entryCount == stamp.entryCount && !listing.open("/Books", swapped), "swapped entry rejected",
+        failures);
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "entries                " << directory.size() << " (" << dirs << " folders)\n";
+  std::cout << "vector sort            " << baselineMs << " ms per visit, " << heapBytes(baseline) / 1024
+            << " KiB of names held\n";
+  std::cout << "listing build (cold)   " << buildMs << " ms with both walks, " << DirectoryListing::RUN_ENTRIES
+            << " names per run held while sorting\n";
+  std::cout << "listing open (warm)    " << openMs << " ms (" << stampMs << " ms of it the stamp walk), "
+            << DirectoryListing::WINDOW_PAGES * DirectoryListing::PAGE_ENTRIES << " names held while browsing\n";
+  std::cout << "page through all       " << scanMs << " ms\n";
+  std::cout << "find                   " << findUs << " us per lookup\n";
+  std::cout << "letter jumps           " << jumps << " to wrap around\n";
+
+  const std::string cleanup = std::string("rm -rf ") + rootTemplate;
+  if (std::system(cleanup.c_str()) != 0) {
+    std::cerr << "Could not remove " << rootTemplate << "\n";
+  }
+
+  if (failures > 0) {
+    std::cout << failures << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "All checks passed\n";
+  return 0;
+}
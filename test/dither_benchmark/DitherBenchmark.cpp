@@ -0,0 +1,181 @@
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/GfxRenderer/BitmapHelpers.h"
+
+// Dithers a set of synthetic cover images with the per-pixel ditherer API and with the row kernels, checks that
+// both produce identical packed output and reports ms per megapixel for each, next to the callers' loops from
+// before the row kernels and lookup tables existed.
+
+struct CoverImage {
+  std::string name;
+  int width;
+  int height;
+  std::vector<uint8_t> pixels;
+};
+
+CoverImage makeCover(const std::string& name, const int width, const int height,
+                     const std::function<uint8_t(int, int)>& pixel) {
+  CoverImage image{name, width, height, std::vector<uint8_t>(static_cast<size_t>(width) * height)};
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      image.pixels[static_cast<size_t>(y) * width + x] = pixel(x, y);
+    }
+  }
+  return image;
+}
+
+uint32_t hash(const int x, const int y) {
+  uint32_t h = static_cast<uint32_t>(x) * 374761393u + static_cast<uint32_t>(y) * 668265263u;
+  h = (h ^ (h >> 13)) * 1274126177u;
+  return h ^ (h >> 16);
+}
+
+std::vector<CoverImage> makeCorpus() {
+  std::vector<CoverImage> corpus;
+  // Smooth vertical gradient, the worst case for banding
+  corpus.push_back(makeCover("gradient", 480, 800, [](int x, int y) { return static_cast<uint8_t>((y * 255 / 799 + x / 40) & 0xFF); }));
+  // Photo-like: low frequency shapes plus grain
+  corpus.push_back(makeCover("photo", 480, 800, [](int x, int y) {
+    const int base = 128 + ((x - 240) * (y - 400)) / 1600 + static_cast<int>(hash(x / 16, y / 16) % 64) - 32;
+    const int grain = static_cast<int>(hash(x, y) % 24) - 12;
+    const int v = base + grain;
+    return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+  }));
+  // Title text on a light background
+  corpus.push_back(makeCover("typography", 480, 800, [](int x, int y) {
+    const bool glyph = (y / 40) % 3 == 1 && (hash(x / 6, y / 8) & 3) == 0;
+    return static_cast<uint8_t>(glyph ? 20 : 235);
+  }));
+  // Mostly dark cover with highlights
+  corpus.push_back(makeCover("dark", 480, 800, [](int x, int y) { return static_cast<uint8_t>((hash(x / 3, y / 3) % 60) + ((x + y) % 97 == 0 ? 180 : 0)); }));
+  // Full resolution source before prescaling, odd width to exercise partial bytes
+  corpus.push_back(makeCover("large-odd", 1203, 1600, [](int x, int y) { return static_cast<uint8_t>((x * 3 + y * 5 + hash(x, y) % 16) & 0xFF); }));
+  return corpus;
+}
+
+// The adjustment as it was before it became a table: an out-of-line call per pixel, which with the brightness
+// adjustments disabled hands the gray level back unchanged
+__attribute__((noinline)) int baselineAdjustPixel(const int gray) {
+  constexpr bool USE_BRIGHTNESS = false;
+  if (!USE_BRIGHTNESS) return gray;
+  return gray;
+}
+
+struct RunResult {
+  std::vector<uint8_t> output;
+  double milliseconds = 0.0;
+};
+
+constexpr int RUNS = 5;
+
+// Best of RUNS, each with a fresh ditherer so every run produces the same output
+template <typename Ditherer, typename Fn>
+RunResult timeRun(const CoverImage& image, const int bytesPerRow, Fn&& processRow) {
+  RunResult result;
+  for (int run = 0; run < RUNS; run++) {
+    Ditherer ditherer(image.width);
+    result.output.assign(static_cast<size_t>(bytesPerRow) * image.height, 0);
+    const auto start = std::chrono::steady_clock::now();
+    for (int y = 0; y < image.height; y++) {
+      processRow(ditherer, image.pixels.data() + static_cast<size_t>(y) * image.width,
+                 result.output.data() + static_cast<size_t>(y) * bytesPerRow);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    if (run == 0 || milliseconds < result.milliseconds) result.milliseconds = milliseconds;
+  }
+  return result;
+}
+
+// The baseline is only timed: its Floyd-Steinberg walked every row left to right, so its output differs
+void report(const std::string& kernel, const CoverImage& image, const RunResult& baseline, const RunResult& perPixel,
+            const RunResult& row, int& failures) {
+  const double megapixels = static_cast<double>(image.width) * image.height / 1e6;
+  const bool identical = perPixel.output == row.output;
+  if (!identical) failures++;
+  std::cout << std::left << std::setw(12) << image.name << std::setw(16) << kernel << std::right << std::fixed
+            << std::setprecision(2) << "baseline " << std::setw(6) << baseline.milliseconds / megapixels
+            << " ms/MP   per-pixel " << std::setw(6) << perPixel.milliseconds / megapixels << " ms/MP   row "
+            << std::setw(6) << row.milliseconds / megapixels << " ms/MP   vs baseline " << std::setw(5)
+            << baseline.milliseconds / row.milliseconds << "x   vs per-pixel " << std::setw(5)
+            << perPixel.milliseconds / row.milliseconds << "x" << (identical ? "" : "   MISMATCH") << std::endl;
+}
+
+int main() {
+  int failures = 0;
+  const auto corpus = makeCorpus();
+
+  for (const auto& image : corpus) {
+    const int width = image.width;
+    const int bytes2Bit = (width + 3) / 4;
+    const int bytes1Bit = (width + 7) / 8;
+
+    const auto baselineAtkinson = timeRun<AtkinsonDitherer>(image, bytes2Bit, [&](auto& ditherer, const uint8_t* gray, uint8_t* out) {
+      for (int x = 0; x < width; x++) {
+        const uint8_t level = ditherer.processPixel(baselineAdjustPixel(gray[x]), x);
+        out[x / 4] |= level << (6 - (x % 4) * 2);
+      }
+      ditherer.nextRow();
+    });
+    const auto perPixelAtkinson = timeRun<AtkinsonDitherer>(image, bytes2Bit, [&](auto& ditherer, const uint8_t* gray, uint8_t* out) {
+      for (int x = 0; x < width; x++) {
+        const uint8_t level = ditherer.processPixel(adjustPixel(gray[x]), x);
+        out[x / 4] |= level << (6 - (x % 4) * 2);
+      }
+      ditherer.nextRow();
+    });
+    const auto rowAtkinson = timeRun<AtkinsonDitherer>(
+        image, bytes2Bit, [](auto& ditherer, const uint8_t* gray, uint8_t* out) { ditherer.processRow(gray, out); });
+    report("atkinson-2bit", image, baselineAtkinson, perPixelAtkinson, rowAtkinson, failures);
+
+    // processPixel applies the adjustment itself, now from the table, so this baseline is if anything flattered
+    const auto baselineAtkinson1Bit = timeRun<Atkinson1BitDitherer>(image, bytes1Bit, [&](auto& ditherer, const uint8_t* gray, uint8_t* out) {
+      for (int x = 0; x < width; x++) {
+        const uint8_t bit = ditherer.processPixel(gray[x], x);
+        out[x / 8] |= (bit << (7 - (x % 8)));
+      }
+      ditherer.nextRow();
+    });
+    const auto perPixelAtkinson1Bit = timeRun<Atkinson1BitDitherer>(image, bytes1Bit, [&](auto& ditherer, const uint8_t* gray, uint8_t* out) {
+      for (int x = 0; x < width; x++) {
+        const uint8_t bit = ditherer.processPixel(gray[x], x);
+        out[x / 8] |= bit << (7 - (x % 8));
+      }
+      ditherer.nextRow();
+    });
+    const auto rowAtkinson1Bit = timeRun<Atkinson1BitDitherer>(
+        image, bytes1Bit, [](auto& ditherer, const uint8_t* gray, uint8_t* out) { ditherer.processRow(gray, out); });
+    report("atkinson-1bit", image, baselineAtkinson1Bit, perPixelAtkinson1Bit, rowAtkinson1Bit, failures);
+
+    const auto baselineFs = timeRun<FloydSteinbergDitherer>(image, bytes2Bit, [&](auto& ditherer, const uint8_t* gray, uint8_t* out) {
+      for (int x = 0; x < width; x++) {
+        const uint8_t level = ditherer.processPixel(baselineAdjustPixel(gray[x]), x);
+        out[x / 4] |= level << (6 - (x % 4) * 2);
+      }
+      ditherer.nextRow();
+    });
+    const auto perPixelFs = timeRun<FloydSteinbergDitherer>(image, bytes2Bit, [&](auto& ditherer, const uint8_t* gray, uint8_t* out) {
+      // Serpentine order, as processRow does internally
+      const bool reverse = ditherer.isReverseRow();
+      for (int i = 0; i < width; i++) {
+        const int x = reverse ? width - 1 - i : i;
+        const uint8_t level = ditherer.processPixel(adjustPixel(gray[x]), x);
+        out[x / 4] |= level << (6 - (x % 4) * 2);
+      }
+      ditherer.nextRow();
+    });
+    const auto rowFs = timeRun<FloydSteinbergDitherer>(
+        image, bytes2Bit, [](auto& ditherer, const uint8_t* gray, uint8_t* out) { ditherer.processRow(gray, out); });
+    report("floyd-steinberg", image, baselineFs, perPixelFs, rowFs, failures);
+  }
+
+  std::cout << (failures == 0 ? "Row kernels match per-pixel output" : "Row kernels DIFFER from per-pixel output")
+            << std::endl;
+  return failures == 0 ? 0 : 1;
+}
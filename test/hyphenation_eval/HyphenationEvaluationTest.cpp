@@ -2,17 +2,37 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <new>
+#include <random>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "lib/Epub/Epub/hyphenation/HyphenationCache.h"
 #include "lib/Epub/Epub/hyphenation/HyphenationCommon.h"
+#include "lib/Epub/Epub/hyphenation/Hyphenator.h"
 #include "lib/Epub/Epub/hyphenation/LanguageHyphenator.h"
 #include "lib/Epub/Epub/hyphenation/LanguageRegistry.h"
+#include "lib/Epub/Epub/hyphenation/PagedHyphenationTrie.h"
+
+// Heap allocation counter for --throughput mode.
+size_t gAllocationCount = 0;
+
+void* operator new(const size_t size) {
+  ++gAllocationCount;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
 
 struct TestCase {
   std::string word;
@@ -301,7 +321,233 @@ void printResults(const std::string& language, const std::vector<TestCase>& test
   }
 }
 
+struct ThroughputResult {
+  double wordsPerSecond = 0.0;
+  double allocationsPerWord = 0.0;
+};
+
+constexpr int kThroughputPasses = 20;
+
+// Runs fn over every test word kThroughputPasses times, reporting the rate and heap allocations per word.
+ThroughputResult measureThroughput(const std::vector<TestCase>& testCases,
+                                   const std::function<size_t(const std::string&)>& fn) {
+  size_t sink = 0;
+  const size_t allocationsBefore = gAllocationCount;
+  const auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < kThroughputPasses; ++pass) {
+    for (const auto& testCase : testCases) {
+      sink += fn(testCase.word);
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const size_t allocations = gAllocationCount - allocationsBefore;
+
+  const double words = static_cast<double>(testCases.size()) * kThroughputPasses;
+  const double seconds = std::chrono::duration<double>(end - start).count();
+  if (sink == 0) {
+    std::cerr << "No breaks produced" << std::endl;
+  }
+  return {words / seconds, static_cast<double>(allocations) / words};
+}
+
+void printThroughput(const std::string& api, const ThroughputResult& result) {
+  std::cout << "  " << api << ": " << static_cast<long>(result.wordsPerSecond) << " words/s, "
+            << result.allocationsPerWord << " allocs/word" << std::endl;
+}
+
+// Stands in for a trie file on the SD card.
+class MemoryTrieSource : public HyphenationTrieSource {
+ public:
+  explicit MemoryTrieSource(std::vector<uint8_t> blob) : blob_(std::move(blob)) {}
+  size_t size() const override { return blob_.size(); }
+  bool read(const size_t offset, uint8_t* dst, const size_t len) override {
+    if (offset + len > blob_.size()) {
+      return false;
+    }
+    std::copy(blob_.begin() + offset, blob_.begin() + offset + len, dst);
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t> blob_;
+};
+
+// Liang-only break count using caller-owned buffers, so the timing reflects trie access.
+size_t countLiangBreaks(const std::string& word, const LanguageHyphenator& hyphenator) {
+  static CodepointInfo cps[LiangScratch::kMaxCodepoints];
+  static LiangScratch scratch;
+  static uint16_t indexes[LiangScratch::kMaxCodepoints];
+  const size_t collected = collectCodepoints(word, cps, LiangScratch::kMaxCodepoints);
+  if (collected > LiangScratch::kMaxCodepoints) {
+    return 0;
+  }
+  const CodepointInfo* first = cps;
+  size_t count = collected;
+  trimSurroundingPunctuationAndFootnote(&first, &count);
+  return hyphenator.breakIndexes(first, count, scratch, indexes, LiangScratch::kMaxCodepoints);
+}
+
+constexpr size_t kPagedFastTableBytes = 8192;
+constexpr int kPagedRounds = 3;
+
+// Every word repeated by its frequency in the source book, in a fixed shuffled order: the mix the hyphenator sees
+// while a book is laid out, which is what decides how warm the node cache stays.
+std::vector<TestCase> frequencyWeightedStream(const std::vector<TestCase>& testCases) {
+  std::vector<TestCase> stream;
+  for (const auto& testCase : testCases) {
+    for (int i = 0; i < std::max(1, testCase.frequency); ++i) {
+      stream.push_back(testCase);
+    }
+  }
+  std::shuffle(stream.begin(), stream.end(), std::mt19937(12345));
+  return stream;
+}
+
+// Loads the compiled-in trie through PagedHyphenationTrie, as an SD card language would be, and compares results
+// and warm-cache speed with the flash-resident trie.
+int comparePagedTrie(const std::vector<TestCase>& testCases, const LanguageHyphenator& flashHyphenator) {
+  const auto& flashPatterns = flashHyphenator.patterns();
+  PagedHyphenationTrie paged(std::unique_ptr<HyphenationTrieSource>(
+      new MemoryTrieSource(std::vector<uint8_t>(flashPatterns.data, flashPatterns.data + flashPatterns.size))));
+  if (!paged.open()) {
+    std::cerr << "Failed to open paged trie" << std::endl;
+    return 1;
+  }
+  SerializedHyphenationPatterns pagedPatterns{nullptr, flashPatterns.size, nullptr, &paged};
+  OwnedHyphenationFastTable fastTable;
+  if (buildHyphenationFastTable(pagedPatterns, kPagedFastTableBytes, fastTable)) {
+    pagedPatterns.fastTable = &fastTable.table;
+  }
+  const auto& config = flashHyphenator.config();
+  const LanguageHyphenator pagedHyphenator(pagedPatterns, config.isLetter, config.toLower, config.minPrefix,
+                                           config.minSuffix);
+
+  int mismatches = 0;
+  for (const auto& testCase : testCases) {
+    if (hyphenateWordWithHyphenator(testCase.word, flashHyphenator) !=
+        hyphenateWordWithHyphenator(testCase.word, pagedHyphenator)) {
+      std::cerr << "Paged trie mismatch for " << testCase.word << std::endl;
+      ++mismatches;
+    }
+  }
+
+  // Alternate the two and keep the best round of each, so load on the host doesn't land on one side only
+  const auto stream = frequencyWeightedStream(testCases);
+  ThroughputResult flash{};
+  ThroughputResult pagedResult{};
+  const auto before = paged.stats();
+  for (int round = 0; round < kPagedRounds; ++round) {
+    const auto flashRound = measureThroughput(
+        stream, [&flashHyphenator](const std::string& word) { return countLiangBreaks(word, flashHyphenator); });
+    const auto pagedRound = measureThroughput(
+        stream, [&pagedHyphenator](const std::string& word) { return countLiangBreaks(word, pagedHyphenator); });
+    if (flashRound.wordsPerSecond > flash.wordsPerSecond) {
+      flash = flashRound;
+    }
+    if (pagedRound.wordsPerSecond > pagedResult.wordsPerSecond) {
+      pagedResult = pagedRound;
+    }
+  }
+  const auto after = paged.stats();
+  const double words = static_cast<double>(stream.size()) * kThroughputPasses * kPagedRounds;
+
+  // Same stream through HyphenationCache, the path the reader uses, with the paged trie registered like an SD
+  // card language.
+  Hyphenator::Scratch scratch;
+  Hyphenator::BreakList breakList;
+  const auto cachedBreaks = [&scratch, &breakList](const std::string& word) {
+    HyphenationCache::breakOffsets(word, false, scratch, breakList);
+    return breakList.size();
+  };
+  HyphenationCache::clear();
+  const auto flashCached = measureThroughput(stream, cachedBreaks);
+  setRuntimeLanguageHyphenator("zz", &pagedHyphenator);
+  Hyphenator::setPreferredLanguage("zz");
+  HyphenationCache::clear();
+  const auto pagedCached = measureThroughput(stream, cachedBreaks);
+  setRuntimeLanguageHyphenator("zz", nullptr);
+  HyphenationCache::clear();
+
+  printThroughput("flash ", flash);
+  printThroughput("paged ", pagedResult);
+  printThroughput("flash+cache", flashCached);
+  printThroughput("paged+cache", pagedCached);
+  std::cout << "  paged+cache slowdown: " << flashCached.wordsPerSecond / pagedCached.wordsPerSecond << "x"
+            << std::endl;
+  std::cout << "  paged slowdown: " << flash.wordsPerSecond / pagedResult.wordsPerSecond << "x, "
+            << (after.nodeLookups - before.nodeLookups) / words << " node lookups/word ("
+            << (after.pinnedLookups - before.pinnedLookups) / words << " pinned in " << paged.pinnedLevels()
+            << " levels), " << (after.pageReads - before.pageReads) / words << " page reads/word" << std::endl;
+  return mismatches;
+}
+
+// Compares the vector, fixed-capacity and cached Hyphenator::breakOffsets paths on the test corpus.
+int runThroughput(const std::vector<LanguageConfig>& languages) {
+  int mismatches = 0;
+  Hyphenator::Scratch scratch;
+  Hyphenator::BreakList breakList;
+
+  for (const auto& lang : languages) {
+    const std::vector<TestCase> testCases = loadTestData(lang.testDataFile);
+    if (testCases.empty()) {
+      continue;
+    }
+    Hyphenator::setPreferredLanguage(lang.primaryTag);
+    HyphenationCache::clear();
+    HyphenationCache::resetStats();
+
+    for (const auto& testCase : testCases) {
+      const auto expected = Hyphenator::breakOffsets(testCase.word, false);
+      Hyphenator::breakOffsets(testCase.word, false, scratch, breakList);
+      bool same = expected.size() == breakList.size();
+      for (size_t i = 0; same && i < expected.size(); ++i) {
+        same = expected[i].byteOffset == breakList[i].byteOffset &&
+               expected[i].requiresInsertedHyphen == breakList[i].requiresInsertedHyphen;
+      }
+      if (!same) {
+        std::cerr << "Mismatch for " << testCase.word << std::endl;
+        ++mismatches;
+      }
+    }
+
+    std::cout << lang.cliName << " (" << testCases.size() << " words x " << kThroughputPasses << ")" << std::endl;
+    printThroughput("vector", measureThroughput(testCases, [](const std::string& word) {
+                      return Hyphenator::breakOffsets(word, false).size();
+                    }));
+    printThroughput("fixed ", measureThroughput(testCases, [&scratch, &breakList](const std::string& word) {
+                      Hyphenator::breakOffsets(word, false, scratch, breakList);
+                      return breakList.size();
+                    }));
+    printThroughput("cached", measureThroughput(testCases, [&scratch, &breakList](const std::string& word) {
+                      HyphenationCache::breakOffsets(word, false, scratch, breakList);
+                      return breakList.size();
+                    }));
+    const auto& stats = HyphenationCache::stats();
+    const double lookups = static_cast<double>(stats.hits + stats.misses + stats.uncached);
+    std::cout << "  cache hit rate: " << (lookups > 0 ? stats.hits * 100.0 / lookups : 0.0) << "%" << std::endl;
+
+    if (const auto* hyphenator = getLanguageHyphenatorForPrimaryTag(lang.primaryTag)) {
+      mismatches += comparePagedTrie(testCases, *hyphenator);
+    }
+  }
+
+  std::cout << (mismatches == 0 ? "Fixed-capacity and paged breaks match the vector API"
+                                 : "Fixed-capacity or paged breaks DIFFER from the vector API")
+            << std::endl;
+  return mismatches == 0 ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--throughput") {
+    const std::string selection = argc > 2 ? argv[2] : "all";
+    const auto languages = resolveLanguages(selection);
+    if (languages.empty()) {
+      std::cerr << "Unknown language: " << selection << std::endl;
+      return 1;
+    }
+    return runThroughput(languages);
+  }
+
   const bool summaryMode = argc <= 1;
   const std::string languageSelection = summaryMode ? "all" : argv[1];
 
@@ -0,0 +1,430 @@
+#include <HardwareSerial.h>
+#include <Print.h>
+#include <SdFat.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/GfxRenderer/BitmapHelpers.h"
+#include "lib/JpegToBmpConverter/JpegToBmpConverter.h"
+
+// Encodes cover-sized baseline JPEGs (4:2:0 colour and grayscale), converts them to the home screen thumbnails the
+// way Epub::generateThumbBmps does and checks which outputs took picojpeg's DC-only decode, the BMP sizes, and how
+// closely each thumbnail's tone follows the source. Then times the conversion.
+
+struct Rgb {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+};
+
+struct Image {
+  int width;
+  int height;
+  std::vector<Rgb> pixels;
+
+  const Rgb& at(const int x, const int y) const {
+    const int cx = x < width ? x : width - 1;
+    const int cy = y < height ? y : height - 1;
+    return pixels[static_cast<size_t>(cy) * width + cx];
+  }
+};
+
+uint8_t luminance(const Rgb& p) { return (p.r * 25 + p.g * 50 + p.b * 25) / 100; }
+
+uint8_t clampByte(const double v) { return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : std::lround(v))); }
+
+// A cover-like picture: a gradient background, a large disc and a band of fine title-like stripes
+Image makeCover(const int width, const int height, const bool color) {
+  Image image{width, height, std::vector<Rgb>(static_cast<size_t>(width) * height)};
+  const double cx = width * 0.5;
+  const double cy = height * 0.55;
+  const double radius = width * 0.35;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const double fx = static_cast<double>(x) / width;
+      const double fy = static_cast<double>(y) / height;
+      double r = 40 + 180 * fy;
+      double g = 60 + 120 * fx;
+      double b = 200 - 150 * fy;
+      const double dx = x - cx;
+      const double dy = y - cy;
+      if (dx * dx + dy * dy < radius * radius) {
+        r = 230;
+        g = 200 - 100 * fy;
+        b = 40;
+      }
+      if (fy > 0.08 && fy < 0.22 && fx > 0.1 && fx < 0.9 && ((x / 3 + y / 5) % 4 == 0)) {
+        r = g = b = 10;
+      }
+      if (!color) {
+        r = g = b = 0.3 * r + 0.5 * g + 0.2 * b;
+      }
+      image.pixels[static_cast<size_t>(y) * width + x] = {clampByte(r), clampByte(g), clampByte(b)};
+    }
+  }
+  return image;
+}
+
+// Minimal baseline JPEG encoder: one flat quantization table, and Huffman tables with every DC symbol on a 4-bit
+// code and every AC symbol on an 8-bit code, which picojpeg decodes like any other table
+class JpegEncoder {
+ public:
+  static std::vector<uint8_t> encode(const Image& image, const bool color) {
+    JpegEncoder encoder(image, color);
+    encoder.writeHeaders();
+    encoder.writeScan();
+    return std::move(encoder.out);
+  }
+
+ private:
+  static constexpr int QUANT = 8;
+
+  const Image& image;
+  const bool color;
+  std::vector<uint8_t> out;
+  uint32_t bitBuffer = 0;
+  int bitCount = 0;
+  int zigzag[64] = {};
+  uint8_t acSymbols[162] = {};
+  int acCodes[256] = {};
+  double cosTable[8][8] = {};
+
+  JpegEncoder(const Image& image, const bool color) : image(image), color(color) {
+    int k = 0;
+    for (int s = 0; s < 15; s++) {
+      for (int i = 0; i <= s; i++) {
+        const int row = s % 2 == 1 ? i : s - i;
+        const int col = s - row;
+        if (row < 8 && col < 8) zigzag[k++] = row * 8 + col;
+      }
+    }
+    int n = 0;
+    acSymbols[n++] = 0x00;
+    acSymbols[n++] = 0xF0;
+    for (int run = 0; run < 16; run++) {
+      for (int size = 1; size <= 10; size++) acSymbols[n++] = static_cast<uint8_t>(run << 4 | size);
+    }
+    for (int i = 0; i < n; i++) acCodes[acSymbols[i]] = i;
+    for (int x = 0; x < 8; x++) {
+      for (int u = 0; u < 8; u++) cosTable[x][u] = std::cos((2 * x + 1) * u * M_PI / 16);
+    }
+  }
+
+  void put16(const int v) {
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v & 0xFF));
+  }
+
+  void writeHeaders() {
+    const int comps = color ? 3 : 1;
+    out.insert(out.end(), {0xFF, 0xD8});
+
+    out.insert(out.end(), {0xFF, 0xDB});
+    put16(67);
+    out.push_back(0);
+    for (int i = 0; i < 64; i++) out.push_back(QUANT);
+
+    out.insert(out.end(), {0xFF, 0xC0});
+    put16(8 + 3 * comps);
+    out.push_back(8);
+    put16(image.height);
+    put16(image.width);
+    out.push_back(static_cast<uint8_t>(comps));
+    for (int c = 0; c < comps; c++) {
+      out.push_back(static_cast<uint8_t>(c + 1));
+      out.push_back(color && c == 0 ? 0x22 : 0x11);
+      out.push_back(0);
+    }
+
+    out.insert(out.end(), {0xFF, 0xC4});
+    put16(2 + 17 + 12 + 17 + 162);
+    out.push_back(0x00);
+    for (int i = 0; i < 16; i++) out.push_back(i == 3 ? 12 : 0);
+    for (int i = 0; i < 12; i++) out.push_back(static_cast<uint8_t>(i));
+    out.push_back(0x10);
+    for (int i = 0; i < 16; i++) out.push_back(i == 7 ? 162 : 0);
+    out.insert(out.end(), acSymbols, acSymbols + 162);
+
+    out.insert(out.end(), {0xFF, 0xDA});
+    put16(6 + 2 * comps);
+    out.push_back(static_cast<uint8_t>(comps));
+    for (int c = 0; c < comps; c++) {
+      out.push_back(static_cast<uint8_t>(c + 1));
+      out.push_back(0x00);
+    }
+    out.insert(out.end(), {0x00, 0x3F, 0x00});
+  }
+
+  void putBits(const uint32_t code, const int length) {
+    bitBuffer = bitBuffer << length | code;
+    bitCount += length;
+    while (bitCount >= 8) {
+      const auto byte = static_cast<uint8_t>(bitBuffer >> (bitCount - 8));
+      out.push_back(byte);
+      if (byte == 0xFF) out.push_back(0);
+      bitCount -= 8;
+    }
+    bitBuffer &= (1u << bitCount) - 1;
+  }
+
+  static int bitSize(int v) {
+    v = v < 0 ? -v : v;
+    int size = 0;
+    while (v) {
+      size++;
+      v >>= 1;
+    }
+    return size;
+  }
+
+  void putValue(const int v, const int size) {
+    if (size > 0) putBits(static_cast<uint32_t>(v < 0 ? v - 1 : v) & ((1u << size) - 1), size);
+  }
+
+  void encodeBlock(const double (&samples)[64], int& dcPrediction) {
+    int coefficients[64];
+    for (int v = 0; v < 8; v++) {
+      for (int u = 0; u < 8; u++) {
+        double sum = 0;
+        for (int y = 0; y < 8; y++) {
+          for (int x = 0; x < 8; x++) sum += (samples[y * 8 + x] - 128) * cosTable[x][u] * cosTable[y][v];
+        }
+        const double scale = (u == 0 ? M_SQRT1_2 : 1) * (v == 0 ? M_SQRT1_2 : 1) / 4;
+        coefficients[v * 8 + u] = static_cast<int>(std::lround(sum * scale / QUANT));
+      }
+    }
+
+    const int diff = coefficients[0] - dcPrediction;
+    dcPrediction = coefficients[0];
+    putBits(bitSize(diff), 4);
+    putValue(diff, bitSize(diff));
+
+    int run = 0;
+    for (int k = 1; k < 64; k++) {
+      const int ac = coefficients[zigzag[k]];
+      if (ac == 0) {
+        run++;
+        continue;
+      }
+      while (run >= 16) {
+        putBits(acCodes[0xF0], 8);
+        run -= 16;
+      }
+      const int size = bitSize(ac);
+      putBits(acCodes[run << 4 | size], 8);
+      putValue(ac, size);
+      run = 0;
+    }
+    if (run > 0) putBits(acCodes[0x00], 8);
+  }
+
+  void writeScan() {
+    const int mcuSize = color ? 16 : 8;
+    int predictions[3] = {};
+    double block[64];
+    for (int my = 0; my < image.height; my += mcuSize) {
+      for (int mx = 0; mx < image.width; mx += mcuSize) {
+        for (int by = 0; by < mcuSize; by += 8) {
+          for (int bx = 0; bx < mcuSize; bx += 8) {
+            for (int i = 0; i < 64; i++) {
+              const Rgb& p = image.at(mx + bx + i % 8, my + by + i / 8);
+              block[i] = 0.299 * p.r + 0.587 * p.g + 0.114 * p.b;
+            }
+            encodeBlock(block, predictions[0]);
+          }
+        }
+        if (!color) continue;
+        for (int c = 1; c < 3; c++) {
+          for (int i = 0; i < 64; i++) {
+            double sum = 0;
+            for (int s = 0; s < 4; s++) {
+              const Rgb& p = image.at(mx + (i % 8) * 2 + s % 2, my + (i / 8) * 2 + s / 2);
+              sum += c == 1 ? -0.1687 * p.r - 0.3313 * p.g + 0.5 * p.b : 0.5 * p.r - 0.4187 * p.g - 0.0813 * p.b;
+            }
+            block[i] = sum / 4 + 128;
+          }
+          encodeBlock(block, predictions[c]);
+        }
+      }
+    }
+    if (bitCount > 0) putBits((1u << (8 - bitCount)) - 1, 8 - bitCount);
+    out.insert(out.end(), {0xFF, 0xD9});
+  }
+};
+
+class MemoryPrint final : public Print {
+ public:
+  std::vector<uint8_t> data;
+  size_t write(const uint8_t c) override {
+    data.push_back(c);
+    return 1;
+  }
+  size_t write(const uint8_t* buffer, const size_t size) override {
+    data.insert(data.end(), buffer, buffer + size);
+    return size;
+  }
+};
+
+int32_t readLe32(const std::vector<uint8_t>& data, const size_t offset) {
+  return static_cast<int32_t>(data[offset] | data[offset + 1] << 8 | data[offset + 2] << 16 |
+                              static_cast<uint32_t>(data[offset + 3]) << 24);
+}
+
+// Mean difference over 4x4 cells between a 1-bit thumbnail and the source area-averaged to the thumbnail's size,
+// with the display adjustment the ditherer applies. -1 if the BMP isn't the expected size.
+double toneError(const std::vector<uint8_t>& bmp, const Image& image, const int outWidth, const int outHeight) {
+  if (bmp.size() < 62 || bmp[0] != 'B' || readLe32(bmp, 18) != outWidth || readLe32(bmp, 22) != -outHeight) {
+    return -1;
+  }
+  const int bytesPerRow = (outWidth + 31) / 32 * 4;
+  const size_t dataOffset = readLe32(bmp, 10);
+  if (bmp.size() < dataOffset + static_cast<size_t>(bytesPerRow) * outHeight) {
+    return -1;
+  }
+
+  constexpr int CELL = 4;
+  double totalError = 0;
+  int cells = 0;
+  for (int cellY = 0; cellY + CELL <= outHeight; cellY += CELL) {
+    for (int cellX = 0; cellX + CELL <= outWidth; cellX += CELL) {
+      double bmpSum = 0;
+      double refSum = 0;
+      for (int oy = cellY; oy < cellY + CELL; oy++) {
+        for (int ox = cellX; ox < cellX + CELL; ox++) {
+          const uint8_t byte = bmp[dataOffset + static_cast<size_t>(oy) * bytesPerRow + ox / 8];
+          bmpSum += (byte >> (7 - ox % 8) & 1) ? 255 : 0;
+
+          const int x0 = static_cast<int>(static_cast<int64_t>(ox) * image.width / outWidth);
+          const int x1 = static_cast<int>(static_cast<int64_t>(ox + 1) * image.width / outWidth);
+          const int y0 = static_cast<int>(static_cast<int64_t>(oy) * image.height / outHeight);
+          const int y1 = static_cast<int>(static_cast<int64_t>(oy + 1) * image.height / outHeight);
+          int sum = 0;
+          for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) sum += luminance(image.at(x, y));
+          }
+          refSum += adjustPixel(sum / ((x1 - x0) * (y1 - y0)));
+        }
+      }
+      totalError += std::abs(bmpSum - refSum) / (CELL * CELL);
+      cells++;
+    }
+  }
+  return totalError / cells;
+}
+
+struct ThumbCheck {
+  int height;
+  bool expectDcOnly;
+};
+
+struct CoverCase {
+  std::string name;
+  int width;
+  int height;
+  bool color;
+  std::vector<ThumbCheck> thumbs;
+};
+
+int main(const int argc, char** argv) {
+  const std::string workDir = argc > 1 ? argv[1] : ".";
+  int failures = 0;
+
+  // Base (400) and Lyra (226) home screen thumbnail heights, as HomeActivity requests them together
+  const std::vector<CoverCase> cases = {
+      {"color 4:2:0", 1600, 2560, true, {{400, false}, {226, true}}},
+      {"grayscale", 1200, 1920, false, {{400, false}, {226, true}}},
+      {"small color", 1000, 1500, true, {{400, false}, {226, false}}},
+  };
+
+  std::cout << "--- Thumbnails ---" << std::endl;
+  for (const auto& cover : cases) {
+    const Image image = makeCover(cover.width, cover.height, cover.color);
+    const std::vector<uint8_t> jpeg = JpegEncoder::encode(image, cover.color);
+    const std::string path = workDir + "/cover.jpg";
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(jpeg.data()), jpeg.size());
+
+    FsFile file;
+    if (!file.open(path.c_str())) {
+      std::cout << "FAIL " << cover.name << ": can't open " << path << std::endl;
+      failures++;
+      continue;
+    }
+
+    std::vector<MemoryPrint> outputs(cover.thumbs.size());
+    std::vector<JpegToBmpConverter::BmpTarget> targets;
+    for (size_t i = 0; i < cover.thumbs.size(); i++) {
+      const int height = cover.thumbs[i].height;
+      targets.push_back({&outputs[i], static_cast<int>(height * 0.6), height, true, true});
+    }
+
+    std::string log;
+    Serial.capture = &log;
+    const auto start = std::chrono::steady_clock::now();
+    const bool ok = JpegToBmpConverter::jpegFileToBmpStreams(file, targets.data(), static_cast<int>(targets.size()));
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Serial.capture = nullptr;
+
+    if (!ok) {
+      std::cout << "FAIL " << cover.name << ": conversion failed" << std::endl << log;
+      failures++;
+      continue;
+    }
+
+    std::cout << cover.name << " " << cover.width << "x" << cover.height << " (" << jpeg.size() / 1024 << " KB), "
+              << std::fixed << std::setprecision(1) << ms << " ms" << std::endl;
+    for (size_t i = 0; i < cover.thumbs.size(); i++) {
+      const auto& target = targets[i];
+      int outWidth;
+      int outHeight;
+      BmpOutputStage::computeOutputSize(cover.width, cover.height, target.maxWidth, target.maxHeight, true, &outWidth,
+                                        &outHeight);
+      // The converter logs every output with the scale it is decoded at
+      const std::string dcLine = "(1/" + std::to_string(JpegToBmpConverter::DC_ONLY_SCALE) + ") -> " +
+                                 std::to_string(outWidth) + "x" + std::to_string(outHeight) + " ";
+      const bool dcOnly = log.find(dcLine) != std::string::npos;
+      const double error = toneError(outputs[i].data, image, outWidth, outHeight);
+      // Dithered 1-bit thumbnails of the source stay within this mean tone difference
+      const bool pass = dcOnly == cover.thumbs[i].expectDcOnly && error >= 0 && error < 24;
+      failures += pass ? 0 : 1;
+      std::cout << (pass ? "ok   " : "FAIL ") << std::setw(3) << target.maxHeight << " -> " << outWidth << "x"
+                << outHeight << (dcOnly ? " DC-only" : " full   ") << " decode, tone error " << std::setprecision(1)
+                << error << std::endl;
+    }
+  }
+
+  std::cout << "--- Timing (color 4:2:0, 1600x2560) ---" << std::endl;
+  {
+    const Image image = makeCover(1600, 2560, true);
+    const std::vector<uint8_t> jpeg = JpegEncoder::encode(image, true);
+    const std::string path = workDir + "/cover.jpg";
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(jpeg.data()), jpeg.size());
+
+    for (const int height : {400, 226}) {
+      constexpr int RUNS = 3;
+      double totalMs = 0;
+      for (int run = 0; run < RUNS; run++) {
+        FsFile file;
+        MemoryPrint output;
+        const JpegToBmpConverter::BmpTarget target = {&output, static_cast<int>(height * 0.6), height, true, true};
+        const auto start = std::chrono::steady_clock::now();
+        if (!file.open(path.c_str()) || !JpegToBmpConverter::jpegFileToBmpStreams(file, &target, 1)) {
+          failures++;
+        }
+        totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      }
+      std::cout << std::setw(3) << height << " px thumbnail alone: " << std::fixed << std::setprecision(1)
+                << totalMs / RUNS << " ms" << std::endl;
+    }
+  }
+
+  std::cout << (failures == 0 ? "All JPEG decode checks passed" : "JPEG decode checks FAILED") << std::endl;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,382 @@
+#include <miniz.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/PngToBmpConverter/PngRowDecoder.h"
+
+// Generates a corpus of PNGs in memory (every colour type and bit depth, all five filter types, split IDAT
+// chunks, transparency), decodes them with PngRowDecoder and compares against the expected luminance.
+// Then times decoding of cover-sized images.
+
+struct PngSpec {
+  std::string name;
+  int width;
+  int height;
+  uint8_t colorType;
+  uint8_t bitDepth;
+  bool withTransparency;
+  size_t idatChunkSize;  // Split image data into IDAT chunks of this size
+  uint8_t interlace;
+};
+
+struct MemoryReader {
+  const std::vector<uint8_t>* data;
+  size_t pos;
+  size_t maxRead;  // Emulate short reads from the SD card
+};
+
+size_t memoryReadCallback(uint8_t* buffer, size_t length, void* context) {
+  auto* reader = static_cast<MemoryReader*>(context);
+  const size_t remaining = reader->data->size() - reader->pos;
+  size_t toRead = length < remaining ? length : remaining;
+  if (toRead > reader->maxRead) toRead = reader->maxRead;
+  memcpy(buffer, reader->data->data() + reader->pos, toRead);
+  reader->pos += toRead;
+  return toRead;
+}
+
+int channelsFor(const uint8_t colorType) {
+  switch (colorType) {
+    case 2:
+      return 3;
+    case 4:
+      return 2;
+    case 6:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+uint8_t luminance(const uint8_t r, const uint8_t g, const uint8_t b) { return (r * 25 + g * 50 + b * 25) / 100; }
+
+uint8_t composite(const uint8_t gray, const uint8_t alpha) { return (gray * alpha + 255 * (255 - alpha) + 127) / 255; }
+
+// Deterministic, filter-friendly test pattern
+uint16_t sampleValue(const int x, const int y, const int channel, const int maxValue) {
+  const uint32_t v = static_cast<uint32_t>(x * 7 + y * 13 + channel * 61 + ((x * y) % 37) * 3);
+  return static_cast<uint16_t>(v % (maxValue + 1));
+}
+
+void appendBigEndian32(std::vector<uint8_t>& out, const uint32_t value) {
+  out.push_back(value >> 24);
+  out.push_back((value >> 16) & 0xFF);
+  out.push_back((value >> 8) & 0xFF);
+  out.push_back(value & 0xFF);
+}
+
+void appendChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, const size_t length) {
+  appendBigEndian32(out, static_cast<uint32_t>(length));
+  const size_t typeOffset = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data, data + length);
+  appendBigEndian32(out, static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, out.data() + typeOffset, length + 4)));
+}
+
+uint8_t paeth(const int a, const int b, const int c) {
+  const int p = a + b - c;
+  const int pa = std::abs(p - a);
+  const int pb = std::abs(p - b);
+  const int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) return a;
+  if (pb <= pc) return b;
+  return c;
+}
+
+// Builds the PNG and the expected grayscale output
+std::vector<uint8_t> encodePng(const PngSpec& spec, std::vector<uint8_t>& expectedGray) {
+  const int channels = channelsFor(spec.colorType);
+  const int maxValue = (1 << spec.bitDepth) - 1;
+  const size_t bitsPerPixel = static_cast<size_t>(channels) * spec.bitDepth;
+  const size_t rowBytes = (spec.width * bitsPerPixel + 7) / 8;
+  const size_t bpp = bitsPerPixel < 8 ? 1 : bitsPerPixel / 8;
+
+  // Palette: a gray-ish ramp with some colour, the first entries partially transparent
+  const int paletteEntries = spec.colorType == 3 ? (1 << spec.bitDepth) : 0;
+  std::vector<uint8_t> palette;
+  std::vector<uint8_t> paletteAlpha;
+  for (int i = 0; i < paletteEntries; i++) {
+    palette.push_back(static_cast<uint8_t>((i * 97) & 0xFF));
+    palette.push_back(static_cast<uint8_t>((i * 53 + 20) & 0xFF));
+    palette.push_back(static_cast<uint8_t>((255 - i * 31) & 0xFF));
+    if (spec.withTransparency && i < paletteEntries / 2) {
+      paletteAlpha.push_back(static_cast<uint8_t>(i * 255 / paletteEntries));
+    }
+  }
+
+  // Colour key for gray/RGB transparency
+  const uint16_t key[3] = {sampleValue(3, 0, 0, maxValue), sampleValue(3, 0, 1, maxValue),
+                           sampleValue(3, 0, 2, maxValue)};
+
+  std::vector<uint8_t> raw;
+  std::vector<uint8_t> previous(rowBytes, 0);
+  std::vector<uint8_t> line(rowBytes);
+  expectedGray.assign(static_cast<size_t>(spec.width) * spec.height, 0);
+
+  for (int y = 0; y < spec.height; y++) {
+    std::fill(line.begin(), line.end(), 0);
+    for (int x = 0; x < spec.width; x++) {
+      uint16_t samples[4];
+      for (int c = 0; c < channels; c++) {
+        samples[c] = spec.colorType == 3 ? sampleValue(x, y, 0, paletteEntries - 1) : sampleValue(x, y, c, maxValue);
+        const size_t bitOffset = (static_cast<size_t>(x) * channels + c) * spec.bitDepth;
+        if (spec.bitDepth == 16) {
+          line[bitOffset / 8] = samples[c] >> 8;
+          line[bitOffset / 8 + 1] = samples[c] & 0xFF;
+        } else if (spec.bitDepth == 8) {
+          line[bitOffset / 8] = static_cast<uint8_t>(samples[c]);
+        } else {
+          line[bitOffset / 8] |= samples[c] << (8 - spec.bitDepth - (bitOffset % 8));
+        }
+      }
+
+      const auto high = [&](const int c) -> uint8_t {
+        if (spec.bitDepth == 16) return samples[c] >> 8;
+        return static_cast<uint8_t>(samples[c]);
+      };
+      uint8_t gray = 0;
+      switch (spec.colorType) {
+        case 0:
+          if (spec.withTransparency && samples[0] == key[0]) {
+            gray = 0xFF;
+          } else {
+            gray = spec.bitDepth < 8 ? samples[0] * 255 / maxValue : high(0);
+          }
+          break;
+        case 2:
+          if (spec.withTransparency && samples[0] == key[0] && samples[1] == key[1] && samples[2] == key[2]) {
+            gray = 0xFF;
+          } else {
+            gray = luminance(high(0), high(1), high(2));
+          }
+          break;
+        case 3: {
+          const int index = samples[0];
+          gray = luminance(palette[index * 3], palette[index * 3 + 1], palette[index * 3 + 2]);
+          if (index < static_cast<int>(paletteAlpha.size())) {
+            gray = composite(gray, paletteAlpha[index]);
+          }
+          break;
+        }
+        case 4:
+          gray = composite(high(0), high(1));
+          break;
+        case 6:
+          gray = composite(luminance(high(0), high(1), high(2)), high(3));
+          break;
+        default:
+          break;
+      }
+      expectedGray[static_cast<size_t>(y) * spec.width + x] = gray;
+    }
+
+    // Cycle through all five filter types
+    const uint8_t filterType = y % 5;
+    raw.push_back(filterType);
+    for (size_t i = 0; i < rowBytes; i++) {
+      const int a = i >= bpp ? line[i - bpp] : 0;
+      const int b = previous[i];
+      const int c = i >= bpp ? previous[i - bpp] : 0;
+      int predicted = 0;
+      switch (filterType) {
+        case 1:
+          predicted = a;
+          break;
+        case 2:
+          predicted = b;
+          break;
+        case 3:
+          predicted = (a + b) >> 1;
+          break;
+        case 4:
+          predicted = paeth(a, b, c);
+          break;
+        default:
+          break;
+      }
+      raw.push_back(static_cast<uint8_t>(line[i] - predicted));
+    }
+    previous = line;
+  }
+
+  size_t compressedSize = 0;
+  void* compressed = tdefl_compress_mem_to_heap(raw.data(), raw.size(), &compressedSize,
+                                                static_cast<int>(TDEFL_WRITE_ZLIB_HEADER) | TDEFL_DEFAULT_MAX_PROBES);
+
+  std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  uint8_t header[13];
+  const uint32_t w = spec.width;
+  const uint32_t h = spec.height;
+  header[0] = w >> 24;
+  header[1] = (w >> 16) & 0xFF;
+  header[2] = (w >> 8) & 0xFF;
+  header[3] = w & 0xFF;
+  header[4] = h >> 24;
+  header[5] = (h >> 16) & 0xFF;
+  header[6] = (h >> 8) & 0xFF;
+  header[7] = h & 0xFF;
+  header[8] = spec.bitDepth;
+  header[9] = spec.colorType;
+  header[10] = 0;
+  header[11] = 0;
+  header[12] = spec.interlace;
+  appendChunk(png, "IHDR", header, sizeof(header));
+
+  // An ancillary chunk the decoder has to skip
+  const char* text = "Comment\0generated by PngDecodeEvaluationTest";
+  appendChunk(png, "tEXt", reinterpret_cast<const uint8_t*>(text), 44);
+
+  if (spec.colorType == 3) {
+    appendChunk(png, "PLTE", palette.data(), palette.size());
+    if (!paletteAlpha.empty()) {
+      appendChunk(png, "tRNS", paletteAlpha.data(), paletteAlpha.size());
+    }
+  } else if (spec.withTransparency && (spec.colorType == 0 || spec.colorType == 2)) {
+    uint8_t trns[6];
+    const int entries = spec.colorType == 0 ? 1 : 3;
+    for (int i = 0; i < entries; i++) {
+      trns[i * 2] = key[i] >> 8;
+      trns[i * 2 + 1] = key[i] & 0xFF;
+    }
+    appendChunk(png, "tRNS", trns, entries * 2);
+  }
+
+  const auto* compressedBytes = static_cast<const uint8_t*>(compressed);
+  for (size_t offset = 0; offset < compressedSize; offset += spec.idatChunkSize) {
+    const size_t length = std::min(spec.idatChunkSize, compressedSize - offset);
+    appendChunk(png, "IDAT", compressedBytes + offset, length);
+  }
+  mz_free(compressed);
+  appendChunk(png, "IEND", nullptr, 0);
+  return png;
+}
+
+struct DecodeResult {
+  bool ok = false;
+  std::string error;
+  size_t mismatches = 0;
+  size_t workingMemory = 0;
+  double milliseconds = 0.0;
+};
+
+DecodeResult decodePng(const std::vector<uint8_t>& png, const std::vector<uint8_t>* expectedGray, const size_t maxRead) {
+  DecodeResult result;
+  MemoryReader reader{&png, 0, maxRead};
+
+  const auto start = std::chrono::steady_clock::now();
+  PngRowDecoder decoder(memoryReadCallback, &reader);
+  if (!decoder.begin()) {
+    result.error = decoder.getError();
+    return result;
+  }
+
+  std::vector<uint8_t> row(decoder.getWidth());
+  for (int y = 0; y < decoder.getHeight(); y++) {
+    if (!decoder.readRow(row.data())) {
+      result.error = decoder.getError();
+      return result;
+    }
+    if (expectedGray) {
+      for (int x = 0; x < decoder.getWidth(); x++) {
+        if (row[x] != (*expectedGray)[static_cast<size_t>(y) * decoder.getWidth() + x]) {
+          result.mismatches++;
+        }
+      }
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  result.ok = result.mismatches == 0;
+  result.workingMemory = decoder.getWorkingMemorySize();
+  result.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+  return result;
+}
+
+int main() {
+  int failures = 0;
+
+  const std::vector<PngSpec> corpus = {
+      {"gray1", 61, 23, 0, 1, false, 1 << 16, 0},
+      {"gray2", 61, 23, 0, 2, false, 1 << 16, 0},
+      {"gray4", 61, 23, 0, 4, true, 1 << 16, 0},
+      {"gray8", 97, 41, 0, 8, true, 64, 0},
+      {"gray16", 97, 41, 0, 16, true, 1 << 16, 0},
+      {"palette1", 45, 30, 3, 1, false, 1 << 16, 0},
+      {"palette2", 45, 30, 3, 2, true, 1 << 16, 0},
+      {"palette4", 45, 30, 3, 4, true, 17, 0},
+      {"palette8", 300, 200, 3, 8, true, 1 << 16, 0},
+      {"gray-alpha8", 80, 50, 4, 8, false, 1 << 16, 0},
+      {"gray-alpha16", 80, 50, 4, 16, false, 100, 0},
+      {"rgb8", 300, 200, 2, 8, true, 1 << 16, 0},
+      {"rgb16", 120, 90, 2, 16, true, 1 << 16, 0},
+      {"rgba8", 300, 200, 6, 8, false, 1000, 0},
+      {"rgba16", 120, 90, 6, 16, false, 1 << 16, 0},
+  };
+
+  std::cout << "--- Corpus ---" << std::endl;
+  for (const auto& spec : corpus) {
+    std::vector<uint8_t> expected;
+    const auto png = encodePng(spec, expected);
+    // Alternate between tiny and large reads to exercise chunk boundary handling
+    bool passed = true;
+    for (const size_t maxRead : {static_cast<size_t>(7), static_cast<size_t>(4096)}) {
+      const DecodeResult result = decodePng(png, &expected, maxRead);
+      if (!result.ok) {
+        failures++;
+        std::cout << "FAIL " << spec.name << " (reads of " << maxRead << "): "
+                  << (result.error.empty() ? std::to_string(result.mismatches) + " mismatched pixels" : result.error)
+                  << std::endl;
+      }
+    }
+    if (passed) {
+      std::cout << "ok   " << spec.name << " " << spec.width << "x" << spec.height << std::endl;
+    }
+  }
+
+  std::cout << "--- Rejections ---" << std::endl;
+  {
+    std::vector<uint8_t> expected;
+    const auto interlaced = encodePng({"interlaced", 16, 16, 0, 8, false, 1 << 16, 1}, expected);
+    const DecodeResult result = decodePng(interlaced, nullptr, 4096);
+    std::cout << (result.ok ? "FAIL" : "ok  ") << " interlaced rejected: " << result.error << std::endl;
+    failures += result.ok ? 1 : 0;
+
+    auto truncated = encodePng({"truncated", 64, 64, 2, 8, false, 1 << 16, 0}, expected);
+    truncated.resize(truncated.size() / 2);
+    const DecodeResult truncatedResult = decodePng(truncated, nullptr, 4096);
+    std::cout << (truncatedResult.ok ? "FAIL" : "ok  ") << " truncated rejected: " << truncatedResult.error
+              << std::endl;
+    failures += truncatedResult.ok ? 1 : 0;
+  }
+
+  std::cout << "--- Timing (cover sized, 1200x1600) ---" << std::endl;
+  const std::vector<PngSpec> timingCorpus = {
+      {"palette8", 1200, 1600, 3, 8, true, 8192, 0},
+      {"gray8", 1200, 1600, 0, 8, false, 8192, 0},
+      {"rgb8", 1200, 1600, 2, 8, false, 8192, 0},
+      {"rgba8", 1200, 1600, 6, 8, false, 8192, 0},
+  };
+  for (const auto& spec : timingCorpus) {
+    std::vector<uint8_t> expected;
+    const auto png = encodePng(spec, expected);
+    const DecodeResult result = decodePng(png, &expected, 512);
+    if (!result.ok) {
+      failures++;
+    }
+    const double megapixels = static_cast<double>(spec.width) * spec.height / 1e6;
+    std::cout << std::left << std::setw(10) << spec.name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(9) << result.milliseconds << " ms  " << std::setw(7) << result.milliseconds / megapixels
+              << " ms/MP  working memory " << result.workingMemory << " bytes" << (result.ok ? "" : "  FAIL")
+              << std::endl;
+  }
+
+  std::cout << (failures == 0 ? "All PNG decode checks passed" : "PNG decode checks FAILED") << std::endl;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/book_search_benchmark"
+BINARY="$BUILD_DIR/BookSearchBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+cc -O2 -w -c "$ROOT_DIR/lib/miniz/miniz.c" -o "$BUILD_DIR/miniz.o"
+
+SOURCES=(
+  "$ROOT_DIR/test/book_search_benchmark/BookSearchBenchmark.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/search/HtmlTextScanner.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/search/TextMatcher.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/search/WordIndex.cpp"
+  "$ROOT_DIR/lib/ZipFile/ZipFile.cpp"
+)
+
+# The stubs directory comes first so the host file shims replace the device headers
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -I"$ROOT_DIR/test/stubs"
+  -I"$ROOT_DIR/lib/Epub/Epub/search"
+  -I"$ROOT_DIR/lib/ZipFile"
+  -I"$ROOT_DIR/lib/miniz"
+  -I"$ROOT_DIR/lib/Serialization"
+)
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" "$BUILD_DIR/miniz.o" -o "$BINARY"
+
+# Optional arguments: EPUB files or directories to search instead of the synthetic corpus
+"$BINARY" "$@"
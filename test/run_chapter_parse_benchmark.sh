@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/chapter_parse_benchmark"
+BINARY="$BUILD_DIR/ChapterParseBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+for source in xmlparse xmlrole xmltok; do
+  cc -O2 -w -DXML_GE=0 -DXML_CONTEXT_BYTES=1024 -c "$ROOT_DIR/lib/expat/$source.c" -o "$BUILD_DIR/$source.o"
+done
+cc -O2 -w -c "$ROOT_DIR/lib/miniz/miniz.c" -o "$BUILD_DIR/miniz.o"
+
+SOURCES=(
+  "$ROOT_DIR/test/chapter_parse_benchmark/ChapterParseBenchmark.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/parsers/ChapterHtmlSlimParser.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/ParsedText.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/Page.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/DomPosition.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/blocks/TextBlock.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/css/CssParser.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCache.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/Hyphenator.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/LanguageRegistry.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/LiangHyphenation.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/PagedHyphenationTrie.cpp"
+  "$ROOT_DIR/lib/Epub/Epub/hyphenation/HyphenationCommon.cpp"
+  "$ROOT_DIR/lib/Utf8/Utf8.cpp"
+)
+
+# The stubs directories come first so the null renderer and host file shims replace the device headers
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -I"$ROOT_DIR/test/chapter_parse_benchmark/stubs"
+  -I"$ROOT_DIR/test/stubs"
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib"
+  -I"$ROOT_DIR/lib/Epub"
+  -I"$ROOT_DIR/lib/EpdFont"
+  -I"$ROOT_DIR/lib/Serialization"
+  -I"$ROOT_DIR/lib/Utf8"
+  -I"$ROOT_DIR/lib/expat"
+  -I"$ROOT_DIR/lib/miniz"
+)
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" "$BUILD_DIR"/xml*.o "$BUILD_DIR/miniz.o" -o "$BINARY"
+
+# Optional arguments: a paragraph count, and stylesheets or EPUBs to report on. Their paths are made absolute since
+# the benchmark runs in the build directory.
+ARGS=()
+for arg in "$@"; do
+  if [[ -e "$arg" ]]; then
+    ARGS+=("$(realpath "$arg")")
+  else
+    ARGS+=("$arg")
+  fi
+done
+
+cd "$BUILD_DIR"
+"$BINARY" "${ARGS[@]}"
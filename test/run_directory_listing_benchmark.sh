@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/directory_listing_benchmark"
+BINARY="$BUILD_DIR/DirectoryListingBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+SOURCES=(
+  "$ROOT_DIR/test/directory_listing_benchmark/DirectoryListingBenchmark.cpp"
+  "$ROOT_DIR/lib/DirectoryListing/DirectoryListing.cpp"
+)
+
+# The stubs directory comes first so the host file shims replace the device headers
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -I"$ROOT_DIR/test/stubs"
+  -I"$ROOT_DIR/lib/DirectoryListing"
+  -I"$ROOT_DIR/lib/Serialization"
+)
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/jpeg_decode_eval"
+BINARY="$BUILD_DIR/JpegDecodeEvaluationTest"
+
+mkdir -p "$BUILD_DIR"
+
+cc -std=c99 -O2 -I"$ROOT_DIR/lib/picojpeg" -c "$ROOT_DIR/lib/picojpeg/picojpeg.c" -o "$BUILD_DIR/picojpeg.o"
+
+SOURCES=(
+  "$ROOT_DIR/test/jpeg_decode_eval/JpegDecodeEvaluationTest.cpp"
+  "$ROOT_DIR/lib/JpegToBmpConverter/JpegToBmpConverter.cpp"
+  "$ROOT_DIR/lib/JpegToBmpConverter/BmpOutputStage.cpp"
+  "$ROOT_DIR/lib/GfxRenderer/BitmapHelpers.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib"
+  -I"$ROOT_DIR/lib/GfxRenderer"
+  -I"$ROOT_DIR/lib/picojpeg"
+  -I"$ROOT_DIR/test/stubs"
+)
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" "$BUILD_DIR/picojpeg.o" -o "$BINARY"
+
+"$BINARY" "$BUILD_DIR" "$@"
@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/png_decode_eval"
+BINARY="$BUILD_DIR/PngDecodeEvaluationTest"
+
+mkdir -p "$BUILD_DIR"
+
+cc -std=c99 -O2 -DMINIZ_NO_ZLIB_COMPATIBLE_NAMES=1 -Wno-unknown-pragmas -c "$ROOT_DIR/lib/miniz/miniz.c" \
+  -o "$BUILD_DIR/miniz.o" 2>/dev/null
+
+SOURCES=(
+  "$ROOT_DIR/test/png_decode_eval/PngDecodeEvaluationTest.cpp"
+  "$ROOT_DIR/lib/PngToBmpConverter/PngRowDecoder.cpp"
+)
+
+CXXFLAGS=(
+  -std=c++20
+  -O2
+  -Wall
+  -Wextra
+  -pedantic
+  -DMINIZ_NO_ZLIB_COMPATIBLE_NAMES=1
+  -I"$ROOT_DIR"
+  -I"$ROOT_DIR/lib"
+  -I"$ROOT_DIR/lib/miniz"
+)
+
+c++ "${CXXFLAGS[@]}" "${SOURCES[@]}" "$BUILD_DIR/miniz.o" -o "$BINARY"
+
+"$BINARY" "$@"
@@ -0,0 +1,32 @@
+#pragma once
+
+// Host stand-in for the Arduino serial console: logging is dropped so it doesn't skew timings, unless a test points
+// Serial.capture at a string to check what was logged. Print comes along with it as it does through the Arduino core.
+
+#include <Print.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Arduino.h provides these unqualified
+using std::max;
+using std::min;
+
+struct HostSerial {
+  std::string* capture = nullptr;
+
+  template <typename... Args>
+  void printf(const char* format, Args... args) {
+    if (capture) {
+      char line[256];
+      std::snprintf(line, sizeof(line), format, args...);
+      capture->append(line);
+    }
+  }
+};
+
+inline HostSerial Serial;
+
+inline unsigned long millis() { return 0; }
@@ -0,0 +1,28 @@
+#pragma once
+
+// Host stand-in for the SD card manager: paths are host paths below hostRoot().
+
+#include <SdFat.h>
+
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+struct HostSdManager {
+  bool openFileForRead(const char*, const std::string& path, FsFile& file) { return file.open(path, "rb"); }
+  bool openFileForWrite(const char*, const std::string& path, FsFile& file) { return file.open(path, "w+b"); }
+  bool exists(const char* path) {
+    std::error_code error;
+    return std::filesystem::exists(hostRoot() + path, error);
+  }
+  bool remove(const char* path) {
+    std::error_code error;
+    return std::filesystem::remove(hostRoot() + path, error);
+  }
+  bool mkdir(const char* path) {
+    std::error_code error;
+    return std::filesystem::create_directories(hostRoot() + path, error);
+  }
+};
+
+inline HostSdManager SdMan;
@@ -0,0 +1,92 @@
+#pragma once
+
+// Host stand-in for SdFat's FsFile on host files below hostRoot(), which stays empty unless a test roots its SD card
+// paths in a scratch directory. A sink file appends its writes to an in-memory buffer instead, so serialized output
+// can be checksummed. Print comes along with it as it does through the Arduino core on the device.
+
+#include <Print.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+inline std::string& hostRoot() {
+  static std::string root;
+  return root;
+}
+
+class FsFile {
+  std::FILE* file = nullptr;
+  bool sink = false;
+  std::string path;
+
+ public:
+  std::string written;
+
+  FsFile() = default;
+  FsFile(const FsFile&) = delete;
+  FsFile& operator=(const FsFile&) = delete;
+  FsFile(FsFile&& other) noexcept
+      : file(other.file), sink(other.sink), path(std::move(other.path)), written(std::move(other.written)) {
+    other.file = nullptr;
+  }
+  FsFile& operator=(FsFile&& other) noexcept {
+    close();
+    file = other.file;
+    sink = other.sink;
+    other.file = nullptr;
+    path = std::move(other.path);
+    written = std::move(other.written);
+    return *this;
+  }
+  ~FsFile() { close(); }
+
+  bool open(const std::string& sdPath, const char* mode = "rb") {
+    close();
+    path = sdPath;
+    file = std::fopen((hostRoot() + sdPath).c_str(), mode);
+    return file != nullptr;
+  }
+  // Collect writes in memory instead of a file
+  void openSink() {
+    close();
+    sink = true;
+  }
+  void close() {
+    if (file) {
+      std::fclose(file);
+      file = nullptr;
+    }
+    sink = false;
+  }
+  explicit operator bool() const { return file != nullptr || sink; }
+
+  int read(void* dst, const size_t len) { return file ? static_cast<int>(std::fread(dst, 1, len, file)) : -1; }
+  int read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  size_t write(const void* src, const size_t len) {
+    if (sink) {
+      written.append(static_cast<const char*>(src), len);
+      return len;
+    }
+    return file ? std::fwrite(src, 1, len, file) : 0;
+  }
+  size_t write(const uint8_t c) { return write(&c, 1); }
+  bool seek(const uint64_t pos) { return file && std::fseek(file, static_cast<long>(pos), SEEK_SET) == 0; }
+  bool seekCur(const int64_t offset) { return file && std::fseek(file, static_cast<long>(offset), SEEK_CUR) == 0; }
+  uint64_t position() { return file ? static_cast<uint64_t>(std::ftell(file)) : written.size(); }
+  uint64_t size() {
+    if (!file) return written.size();
+    const long pos = std::ftell(file);
+    std::fseek(file, 0, SEEK_END);
+    const long end = std::ftell(file);
+    std::fseek(file, pos, SEEK_SET);
+    return static_cast<uint64_t>(end);
+  }
+  int available() { return static_cast<int>(size() - position()); }
+  bool rename(const char* newPath) {
+    return std::rename((hostRoot() + path).c_str(), (hostRoot() + newPath).c_str()) == 0;
+  }
+};